@@ -37,6 +37,7 @@ static GeglOptions *opts_new (void)
   o->file     = NULL;
   o->rest     = NULL;
   o->scale    = 1.0;
+  o->jobs     = 1;
   return o;
 }
 
@@ -68,6 +69,9 @@ _("usage: %s [options] <file | -- [op [op] ..]>\n"
 "\n"
 "     -s scale, --scale scale  scale output dimensions by this factor.\n"
 "\n"
+"     -j n, --jobs n  when rendering video, process up to n frames in\n"
+"                     parallel, each on its own copy of the graph.\n"
+"\n"
 "     -X              output the XML that was read in\n"
 "\n"
 "     -v, --verbose   print diagnostics while running\n"
@@ -444,6 +448,12 @@ parse_args (int    argc,
             get_float (o->scale);
         }
 
+        else if (match ("--jobs") ||
+                 match ("-j")) {
+            get_int (o->jobs);
+            o->jobs = MAX (o->jobs, 1);
+        }
+
         else if (match ("-X")) {
             o->mode = GEGL_RUN_MODE_XML;
         }
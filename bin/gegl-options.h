@@ -51,6 +51,8 @@ struct _GeglOptions
 
   gdouble      scale;
 
+  gint         jobs;
+
   gboolean     serialize;
 };
 
@@ -35,6 +35,7 @@
 #endif
 #include "gegl-path-smooth.h"
 #include "operation/gegl-extension-handler.h"
+#include "operation/gegl-operation.h"
 
 #ifdef G_OS_WIN32
 #include <direct.h>
@@ -93,6 +94,323 @@ static gboolean is_xml_fragment (const char *data)
   return FALSE;
 }
 
+/* pipelined video rendering: a decoder thread renders the source frames of
+ * the graph ahead of time, worker threads run the rest of the graph on frames
+ * in parallel, each on its own instance of the graph, and the main thread
+ * encodes the processed frames in order.  at most n_slots frames are in
+ * flight at any time.
+ */
+
+typedef enum
+{
+  FRAME_FREE,
+  FRAME_DECODED,
+  FRAME_PROCESSED
+} FrameState;
+
+typedef struct
+{
+  gint               frame_no;
+  FrameState         state;
+  GeglBuffer        *input;  /* the decoded frame      */
+  GeglAudioFragment *audio;  /* the frame's audio      */
+  guchar            *pixels; /* the processed frame    */
+} PipelineFrame;
+
+typedef struct
+{
+  GeglOptions   *o;
+  GeglNode      *decoder;  /* the source node of the main graph */
+  GeglRectangle  bounds;   /* the bounds of the rendered frames */
+  gint           duration;
+
+  PipelineFrame *frames;
+  gint           n_slots;
+  GAsyncQueue   *queue;    /* decoded frames, waiting for a worker */
+
+  GMutex         mutex;
+  GCond          cond;
+} Pipeline;
+
+typedef struct
+{
+  Pipeline *pipeline;
+  GeglNode *graph;
+  GeglNode *source;        /* replaces the graph's decoder */
+} PipelineWorker;
+
+static GeglNode *
+find_source_node (GeglNode *graph)
+{
+  GeglNode *iter = gegl_node_get_output_proxy (graph, "output");
+
+  while (gegl_node_get_producer (iter, "input", NULL))
+    iter = gegl_node_get_producer (iter, "input", NULL);
+
+  return iter;
+}
+
+/* creates a separate instance of the graph, fed from a buffer-source in place
+ * of its source node.
+ */
+static GeglNode *
+pipeline_graph_new (GeglOptions  *o,
+                    const gchar  *script,
+                    const gchar  *path_root,
+                    GeglNode    **source)
+{
+  GeglNode     *graph;
+  GeglNode     *decoder;
+  GeglNode    **consumers;
+  const gchar **pads;
+  gint          n_consumers;
+  gint          i;
+
+  if (is_xml_fragment (script))
+    graph = gegl_node_new_from_xml (script, path_root);
+  else
+    graph = gegl_node_new_from_serialized (script, path_root);
+
+  if (o->rest)
+    {
+      GeglNode *proxy = gegl_node_get_output_proxy (graph, "output");
+      GeglNode *iter  = gegl_node_get_producer (proxy, "input", NULL);
+      GError   *error = NULL;
+
+      gegl_create_chain_argv (o->rest, iter, proxy, 0,
+                              gegl_node_get_bounding_box (graph).height,
+                              path_root, &error);
+      g_clear_error (&error);
+    }
+
+  decoder = find_source_node (graph);
+  *source = gegl_node_new_child (graph,
+                                 "operation", "gegl:buffer-source",
+                                 NULL);
+
+  n_consumers = gegl_node_get_consumers (decoder, "output", &consumers, &pads);
+
+  for (i = 0; i < n_consumers; i++)
+    gegl_node_connect (*source, "output", consumers[i], pads[i]);
+
+  g_free (consumers);
+  g_free (pads);
+
+  return graph;
+}
+
+/* the decoder reuses its audio fragment for every frame, so it's copied for
+ * the frames in flight.
+ */
+static GeglAudioFragment *
+audio_fragment_copy (GeglAudioFragment *audio)
+{
+  GeglAudioFragment *copy;
+  gint               channels;
+  gint               n_samples;
+  gint               c;
+
+  channels  = gegl_audio_fragment_get_channels (audio);
+  n_samples = gegl_audio_fragment_get_sample_count (audio);
+
+  copy = gegl_audio_fragment_new (gegl_audio_fragment_get_sample_rate (audio),
+                                  channels,
+                                  gegl_audio_fragment_get_channel_layout (audio),
+                                  gegl_audio_fragment_get_max_samples (audio));
+  gegl_audio_fragment_set_sample_count (copy, n_samples);
+  gegl_audio_fragment_set_pos (copy, gegl_audio_fragment_get_pos (audio));
+
+  for (c = 0; c < channels; c++)
+    memcpy (copy->data[c], audio->data[c], n_samples * sizeof (float));
+
+  return copy;
+}
+
+static gpointer
+pipeline_decoder_thread (gpointer data)
+{
+  Pipeline          *pipeline = data;
+  GeglAudioFragment *audio    = NULL;
+  gint               frame_no;
+  gint               i;
+
+  for (frame_no = 0; frame_no < pipeline->duration; frame_no++)
+    {
+      PipelineFrame     *frame = &pipeline->frames[frame_no % pipeline->n_slots];
+      GeglAudioFragment *copy  = NULL;
+
+      g_mutex_lock (&pipeline->mutex);
+      while (frame->state != FRAME_FREE)
+        g_cond_wait (&pipeline->cond, &pipeline->mutex);
+      g_mutex_unlock (&pipeline->mutex);
+
+      gegl_node_set (pipeline->decoder, "frame", frame_no, NULL);
+      gegl_node_blit_buffer (pipeline->decoder, frame->input, NULL, 0,
+                             GEGL_ABYSS_NONE);
+      gegl_node_get (pipeline->decoder, "audio", &audio, NULL);
+      if (audio)
+        {
+          copy = audio_fragment_copy (audio);
+          g_object_unref (audio);
+        }
+
+      g_mutex_lock (&pipeline->mutex);
+      frame->audio    = copy;
+      frame->frame_no = frame_no;
+      frame->state    = FRAME_DECODED;
+      g_mutex_unlock (&pipeline->mutex);
+
+      g_async_queue_push (pipeline->queue, frame);
+    }
+
+  /* wake up the workers */
+  for (i = 0; i < pipeline->o->jobs; i++)
+    g_async_queue_push (pipeline->queue, pipeline);
+
+  return NULL;
+}
+
+static gpointer
+pipeline_worker_thread (gpointer data)
+{
+  PipelineWorker *worker   = data;
+  Pipeline       *pipeline = worker->pipeline;
+  PipelineFrame  *frame;
+
+  while ((frame = g_async_queue_pop (pipeline->queue)) != (gpointer) pipeline)
+    {
+      gegl_node_set (worker->source, "buffer", frame->input, NULL);
+      gegl_node_blit (worker->graph, pipeline->o->scale, &pipeline->bounds,
+                      babl_format ("R'G'B'A u8"), frame->pixels,
+                      GEGL_AUTO_ROWSTRIDE,
+                      GEGL_BLIT_DEFAULT);
+
+      /* the decoder writes the next frame into the same buffer once the slot
+       * is free, whose changes must not reach our graph
+       */
+      gegl_node_set (worker->source, "buffer", NULL, NULL);
+
+      g_mutex_lock (&pipeline->mutex);
+      frame->state = FRAME_PROCESSED;
+      g_cond_broadcast (&pipeline->cond);
+      g_mutex_unlock (&pipeline->mutex);
+    }
+
+  return NULL;
+}
+
+static void
+render_video_pipelined (GeglOptions *o,
+                        GeglNode    *gegl,
+                        const gchar *script,
+                        const gchar *path_root,
+                        GeglNode    *output,
+                        GeglBuffer  *tempb,
+                        gint         duration)
+{
+  Pipeline        pipeline;
+  PipelineWorker *workers;
+  GThread        *decoder;
+  GThread       **threads;
+  GeglOperation  *operation;
+  GeglRectangle   source_bounds;
+  const Babl     *source_format;
+  gint            frame_no;
+  gint            i;
+
+  pipeline.o        = o;
+  pipeline.decoder  = find_source_node (gegl);
+  pipeline.bounds   = *gegl_buffer_get_extent (tempb);
+  pipeline.duration = duration;
+  pipeline.n_slots  = 2 * o->jobs;
+  pipeline.frames   = g_new0 (PipelineFrame, pipeline.n_slots);
+  pipeline.queue    = g_async_queue_new ();
+
+  g_mutex_init (&pipeline.mutex);
+  g_cond_init (&pipeline.cond);
+
+  source_bounds = gegl_node_get_bounding_box (pipeline.decoder);
+
+  /* keep the decoded frames in the decoder's own format, so that no
+   * precision is lost before the rest of the graph sees them.
+   */
+  operation     = gegl_node_get_gegl_operation (pipeline.decoder);
+  source_format = operation ? gegl_operation_get_format (operation, "output")
+                            : NULL;
+  if (! source_format)
+    source_format = babl_format ("R'G'B'A u8");
+
+  for (i = 0; i < pipeline.n_slots; i++)
+    {
+      pipeline.frames[i].input  = gegl_buffer_new (&source_bounds,
+                                                   source_format);
+      pipeline.frames[i].pixels = gegl_malloc (pipeline.bounds.width *
+                                               pipeline.bounds.height * 4);
+    }
+
+  workers = g_new0 (PipelineWorker, o->jobs);
+  threads = g_new0 (GThread *, o->jobs);
+
+  for (i = 0; i < o->jobs; i++)
+    {
+      workers[i].pipeline = &pipeline;
+      workers[i].graph    = pipeline_graph_new (o, script, path_root,
+                                                &workers[i].source);
+    }
+
+  decoder = g_thread_new ("decoder", pipeline_decoder_thread, &pipeline);
+
+  for (i = 0; i < o->jobs; i++)
+    threads[i] = g_thread_new ("worker", pipeline_worker_thread, &workers[i]);
+
+  for (frame_no = 0; frame_no < duration; frame_no++)
+    {
+      PipelineFrame *frame = &pipeline.frames[frame_no % pipeline.n_slots];
+
+      g_mutex_lock (&pipeline.mutex);
+      while (frame->state != FRAME_PROCESSED)
+        g_cond_wait (&pipeline.cond, &pipeline.mutex);
+      g_mutex_unlock (&pipeline.mutex);
+
+      gegl_buffer_set (tempb, &pipeline.bounds, 0.0,
+                       babl_format ("R'G'B'A u8"),
+                       frame->pixels, GEGL_AUTO_ROWSTRIDE);
+
+      if (frame->audio)
+        gegl_node_set (output, "audio", frame->audio, NULL);
+      fprintf (stderr, "\r%i/%i %p", frame_no, duration-1, frame->audio);
+
+      gegl_node_process (output);
+
+      g_clear_object (&frame->audio);
+
+      g_mutex_lock (&pipeline.mutex);
+      frame->state = FRAME_FREE;
+      g_cond_broadcast (&pipeline.cond);
+      g_mutex_unlock (&pipeline.mutex);
+    }
+
+  g_thread_join (decoder);
+  for (i = 0; i < o->jobs; i++)
+    {
+      g_thread_join (threads[i]);
+      g_object_unref (workers[i].graph);
+    }
+
+  for (i = 0; i < pipeline.n_slots; i++)
+    {
+      g_object_unref (pipeline.frames[i].input);
+      gegl_free (pipeline.frames[i].pixels);
+    }
+
+  g_free (threads);
+  g_free (workers);
+  g_free (pipeline.frames);
+  g_async_queue_unref (pipeline.queue);
+  g_mutex_clear (&pipeline.mutex);
+  g_cond_clear (&pipeline.cond);
+}
+
 int mrg_ui_main (int argc, char **argv, char **ops);
 
 gint
@@ -311,26 +629,34 @@ main (gint    argc,
               int duration = 0;
               gegl_node_get (iter, "frames", &duration, NULL);
 
-              while (frame_no < duration)
-              {
-                gegl_node_blit (gegl, o->scale, &bounds,
-                                babl_format("R'G'B'A u8"), temp,
-                                GEGL_AUTO_ROWSTRIDE,
-                                GEGL_BLIT_DEFAULT);
-
-                gegl_buffer_set (tempb, &bounds, 0.0, babl_format ("R'G'B'A u8"),
-                                 temp, GEGL_AUTO_ROWSTRIDE);
-
-                gegl_node_get (iter, "audio", &audio, NULL);
-                if (audio)
-                  gegl_node_set (output, "audio", audio, NULL);
-                fprintf (stderr, "\r%i/%i %p", frame_no, duration-1, audio);
-
-                gegl_node_process (output);
-
-                frame_no ++;
-                gegl_node_set (iter, "frame", frame_no, NULL);
-              }
+              if (o->jobs > 1)
+                {
+                  render_video_pipelined (o, gegl, script, path_root,
+                                          output, tempb, duration);
+                }
+              else
+                {
+                  while (frame_no < duration)
+                  {
+                    gegl_node_blit (gegl, o->scale, &bounds,
+                                    babl_format("R'G'B'A u8"), temp,
+                                    GEGL_AUTO_ROWSTRIDE,
+                                    GEGL_BLIT_DEFAULT);
+
+                    gegl_buffer_set (tempb, &bounds, 0.0, babl_format ("R'G'B'A u8"),
+                                     temp, GEGL_AUTO_ROWSTRIDE);
+
+                    gegl_node_get (iter, "audio", &audio, NULL);
+                    if (audio)
+                      gegl_node_set (output, "audio", audio, NULL);
+                    fprintf (stderr, "\r%i/%i %p", frame_no, duration-1, audio);
+
+                    gegl_node_process (output);
+
+                    frame_no ++;
+                    gegl_node_set (iter, "frame", frame_no, NULL);
+                  }
+                }
               fprintf (stderr, "\n");
             }
             gegl_free (temp);
@@ -102,6 +102,21 @@ void GEGL_SIMD_SUFFIX(gegl_resample_nearest) (guchar              *dst,
 
 GeglDownscale2x2Fun GEGL_SIMD_SUFFIX(gegl_downscale_2x2_get_fun) (const Babl *format);
 
+/* point-sample n locations, given as consecutive x,y pairs, with a linear or
+ * cubic sampler, storing the results in its interpolation format.
+ */
+void GEGL_SIMD_SUFFIX(gegl_sampler_linear_span) (GeglSampler     *self,
+                                                 const gdouble   *coords,
+                                                 gfloat          *output,
+                                                 gint             n,
+                                                 GeglAbyssPolicy  repeat_mode);
+
+void GEGL_SIMD_SUFFIX(gegl_sampler_cubic_span)  (GeglSampler     *self,
+                                                 const gdouble   *coords,
+                                                 gfloat          *output,
+                                                 gint             n,
+                                                 GeglAbyssPolicy  repeat_mode);
+
 #ifdef ARCH_X86_64
 GeglDownscale2x2Fun gegl_downscale_2x2_get_fun_x86_64_v2 (const Babl *format);
 GeglDownscale2x2Fun gegl_downscale_2x2_get_fun_x86_64_v3 (const Babl *format);
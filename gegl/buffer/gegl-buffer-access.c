@@ -2084,6 +2084,8 @@ _gegl_buffer_get_unlocked (GeglBuffer          *buffer,
 
   if (GEGL_FLOAT_EQUAL (scale, 1.0))
     {
+      gegl_buffer_prefetch (buffer, rect, 0);
+
       gegl_buffer_iterate_read_dispatch (buffer, rect, dest_buf, rowstride,
                                          format, 0, repeat_mode);
       return;
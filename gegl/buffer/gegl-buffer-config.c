@@ -35,8 +35,10 @@ enum
 {
   PROP_0,
   PROP_TILE_CACHE_SIZE,
+  PROP_TILE_CACHE_POLICY,
   PROP_SWAP,
   PROP_SWAP_COMPRESSION,
+  PROP_SWAP_IO_THREADS,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_QUEUE_SIZE,
@@ -56,6 +58,10 @@ gegl_buffer_config_get_property (GObject    *gobject,
         g_value_set_uint64 (value, config->tile_cache_size);
         break;
 
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_string (value, config->tile_cache_policy);
+        break;
+
       case PROP_TILE_WIDTH:
         g_value_set_int (value, config->tile_width);
         break;
@@ -72,6 +78,10 @@ gegl_buffer_config_get_property (GObject    *gobject,
         g_value_set_string (value, config->swap_compression);
         break;
 
+      case PROP_SWAP_IO_THREADS:
+        g_value_set_int (value, config->swap_io_threads);
+        break;
+
       case PROP_QUEUE_SIZE:
         g_value_set_int (value, config->queue_size);
         break;
@@ -95,6 +105,10 @@ gegl_buffer_config_set_property (GObject      *gobject,
       case PROP_TILE_CACHE_SIZE:
         config->tile_cache_size = g_value_get_uint64 (value);
         break;
+      case PROP_TILE_CACHE_POLICY:
+        g_free (config->tile_cache_policy);
+        config->tile_cache_policy = g_value_dup_string (value);
+        break;
       case PROP_TILE_WIDTH:
         config->tile_width = g_value_get_int (value);
         break;
@@ -112,6 +126,9 @@ gegl_buffer_config_set_property (GObject      *gobject,
         g_free (config->swap_compression);
         config->swap_compression = g_value_dup_string (value);
         break;
+      case PROP_SWAP_IO_THREADS:
+        config->swap_io_threads = g_value_get_int (value);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -125,6 +142,7 @@ gegl_buffer_config_finalize (GObject *gobject)
 
   g_free (config->swap);
   g_free (config->swap_compression);
+  g_free (config->tile_cache_policy);
 
   G_OBJECT_CLASS (gegl_buffer_config_parent_class)->finalize (gobject);
 }
@@ -168,6 +186,15 @@ gegl_buffer_config_class_init (GeglBufferConfigClass *klass)
                                                         G_PARAM_CONSTRUCT |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_string ("tile-cache-policy",
+                                                        "Tile Cache policy",
+                                                        "eviction policy of the tile cache: lru, 2q or cost",
+                                                        "lru",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT |
+                                                        G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_SWAP,
                                    g_param_spec_string ("swap",
                                                         "Swap",
@@ -186,6 +213,15 @@ gegl_buffer_config_class_init (GeglBufferConfigClass *klass)
                                                         G_PARAM_CONSTRUCT |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_IO_THREADS,
+                                   g_param_spec_int ("swap-io-threads",
+                                                     "Swap I/O threads",
+                                                     "Number of threads serving swap reads and writes",
+                                                     1, 16, 2,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT |
+                                                     G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
                                    g_param_spec_int ("queue-size",
                                                      "Queue size",
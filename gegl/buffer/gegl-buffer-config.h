@@ -45,7 +45,9 @@ struct _GeglBufferConfig
 
   gchar   *swap;
   gchar   *swap_compression;
+  gint     swap_io_threads;
   guint64  tile_cache_size;
+  gchar   *tile_cache_policy;
   gint     tile_width;
   gint     tile_height;
   gint     queue_size;
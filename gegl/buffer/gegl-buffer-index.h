@@ -10,6 +10,11 @@ GeglBuffer on disk representation
 
 /* Increase this number when the structures change.*/
 #define GEGL_FILE_SPEC_REV     0
+
+/* the revision of the format with a contiguous tile index and compressed
+ * tiles, see GeglBufferIndex below.
+ */
+#define GEGL_FILE_SPEC_REV_V2  1
 #define GEGL_MAGIC             {'G','E','G','L'}
 
 #define GEGL_FLAG_TILE         1
@@ -18,6 +23,9 @@ GeglBuffer on disk representation
 /* a VOID message, indicating that the specified tile has been rewritten */
 #define GEGL_FLAG_INVALIDATED  2
 
+/* a contiguous array of tile entries, used by GEGL_FILE_SPEC_REV_V2 */
+#define GEGL_FLAG_TILE_INDEX   3
+
 /* these flags are used for the header, the lower bits of the
  * header store the revision
  */
@@ -32,6 +40,9 @@ GeglBuffer on disk representation
 #define  GEGL_FLAG_HEADER    (GEGL_FLAG_FLUSHED  |\
                               GEGL_FLAG_IS_HEADER|\
                               GEGL_FILE_SPEC_REV)
+#define  GEGL_FLAG_HEADER_V2 (GEGL_FLAG_FLUSHED  |\
+                              GEGL_FLAG_IS_HEADER|\
+                              GEGL_FILE_SPEC_REV_V2)
 
 /*
  * This header is the first 256 bytes of the GEGL buffer.
@@ -59,7 +70,15 @@ typedef struct {
 
   guint32 rev;             /* if it changes on disk it means the index has changed */
 
-  gint32  padding[36];     /* Pad the structure to be 256 bytes long */
+  /* the following fields are only used by GEGL_FILE_SPEC_REV_V2 */
+  gchar   compression[16]; /* the name of the GeglCompression algorithm
+                            * compressed tiles are stored with, "" if none
+                            */
+  guint32 n_levels;        /* the number of stored mipmap levels, including
+                            * level 0
+                            */
+
+  gint32  padding[31];     /* Pad the structure to be 256 bytes long */
 } GeglBufferHeader;
 
 /* the revision of the format is stored in the flags of the header in the
@@ -99,6 +118,32 @@ typedef struct {
                             own state when revision differs. */
 } GeglBufferTile;
 
+/* In GEGL_FILE_SPEC_REV_V2, the header's next offset points to a single
+ * GeglBufferIndex block, immediately followed by n_tiles GeglBufferTileV2
+ * entries, so that the whole index can be read at once.  The block's length
+ * covers the entries as well.
+ */
+
+/* the entries are sorted by z, y and x */
+#define GEGL_INDEX_SORTED      1
+
+typedef struct {
+  GeglBufferBlock block; /* flags is GEGL_FLAG_TILE_INDEX, next is 0       */
+  guint32 n_tiles;       /* number of entries following the block          */
+  guint32 flags;         /* GEGL_INDEX_SORTED                              */
+} GeglBufferIndex;
+
+typedef struct {
+  guint64 offset;        /* offset into file for this tile             */
+  gint32  x;             /* upperleft of tile % tile_width coordinates */
+  gint32  y;
+  gint32  z;             /* mipmap subdivision level of tile (0=100%)  */
+  guint32 size;          /* stored size of the tile data, the tile is
+                            compressed if it is smaller than the tile size */
+  guint32 rev;           /* revision, as in GeglBufferTile             */
+  guint32 padding;
+} GeglBufferTileV2;
+
 /* A convenience union to allow quick and simple casting */
 typedef union {
   guint32          length;
@@ -129,6 +174,13 @@ GeglBufferItem *gegl_buffer_read_header(int      i,
 GList          *gegl_buffer_read_index (int      i,
                                         goffset *offset);
 
+/* reads a GEGL_FILE_SPEC_REV_V2 index at offset, returning the array of
+ * entries, or NULL if there is none.
+ */
+GeglBufferTileV2 *gegl_buffer_read_index_v2 (int      i,
+                                             goffset  offset,
+                                             gint    *n_tiles);
+
 #define struct_check_padding(type, size) \
   if (sizeof (type) != size) \
     {\
@@ -141,7 +193,9 @@ GList          *gegl_buffer_read_index (int      i,
     }
 #define GEGL_BUFFER_STRUCT_CHECK_PADDING \
   {struct_check_padding (GeglBufferBlock, 16);\
-  struct_check_padding (GeglBufferHeader, 256);}
+  struct_check_padding (GeglBufferHeader, 256);\
+  struct_check_padding (GeglBufferIndex, 24);\
+  struct_check_padding (GeglBufferTileV2, 32);}
 #define GEGL_BUFFER_SANITY {static gboolean done=FALSE;if(!done){GEGL_BUFFER_STRUCT_CHECK_PADDING;done=TRUE;}}
 
 #endif
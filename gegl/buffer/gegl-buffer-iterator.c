@@ -562,6 +562,10 @@ prepare_iteration (GeglBufferIterator *iter)
             }
         }
 
+      /* Let the backend start reading the tiles we're about to fetch */
+      if (sub->access_mode & GEGL_ACCESS_READ)
+        gegl_buffer_prefetch (buf, &sub->full_rect, sub->level);
+
       /* Format converison needed */
       if (gegl_buffer_get_format (sub->buffer) != sub->format)
         sub->access_mode |= GEGL_ITERATOR_INCOMPATIBLE;
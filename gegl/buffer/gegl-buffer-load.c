@@ -29,10 +29,15 @@
 #include "gegl-buffer.h"
 #include "gegl-buffer-private.h"
 #include "gegl-buffer-index.h"
+#include "gegl-compression.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-backend-mmap.h"
+#include "gegl-tile-handler-cache.h"
 #include "gegl-debug.h"
 
 #include <glib/gprintf.h>
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 
 #ifdef G_OS_WIN32
 #define BINARY_FLAG O_BINARY
@@ -228,6 +233,57 @@ gegl_buffer_read_index (int           i,
   return ret;
 }
 
+GeglBufferTileV2 *
+gegl_buffer_read_index_v2 (int      i,
+                           goffset  offset,
+                           gint    *n_tiles)
+{
+  GeglBufferIndex   index;
+  GeglBufferTileV2 *tiles;
+  gsize             size;
+
+  *n_tiles = 0;
+
+  if (offset == 0)
+    return NULL;
+
+  if (lseek (i, offset, SEEK_SET) == -1)
+    {
+      g_warning ("failed seeking to %i", (gint) offset);
+      return NULL;
+    }
+
+  if (read (i, &index, sizeof (GeglBufferIndex)) != sizeof (GeglBufferIndex) ||
+      index.block.flags != GEGL_FLAG_TILE_INDEX)
+    {
+      g_warning ("failed reading tile index");
+      return NULL;
+    }
+
+  size = (gsize) index.n_tiles * sizeof (GeglBufferTileV2);
+
+  if (index.block.length < sizeof (GeglBufferIndex) + size)
+    {
+      g_warning ("tile index is truncated");
+      return NULL;
+    }
+
+  tiles = g_malloc (size);
+
+  if (read (i, tiles, size) != (gssize) size)
+    {
+      g_warning ("failed reading tile index");
+      g_free (tiles);
+      return NULL;
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "read index of %i tiles", index.n_tiles);
+
+  *n_tiles = index.n_tiles;
+
+  return tiles;
+}
+
 
 static void sanity(void) { GEGL_BUFFER_SANITY; }
 
@@ -246,8 +302,179 @@ gegl_buffer_open (const gchar *path)
                        NULL);
 }
 
+GeglBuffer *
+gegl_buffer_open_mapped (const gchar *path)
+{
+  GeglTileBackend *backend;
+  GeglBuffer      *buffer;
+  GeglBufferItem  *item;
+  const Babl      *format;
+  int              i;
+
+  sanity();
+
+  i = g_open (path, O_RDONLY|BINARY_FLAG, 0);
+  if (i == -1)
+    {
+      g_warning ("%s: Could not open '%s': %s", G_STRFUNC, path, g_strerror (errno));
+      return NULL;
+    }
+
+  item = gegl_buffer_read_header (i, NULL);
+  close (i);
+
+  if (memcmp (item->header.magic, "GEGL", 4))
+    {
+      g_free (item);
+      return NULL;
+    }
+
+  format = babl_format (item->header.description);
+
+  backend = g_object_new (GEGL_TYPE_TILE_BACKEND_MMAP,
+                          "tile-width",  item->header.tile_width,
+                          "tile-height", item->header.tile_height,
+                          "format",      format,
+                          "path",        path,
+                          NULL);
+  g_free (item);
+
+  buffer = gegl_buffer_new_for_backend (NULL, backend);
+  g_object_unref (backend);
+
+  return buffer;
+}
+
+/* reads the tiles of a GEGL_FILE_SPEC_REV_V2 file, in file order, and inserts
+ * them into the cache of buffer.  fails if the file's compression algorithm
+ * isn't available, or its index can't be read.
+ */
+static gboolean
+gegl_buffer_load_v2 (LoadInfo    *info,
+                     GeglBuffer  *buffer,
+                     GError     **error)
+{
+  const GeglCompression *compression = NULL;
+  GeglBufferTileV2      *tiles;
+  guchar                *compressed;
+  gint                   n_tiles;
+  gint                   bpp;
+  gint                   i;
+
+  if (info->header.compression[0])
+    {
+      gchar name[sizeof (info->header.compression) + 1] = "";
+
+      memcpy (name, info->header.compression, sizeof (info->header.compression));
+
+      compression = gegl_compression (name);
+
+      if (! compression)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "%s: unknown compression algorithm '%s'",
+                       info->path, name);
+          return FALSE;
+        }
+    }
+
+  tiles = gegl_buffer_read_index_v2 (info->i, info->header.next, &n_tiles);
+
+  if (! tiles)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "%s: failed reading tile index", info->path);
+      return FALSE;
+    }
+
+  info->offset = -1;
+  bpp          = info->header.bytes_per_pixel;
+  compressed   = gegl_scratch_alloc (info->tile_size);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GeglBufferTileV2 *entry = &tiles[i];
+      GeglTile         *tile;
+      gboolean          success;
+
+      if (entry->size > info->tile_size ||
+          (entry->size < info->tile_size && ! compression))
+        {
+          g_warning ("%s: bad tile size %u", info->path, entry->size);
+          continue;
+        }
+
+      if (info->offset != entry->offset)
+        seekto (info, entry->offset);
+
+      tile = gegl_tile_new (info->tile_size);
+      gegl_tile_lock (tile);
+
+      if (entry->size == info->tile_size)
+        {
+          success = read (info->i, gegl_tile_get_data (tile),
+                          entry->size) == (gssize) entry->size;
+        }
+      else
+        {
+          success = read (info->i, compressed,
+                          entry->size) == (gssize) entry->size &&
+                    gegl_compression_decompress (compression, info->format,
+                                                 gegl_tile_get_data (tile),
+                                                 info->tile_size / bpp,
+                                                 compressed, entry->size);
+        }
+
+      gegl_tile_unlock (tile);
+
+      if (success)
+        {
+          info->offset += entry->size;
+
+          gegl_tile_handler_cache_insert (buffer->tile_storage->cache, tile,
+                                          entry->x, entry->y, entry->z);
+        }
+      else
+        {
+          g_warning ("%s: failed reading tile %i,%i,%i", info->path,
+                     entry->x, entry->y, entry->z);
+
+          info->offset = -1;
+        }
+
+      gegl_tile_unref (tile);
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "%i tiles loaded", n_tiles);
+
+  gegl_scratch_free (compressed);
+  g_free (tiles);
+
+  return TRUE;
+}
+
 GeglBuffer *
 gegl_buffer_load (const gchar *path)
+{
+  GeglBuffer *ret;
+  GError     *error = NULL;
+
+  ret = gegl_buffer_load_with_error (path, &error);
+
+  /* missing files are expected, and only reported by returning NULL */
+  if (error && error->domain != G_FILE_ERROR)
+    {
+      g_warning ("%s", error->message);
+    }
+
+  g_clear_error (&error);
+
+  return ret;
+}
+
+GeglBuffer *
+gegl_buffer_load_with_error (const gchar  *path,
+                             GError      **error)
 {
   GeglBuffer *ret;
 
@@ -258,7 +485,12 @@ gegl_buffer_load (const gchar *path)
   GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "starting to load buffer %s", path);
   if (info->i == -1)
     {
+      gint errsv = errno;
+
       GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "failed to open %s for reading", path);
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "%s: %s", path, g_strerror (errsv));
+      load_info_destroy (info);
       return NULL;
     }
 
@@ -289,6 +521,15 @@ gegl_buffer_load (const gchar *path)
   */
   g_assert (babl_format_get_bytes_per_pixel (info->format) == info->header.bytes_per_pixel);
 
+  if (gegl_buffer_header_get_rev (&info->header) == GEGL_FILE_SPEC_REV_V2)
+    {
+      if (! gegl_buffer_load_v2 (info, ret, error))
+        g_clear_object (&ret);
+
+      load_info_destroy (info);
+      return ret;
+    }
+
   info->tiles = gegl_buffer_read_index (info->i, &info->offset);
 
   /* load each tile */
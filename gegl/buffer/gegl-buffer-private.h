@@ -132,6 +132,13 @@ void              gegl_buffer_get_unlocked (GeglBuffer          *buffer,
 GeglBuffer *      gegl_buffer_new_ram     (const GeglRectangle *extent,
                                            const Babl          *format);
 
+/* announces that the tiles of @buffer covering @roi, at @level, are about to
+ * be fetched, letting the backend start reading them in the background.
+ */
+void              gegl_buffer_prefetch    (GeglBuffer          *buffer,
+                                           const GeglRectangle *roi,
+                                           gint                 level);
+
 void              gegl_buffer_emit_changed_signal (GeglBuffer *buffer,
                                                    const GeglRectangle *rect);
 
@@ -254,6 +261,18 @@ extern void (*gegl_downscale_2x2) (const Babl *format,
                                    guchar     *dst_data,
                                    gint        dst_rowstride);
 
+extern void (*gegl_sampler_linear_span) (GeglSampler     *self,
+                                         const gdouble   *coords,
+                                         gfloat          *output,
+                                         gint             n,
+                                         GeglAbyssPolicy  repeat_mode);
+
+extern void (*gegl_sampler_cubic_span)  (GeglSampler     *self,
+                                         const gdouble   *coords,
+                                         gfloat          *output,
+                                         gint             n,
+                                         GeglAbyssPolicy  repeat_mode);
+
 
 #ifndef __GEGL_TILE_H__
 #define gegl_tile_get_data(tile)  ((tile)->data)
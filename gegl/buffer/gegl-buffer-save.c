@@ -36,6 +36,8 @@
 #include "gegl-tile-storage.h"
 #include "gegl-tile.h"
 #include "gegl-buffer-index.h"
+#include "gegl-compression.h"
+#include "gegl-memory-private.h"
 
 #ifdef G_OS_WIN32
 #define BINARY_FLAG O_BINARY
@@ -43,6 +45,11 @@
 #define BINARY_FLAG 0
 #endif
 
+/* the maximal number of mipmap levels stored by gegl_buffer_save_compressed(),
+ * in addition to level 0.
+ */
+#define MAX_LEVELS 8
+
 typedef struct
 {
   GeglBufferHeader header;
@@ -374,3 +381,280 @@ gegl_buffer_save (GeglBuffer          *buffer,
   }
   save_info_destroy (info);
 }
+
+
+static gint
+tile_v2_compare (gconstpointer a,
+                 gconstpointer b)
+{
+  const GeglBufferTileV2 *entryA = a;
+  const GeglBufferTileV2 *entryB = b;
+
+  if (entryA->z != entryB->z)
+    return entryA->z - entryB->z;
+  if (entryA->y != entryB->y)
+    return entryA->y - entryB->y;
+
+  return entryA->x - entryB->x;
+}
+
+static gboolean
+write_all (gint          o,
+           gconstpointer data,
+           gsize         length)
+{
+  const gchar *p = data;
+
+  while (length > 0)
+    {
+      gssize ret = write (o, p, length);
+
+      if (ret <= 0)
+        return FALSE;
+
+      p      += ret;
+      length -= ret;
+    }
+
+  return TRUE;
+}
+
+/* collects the tiles of level z, which are the parents of the tiles of
+ * level z - 1 in tiles.
+ */
+static void
+collect_level_tiles (GArray *tiles,
+                     gint    z)
+{
+  GHashTable *parents = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                               g_free, NULL);
+  guint       n       = tiles->len;
+  guint       i;
+
+  for (i = 0; i < n; i++)
+    {
+      GeglBufferTileV2 *child = &g_array_index (tiles, GeglBufferTileV2, i);
+      GeglBufferTileV2  entry = { 0, };
+      gint64           *key;
+
+      if (child->z != z - 1)
+        continue;
+
+      entry.x = gegl_tile_indice (child->x, 2);
+      entry.y = gegl_tile_indice (child->y, 2);
+      entry.z = z;
+
+      key  = g_new (gint64, 1);
+      *key = ((gint64) entry.x << 32) | (guint32) entry.y;
+
+      if (! g_hash_table_add (parents, key))
+        continue;
+
+      g_array_append_val (tiles, entry);
+    }
+
+  g_hash_table_unref (parents);
+}
+
+void
+gegl_buffer_save_compressed (GeglBuffer          *buffer,
+                             const gchar         *path,
+                             const GeglRectangle *roi,
+                             const gchar         *compression,
+                             gint                 levels)
+{
+  GeglBufferHeader        header = { { 0, }, };
+  GeglBufferIndex         index  = { { 0, }, };
+  const GeglCompression  *algorithm = NULL;
+  const Babl             *format;
+  GArray                 *tiles;
+  guchar                 *compressed = NULL;
+  gint                    bpp;
+  gint                    tile_width;
+  gint                    tile_height;
+  gint                    tile_size;
+  goffset                 offset;
+  gint                    o;
+  gint                    z;
+  guint                   i;
+
+  GEGL_BUFFER_SANITY;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (path != NULL);
+
+  if (! roi)
+    roi = &buffer->extent;
+
+  levels = CLAMP (levels, 0, MAX_LEVELS);
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
+             "starting to save compressed buffer %s, roi: %d,%d %dx%d",
+             path, roi->x, roi->y, roi->width, roi->height);
+
+#ifndef G_OS_WIN32
+  o = g_open (path, O_RDWR|O_CREAT|O_TRUNC|BINARY_FLAG, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+#else
+  o = g_open (path, O_RDWR|O_CREAT|O_TRUNC|BINARY_FLAG, S_IRUSR|S_IWUSR);
+#endif
+
+  if (o == -1)
+    {
+      g_warning ("%s: Could not open '%s': %s", G_STRFUNC, path, g_strerror(errno));
+      return;
+    }
+
+  if (compression && *compression)
+    {
+      algorithm = gegl_compression (compression);
+
+      if (! algorithm)
+        g_warning ("%s: unknown compression algorithm '%s', storing "
+                   "uncompressed tiles", G_STRFUNC, compression);
+      else if (algorithm == gegl_compression ("nop"))
+        algorithm = NULL;
+    }
+
+  format      = buffer->tile_storage->format;
+  tile_width  = buffer->tile_storage->tile_width;
+  tile_height = buffer->tile_storage->tile_height;
+  bpp         = babl_format_get_bytes_per_pixel (format);
+  tile_size   = tile_width * tile_height * bpp;
+
+  header.x      = roi->x;
+  header.y      = roi->y;
+  header.width  = roi->width;
+  header.height = roi->height;
+  gegl_buffer_header_init (&header, tile_width, tile_height, bpp, format);
+  header.flags    = GEGL_FLAG_HEADER_V2;
+  header.next     = sizeof (GeglBufferHeader);
+  header.n_levels = levels + 1;
+
+  if (algorithm)
+    {
+      g_strlcpy (header.compression, gegl_compression_get_name (algorithm),
+                 sizeof (header.compression));
+
+      compressed = gegl_scratch_alloc (tile_size);
+    }
+
+  /* collect the stored tiles of level 0, and their parents in the
+   * following levels.
+   */
+  tiles = g_array_new (FALSE, TRUE, sizeof (GeglBufferTileV2));
+
+  if (roi->width > 0 && roi->height > 0)
+    {
+      gint x0 = gegl_tile_indice (roi->x + buffer->shift_x, tile_width);
+      gint y0 = gegl_tile_indice (roi->y + buffer->shift_y, tile_height);
+      gint x1 = gegl_tile_indice (roi->x + buffer->shift_x + roi->width - 1,
+                                  tile_width);
+      gint y1 = gegl_tile_indice (roi->y + buffer->shift_y + roi->height - 1,
+                                  tile_height);
+      gint tx;
+      gint ty;
+
+      for (ty = y0; ty <= y1; ty++)
+        for (tx = x0; tx <= x1; tx++)
+          {
+            if (gegl_tile_source_exist (GEGL_TILE_SOURCE (buffer), tx, ty, 0))
+              {
+                GeglBufferTileV2 entry = { 0, };
+
+                entry.x = tx;
+                entry.y = ty;
+
+                g_array_append_val (tiles, entry);
+              }
+          }
+    }
+
+  for (z = 1; z <= levels; z++)
+    collect_level_tiles (tiles, z);
+
+  g_array_sort (tiles, tile_v2_compare);
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
+             "number of tiles to be written: %d", tiles->len);
+
+  index.block.flags  = GEGL_FLAG_TILE_INDEX;
+  index.block.length = sizeof (GeglBufferIndex) +
+                       tiles->len * sizeof (GeglBufferTileV2);
+  index.block.next   = 0;
+  index.n_tiles      = tiles->len;
+  index.flags        = GEGL_INDEX_SORTED;
+
+  /* the index is written once the tiles have been, and their offsets and
+   * sizes are known.
+   */
+  offset = header.next + index.block.length;
+
+  if (lseek (o, offset, SEEK_SET) == -1)
+    g_warning ("%s: failed seeking in '%s'", G_STRFUNC, path);
+
+  for (i = 0; i < tiles->len; i++)
+    {
+      GeglBufferTileV2 *entry = &g_array_index (tiles, GeglBufferTileV2, i);
+      GeglTile         *tile;
+      const guchar     *data;
+      gint              size  = tile_size;
+
+      tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (buffer),
+                                        entry->x, entry->y, entry->z);
+      g_assert (tile);
+
+      data = gegl_tile_get_data (tile);
+
+      /* tiles that don't compress to less than the tile size are stored
+       * as is.
+       */
+      if (algorithm &&
+          gegl_compression_compress (algorithm, format,
+                                     data, tile_size / bpp,
+                                     compressed, &size, tile_size - 1))
+        {
+          data = compressed;
+        }
+      else
+        {
+          size = tile_size;
+
+          /* align uncompressed tile data, so that it can be used in place
+           * when the file is mapped into memory.
+           */
+          if (offset != GEGL_ALIGN (offset))
+            {
+              offset = GEGL_ALIGN (offset);
+
+              if (lseek (o, offset, SEEK_SET) == -1)
+                g_warning ("%s: failed seeking in '%s'", G_STRFUNC, path);
+            }
+        }
+
+      entry->offset = offset;
+      entry->size   = size;
+      entry->rev    = gegl_tile_get_rev (tile);
+
+      if (! write_all (o, data, size))
+        g_warning ("%s: failed writing to '%s'", G_STRFUNC, path);
+
+      offset += size;
+
+      gegl_tile_unref (tile);
+    }
+
+  if (lseek (o, 0, SEEK_SET) == -1                              ||
+      ! write_all (o, &header, sizeof (GeglBufferHeader))       ||
+      ! write_all (o, &index, sizeof (GeglBufferIndex))         ||
+      ! write_all (o, tiles->data,
+                   tiles->len * sizeof (GeglBufferTileV2)))
+    {
+      g_warning ("%s: failed writing index to '%s'", G_STRFUNC, path);
+    }
+
+  if (compressed)
+    gegl_scratch_free (compressed);
+
+  g_array_free (tiles, TRUE);
+  close (o);
+}
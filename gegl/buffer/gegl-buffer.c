@@ -1301,6 +1301,54 @@ gegl_buffer_get_tile (GeglBuffer *buffer,
   return tile;
 }
 
+void
+gegl_buffer_prefetch (GeglBuffer          *buffer,
+                      const GeglRectangle *roi,
+                      gint                 level)
+{
+  GeglRectangle abyss;
+  GeglRectangle rect;
+  GeglRectangle tiles;
+  gint          x1, y1;
+  gint          x2, y2;
+
+  /* only the swap and file backends can read ahead; don't take the storage
+   * mutex for nothing, which would serialize the readers of ram buffers
+   */
+  if (! buffer->tile_storage->can_prefetch)
+    return;
+
+  /* roi is in the coordinates of level */
+  abyss.x      = buffer->abyss.x >> level;
+  abyss.y      = buffer->abyss.y >> level;
+  abyss.width  = ((buffer->abyss.x + buffer->abyss.width  +
+                   (1 << level) - 1) >> level) - abyss.x;
+  abyss.height = ((buffer->abyss.y + buffer->abyss.height +
+                   (1 << level) - 1) >> level) - abyss.y;
+
+  if (! gegl_rectangle_intersect (&rect, roi, &abyss))
+    return;
+
+  x1 = gegl_tile_indice (rect.x + buffer->shift_x, buffer->tile_width);
+  y1 = gegl_tile_indice (rect.y + buffer->shift_y, buffer->tile_height);
+  x2 = gegl_tile_indice (rect.x + rect.width  - 1 + buffer->shift_x,
+                         buffer->tile_width);
+  y2 = gegl_tile_indice (rect.y + rect.height - 1 + buffer->shift_y,
+                         buffer->tile_height);
+
+  /* a single tile is going to be fetched right away */
+  if (x1 == x2 && y1 == y2)
+    return;
+
+  gegl_rectangle_set (&tiles, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+  g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+  gegl_tile_source_prefetch (GEGL_TILE_SOURCE (buffer), &tiles, level);
+
+  g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+}
+
 void (*gegl_tile_handler_cache_ext_flush) (void *cache, const GeglRectangle *rect)=NULL;
 void (*gegl_buffer_ext_flush) (GeglBuffer *buffer, const GeglRectangle *rect)=NULL;
 void (*gegl_buffer_ext_invalidate) (GeglBuffer *buffer, const GeglRectangle *rect)=NULL;
@@ -1346,6 +1394,20 @@ void (*gegl_downscale_2x2) (const Babl *format,
                             gint        dst_rowstride) =
       gegl_downscale_2x2_generic;
 
+void (*gegl_sampler_linear_span) (GeglSampler     *self,
+                                  const gdouble   *coords,
+                                  gfloat          *output,
+                                  gint             n,
+                                  GeglAbyssPolicy  repeat_mode) =
+      gegl_sampler_linear_span_generic;
+
+void (*gegl_sampler_cubic_span)  (GeglSampler     *self,
+                                  const gdouble   *coords,
+                                  gfloat          *output,
+                                  gint             n,
+                                  GeglAbyssPolicy  repeat_mode) =
+      gegl_sampler_cubic_span_generic;
+
 
 #define GEGL_VARIANTS(variant) \
 void gegl_resample_nearest_##variant   (guchar              *dest_buf,     \
@@ -1378,7 +1440,17 @@ void gegl_downscale_2x2_##variant      (const Babl          *format,       \
                                         guchar              *src_data,     \
                                         gint                 src_rowstride,\
                                         guchar              *dst_data,     \
-                                        gint                 dst_rowstride);
+                                        gint                 dst_rowstride); \
+void gegl_sampler_linear_span_##variant (GeglSampler        *self,         \
+                                        const gdouble       *coords,       \
+                                        gfloat              *output,       \
+                                        gint                 n,            \
+                                        GeglAbyssPolicy      repeat_mode); \
+void gegl_sampler_cubic_span_##variant (GeglSampler         *self,         \
+                                        const gdouble       *coords,       \
+                                        gfloat              *output,       \
+                                        gint                 n,            \
+                                        GeglAbyssPolicy      repeat_mode);
 
 #include "gegl-variants.inc"
 //GEGL_VARIANTS(generic)
@@ -1422,6 +1494,8 @@ void _gegl_init_buffer (int variant)
     gegl_resample_boxfilter = gegl_resample_boxfilter_arm_neon;
     gegl_resample_nearest   = gegl_resample_nearest_arm_neon;
     gegl_downscale_2x2      = gegl_downscale_2x2_arm_neon;
+    gegl_sampler_linear_span = gegl_sampler_linear_span_arm_neon;
+    gegl_sampler_cubic_span  = gegl_sampler_cubic_span_arm_neon;
   }
 #endif
 #ifdef ARCH_X86_64
@@ -1434,12 +1508,16 @@ void _gegl_init_buffer (int variant)
       gegl_resample_boxfilter = gegl_resample_boxfilter_x86_64_v2;
       gegl_resample_nearest   = gegl_resample_nearest_x86_64_v2;
       gegl_downscale_2x2      = gegl_downscale_2x2_x86_64_v2;
+      gegl_sampler_linear_span = gegl_sampler_linear_span_x86_64_v2;
+      gegl_sampler_cubic_span  = gegl_sampler_cubic_span_x86_64_v2;
       break;
     case 3:
       gegl_resample_bilinear  = gegl_resample_bilinear_x86_64_v3;
       gegl_resample_boxfilter = gegl_resample_boxfilter_x86_64_v3;
       gegl_resample_nearest   = gegl_resample_nearest_x86_64_v3;
       gegl_downscale_2x2      = gegl_downscale_2x2_x86_64_v3;
+      gegl_sampler_linear_span = gegl_sampler_linear_span_x86_64_v3;
+      gegl_sampler_cubic_span  = gegl_sampler_cubic_span_x86_64_v3;
       break;
   }
 #endif
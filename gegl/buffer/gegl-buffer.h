@@ -114,6 +114,24 @@ void           gegl_buffer_remove_handler     (GeglBuffer          *buffer,
  */
 GeglBuffer *    gegl_buffer_open              (const gchar         *path);
 
+/**
+ * gegl_buffer_open_mapped:
+ * @path: the path to a gegl buffer on disk.
+ *
+ * Open an existing on-disk GeglBuffer read-only, by mapping the file into
+ * memory.  Tiles are read directly from the mapping, so that opening the file
+ * only reads its tile index, and so that all processes opening the same file
+ * share a single copy of its data.  Modifications to the returned buffer are
+ * kept in memory, and are never written back to the file.
+ *
+ * Compressed tiles, as written by gegl_buffer_save_compressed(), are decoded
+ * on access, rather than read in place.
+ *
+ * Returns: (transfer full) (nullable): a GeglBuffer object, or %NULL if the
+ * file can't be opened.
+ */
+GeglBuffer *    gegl_buffer_open_mapped       (const gchar         *path);
+
 /**
  * gegl_buffer_save:
  * @buffer: (transfer none): a #GeglBuffer.
@@ -127,6 +145,29 @@ void            gegl_buffer_save              (GeglBuffer          *buffer,
                                                const gchar         *path,
                                                const GeglRectangle *roi);
 
+/**
+ * gegl_buffer_save_compressed:
+ * @buffer: (transfer none): a #GeglBuffer.
+ * @path: the path where the gegl buffer will be saved.
+ * @roi: the region of interest to write, this is the tiles that will be collected and
+ * written to disk.
+ * @compression: (nullable): the name of the compression algorithm tiles are
+ * stored with, as in the "swap-compression" property of #GeglConfig, or %NULL
+ * to store uncompressed tiles.
+ * @levels: the number of mipmap levels to store in addition to the full
+ * resolution one.
+ *
+ * Write a GeglBuffer to a file, in the second version of the format, which
+ * stores the tile index contiguously, and compresses the tiles.  Such files
+ * can be read by gegl_buffer_load() and gegl_buffer_open(), but not by
+ * versions of GEGL predating this function.
+ */
+void            gegl_buffer_save_compressed   (GeglBuffer          *buffer,
+                                               const gchar         *path,
+                                               const GeglRectangle *roi,
+                                               const gchar         *compression,
+                                               gint                 levels);
+
 /**
  * gegl_buffer_load:
  * @path: the path to a gegl buffer on disk.
@@ -139,6 +180,20 @@ void            gegl_buffer_save              (GeglBuffer          *buffer,
  */
 GeglBuffer *     gegl_buffer_load             (const gchar         *path);
 
+/**
+ * gegl_buffer_load_with_error:
+ * @path: the path to a gegl buffer on disk.
+ * @error: return location for an error, or %NULL
+ *
+ * Like gegl_buffer_load(), but reports why a buffer couldn't be loaded,
+ * for example when the file was compressed using an algorithm this build
+ * of GEGL doesn't support.
+ *
+ * Returns: (transfer full) (nullable): a #GeglBuffer object, or %NULL.
+ */
+GeglBuffer *     gegl_buffer_load_with_error  (const gchar         *path,
+                                               GError             **error);
+
 /**
  * gegl_buffer_flush:
  * @buffer: a #GeglBuffer
@@ -579,6 +634,55 @@ void              gegl_sampler_get            (GeglSampler       *sampler,
                                                void              *output,
                                                GeglAbyssPolicy   repeat_mode);
 
+/**
+ * gegl_sampler_get_span:
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @x: x coordinate of the first sample
+ * @y: y coordinate of the first sample
+ * @dx: x step between successive samples
+ * @dy: y step between successive samples
+ * @scale: matrix representing extent of sampling area in source buffer,
+ * common to all samples.
+ * @output: memory location for output data, room for @n pixels.
+ * @n: number of samples
+ * @repeat_mode: how requests outside the buffer extent are handled.
+ *
+ * Perform @n samplings with the provided @sampler, along the line starting
+ * at @x,@y and advancing by @dx,@dy; the result is the same as calling
+ * gegl_sampler_get() for each of the coordinates, but the pixels are sampled,
+ * and converted to the sampler's format, in batches.
+ */
+void              gegl_sampler_get_span       (GeglSampler       *sampler,
+                                               gdouble            x,
+                                               gdouble            y,
+                                               gdouble            dx,
+                                               gdouble            dy,
+                                               GeglBufferMatrix2 *scale,
+                                               void              *output,
+                                               gint               n,
+                                               GeglAbyssPolicy    repeat_mode);
+
+/**
+ * gegl_sampler_get_points:
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @coords: (array): @n pairs of x,y coordinates to sample
+ * @scale: matrix representing extent of sampling area in source buffer,
+ * common to all samples.
+ * @output: memory location for output data, room for @n pixels.
+ * @n: number of samples
+ * @repeat_mode: how requests outside the buffer extent are handled.
+ *
+ * Perform @n samplings with the provided @sampler, at arbitrary
+ * coordinates; the result is the same as calling gegl_sampler_get() for each
+ * of them.
+ */
+void              gegl_sampler_get_points     (GeglSampler       *sampler,
+                                               const gdouble     *coords,
+                                               GeglBufferMatrix2 *scale,
+                                               void              *output,
+                                               gint               n,
+                                               GeglAbyssPolicy    repeat_mode);
+
 /* code template utility, updates the jacobian matrix using
  * a user defined mapping function for displacement, example
  * with an identity transform (note that for the identity
@@ -0,0 +1,117 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl-compression-filter.h"
+
+
+/* a reversible pre-filter for the general-purpose codecs.  the pixels are
+ * split into byte planes -- all the first bytes of each pixel, followed by
+ * all the second bytes, etc. -- like the rle codecs do per bit plane, so that
+ * similar bytes end up next to each other.  for integer formats, each plane
+ * is additionally delta-coded, turning smooth gradients into runs of small
+ * values.  floating-point planes are only shuffled, since their low mantissa
+ * bytes are effectively noise, which delta-coding only spreads further.
+ *
+ * the loops are kept simple and branch-free, so that the compiler can
+ * vectorize them.
+ */
+
+
+/*  local function prototypes  */
+
+static gboolean   gegl_compression_filter_use_delta (const Babl *format);
+
+
+/*  private functions  */
+
+static gboolean
+gegl_compression_filter_use_delta (const Babl *format)
+{
+  const Babl  *type = babl_format_get_type (format, 0);
+  const gchar *name = babl_get_name (type);
+
+  return ! (strcmp (name, "float")  == 0 ||
+            strcmp (name, "double") == 0 ||
+            strcmp (name, "half")   == 0);
+}
+
+
+/*  public functions  */
+
+void
+gegl_compression_filter_encode (const Babl   *format,
+                                const guint8 *data,
+                                gint          n,
+                                guint8       *filtered)
+{
+  gint     bpp   = babl_format_get_bytes_per_pixel (format);
+  gboolean delta = gegl_compression_filter_use_delta (format);
+  gint     i;
+
+  for (i = 0; i < bpp; i++)
+    {
+      const guint8 *src  = data + i;
+      guint8       *dest = filtered + (gsize) i * n;
+      gint          j;
+
+      for (j = 0; j < n; j++)
+        dest[j] = src[(gsize) j * bpp];
+
+      if (delta)
+        {
+          for (j = n - 1; j > 0; j--)
+            dest[j] -= dest[j - 1];
+        }
+    }
+}
+
+void
+gegl_compression_filter_decode (const Babl   *format,
+                                const guint8 *filtered,
+                                gint          n,
+                                guint8       *data)
+{
+  gint     bpp   = babl_format_get_bytes_per_pixel (format);
+  gboolean delta = gegl_compression_filter_use_delta (format);
+  gint     i;
+
+  for (i = 0; i < bpp; i++)
+    {
+      const guint8 *src  = filtered + (gsize) i * n;
+      guint8       *dest = data + i;
+      guint8        val  = 0;
+      gint          j;
+
+      if (delta)
+        {
+          for (j = 0; j < n; j++)
+            {
+              val += src[j];
+
+              dest[(gsize) j * bpp] = val;
+            }
+        }
+      else
+        {
+          for (j = 0; j < n; j++)
+            dest[(gsize) j * bpp] = src[j];
+        }
+    }
+}
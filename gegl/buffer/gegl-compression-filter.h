@@ -0,0 +1,37 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_COMPRESSION_FILTER_H__
+#define __GEGL_COMPRESSION_FILTER_H__
+
+
+#include <glib.h>
+#include <babl/babl.h>
+
+G_BEGIN_DECLS
+
+void   gegl_compression_filter_encode (const Babl   *format,
+                                       const guint8 *data,
+                                       gint          n,
+                                       guint8       *filtered);
+void   gegl_compression_filter_decode (const Babl   *format,
+                                       const guint8 *filtered,
+                                       gint          n,
+                                       guint8       *data);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,174 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl-compression.h"
+#include "gegl-compression-filter.h"
+#include "gegl-compression-lz4.h"
+#include "gegl-scratch.h"
+
+
+#ifdef HAVE_LZ4
+
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+
+typedef struct
+{
+  GeglCompression compression;
+  gint            level; /* 0 for the fast compressor */
+} GeglCompressionLz4;
+
+
+/*  local function prototypes  */
+
+static gboolean   gegl_compression_lz4_compress   (const GeglCompression *compression,
+                                                   const Babl            *format,
+                                                   gconstpointer          data,
+                                                   gint                   n,
+                                                   gpointer               compressed,
+                                                   gint                  *compressed_size,
+                                                   gint                   max_compressed_size);
+static gboolean   gegl_compression_lz4_decompress (const GeglCompression *compression,
+                                                   const Babl            *format,
+                                                   gpointer               data,
+                                                   gint                   n,
+                                                   gconstpointer          compressed,
+                                                   gint                   compressed_size);
+
+
+/*  private functions  */
+
+static gboolean
+gegl_compression_lz4_compress (const GeglCompression *compression,
+                               const Babl            *format,
+                               gconstpointer          data,
+                               gint                   n,
+                               gpointer               compressed,
+                               gint                  *compressed_size,
+                               gint                   max_compressed_size)
+{
+  const GeglCompressionLz4 *compression_lz4;
+  guint8                   *filtered;
+  gint                      size;
+  gint                      result;
+
+  compression_lz4 = (const GeglCompressionLz4 *) compression;
+
+  size     = n * babl_format_get_bytes_per_pixel (format);
+  filtered = gegl_scratch_alloc (size);
+
+  gegl_compression_filter_encode (format, data, n, filtered);
+
+  if (compression_lz4->level)
+    {
+      result = LZ4_compress_HC ((const gchar *) filtered, compressed,
+                                size, max_compressed_size,
+                                compression_lz4->level);
+    }
+  else
+    {
+      result = LZ4_compress_default ((const gchar *) filtered, compressed,
+                                     size, max_compressed_size);
+    }
+
+  gegl_scratch_free (filtered);
+
+  if (result <= 0)
+    return FALSE;
+
+  *compressed_size = result;
+
+  return TRUE;
+}
+
+static gboolean
+gegl_compression_lz4_decompress (const GeglCompression *compression,
+                                 const Babl            *format,
+                                 gpointer               data,
+                                 gint                   n,
+                                 gconstpointer          compressed,
+                                 gint                   compressed_size)
+{
+  guint8 *filtered;
+  gint    size;
+  gint    result;
+
+  size     = n * babl_format_get_bytes_per_pixel (format);
+  filtered = gegl_scratch_alloc (size);
+
+  result = LZ4_decompress_safe (compressed, (gchar *) filtered,
+                                compressed_size, size);
+
+  if (result != size)
+    {
+      gegl_scratch_free (filtered);
+
+      return FALSE;
+    }
+
+  gegl_compression_filter_decode (format, filtered, n, data);
+
+  gegl_scratch_free (filtered);
+
+  return TRUE;
+}
+
+
+/*  public functions  */
+
+void
+gegl_compression_lz4_init (void)
+{
+  #define COMPRESSION_LZ4(name, lz4_level)                 \
+    G_STMT_START                                           \
+      {                                                    \
+        static const GeglCompressionLz4 compression_lz4 =  \
+        {                                                  \
+          .compression =                                   \
+          {                                                \
+            .compress   = gegl_compression_lz4_compress,   \
+            .decompress = gegl_compression_lz4_decompress  \
+          },                                               \
+          .level = (lz4_level)                             \
+        };                                                 \
+                                                           \
+        gegl_compression_register (                        \
+          name,                                            \
+          (const GeglCompression *) &compression_lz4);     \
+      }                                                    \
+    G_STMT_END
+
+  COMPRESSION_LZ4 ("lz4",   0);
+  COMPRESSION_LZ4 ("lz4hc", LZ4HC_CLEVEL_DEFAULT);
+}
+
+
+#else /* ! HAVE_LZ4 */
+
+
+/*  public functions  */
+
+void
+gegl_compression_lz4_init (void)
+{
+}
+
+
+#endif /* ! HAVE_LZ4 */
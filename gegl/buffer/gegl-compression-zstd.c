@@ -0,0 +1,222 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl-compression.h"
+#include "gegl-compression-filter.h"
+#include "gegl-compression-zstd.h"
+#include "gegl-scratch.h"
+
+
+#ifdef HAVE_ZSTD
+
+
+#include <zstd.h>
+
+
+typedef struct
+{
+  GeglCompression compression;
+  gint            level;
+} GeglCompressionZstd;
+
+
+/*  local function prototypes  */
+
+static gboolean   gegl_compression_zstd_compress   (const GeglCompression *compression,
+                                                    const Babl            *format,
+                                                    gconstpointer          data,
+                                                    gint                   n,
+                                                    gpointer               compressed,
+                                                    gint                  *compressed_size,
+                                                    gint                   max_compressed_size);
+static gboolean   gegl_compression_zstd_decompress (const GeglCompression *compression,
+                                                    const Babl            *format,
+                                                    gpointer               data,
+                                                    gint                   n,
+                                                    gconstpointer          compressed,
+                                                    gint                   compressed_size);
+
+static void       gegl_compression_zstd_free_cctx  (gpointer               cctx);
+static void       gegl_compression_zstd_free_dctx  (gpointer               dctx);
+
+
+/*  local variables  */
+
+/* zstd contexts are expensive to create, relative to the size of a tile, so
+ * we keep one of each per thread.
+ */
+static GPrivate cctx_private = G_PRIVATE_INIT (gegl_compression_zstd_free_cctx);
+static GPrivate dctx_private = G_PRIVATE_INIT (gegl_compression_zstd_free_dctx);
+
+
+/*  private functions  */
+
+static gboolean
+gegl_compression_zstd_compress (const GeglCompression *compression,
+                                const Babl            *format,
+                                gconstpointer          data,
+                                gint                   n,
+                                gpointer               compressed,
+                                gint                  *compressed_size,
+                                gint                   max_compressed_size)
+{
+  const GeglCompressionZstd *compression_zstd;
+  ZSTD_CCtx                 *cctx;
+  guint8                    *filtered;
+  gint                       size;
+  gsize                      result;
+
+  compression_zstd = (const GeglCompressionZstd *) compression;
+
+  cctx = g_private_get (&cctx_private);
+
+  if (! cctx)
+    {
+      cctx = ZSTD_createCCtx ();
+
+      if (! cctx)
+        return FALSE;
+
+      g_private_set (&cctx_private, cctx);
+    }
+
+  size     = n * babl_format_get_bytes_per_pixel (format);
+  filtered = gegl_scratch_alloc (size);
+
+  gegl_compression_filter_encode (format, data, n, filtered);
+
+  result = ZSTD_compressCCtx (cctx,
+                              compressed, max_compressed_size,
+                              filtered, size,
+                              compression_zstd->level);
+
+  gegl_scratch_free (filtered);
+
+  if (ZSTD_isError (result))
+    return FALSE;
+
+  *compressed_size = result;
+
+  return TRUE;
+}
+
+static gboolean
+gegl_compression_zstd_decompress (const GeglCompression *compression,
+                                  const Babl            *format,
+                                  gpointer               data,
+                                  gint                   n,
+                                  gconstpointer          compressed,
+                                  gint                   compressed_size)
+{
+  ZSTD_DCtx *dctx;
+  guint8    *filtered;
+  gint       size;
+  gsize      result;
+
+  dctx = g_private_get (&dctx_private);
+
+  if (! dctx)
+    {
+      dctx = ZSTD_createDCtx ();
+
+      if (! dctx)
+        return FALSE;
+
+      g_private_set (&dctx_private, dctx);
+    }
+
+  size     = n * babl_format_get_bytes_per_pixel (format);
+  filtered = gegl_scratch_alloc (size);
+
+  result = ZSTD_decompressDCtx (dctx,
+                                filtered, size,
+                                compressed, compressed_size);
+
+  if (result != (gsize) size)
+    {
+      gegl_scratch_free (filtered);
+
+      return FALSE;
+    }
+
+  gegl_compression_filter_decode (format, filtered, n, data);
+
+  gegl_scratch_free (filtered);
+
+  return TRUE;
+}
+
+static void
+gegl_compression_zstd_free_cctx (gpointer cctx)
+{
+  ZSTD_freeCCtx (cctx);
+}
+
+static void
+gegl_compression_zstd_free_dctx (gpointer dctx)
+{
+  ZSTD_freeDCtx (dctx);
+}
+
+
+/*  public functions  */
+
+void
+gegl_compression_zstd_init (void)
+{
+  #define COMPRESSION_ZSTD(name, zstd_level)                \
+    G_STMT_START                                            \
+      {                                                     \
+        static const GeglCompressionZstd compression_zstd = \
+        {                                                   \
+          .compression =                                    \
+          {                                                 \
+            .compress   = gegl_compression_zstd_compress,   \
+            .decompress = gegl_compression_zstd_decompress  \
+          },                                                \
+          .level = (zstd_level)                             \
+        };                                                  \
+                                                            \
+        gegl_compression_register (                         \
+          name,                                             \
+          (const GeglCompression *) &compression_zstd);     \
+      }                                                     \
+    G_STMT_END
+
+  COMPRESSION_ZSTD ("zstd",   3);
+  COMPRESSION_ZSTD ("zstd1",  1);
+  COMPRESSION_ZSTD ("zstd3",  3);
+  COMPRESSION_ZSTD ("zstd6",  6);
+  COMPRESSION_ZSTD ("zstd9",  9);
+  COMPRESSION_ZSTD ("zstd12", 12);
+  COMPRESSION_ZSTD ("zstd19", 19);
+}
+
+
+#else /* ! HAVE_ZSTD */
+
+
+/*  public functions  */
+
+void
+gegl_compression_zstd_init (void)
+{
+}
+
+
+#endif /* ! HAVE_ZSTD */
@@ -24,6 +24,8 @@
 #include "gegl-compression-nop.h"
 #include "gegl-compression-rle.h"
 #include "gegl-compression-zlib.h"
+#include "gegl-compression-lz4.h"
+#include "gegl-compression-zstd.h"
 
 
 /*  local function prototypes  */
@@ -35,6 +37,7 @@ void   gegl_compression_register_alias (const gchar *name,
 /*  local variables  */
 
 GHashTable *algorithms;
+GHashTable *aliases;
 
 
 /*  private functions  */
@@ -55,6 +58,7 @@ gegl_compression_register_alias (const gchar *name,
       if (compression)
         {
           gegl_compression_register (name, compression);
+          g_hash_table_add (aliases, g_strdup (name));
 
           break;
         }
@@ -72,10 +76,13 @@ gegl_compression_init (void)
   g_return_if_fail (algorithms == NULL);
 
   algorithms = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  aliases    = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   gegl_compression_nop_init ();
   gegl_compression_rle_init ();
   gegl_compression_zlib_init ();
+  gegl_compression_lz4_init ();
+  gegl_compression_zstd_init ();
 
   gegl_compression_register_alias ("fast",
                                    /* in order of precedence: */
@@ -103,6 +110,7 @@ void
 gegl_compression_cleanup (void)
 {
   g_clear_pointer (&algorithms, g_hash_table_unref);
+  g_clear_pointer (&aliases, g_hash_table_unref);
 }
 
 void
@@ -155,6 +163,26 @@ gegl_compression (const gchar *name)
   return g_hash_table_lookup (algorithms, name);
 }
 
+const gchar *
+gegl_compression_get_name (const GeglCompression *compression)
+{
+  GHashTableIter  iter;
+  const gchar    *name;
+  gpointer        value;
+
+  g_return_val_if_fail (compression != NULL, NULL);
+
+  g_hash_table_iter_init (&iter, algorithms);
+
+  while (g_hash_table_iter_next (&iter, (gpointer *) &name, &value))
+    {
+      if (value == compression && ! g_hash_table_contains (aliases, name))
+        return name;
+    }
+
+  return NULL;
+}
+
 gboolean
 gegl_compression_compress (const GeglCompression *compression,
                            const Babl            *format,
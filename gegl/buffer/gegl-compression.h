@@ -53,6 +53,8 @@ void                     gegl_compression_register   (const gchar           *nam
 const gchar           ** gegl_compression_list       (void);
 
 const GeglCompression  * gegl_compression            (const gchar           *name);
+/* returns the name the algorithm is registered with, rather than an alias */
+const gchar            * gegl_compression_get_name   (const GeglCompression *compression);
 
 gboolean                 gegl_compression_compress   (const GeglCompression *compression,
                                                       const Babl            *format,
@@ -47,6 +47,11 @@ static void            gegl_sampler_cubic_get         (      GeglSampler* restri
                                                              GeglBufferMatrix2*     scale,
                                                              void*        restrict  output,
                                                              GeglAbyssPolicy        repeat_mode);
+static void            gegl_sampler_cubic_interpolate_n (    GeglSampler* restrict  self,
+                                                       const gdouble*     restrict  coords,
+                                                             gpointer     restrict  output,
+                                                             gint                   n,
+                                                             GeglAbyssPolicy        repeat_mode);
 static void            get_property                   (      GObject               *gobject,
                                                              guint                  prop_id,
                                                              GValue                *value,
@@ -55,9 +60,6 @@ static void            set_property                   (      GObject
                                                              guint                  prop_id,
                                                        const GValue                *value,
                                                              GParamSpec            *pspec);
-static inline gfloat   cubicKernel                    (const gfloat                 x,
-                                                       const gfloat                 b,
-                                                       const gfloat                 c);
 
 
 G_DEFINE_TYPE (GeglSamplerCubic, gegl_sampler_cubic, GEGL_TYPE_SAMPLER)
@@ -73,7 +75,8 @@ gegl_sampler_cubic_class_init (GeglSamplerCubicClass *klass)
   object_class->finalize     = gegl_sampler_cubic_finalize;
 
   sampler_class->get         = gegl_sampler_cubic_get;
-  sampler_class->interpolate = gegl_sampler_cubic_interpolate;
+  sampler_class->interpolate   = gegl_sampler_cubic_interpolate;
+  sampler_class->interpolate_n = gegl_sampler_cubic_interpolate_n;
 
   g_object_class_install_property ( object_class, PROP_B,
     g_param_spec_double ("b",
@@ -191,11 +194,11 @@ gegl_sampler_cubic_interpolate (      GeglSampler     *self,
     output[c] = 0.0f;
 
   for (i = 0; i < 4; i++)
-    factor_i[i] = cubicKernel (x - (i - 1), cubic_b, cubic_c);
+    factor_i[i] = gegl_sampler_cubic_kernel (x - (i - 1), cubic_b, cubic_c);
 
   for (j = 0; j < 4; j++)
     {
-      gfloat factor_j = cubicKernel (y - (j - 1), cubic_b, cubic_c);
+      gfloat factor_j = gegl_sampler_cubic_kernel (y - (j - 1), cubic_b, cubic_c);
 
       for (i = 0; i < 4; i++)
         {
@@ -235,6 +238,17 @@ gegl_sampler_cubic_get (      GeglSampler       *self,
   }
 }
 
+static void
+gegl_sampler_cubic_interpolate_n (      GeglSampler     *self,
+                                  const gdouble         *coords,
+                                        gpointer         output,
+                                        gint             n,
+                                        GeglAbyssPolicy  repeat_mode)
+{
+  /* the per-cpu variant chosen at init time */
+  gegl_sampler_cubic_span (self, coords, output, n, repeat_mode);
+}
+
 static void
 get_property (GObject    *object,
               guint       prop_id,
@@ -284,30 +298,3 @@ set_property (GObject      *object,
         break;
     }
 }
-
-static inline gfloat int_fabsf (const gfloat x)
-{
-  union {gfloat f; guint32 i;} u = {x};
-  u.i &= 0x7fffffff;
-  return u.f;
-}
-
-static inline gfloat
-cubicKernel (const gfloat x,
-             const gfloat b,
-             const gfloat c)
-{
-  const gfloat x2 = x*x;
-  const gfloat ax = int_fabsf (x);
-
-  if (x2 <= (gfloat) 1.f) return ( (gfloat) ((12-9*b-6*c)/6) * ax +
-                                  (gfloat) ((-18+12*b+6*c)/6) ) * x2 +
-                                  (gfloat) ((6-2*b)/6);
-
-  if (x2 < (gfloat) 4.f) return ( (gfloat) ((-b-6*c)/6) * ax +
-                                 (gfloat) ((6*b+30*c)/6) ) * x2 +
-                                 (gfloat) ((-12*b-48*c)/6) * ax +
-                                 (gfloat) ((8*b+24*c)/6);
-
-  return (gfloat) 0.f;
-}
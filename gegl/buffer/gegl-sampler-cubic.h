@@ -48,6 +48,30 @@ struct _GeglSamplerCubicClass
 
 GType gegl_sampler_cubic_get_type (void) G_GNUC_CONST;
 
+static inline gfloat
+gegl_sampler_cubic_kernel (const gfloat x,
+                           const gfloat b,
+                           const gfloat c)
+{
+  union {gfloat f; guint32 i;} u = {x};
+  const gfloat x2 = x*x;
+  gfloat       ax;
+
+  u.i &= 0x7fffffff;
+  ax   = u.f;
+
+  if (x2 <= (gfloat) 1.f) return ( (gfloat) ((12-9*b-6*c)/6) * ax +
+                                  (gfloat) ((-18+12*b+6*c)/6) ) * x2 +
+                                  (gfloat) ((6-2*b)/6);
+
+  if (x2 < (gfloat) 4.f) return ( (gfloat) ((-b-6*c)/6) * ax +
+                                 (gfloat) ((6*b+30*c)/6) ) * x2 +
+                                 (gfloat) ((-12*b-48*c)/6) * ax +
+                                 (gfloat) ((8*b+24*c)/6);
+
+  return (gfloat) 0.f;
+}
+
 G_END_DECLS
 
 #endif
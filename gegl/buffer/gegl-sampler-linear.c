@@ -43,6 +43,11 @@ static void          gegl_sampler_linear_get         (      GeglSampler* restric
                                                             GeglBufferMatrix2     *scale,
                                                             void*        restrict  output,
                                                             GeglAbyssPolicy        repeat_mode);
+static void          gegl_sampler_linear_interpolate_n (    GeglSampler* restrict  self,
+                                                      const gdouble*     restrict  coords,
+                                                            gpointer     restrict  output,
+                                                            gint                   n,
+                                                            GeglAbyssPolicy        repeat_mode);
 
 G_DEFINE_TYPE (GeglSamplerLinear, gegl_sampler_linear, GEGL_TYPE_SAMPLER)
 
@@ -52,7 +57,8 @@ gegl_sampler_linear_class_init (GeglSamplerLinearClass *klass)
   GeglSamplerClass *sampler_class = GEGL_SAMPLER_CLASS (klass);
 
   sampler_class->get         = gegl_sampler_linear_get;
-  sampler_class->interpolate = gegl_sampler_linear_interpolate;
+  sampler_class->interpolate   = gegl_sampler_linear_interpolate;
+  sampler_class->interpolate_n = gegl_sampler_linear_interpolate_n;
 }
 
 /*
@@ -201,3 +207,14 @@ gegl_sampler_linear_get (      GeglSampler       *self,
 #endif
   }
 }
+
+static void
+gegl_sampler_linear_interpolate_n (      GeglSampler     *self,
+                                   const gdouble         *coords,
+                                         gpointer         output,
+                                         gint             n,
+                                         GeglAbyssPolicy  repeat_mode)
+{
+  /* the per-cpu variant chosen at init time */
+  gegl_sampler_linear_span (self, coords, output, n, repeat_mode);
+}
@@ -45,6 +45,13 @@ gegl_sampler_nearest_get (GeglSampler*    restrict self,
                           void*           restrict output,
                           GeglAbyssPolicy          repeat_mode);
 
+static void
+gegl_sampler_nearest_interpolate_n (GeglSampler*    restrict self,
+                                    const gdouble*  restrict coords,
+                                    gpointer        restrict output,
+                                    gint                     n,
+                                    GeglAbyssPolicy          repeat_mode);
+
 static void
 gegl_sampler_nearest_prepare (GeglSampler*    restrict self);
 
@@ -59,6 +66,7 @@ gegl_sampler_nearest_class_init (GeglSamplerNearestClass *klass)
   object_class->dispose = gegl_sampler_nearest_dispose;
 
   sampler_class->get = gegl_sampler_nearest_get;
+  sampler_class->interpolate_n = gegl_sampler_nearest_interpolate_n;
   sampler_class->prepare = gegl_sampler_nearest_prepare;
 }
 
@@ -91,117 +99,162 @@ gegl_sampler_nearest_dispose (GObject *object)
   G_OBJECT_CLASS (gegl_sampler_nearest_parent_class)->dispose (object);
 }
 
-static inline void
-gegl_sampler_get_pixel (GeglSampler    *sampler,
-                        gint            x,
-                        gint            y,
-                        gpointer        data,
-                        GeglAbyssPolicy repeat_mode)
+/* returns a pointer to the pixel at x,y, which must be inside the buffer's
+ * abyss, in the sampler's hot tile, fetching the tile first if necessary.
+ * the buffer must be locked.
+ */
+static inline guchar *
+gegl_sampler_nearest_get_data (GeglSamplerNearest *nearest_sampler,
+                               gint                x,
+                               gint                y)
 {
-  GeglSamplerNearest *nearest_sampler = (GeglSamplerNearest*)(sampler);
-  GeglBuffer *buffer = sampler->buffer;
-  const GeglRectangle *abyss = &buffer->abyss;
-  guchar              *buf   = data;
-
-  if (y <  abyss->y ||
-      x <  abyss->x ||
-      y >= abyss->y + abyss->height ||
-      x >= abyss->x + abyss->width)
+  GeglBuffer *buffer      = GEGL_SAMPLER (nearest_sampler)->buffer;
+  gint        tile_width  = buffer->tile_width;
+  gint        tile_height = buffer->tile_height;
+  gint        tiledy      = y + buffer->shift_y;
+  gint        tiledx      = x + buffer->shift_x;
+  gint        indice_x    = gegl_tile_indice (tiledx, tile_width);
+  gint        indice_y    = gegl_tile_indice (tiledy, tile_height);
+
+  GeglTile *tile = nearest_sampler->hot_tile;
+
+  if (!(tile &&
+        tile->x == indice_x &&
+        tile->y == indice_y))
+    {
+      g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+      if (tile)
+        {
+          gegl_tile_read_unlock (tile);
+
+          gegl_tile_unref (tile);
+        }
+
+      tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
+                                        indice_x, indice_y,
+                                        0);
+      nearest_sampler->hot_tile = tile;
+
+      gegl_tile_read_lock (tile);
+
+      g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+    }
+
+  if (tile)
+    {
+      gint tile_origin_x = indice_x * tile_width;
+      gint tile_origin_y = indice_y * tile_height;
+      gint       offsetx = tiledx - tile_origin_x;
+      gint       offsety = tiledy - tile_origin_y;
+
+      return gegl_tile_get_data (tile) +
+             (offsety * tile_width + offsetx) * nearest_sampler->buffer_bpp;
+    }
+
+  return NULL;
+}
+
+/* maps x,y into the abyss according to repeat_mode, returning FALSE if the
+ * pixel is a constant color instead.
+ */
+static inline gboolean
+gegl_sampler_nearest_map_abyss (const GeglRectangle *abyss,
+                                gint                *x,
+                                gint                *y,
+                                GeglAbyssPolicy      repeat_mode)
+{
+  if (*y <  abyss->y ||
+      *x <  abyss->x ||
+      *y >= abyss->y + abyss->height ||
+      *x >= abyss->x + abyss->width)
     {
       switch (repeat_mode)
       {
         case GEGL_ABYSS_CLAMP:
-          x = CLAMP (x, abyss->x, abyss->x+abyss->width-1);
-          y = CLAMP (y, abyss->y, abyss->y+abyss->height-1);
+          *x = CLAMP (*x, abyss->x, abyss->x+abyss->width-1);
+          *y = CLAMP (*y, abyss->y, abyss->y+abyss->height-1);
           break;
 
         case GEGL_ABYSS_LOOP:
-          x = abyss->x + GEGL_REMAINDER (x - abyss->x, abyss->width);
-          y = abyss->y + GEGL_REMAINDER (y - abyss->y, abyss->height);
+          *x = abyss->x + GEGL_REMAINDER (*x - abyss->x, abyss->width);
+          *y = abyss->y + GEGL_REMAINDER (*y - abyss->y, abyss->height);
           break;
 
-        case GEGL_ABYSS_BLACK:
-          {
-            gfloat color[4] = {0.0, 0.0, 0.0, 1.0};
-            babl_process (babl_fish (gegl_babl_rgba_linear_float (), sampler->format),
-                          color,
-                          buf,
-                          1);
-            return;
-          }
-
-        case GEGL_ABYSS_WHITE:
-          {
-            gfloat color[4] = {1.0, 1.0, 1.0, 1.0};
-            babl_process (babl_fish (gegl_babl_rgba_linear_float (),
-                                     sampler->format),
-                          color,
-                          buf,
-                          1);
-            return;
-          }
-
         default:
-        case GEGL_ABYSS_NONE:
-          memset (buf, 0x00, babl_format_get_bytes_per_pixel (sampler->format));
-          return;
+          return FALSE;
       }
     }
 
-  gegl_buffer_lock (sampler->buffer);
+  return TRUE;
+}
 
+/* stores the constant color of an abyss pixel in format */
+static void
+gegl_sampler_nearest_get_abyss_color (const Babl      *format,
+                                      gpointer         data,
+                                      GeglAbyssPolicy  repeat_mode)
+{
+  switch (repeat_mode)
   {
-    gint tile_width  = buffer->tile_width;
-    gint tile_height = buffer->tile_height;
-    gint tiledy      = y + buffer->shift_y;
-    gint tiledx      = x + buffer->shift_x;
-    gint indice_x    = gegl_tile_indice (tiledx, tile_width);
-    gint indice_y    = gegl_tile_indice (tiledy, tile_height);
-
-    GeglTile *tile = nearest_sampler->hot_tile;
-
-    if (!(tile &&
-          tile->x == indice_x &&
-          tile->y == indice_y))
+    case GEGL_ABYSS_BLACK:
       {
-        g_rec_mutex_lock (&buffer->tile_storage->mutex);
-
-        if (tile)
-          {
-            gegl_tile_read_unlock (tile);
-
-            gegl_tile_unref (tile);
-          }
+        gfloat color[4] = {0.0, 0.0, 0.0, 1.0};
+        babl_process (babl_fish (gegl_babl_rgba_linear_float (), format),
+                      color,
+                      data,
+                      1);
+        return;
+      }
 
-        tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
-                                          indice_x, indice_y,
-                                          0);
-        nearest_sampler->hot_tile = tile;
+    case GEGL_ABYSS_WHITE:
+      {
+        gfloat color[4] = {1.0, 1.0, 1.0, 1.0};
+        babl_process (babl_fish (gegl_babl_rgba_linear_float (),
+                                 format),
+                      color,
+                      data,
+                      1);
+        return;
+      }
 
-        gegl_tile_read_lock (tile);
+    default:
+    case GEGL_ABYSS_NONE:
+      memset (data, 0x00, babl_format_get_bytes_per_pixel (format));
+      return;
+  }
+}
 
-        g_rec_mutex_unlock (&buffer->tile_storage->mutex);
-      }
+static inline void
+gegl_sampler_get_pixel (GeglSampler    *sampler,
+                        gint            x,
+                        gint            y,
+                        gpointer        data,
+                        GeglAbyssPolicy repeat_mode)
+{
+  GeglSamplerNearest *nearest_sampler = (GeglSamplerNearest*)(sampler);
+  guchar             *buf             = data;
+  guchar             *tp;
 
-    if (tile)
-      {
-        gint tile_origin_x = indice_x * tile_width;
-        gint tile_origin_y = indice_y * tile_height;
-        gint       offsetx = tiledx - tile_origin_x;
-        gint       offsety = tiledy - tile_origin_y;
+  if (! gegl_sampler_nearest_map_abyss (&sampler->buffer->abyss, &x, &y,
+                                        repeat_mode))
+    {
+      gegl_sampler_nearest_get_abyss_color (sampler->format, buf, repeat_mode);
+      return;
+    }
 
-        guchar *tp;
+  gegl_buffer_lock (sampler->buffer);
 
-        tp = gegl_tile_get_data (tile) +
-             (offsety * tile_width + offsetx) * nearest_sampler->buffer_bpp;
+  tp = gegl_sampler_nearest_get_data (nearest_sampler, x, y);
 
+  if (tp)
+    {
 #if BABL_MINOR_VERSION>1 || (BABL_MINOR_VERSION==1 && BABL_MICRO_VERSION >= 90)
-    sampler->fish_process (sampler->fish, (void*)tp, (void*)buf, 1, NULL);
+      sampler->fish_process (sampler->fish, (void*)tp, (void*)buf, 1, NULL);
 #else
-    babl_process (sampler->fish, (void*)tp, (void*)buf, 1);
+      babl_process (sampler->fish, (void*)tp, (void*)buf, 1);
 #endif
-      }
-  }
+    }
 
   gegl_buffer_unlock (sampler->buffer);
 }
@@ -219,6 +272,51 @@ gegl_sampler_nearest_get (      GeglSampler*    restrict  sampler,
            output, repeat_mode);
 }
 
+/* copies the raw pixels, in the buffer's soft format, which the sampler's
+ * fish converts from.
+ */
+static void
+gegl_sampler_nearest_interpolate_n (      GeglSampler*    restrict  sampler,
+                                    const gdouble*        restrict  coords,
+                                          gpointer        restrict  output,
+                                          gint                      n,
+                                          GeglAbyssPolicy           repeat_mode)
+{
+  GeglSamplerNearest  *nearest_sampler = (GeglSamplerNearest*)(sampler);
+  GeglBuffer          *buffer          = sampler->buffer;
+  gint                 bpp             = nearest_sampler->buffer_bpp;
+  guchar              *buf             = output;
+  gint                 i;
+
+  gegl_buffer_lock (buffer);
+
+  for (i = 0; i < n; i++)
+    {
+      gint    x = int_floorf (coords[0]);
+      gint    y = int_floorf (coords[1]);
+      guchar *tp;
+
+      if (! gegl_sampler_nearest_map_abyss (&buffer->abyss, &x, &y,
+                                            repeat_mode))
+        {
+          gegl_sampler_nearest_get_abyss_color (buffer->soft_format, buf,
+                                                repeat_mode);
+        }
+      else if ((tp = gegl_sampler_nearest_get_data (nearest_sampler, x, y)))
+        {
+          memcpy (buf, tp, bpp);
+        }
+      else
+        {
+          memset (buf, 0x00, bpp);
+        }
+
+      coords += 2;
+      buf    += bpp;
+    }
+
+  gegl_buffer_unlock (buffer);
+}
 
 static void
 gegl_sampler_nearest_prepare (GeglSampler* restrict sampler)
@@ -0,0 +1,203 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* batched point-sampling kernels of the linear and cubic samplers.  this file
+ * is built once per simd variant, like gegl-algorithms.c; the kernels are
+ * specialized for the common numbers of components, so that the per-component
+ * loops get unrolled, and vectorized for the variant's instruction set.
+ *
+ * the arithmetic matches the samplers' interpolate() functions exactly.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include <babl/babl.h>
+
+#include "gegl-buffer.h"
+#include "gegl-buffer-formats.h"
+#include "gegl-algorithms.h"
+#include "gegl-sampler.h"
+#include "gegl-sampler-cubic.h"
+
+
+static inline void
+gegl_sampler_linear_span_n (GeglSampler     *self,
+                            const gdouble   *coords,
+                            gfloat          *output,
+                            gint             n,
+                            GeglAbyssPolicy  repeat_mode,
+                            const gint       nc)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      const float iabsolute_x = (float) coords[0] - 0.5;
+      const float iabsolute_y = (float) coords[1] - 0.5;
+
+      const gint ix = int_floorf (iabsolute_x);
+      const gint iy = int_floorf (iabsolute_y);
+
+      const gfloat * restrict top =
+        gegl_sampler_get_ptr (self, ix, iy, repeat_mode);
+      const gfloat * restrict bot = top + GEGL_SAMPLER_MAXIMUM_WIDTH * nc;
+
+      const gfloat x = iabsolute_x - ix;
+      const gfloat y = iabsolute_y - iy;
+
+      const gfloat x_times_y = x * y;
+      const gfloat w_times_y = y - x_times_y;
+      const gfloat x_times_z = x - x_times_y;
+      const gfloat w_times_z = (gfloat) 1. - ( x + w_times_y );
+
+      gint c;
+
+      for (c = 0; c < nc; c++)
+        {
+          output[c] =
+            x_times_y * bot[nc + c]
+            +
+            w_times_y * bot[c]
+            +
+            x_times_z * top[nc + c]
+            +
+            w_times_z * top[c];
+        }
+
+      coords += 2;
+      output += nc;
+    }
+}
+
+void
+GEGL_SIMD_SUFFIX (gegl_sampler_linear_span) (GeglSampler     *self,
+                                             const gdouble   *coords,
+                                             gfloat          *output,
+                                             gint             n,
+                                             GeglAbyssPolicy  repeat_mode)
+{
+  switch (self->interpolate_components)
+    {
+    case 2:
+      gegl_sampler_linear_span_n (self, coords, output, n, repeat_mode, 2);
+      break;
+
+    case 4:
+      gegl_sampler_linear_span_n (self, coords, output, n, repeat_mode, 4);
+      break;
+
+    case 5:
+      gegl_sampler_linear_span_n (self, coords, output, n, repeat_mode, 5);
+      break;
+
+    default:
+      gegl_sampler_linear_span_n (self, coords, output, n, repeat_mode,
+                                  self->interpolate_components);
+      break;
+    }
+}
+
+static inline void
+gegl_sampler_cubic_span_n (GeglSampler     *self,
+                           const gdouble   *coords,
+                           gfloat          *output,
+                           gint             n,
+                           GeglAbyssPolicy  repeat_mode,
+                           const gint       nc)
+{
+  GeglSamplerCubic *cubic   = (GeglSamplerCubic *) self;
+  const gfloat      cubic_b = cubic->b;
+  const gfloat      cubic_c = cubic->c;
+  gint              k;
+
+  for (k = 0; k < n; k++)
+    {
+      const double iabsolute_x = (double) coords[0] - 0.5;
+      const double iabsolute_y = (double) coords[1] - 0.5;
+
+      const gint ix = int_floorf (iabsolute_x);
+      const gint iy = int_floorf (iabsolute_y);
+
+      const gfloat x = iabsolute_x - ix;
+      const gfloat y = iabsolute_y - iy;
+
+      const gfloat * restrict sampler_bptr =
+        gegl_sampler_get_ptr (self, ix, iy, repeat_mode) -
+        (GEGL_SAMPLER_MAXIMUM_WIDTH + 1) * nc;
+
+      gfloat factor_i[4];
+      gint   c;
+      gint   i;
+      gint   j;
+
+      for (c = 0; c < nc; c++)
+        output[c] = 0.0f;
+
+      for (i = 0; i < 4; i++)
+        factor_i[i] = gegl_sampler_cubic_kernel (x - (i - 1), cubic_b, cubic_c);
+
+      for (j = 0; j < 4; j++)
+        {
+          const gfloat factor_j =
+            gegl_sampler_cubic_kernel (y - (j - 1), cubic_b, cubic_c);
+
+          for (i = 0; i < 4; i++)
+            {
+              const gfloat factor = factor_j * factor_i[i];
+
+              for (c = 0; c < nc; c++)
+                output[c] += factor * sampler_bptr[c];
+
+              sampler_bptr += nc;
+            }
+
+          sampler_bptr += (GEGL_SAMPLER_MAXIMUM_WIDTH - 4) * nc;
+        }
+
+      coords += 2;
+      output += nc;
+    }
+}
+
+void
+GEGL_SIMD_SUFFIX (gegl_sampler_cubic_span) (GeglSampler     *self,
+                                            const gdouble   *coords,
+                                            gfloat          *output,
+                                            gint             n,
+                                            GeglAbyssPolicy  repeat_mode)
+{
+  switch (self->interpolate_components)
+    {
+    case 2:
+      gegl_sampler_cubic_span_n (self, coords, output, n, repeat_mode, 2);
+      break;
+
+    case 4:
+      gegl_sampler_cubic_span_n (self, coords, output, n, repeat_mode, 4);
+      break;
+
+    case 5:
+      gegl_sampler_cubic_span_n (self, coords, output, n, repeat_mode, 5);
+      break;
+
+    default:
+      gegl_sampler_cubic_span_n (self, coords, output, n, repeat_mode,
+                                 self->interpolate_components);
+      break;
+    }
+}
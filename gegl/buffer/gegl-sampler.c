@@ -192,6 +192,213 @@ gegl_sampler_get (GeglSampler       *self,
   self->get (self, x, y, scale, output, repeat_mode);
 }
 
+#define GEGL_SAMPLER_SPAN_CHUNK 64
+
+/* whether samples with a common scale can go through the sampler's
+ * interpolate_n(), rather than one at a time through get().
+ */
+static gboolean
+gegl_sampler_can_interpolate_n (GeglSampler       *self,
+                                GeglBufferMatrix2 *scale)
+{
+  GeglSamplerClass *klass = GEGL_SAMPLER_GET_CLASS (self);
+
+  if (self->lvel || ! klass->interpolate_n)
+    return FALSE;
+
+  if (scale)
+    {
+      /* mirrors _gegl_sampler_box_get() */
+      const gdouble u_norm2 = scale->coeff[0][0] * scale->coeff[0][0] +
+                              scale->coeff[1][0] * scale->coeff[1][0];
+      const gdouble v_norm2 = scale->coeff[0][1] * scale->coeff[0][1] +
+                              scale->coeff[1][1] * scale->coeff[1][1];
+
+      if (! (u_norm2 < 4.0 && v_norm2 < 4.0))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gpointer
+gegl_sampler_alloc_scratch (GeglSampler *self)
+{
+  gint bpp = MAX (self->interpolate_bpp,
+                  babl_format_get_bytes_per_pixel (self->buffer->soft_format));
+
+  return gegl_scratch_alloc (GEGL_SAMPLER_SPAN_CHUNK * bpp);
+}
+
+static void
+gegl_sampler_process_n (GeglSampler     *self,
+                        const gdouble   *coords,
+                        gpointer         scratch,
+                        guchar          *output,
+                        gint             n,
+                        GeglAbyssPolicy  repeat_mode)
+{
+  GeglSamplerClass *klass = GEGL_SAMPLER_GET_CLASS (self);
+
+  klass->interpolate_n (self, coords, scratch, n, repeat_mode);
+
+#if BABL_MINOR_VERSION>1 || (BABL_MINOR_VERSION==1 && BABL_MICRO_VERSION >= 90)
+  self->fish_process (self->fish, scratch, (void*)output, n, NULL);
+#else
+  babl_process (self->fish, scratch, (void*)output, n);
+#endif
+}
+
+void
+gegl_sampler_get_span (GeglSampler       *self,
+                       gdouble            x,
+                       gdouble            y,
+                       gdouble            dx,
+                       gdouble            dy,
+                       GeglBufferMatrix2 *scale,
+                       void              *output,
+                       gint               n,
+                       GeglAbyssPolicy    repeat_mode)
+{
+  gdouble  coords[2 * GEGL_SAMPLER_SPAN_CHUNK];
+  guchar  *dst = output;
+  gpointer scratch;
+  gint     bpp;
+
+  if (n <= 0)
+    return;
+
+  bpp = babl_format_get_bytes_per_pixel (self->format);
+
+  if (self->lvel ||
+      ! isfinite (x)  || ! isfinite (y) ||
+      ! isfinite (dx) || ! isfinite (dy))
+    {
+      gint i;
+
+      for (i = 0; i < n; i++)
+        {
+          gegl_sampler_get (self, x, y, scale, dst, repeat_mode);
+
+          x   += dx;
+          y   += dy;
+          dst += bpp;
+        }
+
+      return;
+    }
+
+  if (G_UNLIKELY (gegl_buffer_ext_flush))
+    {
+      gdouble       x1 = x + dx * (n - 1);
+      gdouble       y1 = y + dy * (n - 1);
+      GeglRectangle rect;
+
+      rect.x      = floor (MIN (x, x1));
+      rect.y      = floor (MIN (y, y1));
+      rect.width  = ceil (MAX (x, x1)) - rect.x + 1;
+      rect.height = ceil (MAX (y, y1)) - rect.y + 1;
+
+      gegl_buffer_ext_flush (self->buffer, &rect);
+    }
+
+  if (! gegl_sampler_can_interpolate_n (self, scale))
+    {
+      gint i;
+
+      for (i = 0; i < n; i++)
+        {
+          self->get (self, x, y, scale, dst, repeat_mode);
+
+          x   += dx;
+          y   += dy;
+          dst += bpp;
+        }
+
+      return;
+    }
+
+  scratch = gegl_sampler_alloc_scratch (self);
+
+  while (n > 0)
+    {
+      gint chunk = MIN (n, GEGL_SAMPLER_SPAN_CHUNK);
+      gint i;
+
+      /* step the coordinates the same way per-pixel callers do, so that the
+       * results are identical.
+       */
+      for (i = 0; i < chunk; i++)
+        {
+          coords[2 * i + 0] = x;
+          coords[2 * i + 1] = y;
+
+          x += dx;
+          y += dy;
+        }
+
+      gegl_sampler_process_n (self, coords, scratch, dst, chunk, repeat_mode);
+
+      dst += chunk * bpp;
+      n   -= chunk;
+    }
+
+  gegl_scratch_free (scratch);
+}
+
+void
+gegl_sampler_get_points (GeglSampler       *self,
+                         const gdouble     *coords,
+                         GeglBufferMatrix2 *scale,
+                         void              *output,
+                         gint               n,
+                         GeglAbyssPolicy    repeat_mode)
+{
+  guchar *dst = output;
+  gint    bpp;
+  gint    i;
+
+  if (n <= 0)
+    return;
+
+  bpp = babl_format_get_bytes_per_pixel (self->format);
+
+  if (gegl_sampler_can_interpolate_n (self, scale) &&
+      ! gegl_buffer_ext_flush)
+    {
+      for (i = 0; i < 2 * n; i++)
+        {
+          if (! isfinite (coords[i]))
+            break;
+        }
+
+      if (i == 2 * n)
+        {
+          gpointer scratch = gegl_sampler_alloc_scratch (self);
+
+          for (i = 0; i < n; i += GEGL_SAMPLER_SPAN_CHUNK)
+            {
+              gint chunk = MIN (n - i, GEGL_SAMPLER_SPAN_CHUNK);
+
+              gegl_sampler_process_n (self, coords + 2 * i, scratch,
+                                      dst + i * bpp, chunk, repeat_mode);
+            }
+
+          gegl_scratch_free (scratch);
+
+          return;
+        }
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      gegl_sampler_get (self, coords[2 * i + 0], coords[2 * i + 1],
+                        scale, dst, repeat_mode);
+
+      dst += bpp;
+    }
+}
+
 void
 gegl_sampler_prepare (GeglSampler *self)
 {
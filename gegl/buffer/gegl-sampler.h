@@ -59,6 +59,18 @@ typedef void (* GeglSamplerInterpolateFun) (GeglSampler     *self,
                                             gfloat          *output,
                                             GeglAbyssPolicy  repeat_mode);
 
+/* samplers may additionally provide an interpolate_n() function, which
+ * point-samples n locations, given as consecutive pairs of x and y
+ * coordinates, at once.  its results are in the interpolation format, or,
+ * for samplers without an interpolate() function, in the buffer's soft
+ * format; either way, in the source format of the sampler's fish.
+ */
+typedef void (* GeglSamplerInterpolateNFun) (GeglSampler     *self,
+                                             const gdouble   *coords,
+                                             gpointer         output,
+                                             gint             n,
+                                             GeglAbyssPolicy  repeat_mode);
+
 typedef struct _GeglSamplerClass GeglSamplerClass;
 
 typedef struct GeglSamplerLevel
@@ -104,6 +116,7 @@ struct _GeglSamplerClass
   GeglSamplerInterpolateFun    interpolate;
   void                      (* set_buffer) (GeglSampler *self,
                                             GeglBuffer  *buffer);
+  GeglSamplerInterpolateNFun   interpolate_n;
 };
 
 GType gegl_sampler_get_type    (void) G_GNUC_CONST;
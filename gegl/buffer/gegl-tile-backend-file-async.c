@@ -50,6 +50,7 @@
 #include "gegl-tile-backend-file.h"
 #include "gegl-buffer-index.h"
 #include "gegl-buffer-swap.h"
+#include "gegl-compression.h"
 #include "gegl-buffer-types.h"
 #include "gegl-debug.h"
 #include "gegl-buffer-config.h"
@@ -108,6 +109,12 @@ struct _GeglTileBackendFile
    */
   GeglBufferHeader header;
 
+  /* the algorithm compressed tiles are stored with, for files in the
+   * GEGL_FILE_SPEC_REV_V2 format.  tiles written by us are always stored
+   * uncompressed.
+   */
+  const GeglCompression *compression;
+
   /* cached offsets of the file handles to avoid lseek syscall if possible */
   gint             in_offset;
   gint             out_offset;
@@ -144,6 +151,8 @@ struct _GeglTileBackendFile
 
 
 static void     gegl_tile_backend_file_ensure_exist (GeglTileBackendFile  *self);
+static void     gegl_tile_backend_file_entry_alloc  (GeglTileBackendFile  *self,
+                                                     GeglFileBackendEntry *entry);
 static gboolean gegl_tile_backend_file_write_block  (GeglTileBackendFile  *self,
                                                      GeglFileBackendEntry *block);
 static void     gegl_tile_backend_file_dbg_alloc    (int                   size);
@@ -357,7 +366,41 @@ gegl_tile_backend_file_entry_read (GeglTileBackendFile  *self,
       self->in_offset = offset;
     }
 
-  while (to_be_read > 0)
+  if (entry->stored_size)
+    {
+      const Babl *format = gegl_tile_backend_get_format (GEGL_TILE_BACKEND (self));
+      guchar     *compressed;
+      gint        byte_read;
+
+      compressed = gegl_scratch_alloc (entry->stored_size);
+      byte_read  = read (self->i, compressed, entry->stored_size);
+
+      if (byte_read == entry->stored_size)
+        {
+          self->in_offset += byte_read;
+
+          if (! self->compression ||
+              ! gegl_compression_decompress (
+                  self->compression, format,
+                  dest, tile_size / babl_format_get_bytes_per_pixel (format),
+                  compressed, entry->stored_size))
+            {
+              g_warning ("failed to decompress tile");
+            }
+        }
+      else
+        {
+          g_message ("unable to read compressed tile data from self: "
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), byte_read, entry->stored_size);
+
+          self->in_offset = -1;
+        }
+
+      gegl_scratch_free (compressed);
+    }
+
+  while (! entry->stored_size && to_be_read > 0)
     {
       GError *error = NULL;
       gint    byte_read;
@@ -388,6 +431,12 @@ gegl_tile_backend_file_entry_write (GeglTileBackendFile  *self,
 
   gegl_tile_backend_file_ensure_exist (self);
 
+  /* a compressed tile's slot is too small for the new data, move the tile to
+   * a slot of its own.  the old slot is not reused.
+   */
+  if (entry->stored_size)
+    gegl_tile_backend_file_entry_alloc (self, entry);
+
   if (entry->tile_link)
     {
       g_mutex_lock (&mutex);
@@ -436,14 +485,12 @@ gegl_tile_backend_file_file_entry_create (gint x,
   return entry;
 }
 
-static inline GeglFileBackendEntry *
-gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+/* assigns entry a slot for an uncompressed tile in the file */
+static void
+gegl_tile_backend_file_entry_alloc (GeglTileBackendFile  *self,
+                                    GeglFileBackendEntry *entry)
 {
-  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
-
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
-
-  gegl_tile_backend_file_ensure_exist (self);
+  entry->stored_size = 0;
 
   if (self->free_list)
     {
@@ -480,6 +527,19 @@ gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
           self->in_offset = self->out_offset = -1;
         }
     }
+}
+
+static inline GeglFileBackendEntry *
+gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+{
+  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
+
+  gegl_tile_backend_file_ensure_exist (self);
+
+  gegl_tile_backend_file_entry_alloc (self, entry);
+
   gegl_tile_backend_file_dbg_alloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
   return entry;
 }
@@ -488,8 +548,14 @@ static void
 gegl_tile_backend_file_file_entry_destroy (GeglTileBackendFile  *self,
                                            GeglFileBackendEntry *entry)
 {
-  guint64 *offset = g_new (guint64, 1);
-  *offset = entry->tile->offset;
+  guint64 *offset = NULL;
+
+  /* only uncompressed slots can be reused for other tiles */
+  if (! entry->stored_size)
+    {
+      offset  = g_new (guint64, 1);
+      *offset = entry->tile->offset;
+    }
 
   if (entry->tile_link || entry->block_link)
     {
@@ -515,7 +581,8 @@ gegl_tile_backend_file_file_entry_destroy (GeglTileBackendFile  *self,
       g_mutex_unlock (&mutex);
     }
 
-  self->free_list = g_slist_prepend (self->free_list, offset);
+  if (offset)
+    self->free_list = g_slist_prepend (self->free_list, offset);
   g_hash_table_remove (self->index, entry);
 
   gegl_tile_backend_file_dbg_dealloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
@@ -786,6 +853,58 @@ gegl_tile_backend_file_exist_tile (GeglTileSource *self,
   return entry!=NULL?((gpointer)0x1):NULL;
 }
 
+/* writes the index of a GEGL_FILE_SPEC_REV_V2 file as a single block, at the
+ * end of the file.
+ */
+static void
+gegl_tile_backend_file_write_index_v2 (GeglTileBackendFile *self,
+                                       GList               *tiles)
+{
+  GeglFileBackendThreadParams *params;
+  GeglBufferIndex             *index;
+  GeglBufferTileV2            *entries;
+  GList                       *iter;
+  gint                         tile_size;
+  gint                         n_tiles;
+  gint                         length;
+  gint                         i;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  n_tiles   = g_list_length (tiles);
+  length    = sizeof (GeglBufferIndex) + n_tiles * sizeof (GeglBufferTileV2);
+
+  index   = g_malloc0 (length);
+  entries = (GeglBufferTileV2 *) (index + 1);
+
+  index->block.flags  = GEGL_FLAG_TILE_INDEX;
+  index->block.length = length;
+  index->n_tiles      = n_tiles;
+
+  for (iter = tiles, i = 0; iter; iter = iter->next, i++)
+    {
+      GeglFileBackendEntry *item = iter->data;
+
+      entries[i].offset = item->tile->offset;
+      entries[i].x      = item->tile->x;
+      entries[i].y      = item->tile->y;
+      entries[i].z      = item->tile->z;
+      entries[i].rev    = item->tile->rev;
+      entries[i].size   = item->stored_size ? item->stored_size : tile_size;
+    }
+
+  params            = g_new0 (GeglFileBackendThreadParams, 1);
+  params->operation = OP_WRITE;
+  params->length    = length;
+  params->offset    = self->next_pre_alloc;
+  params->file      = self;
+  params->source    = (guchar *) index;
+
+  gegl_tile_backend_file_push_queue (params);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "pushed index write of %i tiles at %i",
+             n_tiles, (gint) params->offset);
+}
+
 static gpointer
 gegl_tile_backend_file_flush (GeglTileSource *source,
                               GeglTile       *tile,
@@ -812,6 +931,11 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
 
   if (tiles == NULL)
     self->header.next = 0;
+  else if (gegl_buffer_header_get_rev (&self->header) == GEGL_FILE_SPEC_REV_V2)
+    {
+      gegl_tile_backend_file_write_index_v2 (self, tiles);
+      g_list_free (tiles);
+    }
   else
     {
       GList *iter;
@@ -832,6 +956,55 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
   return (gpointer)0xf0f;
 }
 
+/* lets the kernel start reading the stored tiles in @tiles into the page
+ * cache, merging tiles that are stored next to each other.
+ */
+static gpointer
+gegl_tile_backend_file_prefetch (GeglTileSource      *source,
+                                 const GeglRectangle *tiles,
+                                 gint                 z)
+{
+#ifdef HAVE_POSIX_FADVISE
+  GeglTileBackendFile *self      = GEGL_TILE_BACKEND_FILE (source);
+  gint                 tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (source));
+  goffset              start     = -1;
+  goffset              end       = -1;
+  gint                 x;
+  gint                 y;
+
+  if (self->i == -1)
+    return NULL;
+
+  for (y = tiles->y; y < tiles->y + tiles->height; y++)
+    for (x = tiles->x; x < tiles->x + tiles->width; x++)
+      {
+        GeglFileBackendEntry *entry;
+
+        entry = gegl_tile_backend_file_lookup_entry (self, x, y, z);
+
+        /* queued tiles are read from memory */
+        if (! entry || entry->tile_link)
+          continue;
+
+        if (entry->tile->offset != end)
+          {
+            if (start >= 0)
+              posix_fadvise (self->i, start, end - start, POSIX_FADV_WILLNEED);
+
+            start = entry->tile->offset;
+          }
+
+        end = entry->tile->offset +
+              (entry->stored_size ? entry->stored_size : tile_size);
+      }
+
+  if (start >= 0)
+    posix_fadvise (self->i, start, end - start, POSIX_FADV_WILLNEED);
+#endif
+
+  return NULL;
+}
+
 enum
 {
   PROP_0,
@@ -866,6 +1039,8 @@ gegl_tile_backend_file_command (GeglTileSource  *self,
         return gegl_tile_backend_file_exist_tile (self, data, x, y, z);
       case GEGL_TILE_FLUSH:
         return gegl_tile_backend_file_flush (self, data, x, y, z);
+      case GEGL_TILE_PREFETCH:
+        return gegl_tile_backend_file_prefetch (self, data, z);
 
       default:
         break;
@@ -1036,13 +1211,67 @@ gegl_tile_backend_file_equalfunc (gconstpointer a,
 }
 
 
+/* adds a tile entry read from the file's index, replacing the existing entry
+ * of the tile if its revision differs.
+ */
+static void
+gegl_tile_backend_file_load_entry (GeglTileBackendFile *self,
+                                   GeglBufferTile      *item,
+                                   gint                 stored_size)
+{
+  GeglTileBackend      *backend  = GEGL_TILE_BACKEND (self);
+  GeglFileBackendEntry *new;
+  GeglFileBackendEntry *existing =
+    gegl_tile_backend_file_lookup_entry (self, item->x, item->y, item->z);
+
+  if (existing)
+    {
+      if (existing->tile->rev == item->rev)
+        {
+          g_assert (existing->tile->offset == item->offset);
+          *existing->tile = *item;
+          existing->stored_size = stored_size;
+          g_free (item);
+          return;
+        }
+      else
+        {
+          GeglTileStorage *storage =
+            (void*)gegl_tile_backend_peek_storage (backend);
+          GeglRectangle rect;
+          g_hash_table_remove (self->index, existing);
+
+          gegl_tile_source_refetch (GEGL_TILE_SOURCE (storage),
+                                    existing->tile->x,
+                                    existing->tile->y,
+                                    existing->tile->z);
+
+          if (existing->tile->z == 0)
+            {
+              rect.width = self->header.tile_width;
+              rect.height = self->header.tile_height;
+              rect.x = existing->tile->x * self->header.tile_width;
+              rect.y = existing->tile->y * self->header.tile_height;
+            }
+          g_free (existing->tile);
+          g_free (existing);
+
+          g_signal_emit_by_name (storage, "changed", &rect, NULL);
+        }
+    }
+  new = gegl_tile_backend_file_file_entry_create (0, 0, 0);
+  g_free (new->tile);
+  new->tile        = item;
+  new->stored_size = stored_size;
+  g_hash_table_insert (self->index, new, new);
+}
+
 static void
 gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
                                    gboolean             block)
 {
   GeglBufferHeader  new_header;
   GList            *iter;
-  GeglTileBackend  *backend;
   goffset           offset = 0;
   goffset           max    = 0;
   gint              tile_size;
@@ -1072,59 +1301,59 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
 
   tile_size       = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
   offset          = self->header.next;
-  self->tiles     = gegl_buffer_read_index (self->i, &offset);
   self->in_offset = self->out_offset = -1;
-  backend         = GEGL_TILE_BACKEND (self);
 
-  for (iter = self->tiles; iter; iter=iter->next)
+  if (gegl_buffer_header_get_rev (&self->header) == GEGL_FILE_SPEC_REV_V2)
     {
-      GeglBufferItem       *item     = iter->data;
-      GeglFileBackendEntry *new;
-      GeglFileBackendEntry *existing =
-        gegl_tile_backend_file_lookup_entry (self, item->tile.x, item->tile.y, item->tile.z);
+      GeglBufferTileV2 *entries;
+      gint              n_tiles;
+      gint              i;
 
-      if (item->tile.offset > max)
-        max = item->tile.offset + tile_size;
+      /* the whole index is a single block */
+      entries = gegl_buffer_read_index_v2 (self->i, offset, &n_tiles);
 
-      if (existing)
+      if (self->header.next + sizeof (GeglBufferIndex) +
+          n_tiles * sizeof (GeglBufferTileV2) > max)
         {
-          if (existing->tile->rev == item->tile.rev)
-            {
-              g_assert (existing->tile->offset == item->tile.offset);
-              *existing->tile = item->tile;
-              g_free (item);
-              continue;
-            }
-          else
-            {
-              GeglTileStorage *storage =
-                (void*)gegl_tile_backend_peek_storage (backend);
-              GeglRectangle rect;
-              g_hash_table_remove (self->index, existing);
-
-              gegl_tile_source_refetch (GEGL_TILE_SOURCE (storage),
-                                        existing->tile->x,
-                                        existing->tile->y,
-                                        existing->tile->z);
-
-              if (existing->tile->z == 0)
-                {
-                  rect.width = self->header.tile_width;
-                  rect.height = self->header.tile_height;
-                  rect.x = existing->tile->x * self->header.tile_width;
-                  rect.y = existing->tile->y * self->header.tile_height;
-                }
-              g_free (existing->tile);
-              g_free (existing);
-
-              g_signal_emit_by_name (storage, "changed", &rect, NULL);
-            }
+          max = self->header.next + sizeof (GeglBufferIndex) +
+                n_tiles * sizeof (GeglBufferTileV2);
+        }
+
+      for (i = 0; i < n_tiles; i++)
+        {
+          GeglBufferTile *item = gegl_tile_entry_new (entries[i].x,
+                                                      entries[i].y,
+                                                      entries[i].z);
+          gint            size = entries[i].size;
+
+          item->offset = entries[i].offset;
+          item->rev    = entries[i].rev;
+
+          if (item->offset + size > max)
+            max = item->offset + size;
+
+          gegl_tile_backend_file_load_entry (self, item,
+                                             size < tile_size ? size : 0);
         }
-      new = gegl_tile_backend_file_file_entry_create (0, 0, 0);
-      new->tile = iter->data;
-      g_hash_table_insert (self->index, new, new);
+
+      g_free (entries);
     }
-  g_list_free (self->tiles);
+  else
+    {
+      self->tiles = gegl_buffer_read_index (self->i, &offset);
+
+      for (iter = self->tiles; iter; iter=iter->next)
+        {
+          GeglBufferItem *item = iter->data;
+
+          if (item->tile.offset > max)
+            max = item->tile.offset + tile_size;
+
+          gegl_tile_backend_file_load_entry (self, &item->tile, 0);
+        }
+      g_list_free (self->tiles);
+    }
+
   gegl_tile_backend_file_free_free_list (self);
   self->next_pre_alloc = max; /* if bigger than own? */
   self->total          = max;
@@ -1209,6 +1438,21 @@ gegl_tile_backend_file_constructed (GObject *object)
                                                     self->header.width,
                                                     self->header.height};
 
+      if (gegl_buffer_header_get_rev (&self->header) == GEGL_FILE_SPEC_REV_V2 &&
+          self->header.compression[0])
+        {
+          gchar name[sizeof (self->header.compression) + 1] = "";
+
+          memcpy (name, self->header.compression,
+                  sizeof (self->header.compression));
+
+          self->compression = gegl_compression (name);
+
+          if (! self->compression)
+            g_warning ("%s: unknown compression algorithm '%s'",
+                       self->path, name);
+        }
+
       /* insert each of the entries into the hash table */
       gegl_tile_backend_file_load_index (self, TRUE);
       self->exist = TRUE;
@@ -54,6 +54,10 @@ typedef struct
      tile data or a GeglBufferBlock*/
   GList          *tile_link;
   GList          *block_link;
+  /* size of the compressed tile data in a GEGL_FILE_SPEC_REV_V2 file, or 0
+   * if the tile is stored uncompressed
+   */
+  gint            stored_size;
 } GeglFileBackendEntry;
 
 typedef struct
@@ -0,0 +1,739 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* GeglTileBackendMmap maps a .gegl file into memory, and hands out tiles whose
+ * data points directly into the mapping, so that opening the file only costs
+ * reading its index, and so that processes opening the same file share a
+ * single copy of it in the page cache.
+ *
+ * all the tiles handed out for a given file entry are clones of a single
+ * "master" tile, which is owned by the backend and never locked.  since the
+ * master tile keeps the clone count of the entry above 1, locking any of the
+ * handed-out tiles for writing unclones it into freshly allocated memory,
+ * using the regular GeglTile copy-on-write machinery.  modified tiles are
+ * then stored in an in-memory overlay, and are never written back to the
+ * file.
+ *
+ * the clone group of each entry holds a reference to the mapping, which is
+ * dropped by the last tile of the group, so that the mapping outlives the
+ * backend as long as any of its tiles is alive (e.g., after gegl_buffer_copy()
+ * shared the tiles with another buffer).  the file is mapped privately, and
+ * writable, so that the last surviving tile of a group, which doesn't need to
+ * unclone, writes into private copies of the affected pages, rather than
+ * into the file.
+ *
+ * compressed tiles of GEGL_FILE_SPEC_REV_V2 files, as well as tiles whose
+ * data isn't suitably aligned, can't be handed out in place, and are decoded,
+ * or copied, into regular tiles instead.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "gegl-buffer.h"
+#include "gegl-buffer-backend.h"
+#include "gegl-tile-backend.h"
+#include "gegl-tile-backend-mmap.h"
+#include "gegl-buffer-index.h"
+#include "gegl-compression.h"
+#include "gegl-debug.h"
+
+/* We need the private header so we can set up the clone state of tiles */
+#include "gegl-buffer-private.h"
+
+#ifdef G_OS_WIN32
+#define BINARY_FLAG O_BINARY
+#else
+#define BINARY_FLAG 0
+#endif
+
+/* the alignment tile data needs in order to be handed out in place.  tile
+ * data is only ever accessed a component at a time, so this doesn't need to
+ * match the alignment of gegl_tile_alloc().
+ */
+#define MMAP_TILE_ALIGNMENT sizeof (gdouble)
+
+typedef struct _MmapEntry    MmapEntry;
+typedef struct _OverlayEntry OverlayEntry;
+
+struct _MmapEntry
+{
+  gint      x;
+  gint      y;
+  gint      z;
+
+  guint     rev;
+  guint64   offset;
+  gint      size;        /* the stored size, smaller than the tile size if the
+                          * tile is compressed
+                          */
+
+  GeglTile *tile;        /* the master tile of the entry, or NULL */
+  gint      n_clones[2]; /* the clone counters of the entry's tiles */
+};
+
+struct _OverlayEntry
+{
+  gint      x;
+  gint      y;
+  gint      z;
+
+  GeglTile *tile;        /* the modified tile, or NULL if the tile was voided */
+};
+
+struct _GeglMmapMapping
+{
+  gint         ref_count;
+
+  GMappedFile *file;
+  MmapEntry   *entries;
+  gint         n_entries;
+};
+
+G_DEFINE_TYPE (GeglTileBackendMmap, gegl_tile_backend_mmap, GEGL_TYPE_TILE_BACKEND)
+#define parent_class gegl_tile_backend_mmap_parent_class
+
+enum
+{
+  PROP_0,
+  PROP_PATH
+};
+
+
+static GeglMmapMapping *
+gegl_mmap_mapping_ref (GeglMmapMapping *mapping)
+{
+  g_atomic_int_inc (&mapping->ref_count);
+
+  return mapping;
+}
+
+static void
+gegl_mmap_mapping_unref (GeglMmapMapping *mapping)
+{
+  if (g_atomic_int_dec_and_test (&mapping->ref_count))
+    {
+      g_mapped_file_unref (mapping->file);
+      g_free (mapping->entries);
+
+      g_slice_free (GeglMmapMapping, mapping);
+    }
+}
+
+/* both MmapEntry and OverlayEntry start with the tile coordinates */
+static guint
+gegl_tile_backend_mmap_hashfunc (gconstpointer key)
+{
+  const gint *e    = key;
+  guint       hash;
+  gint        i;
+  gint        srcA = e[0];
+  gint        srcB = e[1];
+  gint        srcC = e[2];
+
+  /* interleave the 10 least significant bits of all coordinates,
+   * this gives us Z-order / morton order of the space and should
+   * work well as a hash
+   */
+  hash = 0;
+  for (i = 9; i >= 0; i--)
+    {
+#define ADD_BIT(bit)    do { hash |= (((bit) != 0) ? 1 : 0); hash <<= 1; } while (0)
+      ADD_BIT (srcA & (1 << i));
+      ADD_BIT (srcB & (1 << i));
+      ADD_BIT (srcC & (1 << i));
+#undef ADD_BIT
+    }
+  return hash;
+}
+
+static gboolean
+gegl_tile_backend_mmap_equalfunc (gconstpointer a,
+                                  gconstpointer b)
+{
+  const gint *ea = a;
+  const gint *eb = b;
+
+  if (ea[0] == eb[0] &&
+      ea[1] == eb[1] &&
+      ea[2] == eb[2])
+    return TRUE;
+
+  return FALSE;
+}
+
+static void
+overlay_entry_free_func (gpointer data)
+{
+  OverlayEntry *entry = data;
+
+  if (entry->tile)
+    {
+      /* Mark as stored to prevent an attempt to store by tile_unref */
+      gegl_tile_mark_as_stored (entry->tile);
+      gegl_tile_unref (entry->tile);
+    }
+
+  g_slice_free (OverlayEntry, entry);
+}
+
+static inline gpointer
+lookup (GHashTable *table,
+        gint        x,
+        gint        y,
+        gint        z)
+{
+  gint key[3] = {x, y, z};
+
+  return g_hash_table_lookup (table, key);
+}
+
+static GeglTile *
+gegl_tile_backend_mmap_entry_get_tile (GeglTileBackendMmap *self,
+                                       MmapEntry           *entry)
+{
+  GeglTileBackend *backend   = GEGL_TILE_BACKEND (self);
+  gint             tile_size = gegl_tile_backend_get_tile_size (backend);
+  const guchar    *data;
+  GeglTile        *tile;
+
+  data = (const guchar *) g_mapped_file_get_contents (self->mapping->file) +
+         entry->offset;
+
+  if (entry->size < tile_size)
+    {
+      const Babl *format = gegl_tile_backend_get_format (backend);
+      gint        n      = tile_size / babl_format_get_bytes_per_pixel (format);
+
+      tile = gegl_tile_new (tile_size);
+
+      if (! self->compression ||
+          ! gegl_compression_decompress (self->compression, format,
+                                         gegl_tile_get_data (tile), n,
+                                         data, entry->size))
+        {
+          g_warning ("%s: failed to decompress tile %d,%d,%d",
+                     self->path, entry->x, entry->y, entry->z);
+
+          memset (gegl_tile_get_data (tile), 0, tile_size);
+        }
+    }
+  else if (GPOINTER_TO_SIZE (data) % MMAP_TILE_ALIGNMENT)
+    {
+      tile = gegl_tile_new (tile_size);
+
+      memcpy (gegl_tile_get_data (tile), data, tile_size);
+    }
+  else
+    {
+      if (! entry->tile)
+        {
+          GeglTile *master = gegl_tile_new_bare ();
+
+          master->data           = (guchar *) data;
+          master->size           = tile_size;
+          master->is_global_tile = TRUE;
+
+          master->n_clones   = entry->n_clones;
+          entry->n_clones[0] = 1;
+
+          /* avoid counting the tiles of the mapping towards the total cache
+           * size, since their memory is backed by the file, like we do for
+           * the empty tile.
+           */
+          entry->n_clones[1] = 1;
+
+          master->destroy_notify      = (GDestroyNotify) gegl_mmap_mapping_unref;
+          master->destroy_notify_data = gegl_mmap_mapping_ref (self->mapping);
+
+          entry->tile = master;
+        }
+
+      tile = gegl_tile_dup (entry->tile);
+    }
+
+  gegl_tile_set_rev (tile, entry->rev);
+  gegl_tile_mark_as_stored (tile);
+
+  return tile;
+}
+
+static GeglTile *
+get_tile (GeglTileSource *tile_store,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (tile_store);
+  OverlayEntry        *overlay;
+  MmapEntry           *entry;
+
+  overlay = lookup (self->overlay, x, y, z);
+
+  if (overlay)
+    return overlay->tile ? gegl_tile_ref (overlay->tile) : NULL;
+
+  entry = lookup (self->index, x, y, z);
+
+  if (entry)
+    return gegl_tile_backend_mmap_entry_get_tile (self, entry);
+
+  return NULL;
+}
+
+static gboolean
+set_tile (GeglTileSource *store,
+          GeglTile       *tile,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileBackendMmap *self   = GEGL_TILE_BACKEND_MMAP (store);
+  OverlayEntry        *entry;
+  gboolean             is_dup = FALSE;
+
+  entry = lookup (self->overlay, x, y, z);
+
+  if (G_UNLIKELY (tile->ref_count == 0))
+    {
+      /* We've been handed a dead tile to store, see the ram backend */
+      tile = gegl_tile_dup (tile);
+
+      tile->x = x;
+      tile->y = y;
+      tile->z = z;
+
+      is_dup = TRUE;
+    }
+
+  if (! entry)
+    {
+      entry = g_slice_new (OverlayEntry);
+      entry->x    = x;
+      entry->y    = y;
+      entry->z    = z;
+      entry->tile = NULL;
+      g_hash_table_insert (self->overlay, entry, entry);
+    }
+  else if (entry->tile == tile)
+    {
+      gegl_tile_mark_as_stored (tile);
+      return TRUE;
+    }
+  else if (entry->tile)
+    {
+      /* Mark as stored to prevent a recursive attempt to store by tile_unref */
+      gegl_tile_mark_as_stored (entry->tile);
+      gegl_tile_unref (entry->tile);
+    }
+
+  entry->tile = tile;
+
+  if (! is_dup)
+    gegl_tile_ref (entry->tile);
+
+  gegl_tile_mark_as_stored (entry->tile);
+
+  return TRUE;
+}
+
+static gboolean
+void_tile (GeglTileSource *store,
+           GeglTile       *tile,
+           gint            x,
+           gint            y,
+           gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (store);
+  OverlayEntry        *entry;
+
+  entry = lookup (self->overlay, x, y, z);
+
+  if (entry)
+    {
+      if (entry->tile)
+        {
+          gegl_tile_mark_as_stored (entry->tile);
+          gegl_tile_unref (entry->tile);
+          entry->tile = NULL;
+        }
+    }
+  else if (lookup (self->index, x, y, z))
+    {
+      /* the file can't change, so mask the file's tile instead */
+      entry = g_slice_new (OverlayEntry);
+      entry->x    = x;
+      entry->y    = y;
+      entry->z    = z;
+      entry->tile = NULL;
+      g_hash_table_insert (self->overlay, entry, entry);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+exist_tile (GeglTileSource *store,
+            GeglTile       *tile,
+            gint            x,
+            gint            y,
+            gint            z)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (store);
+  OverlayEntry        *entry;
+
+  entry = lookup (self->overlay, x, y, z);
+
+  if (entry)
+    return entry->tile != NULL;
+
+  return lookup (self->index, x, y, z) != NULL;
+}
+
+static gpointer
+gegl_tile_backend_mmap_command (GeglTileSource  *tile_store,
+                                GeglTileCommand  command,
+                                gint             x,
+                                gint             y,
+                                gint             z,
+                                gpointer         data)
+{
+  switch (command)
+    {
+      case GEGL_TILE_GET:
+        return get_tile (tile_store, x, y, z);
+
+      case GEGL_TILE_SET:
+        set_tile (tile_store, data, x, y, z);
+        return NULL;
+
+      case GEGL_TILE_IDLE:
+        return NULL;
+
+      case GEGL_TILE_VOID:
+        void_tile (tile_store, data, x, y, z);
+        return NULL;
+
+      case GEGL_TILE_EXIST:
+        return GINT_TO_POINTER (exist_tile (tile_store, data, x, y, z));
+
+      case GEGL_TILE_FLUSH:
+        /* the file is read-only */
+        return NULL;
+
+      default:
+        break;
+    }
+
+  return gegl_tile_backend_command (GEGL_TILE_BACKEND (tile_store),
+                                    command, x, y, z, data);
+}
+
+static gboolean
+gegl_tile_backend_mmap_add_entry (GeglTileBackendMmap *self,
+                                  GArray              *entries,
+                                  gint                 x,
+                                  gint                 y,
+                                  gint                 z,
+                                  guint                rev,
+                                  guint64              offset,
+                                  gint                 size)
+{
+  gsize     length = g_mapped_file_get_length (self->mapping->file);
+  MmapEntry entry  = { 0, };
+
+  if (size <= 0 || offset > length || length - offset < (guint64) size)
+    {
+      g_warning ("%s: tile %d,%d,%d is out of bounds", self->path, x, y, z);
+      return FALSE;
+    }
+
+  entry.x      = x;
+  entry.y      = y;
+  entry.z      = z;
+  entry.rev    = rev;
+  entry.offset = offset;
+  entry.size   = size;
+
+  g_array_append_val (entries, entry);
+
+  return TRUE;
+}
+
+/* reads the index of the file, and builds the entries of the mapping */
+static void
+gegl_tile_backend_mmap_load_index (GeglTileBackendMmap    *self,
+                                   int                     i,
+                                   const GeglBufferHeader *header)
+{
+  GeglTileBackend *backend   = GEGL_TILE_BACKEND (self);
+  gint             tile_size = gegl_tile_backend_get_tile_size (backend);
+  GArray          *entries;
+  gint             n;
+
+  entries = g_array_new (FALSE, FALSE, sizeof (MmapEntry));
+
+  if (gegl_buffer_header_get_rev (header) == GEGL_FILE_SPEC_REV_V2)
+    {
+      GeglBufferTileV2 *tiles;
+      gint              n_tiles;
+
+      tiles = gegl_buffer_read_index_v2 (i, header->next, &n_tiles);
+
+      for (n = 0; n < n_tiles; n++)
+        {
+          gegl_tile_backend_mmap_add_entry (self, entries,
+                                            tiles[n].x, tiles[n].y, tiles[n].z,
+                                            tiles[n].rev, tiles[n].offset,
+                                            MIN ((gint) tiles[n].size,
+                                                 tile_size));
+        }
+
+      g_free (tiles);
+    }
+  else
+    {
+      goffset  offset = header->next;
+      GList   *tiles  = gegl_buffer_read_index (i, &offset);
+      GList   *iter;
+
+      for (iter = tiles; iter; iter = iter->next)
+        {
+          GeglBufferItem *item = iter->data;
+
+          gegl_tile_backend_mmap_add_entry (self, entries,
+                                            item->tile.x,
+                                            item->tile.y,
+                                            item->tile.z,
+                                            item->tile.rev,
+                                            item->tile.offset,
+                                            tile_size);
+
+          g_free (item);
+        }
+
+      g_list_free (tiles);
+    }
+
+  self->mapping->n_entries = entries->len;
+  self->mapping->entries   = (MmapEntry *) g_array_free (entries, FALSE);
+
+  /* later entries take precedence, like they do for the file backend */
+  for (n = 0; n < self->mapping->n_entries; n++)
+    {
+      MmapEntry *entry = &self->mapping->entries[n];
+
+      g_hash_table_replace (self->index, entry, entry);
+    }
+}
+
+static void
+gegl_tile_backend_mmap_constructed (GObject *object)
+{
+  GeglTileBackendMmap    *self    = GEGL_TILE_BACKEND_MMAP (object);
+  GeglTileBackend        *backend = GEGL_TILE_BACKEND (object);
+  const GeglBufferHeader *header;
+  GMappedFile            *file;
+  GError                 *error   = NULL;
+  int                     i;
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+
+  gegl_tile_backend_set_flush_on_destroy (backend, FALSE);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "constructing mmap backend: %s", self->path);
+
+  i = g_open (self->path, O_RDONLY|BINARY_FLAG, 0);
+
+  if (i == -1)
+    {
+      g_warning ("%s: Could not open '%s': %s", G_STRFUNC, self->path, g_strerror (errno));
+      return;
+    }
+
+  file = g_mapped_file_new_from_fd (i, TRUE, &error);
+
+  if (! file)
+    {
+      g_warning ("%s: Could not map '%s': %s", G_STRFUNC, self->path, error->message);
+      g_error_free (error);
+      close (i);
+      return;
+    }
+
+  header = (const GeglBufferHeader *) g_mapped_file_get_contents (file);
+
+  if (g_mapped_file_get_length (file) < sizeof (GeglBufferHeader) ||
+      memcmp (header->magic, "GEGL", 4))
+    {
+      g_warning ("%s: '%s' is not a GeglBuffer file", G_STRFUNC, self->path);
+      g_mapped_file_unref (file);
+      close (i);
+      return;
+    }
+
+  if (header->tile_width  != gegl_tile_backend_get_tile_width (backend) ||
+      header->tile_height != gegl_tile_backend_get_tile_height (backend) ||
+      babl_format (header->description) != gegl_tile_backend_get_format (backend))
+    {
+      g_warning ("%s: the backend's tile layout doesn't match '%s'", G_STRFUNC, self->path);
+      g_mapped_file_unref (file);
+      close (i);
+      return;
+    }
+
+  self->mapping            = g_slice_new0 (GeglMmapMapping);
+  self->mapping->ref_count = 1;
+  self->mapping->file      = file;
+
+  if (gegl_buffer_header_get_rev (header) == GEGL_FILE_SPEC_REV_V2 &&
+      header->compression[0])
+    {
+      gchar name[sizeof (header->compression) + 1] = "";
+
+      memcpy (name, header->compression, sizeof (header->compression));
+
+      self->compression = gegl_compression (name);
+
+      if (! self->compression)
+        g_warning ("%s: unknown compression algorithm '%s'",
+                   self->path, name);
+    }
+
+  gegl_tile_backend_set_extent (backend,
+                                GEGL_RECTANGLE (header->x, header->y,
+                                                header->width, header->height));
+
+  gegl_tile_backend_mmap_load_index (self, i, header);
+
+  /* the mapping remains valid after closing the file */
+  close (i);
+}
+
+static void
+gegl_tile_backend_mmap_finalize (GObject *object)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (object);
+
+  g_hash_table_unref (self->overlay);
+  g_hash_table_unref (self->index);
+
+  if (self->mapping)
+    {
+      gint i;
+
+      /* drop the master tiles.  if any of their clones is still alive, the
+       * clone group keeps the mapping alive until the last clone is gone.
+       */
+      for (i = 0; i < self->mapping->n_entries; i++)
+        {
+          MmapEntry *entry = &self->mapping->entries[i];
+
+          if (entry->tile)
+            gegl_tile_unref (entry->tile);
+        }
+
+      gegl_mmap_mapping_unref (self->mapping);
+    }
+
+  g_free (self->path);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+set_property (GObject       *object,
+              guint          property_id,
+              const GValue  *value,
+              GParamSpec    *pspec)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (object);
+
+  switch (property_id)
+    {
+      case PROP_PATH:
+        g_free (self->path);
+        self->path = g_value_dup_string (value);
+        break;
+
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject    *object,
+              guint       property_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (object);
+
+  switch (property_id)
+    {
+      case PROP_PATH:
+        g_value_set_string (value, self->path);
+        break;
+
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+gegl_tile_backend_mmap_class_init (GeglTileBackendMmapClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->get_property = get_property;
+  gobject_class->set_property = set_property;
+  gobject_class->constructed  = gegl_tile_backend_mmap_constructed;
+  gobject_class->finalize     = gegl_tile_backend_mmap_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_PATH,
+                                   g_param_spec_string ("path",
+                                                        "path",
+                                                        "The path of the mapped file",
+                                                        NULL,
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gegl_tile_backend_mmap_init (GeglTileBackendMmap *self)
+{
+  GEGL_TILE_SOURCE (self)->command = gegl_tile_backend_mmap_command;
+
+  self->index   = g_hash_table_new (gegl_tile_backend_mmap_hashfunc,
+                                    gegl_tile_backend_mmap_equalfunc);
+  self->overlay = g_hash_table_new_full (gegl_tile_backend_mmap_hashfunc,
+                                         gegl_tile_backend_mmap_equalfunc,
+                                         NULL,
+                                         overlay_entry_free_func);
+}
@@ -0,0 +1,65 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_BACKEND_MMAP_H__
+#define __GEGL_TILE_BACKEND_MMAP_H__
+
+#include "gegl-tile-backend.h"
+#include "gegl-compression.h"
+
+/***
+ * GeglTileBackendMmap is a read-only GeglTileBackend that maps a .gegl file
+ * into memory, and hands out tiles pointing directly into the mapping.
+ * Modified tiles are kept in memory, and are never written back to the file.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_BACKEND_MMAP            (gegl_tile_backend_mmap_get_type ())
+#define GEGL_TILE_BACKEND_MMAP(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmap))
+#define GEGL_TILE_BACKEND_MMAP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+#define GEGL_IS_TILE_BACKEND_MMAP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_IS_TILE_BACKEND_MMAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_TILE_BACKEND_MMAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+
+typedef struct _GeglTileBackendMmap      GeglTileBackendMmap;
+typedef struct _GeglTileBackendMmapClass GeglTileBackendMmapClass;
+
+typedef struct _GeglMmapMapping          GeglMmapMapping;
+
+struct _GeglTileBackendMmap
+{
+  GeglTileBackend        parent_instance;
+
+  gchar                 *path;
+
+  GeglMmapMapping       *mapping;     /* the mapped file, and its tile index */
+  GHashTable            *index;       /* (x,y,z) -> entry of the mapping     */
+  GHashTable            *overlay;     /* (x,y,z) -> modified or voided tile  */
+
+  const GeglCompression *compression; /* compression of the stored tiles     */
+};
+
+struct _GeglTileBackendMmapClass
+{
+  GeglTileBackendClass parent_class;
+};
+
+GType gegl_tile_backend_mmap_get_type (void) G_GNUC_CONST;
+
+G_END_DECLS
+
+#endif
@@ -23,6 +23,7 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -71,6 +72,15 @@
  */
 #define COMPRESSION_MAX_RATIO 0.95
 
+/* maximal number of queued ops a single i/o thread serves at once.  the
+ * blocks of a batch are compressed together, and written with as few
+ * writes as possible, by merging those that end up adjacent in the file.
+ */
+#define SWAP_BATCH_SIZE 8
+
+/* maximal number of i/o threads */
+#define SWAP_MAX_IO_THREADS 16
+
 
 G_DEFINE_TYPE (GeglTileBackendSwap, gegl_tile_backend_swap, GEGL_TYPE_TILE_BACKEND)
 
@@ -83,12 +93,15 @@ typedef enum
   OP_DESTROY,
 } ThreadOp;
 
+typedef struct _ThreadParams ThreadParams;
+
 typedef struct
 {
   gint                   ref_count;
   gint                   size;
   const GeglCompression *compression;
   GList                 *link;
+  ThreadParams          *in_progress; /* op currently served by an i/o thread */
   gint64                 offset;
 } SwapBlock;
 
@@ -100,7 +113,7 @@ typedef struct
   SwapBlock *block;
 } SwapEntry;
 
-typedef struct
+struct _ThreadParams
 {
   SwapBlock  *block;
   const Babl *format;
@@ -109,7 +122,17 @@ typedef struct
   gint        size;
   gint        compressed_size;
   ThreadOp    operation;
-} ThreadParams;
+};
+
+/* the data of a write op, once it's ready to be written */
+typedef struct
+{
+  ThreadParams *params;
+  const guint8 *data;
+  gint          size;
+  gpointer      buffer; /* scratch buffer holding the compressed data */
+  gint64        offset;
+} SwapWrite;
 
 typedef struct _SwapGap
 {
@@ -143,8 +166,19 @@ static void        gegl_tile_backend_swap_free_block             (SwapBlock
 static gint        gegl_tile_backend_swap_get_data_size          (ThreadParams              *params);
 static gint        gegl_tile_backend_swap_get_data_cost          (ThreadParams              *params);
 static void        gegl_tile_backend_swap_free_data              (ThreadParams              *params);
-static void        gegl_tile_backend_swap_write                  (ThreadParams              *params);
+static void        gegl_tile_backend_swap_prepare_write          (ThreadParams              *params,
+                                                                  SwapWrite                 *swap_write);
+static void        gegl_tile_backend_swap_allocate_write         (SwapWrite                 *swap_write);
+static gboolean    gegl_tile_backend_swap_write_at               (const guint8              *data,
+                                                                  gint                       size,
+                                                                  gint64                     offset);
+static gboolean    gegl_tile_backend_swap_read_at                (guint8                    *data,
+                                                                  gint                       size,
+                                                                  gint64                     offset);
+static void        gegl_tile_backend_swap_write_batch            (ThreadParams             **batch,
+                                                                  gint                       n);
 static void        gegl_tile_backend_swap_destroy                (ThreadParams              *params);
+static gint        gegl_tile_backend_swap_pop_batch              (ThreadParams             **batch);
 static gpointer    gegl_tile_backend_swap_writer_thread          (gpointer ignored);
 static GeglTile   *gegl_tile_backend_swap_entry_read             (GeglTileBackendSwap       *self,
                                                                   SwapEntry                 *entry);
@@ -195,6 +229,9 @@ static gpointer    gegl_tile_backend_swap_copy_tile              (GeglTileSource
                                                                   gint                       y,
                                                                   gint                       z,
                                                                   const GeglTileCopyParams  *params);
+static gpointer    gegl_tile_backend_swap_prefetch               (GeglTileSource            *self,
+                                                                  const GeglRectangle       *tiles,
+                                                                  gint                       z);
 static gpointer    gegl_tile_backend_swap_command                (GeglTileSource            *self,
                                                                   GeglTileCommand            command,
                                                                   gint                       x,
@@ -219,30 +256,33 @@ static gchar                 *path               = NULL;
 static const GeglCompression *compression        = NULL;
 static gint                   in_fd              = -1;
 static gint                   out_fd             = -1;
+#if ! defined (HAVE_PREAD) || ! defined (HAVE_PWRITE)
 static gint64                 in_offset          = 0;
 static gint64                 out_offset         = 0;
+#endif
 static SwapGap               *gap_list           = NULL;
 static GTree                 *gap_tree           = NULL;
 static gint64                 file_size          = 0;
 static gint64                 total              = 0;
 static guintptr               total_uncompressed = 0;
 static gboolean               busy               = FALSE;
-static gboolean               reading            = FALSE;
+static gint                  reading            = 0; /* number of reads in progress */
 static gint64                 read_total         = 0;
-static gboolean               writing            = FALSE;
+static gint                   writing            = 0; /* number of writes in progress */
 static gint64                 write_total        = 0;
 static gint64                 queued_total       = 0;
 static gint64                 queued_cost        = 0;
 static gint64                 queued_max         = 0;
 static gint                   queue_stalls       = 0;
 
-static GThread      *writer_thread           = NULL;
+static GThread      *writer_threads[SWAP_MAX_IO_THREADS];
+static gint          n_writer_threads        = 0;
 static GQueue       *queue                   = NULL;
-static ThreadParams *in_progress             = NULL;
+static gint          n_in_progress           = 0;
 static gboolean      exit_thread             = FALSE;
-static gpointer      compression_buffer      = NULL;
-static gint          compression_buffer_size = 0;
-static GMutex        read_mutex;
+static GMutex        read_mutex;  /* guards read_total, and in_offset */
+static GMutex        write_mutex; /* guards write_total, and out_offset */
+static GMutex        gap_mutex;   /* guards the swap-file allocation */
 static GMutex        queue_mutex;
 static GCond         queue_cond;
 static GCond         push_cond;
@@ -552,19 +592,21 @@ gegl_tile_backend_swap_free_data (ThreadParams *params)
     }
 }
 
+/* compresses the data of a write op, if needed.  called without any lock
+ * held, so that the i/o threads compress in parallel.
+ */
 static void
-gegl_tile_backend_swap_write (ThreadParams *params)
+gegl_tile_backend_swap_prepare_write (ThreadParams *params,
+                                      SwapWrite    *swap_write)
 {
-  const guint8 *data;
-  gint64        offset = params->block->offset;
-  gint          to_be_written;
-
-  gegl_tile_backend_swap_ensure_exist ();
+  swap_write->params = params;
+  swap_write->buffer = NULL;
+  swap_write->offset = -1;
 
   if (params->tile)
     {
-      data          = gegl_tile_get_data (params->tile);
-      to_be_written = params->size;
+      swap_write->data = gegl_tile_get_data (params->tile);
+      swap_write->size = params->size;
 
       if (params->block->compression)
         {
@@ -574,35 +616,43 @@ gegl_tile_backend_swap_write (ThreadParams *params)
 
           max_compressed_size = params->size * COMPRESSION_MAX_RATIO;
 
-          if (max_compressed_size > compression_buffer_size)
-            {
-              compression_buffer      = g_realloc (compression_buffer,
-                                                   max_compressed_size);
-              compression_buffer_size = max_compressed_size;
-            }
+          swap_write->buffer = gegl_scratch_alloc (max_compressed_size);
 
           if (gegl_compression_compress (params->block->compression,
                                          params->format,
-                                         data, params->size / bpp,
-                                         compression_buffer, &compressed_size,
+                                         swap_write->data, params->size / bpp,
+                                         swap_write->buffer, &compressed_size,
                                          max_compressed_size))
             {
-              data          = compression_buffer;
-              to_be_written = compressed_size;
+              swap_write->data = swap_write->buffer;
+              swap_write->size = compressed_size;
             }
           else
             {
               params->block->compression = NULL;
+
+              gegl_scratch_free (swap_write->buffer);
+              swap_write->buffer = NULL;
             }
         }
     }
   else
     {
-      data          = params->compressed;
-      to_be_written = params->compressed_size;
+      swap_write->data = params->compressed;
+      swap_write->size = params->compressed_size;
     }
+}
+
+/* finds room for a write op in the swap file.  must be called with
+ * gap_mutex held.
+ */
+static void
+gegl_tile_backend_swap_allocate_write (SwapWrite *swap_write)
+{
+  ThreadParams *params = swap_write->params;
+  gint64        offset = params->block->offset;
 
-  if (offset >= 0 && params->block->size != to_be_written)
+  if (offset >= 0 && params->block->size != swap_write->size)
     {
       g_atomic_pointer_add (&total_uncompressed, -params->size);
 
@@ -614,61 +664,264 @@ gegl_tile_backend_swap_write (ThreadParams *params)
   if (offset < 0)
     {
       /* storage for entry not allocated yet.  allocate now. */
-      offset = gegl_tile_backend_swap_find_offset (to_be_written);
+      offset = gegl_tile_backend_swap_find_offset (swap_write->size);
 
       params->block->offset = offset;
-      params->block->size   = to_be_written;
+      params->block->size   = swap_write->size;
 
       g_atomic_pointer_add (&total_uncompressed, +params->size);
     }
 
-  writing = TRUE;
+  swap_write->offset = offset;
+}
+
+static gboolean
+gegl_tile_backend_swap_write_at (const guint8 *data,
+                                 gint          size,
+                                 gint64        offset)
+{
+  gint to_be_written = size;
+
+#if ! defined (HAVE_PWRITE)
+  g_mutex_lock (&write_mutex);
 
   if (out_offset != offset)
     {
       if (lseek (out_fd, offset, SEEK_SET) < 0)
         {
+          g_mutex_unlock (&write_mutex);
+
           g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
 
-          goto error;
+          return FALSE;
         }
       out_offset = offset;
     }
+#endif
 
   while (to_be_written > 0)
     {
       gint wrote;
+
+#ifdef HAVE_PWRITE
+      wrote = pwrite (out_fd, data, to_be_written, offset);
+#else
       wrote = write (out_fd, data, to_be_written);
+#endif
       if (wrote <= 0)
         {
+#if ! defined (HAVE_PWRITE)
+          g_mutex_unlock (&write_mutex);
+#endif
+
           g_message ("unable to write tile data to self: "
                      "%s (%d/%d bytes written)",
                      g_strerror (errno), wrote, to_be_written);
 
-          goto error;
+          return FALSE;
         }
 
       data          += wrote;
       to_be_written -= wrote;
-      out_offset    += wrote;
+      offset        += wrote;
 
-      write_total   += wrote;
+#ifdef HAVE_PWRITE
+      g_mutex_lock (&write_mutex);
+      write_total += wrote;
+      g_mutex_unlock (&write_mutex);
+#else
+      out_offset  += wrote;
+      write_total += wrote;
+#endif
     }
 
-  writing = FALSE;
+#if ! defined (HAVE_PWRITE)
+  g_mutex_unlock (&write_mutex);
+#endif
+
+  return TRUE;
+}
+
+static gboolean
+gegl_tile_backend_swap_read_at (guint8 *data,
+                                gint    size,
+                                gint64  offset)
+{
+  gint to_be_read = size;
+
+#if ! defined (HAVE_PREAD)
+  g_mutex_lock (&read_mutex);
+
+  if (in_offset != offset)
+    {
+      if (lseek (in_fd, offset, SEEK_SET) < 0)
+        {
+          g_mutex_unlock (&read_mutex);
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote at %i", (gint)offset);
+          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
 
-  return;
+          return FALSE;
+        }
+      in_offset = offset;
+    }
+#endif
 
-error:
-  writing = FALSE;
+  while (to_be_read > 0)
+    {
+      gint bytes_read;
 
-  g_atomic_pointer_add (&total_uncompressed, -params->size);
+#ifdef HAVE_PREAD
+      bytes_read = pread (in_fd, data, to_be_read, offset);
+#else
+      bytes_read = read (in_fd, data, to_be_read);
+#endif
 
-  gegl_tile_backend_swap_free_block (params->block);
+      if (bytes_read <= 0)
+        {
+#if ! defined (HAVE_PREAD)
+          g_mutex_unlock (&read_mutex);
+#endif
+
+          g_message ("unable to read tile data from swap: "
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), bytes_read, to_be_read);
+
+          return FALSE;
+        }
+
+      data       += bytes_read;
+      to_be_read -= bytes_read;
+      offset     += bytes_read;
+
+#ifdef HAVE_PREAD
+      g_mutex_lock (&read_mutex);
+      read_total += bytes_read;
+      g_mutex_unlock (&read_mutex);
+#else
+      in_offset  += bytes_read;
+      read_total += bytes_read;
+#endif
+    }
+
+#if ! defined (HAVE_PREAD)
+  g_mutex_unlock (&read_mutex);
+#endif
+
+  return TRUE;
+}
+
+static gint
+gegl_tile_backend_swap_write_compare (const SwapWrite *write1,
+                                      const SwapWrite *write2)
+{
+  return (write1->offset > write2->offset) -
+         (write1->offset < write2->offset);
+}
+
+/* serves the write ops of a batch:  the data is compressed, the blocks are
+ * allocated, and runs of blocks that are adjacent in the file are written
+ * using a single write.
+ */
+static void
+gegl_tile_backend_swap_write_batch (ThreadParams **batch,
+                                    gint           n)
+{
+  SwapWrite writes[SWAP_BATCH_SIZE];
+  gint      n_writes = 0;
+  gint      i;
+
+  for (i = 0; i < n; i++)
+    gegl_tile_backend_swap_prepare_write (batch[i], &writes[n_writes++]);
+
+  g_mutex_lock (&gap_mutex);
+
+  gegl_tile_backend_swap_ensure_exist ();
+
+  for (i = 0; i < n_writes; i++)
+    gegl_tile_backend_swap_allocate_write (&writes[i]);
+
+  g_mutex_unlock (&gap_mutex);
+
+  qsort (writes, n_writes, sizeof (SwapWrite),
+         (GCompareFunc) gegl_tile_backend_swap_write_compare);
+
+  g_atomic_int_inc (&writing);
+
+  for (i = 0; i < n_writes; )
+    {
+      gint64        offset = writes[i].offset;
+      const guint8 *data   = writes[i].data;
+      gpointer      buffer = NULL;
+      gint          size   = writes[i].size;
+      gint          j;
+
+      if (offset < 0)
+        {
+          i++;
+
+          continue;
+        }
+
+      for (j = i + 1;
+           j < n_writes && writes[j].offset == offset + size;
+           j++)
+        {
+          size += writes[j].size;
+        }
+
+      if (j - i > 1)
+        {
+          gint k;
+
+          buffer = gegl_scratch_alloc (size);
+          size   = 0;
+
+          for (k = i; k < j; k++)
+            {
+              memcpy ((guint8 *) buffer + size, writes[k].data, writes[k].size);
+
+              size += writes[k].size;
+            }
+
+          data = buffer;
+        }
+
+      if (gegl_tile_backend_swap_write_at (data, size, offset))
+        {
+          GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND,
+                     "writer thread wrote %i blocks at %i",
+                     j - i, (gint) offset);
+        }
+      else
+        {
+          gint k;
+
+          g_mutex_lock (&gap_mutex);
+
+          for (k = i; k < j; k++)
+            {
+              g_atomic_pointer_add (&total_uncompressed,
+                                    -writes[k].params->size);
 
-  return;
+              gegl_tile_backend_swap_free_block (writes[k].params->block);
+            }
+
+          g_mutex_unlock (&gap_mutex);
+        }
+
+      if (buffer)
+        gegl_scratch_free (buffer);
+
+      i = j;
+    }
+
+  g_atomic_int_dec_and_test (&writing);
+
+  for (i = 0; i < n_writes; i++)
+    {
+      if (writes[i].buffer)
+        gegl_scratch_free (writes[i].buffer);
+    }
 }
 
 static void
@@ -677,11 +930,49 @@ gegl_tile_backend_swap_destroy (ThreadParams *params)
   if (params->block->offset >= 0)
     g_atomic_pointer_add (&total_uncompressed, -params->size);
 
+  g_mutex_lock (&gap_mutex);
+
   gegl_tile_backend_swap_free_block (params->block);
 
+  g_mutex_unlock (&gap_mutex);
+
   gegl_tile_backend_swap_block_free (params->block);
 }
 
+/* pops up to SWAP_BATCH_SIZE ops off the queue, skipping ops whose block is
+ * being served by another thread, so that the ops of each block are served
+ * in order.  must be called with queue_mutex held.
+ */
+static gint
+gegl_tile_backend_swap_pop_batch (ThreadParams **batch)
+{
+  GList *link = g_queue_peek_head_link (queue);
+  gint   n    = 0;
+
+  while (link && n < SWAP_BATCH_SIZE)
+    {
+      GList        *next   = link->next;
+      ThreadParams *params = link->data;
+
+      if (! params->block || ! params->block->in_progress)
+        {
+          g_queue_delete_link (queue, link);
+
+          if (params->block)
+            {
+              params->block->link        = NULL;
+              params->block->in_progress = params;
+            }
+
+          batch[n++] = params;
+        }
+
+      link = next;
+    }
+
+  return n;
+}
+
 static gpointer
 gegl_tile_backend_swap_writer_thread (gpointer ignored)
 {
@@ -689,44 +980,68 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
 
   while (TRUE)
     {
-      ThreadParams *params;
-
-      while (g_queue_is_empty (queue) && !exit_thread)
+      ThreadParams *batch[SWAP_BATCH_SIZE];
+      ThreadParams *writes[SWAP_BATCH_SIZE];
+      gint          n_batch;
+      gint          n_writes = 0;
+      gint          i;
+
+      while (! (n_batch = gegl_tile_backend_swap_pop_batch (batch)) &&
+             ! exit_thread)
         {
-          busy = FALSE;
+          if (! n_in_progress && g_queue_is_empty (queue))
+            busy = FALSE;
 
           g_cond_wait (&queue_cond, &queue_mutex);
         }
 
-      if (exit_thread)
+      if (! n_batch)
         break;
 
-      params = (ThreadParams *)g_queue_pop_head (queue);
-      if (params->block)
-        {
-          in_progress = params;
-          params->block->link = NULL;
-        }
+      n_in_progress += n_batch;
 
       g_mutex_unlock (&queue_mutex);
 
-      switch (params->operation)
+      /* serve the destroy ops first, so that the write ops are free to reuse
+       * the reclaimed space.
+       */
+      for (i = 0; i < n_batch; i++)
         {
-        case OP_WRITE:
-          gegl_tile_backend_swap_write (params);
-          break;
-        case OP_DESTROY:
-          gegl_tile_backend_swap_destroy (params);
-          break;
+          switch (batch[i]->operation)
+            {
+            case OP_WRITE:
+              writes[n_writes++] = batch[i];
+              break;
+            case OP_DESTROY:
+              gegl_tile_backend_swap_destroy (batch[i]);
+              break;
+            }
         }
 
+      if (n_writes)
+        gegl_tile_backend_swap_write_batch (writes, n_writes);
+
       g_mutex_lock (&queue_mutex);
 
-      in_progress = NULL;
+      for (i = 0; i < n_batch; i++)
+        {
+          ThreadParams *params = batch[i];
+
+          /* the block of a destroy op is already freed */
+          if (params->operation == OP_WRITE)
+            params->block->in_progress = NULL;
 
-      gegl_tile_backend_swap_free_data (params);
+          gegl_tile_backend_swap_free_data (params);
+
+          g_slice_free (ThreadParams, params);
+        }
 
-      g_slice_free (ThreadParams, params);
+      n_in_progress -= n_batch;
+
+      /* ops that were skipped because their block was in progress can now be
+       * served.
+       */
+      g_cond_broadcast (&queue_cond);
     }
 
   g_mutex_unlock (&queue_mutex);
@@ -746,7 +1061,6 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
   gint64           offset;
   gint             tile_size;
   gint             bpp;
-  gint             to_be_read;
 
   format    = gegl_tile_backend_get_format (backend);
   tile_size = gegl_tile_backend_get_tile_size (backend);
@@ -763,14 +1077,14 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
 
   g_mutex_lock (&queue_mutex);
 
-  if (entry->block->link || in_progress)
+  if (entry->block->link || entry->block->in_progress)
     {
-      ThreadParams *queued_op = NULL;
+      ThreadParams *queued_op;
 
       if (entry->block->link)
         queued_op = entry->block->link->data;
-      else if (in_progress->block == entry->block)
-        queued_op = in_progress;
+      else
+        queued_op = entry->block->in_progress;
 
       if (queued_op)
         {
@@ -821,58 +1135,19 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
   else
     data = dest;
 
-  g_mutex_lock (&read_mutex);
-
-  reading = TRUE;
-
-  if (in_offset != offset)
-    {
-      if (lseek (in_fd, offset, SEEK_SET) < 0)
-        {
-          reading = FALSE;
-
-          g_mutex_unlock (&read_mutex);
-
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
-          return tile;
-        }
-      in_offset = offset;
-    }
-
-  to_be_read = entry->block->size;
+  g_atomic_int_inc (&reading);
 
-  while (to_be_read > 0)
+  if (! gegl_tile_backend_swap_read_at (data, entry->block->size, offset))
     {
-      GError *error = NULL;
-      gint    bytes_read;
-
-      bytes_read = read (in_fd,
-                         data + entry->block->size - to_be_read, to_be_read);
+      g_atomic_int_dec_and_test (&reading);
 
-      if (bytes_read <= 0)
-        {
-          reading = FALSE;
-
-          g_mutex_unlock (&read_mutex);
+      if (entry->block->compression)
+        gegl_scratch_free (data);
 
-          if (entry->block->compression)
-            gegl_scratch_free (data);
-
-          g_message ("unable to read tile data from swap: "
-                     "%s (%d/%d bytes read) %s",
-                     g_strerror (errno), bytes_read, to_be_read, error?error->message:"--");
-          return tile;
-        }
-
-      to_be_read -= bytes_read;
-      in_offset  += bytes_read;
-
-      read_total += bytes_read;
+      return tile;
     }
 
-  reading = FALSE;
-
-  g_mutex_unlock (&read_mutex);
+  g_atomic_int_dec_and_test (&reading);
 
   if (entry->block->compression)
     {
@@ -962,9 +1237,10 @@ gegl_tile_backend_swap_block_create (void)
 {
   SwapBlock *block = g_slice_new (SwapBlock);
 
-  block->ref_count = 1;
-  block->link      = NULL;
-  block->offset    = -1;
+  block->ref_count   = 1;
+  block->link        = NULL;
+  block->in_progress = NULL;
+  block->offset      = -1;
 
   return block;
 }
@@ -1286,6 +1562,87 @@ gegl_tile_backend_swap_copy_tile (GeglTileSource           *self,
   return GINT_TO_POINTER (TRUE);
 }
 
+/* asks the kernel to start reading the swap-file ranges of the tiles in
+ * @tiles into the page cache, so that the subsequent reads don't block on
+ * the disk.  tiles that are queued, or being written, are served from memory
+ * anyway, and are skipped.
+ */
+static gpointer
+gegl_tile_backend_swap_prefetch (GeglTileSource      *self,
+                                 const GeglRectangle *tiles,
+                                 gint                 z)
+{
+#ifdef HAVE_POSIX_FADVISE
+  GeglTileBackendSwap *swap   = GEGL_TILE_BACKEND_SWAP (self);
+  GArray              *ranges;
+  gint64               start  = -1;
+  gint64               end    = -1;
+  gint                 x;
+  gint                 y;
+  guint                i;
+
+  if (in_fd < 0)
+    return NULL;
+
+  ranges = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  g_mutex_lock (&queue_mutex);
+
+  for (y = tiles->y; y < tiles->y + tiles->height; y++)
+    {
+      for (x = tiles->x; x < tiles->x + tiles->width; x++)
+        {
+          SwapEntry *entry;
+
+          entry = gegl_tile_backend_swap_lookup_entry (swap, x, y, z);
+
+          if (! entry                     ||
+              entry->block->link          ||
+              entry->block->in_progress   ||
+              entry->block->offset < 0)
+            {
+              continue;
+            }
+
+          if (entry->block->offset != end)
+            {
+              if (start >= 0)
+                {
+                  g_array_append_val (ranges, start);
+                  g_array_append_val (ranges, end);
+                }
+
+              start = entry->block->offset;
+            }
+
+          end = entry->block->offset + entry->block->size;
+        }
+    }
+
+  g_mutex_unlock (&queue_mutex);
+
+  if (start >= 0)
+    {
+      g_array_append_val (ranges, start);
+      g_array_append_val (ranges, end);
+    }
+
+  for (i = 0; i < ranges->len; i += 2)
+    {
+      start = g_array_index (ranges, gint64, i);
+      end   = g_array_index (ranges, gint64, i + 1);
+
+      posix_fadvise (in_fd, start, end - start, POSIX_FADV_WILLNEED);
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "prefetched %i ranges", ranges->len / 2);
+
+  g_array_free (ranges, TRUE);
+#endif
+
+  return NULL;
+}
+
 static gpointer
 gegl_tile_backend_swap_command (GeglTileSource  *self,
                                 GeglTileCommand  command,
@@ -1310,6 +1667,8 @@ gegl_tile_backend_swap_command (GeglTileSource  *self,
         return NULL;
       case GEGL_TILE_COPY:
         return gegl_tile_backend_swap_copy_tile (self, x, y, z, data);
+      case GEGL_TILE_PREFETCH:
+        return gegl_tile_backend_swap_prefetch (self, data, z);
 
       default:
         break;
@@ -1475,6 +1834,7 @@ static void
 gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  gint          i;
 
   parent_class = g_type_class_peek_parent (klass);
 
@@ -1483,10 +1843,20 @@ gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
 
   gap_tree = g_tree_new ((GCompareFunc) gegl_tile_backend_swap_gap_compare);
 
-  queue         = g_queue_new ();
-  writer_thread = g_thread_new ("swap writer",
-                                gegl_tile_backend_swap_writer_thread,
-                                NULL);
+  queue = g_queue_new ();
+
+  g_object_get (gegl_buffer_config (),
+                "swap-io-threads", &n_writer_threads,
+                NULL);
+
+  n_writer_threads = CLAMP (n_writer_threads, 1, SWAP_MAX_IO_THREADS);
+
+  for (i = 0; i < n_writer_threads; i++)
+    {
+      writer_threads[i] = g_thread_new ("swap writer",
+                                        gegl_tile_backend_swap_writer_thread,
+                                        NULL);
+    }
 
   g_signal_connect (gegl_buffer_config (), "notify::swap-compression",
                     G_CALLBACK (gegl_tile_backend_swap_compression_notify),
@@ -1506,7 +1876,9 @@ gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
 void
 gegl_tile_backend_swap_cleanup (void)
 {
-  if (! writer_thread)
+  gint i;
+
+  if (! n_writer_threads)
     return;
 
   g_signal_handlers_disconnect_by_func (
@@ -1521,10 +1893,15 @@ gegl_tile_backend_swap_cleanup (void)
 
   g_mutex_lock (&queue_mutex);
   exit_thread = TRUE;
-  g_cond_signal (&queue_cond);
+  g_cond_broadcast (&queue_cond);
   g_mutex_unlock (&queue_mutex);
-  g_thread_join (writer_thread);
-  writer_thread = NULL;
+
+  for (i = 0; i < n_writer_threads; i++)
+    {
+      g_thread_join (writer_threads[i]);
+      writer_threads[i] = NULL;
+    }
+  n_writer_threads = 0;
 
   if (g_queue_get_length (queue) != 0)
     g_warning ("tile-backend-swap writer queue wasn't empty before freeing\n");
@@ -1532,9 +1909,6 @@ gegl_tile_backend_swap_cleanup (void)
   g_queue_free (queue);
   queue = NULL;
 
-  g_clear_pointer (&compression_buffer, g_free);
-  compression_buffer_size = 0;
-
   g_tree_unref (gap_tree);
   gap_tree = NULL;
 
@@ -1638,7 +2012,7 @@ gegl_tile_backend_swap_get_queue_stalls (void)
 gboolean
 gegl_tile_backend_swap_get_reading (void)
 {
-  return reading;
+  return g_atomic_int_get (&reading) > 0;
 }
 
 guint64
@@ -1650,7 +2024,7 @@ gegl_tile_backend_swap_get_read_total (void)
 gboolean
 gegl_tile_backend_swap_get_writing (void)
 {
-  return writing;
+  return g_atomic_int_get (&writing) > 0;
 }
 
 guint64
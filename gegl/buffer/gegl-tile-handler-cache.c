@@ -18,6 +18,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib-object.h>
 
@@ -38,6 +40,15 @@
 #define GEGL_CACHE_TRIM_RATIO_MAX  0.50
 #define GEGL_CACHE_TRIM_RATIO_RATE 2.0
 
+/* the global set of caches is split into shards, each with its own lock, so
+ * that buffers created, destroyed and trimmed by different threads rarely
+ * contend.
+ */
+#define GEGL_CACHE_N_SHARDS        16
+
+/* the number of evictable items the cost-aware policy considers at a time */
+#define GEGL_CACHE_COST_WINDOW     8
+
 typedef struct CacheItem
 {
   GeglTile *tile; /* The tile */
@@ -47,6 +58,8 @@ typedef struct CacheItem
   gint      x;    /* The coordinates this tile was cached for */
   gint      y;
   gint      z;
+
+  gboolean  hot;  /* whether the item is in the hot part of the queue */
 } CacheItem;
 
 #define LINK_GET_CACHE(l) \
@@ -54,6 +67,83 @@ typedef struct CacheItem
 #define LINK_GET_ITEM(l) \
         ((CacheItem *) ((guchar *) l - G_STRUCT_OFFSET (CacheItem, link)))
 
+#define CACHE_GET_SHARD(cache) \
+        (&cache_shards[((guintptr) (cache) >> 6) % GEGL_CACHE_N_SHARDS])
+
+typedef struct CacheShard
+{
+  GMutex  mutex;
+  GQueue  queue;      /* the caches of this shard */
+  guint   generation; /* bumped whenever a cache leaves the shard */
+} CacheShard;
+
+/* iterates over the caches of all shards, from the least recently used one
+ * of all of them, as a single list of caches would.  only the shard the
+ * last cache came from is looked at again on every step;  the others keep
+ * the time of their next cache from the last time they were looked at.
+ */
+typedef struct CacheCursor
+{
+  gint                  start;   /* the shard favored on ties, which varies */
+  guint                 done;    /* a bit for every exhausted shard */
+  guint                 scanned; /* a bit for every shard whose next cache's
+                                  * time is known
+                                  */
+  GeglTileHandlerCache *caches[GEGL_CACHE_N_SHARDS];      /* the last cache
+                                                            * visited in each
+                                                            * shard
+                                                            */
+  guint                 generations[GEGL_CACHE_N_SHARDS]; /* the generation of
+                                                            * each shard when
+                                                            * its last cache
+                                                            * was visited
+                                                            */
+  guintptr              times[GEGL_CACHE_N_SHARDS];       /* the time of the
+                                                            * next cache of
+                                                            * each shard
+                                                            */
+} CacheCursor;
+
+/* an eviction policy.  each cache keeps its items in a single queue, which
+ * trim() walks from the tail;  the policies differ in where items are placed
+ * in the queue, and in which of the items near the tail gets evicted.
+ *
+ * the queue is split into a hot part, at the head, and a probationary part,
+ * at the tail, starting at cache->probation.
+ */
+typedef struct CachePolicy
+{
+  const gchar *name;
+
+  void      (* insert) (GeglTileHandlerCache *cache,
+                        CacheItem            *item);
+  void      (* access) (GeglTileHandlerCache *cache,
+                        CacheItem            *item);
+  /* returns the link of the item to evict, searching from link toward the
+   * head of the queue, or NULL if there's none.
+   */
+  GList   * (* select) (GeglTileHandlerCache *cache,
+                        GList                *link);
+} CachePolicy;
+
+enum
+{
+  CACHE_POLICY_LRU,
+  CACHE_POLICY_2Q,
+  CACHE_POLICY_COST,
+
+  N_CACHE_POLICIES
+};
+
+/* hit/miss counters are kept per thread, so that tile lookups don't fight
+ * over a shared cache line, and are only summed when queried.
+ */
+typedef struct CacheThreadStats
+{
+  gint hits[N_CACHE_POLICIES];
+  gint misses[N_CACHE_POLICIES];
+} CacheThreadStats;
+
 
 static gboolean   gegl_tile_handler_cache_equalfunc  (gconstpointer             a,
                                                       gconstpointer             b);
@@ -84,22 +174,326 @@ static gboolean   gegl_tile_handler_cache_copy       (GeglTileHandlerCache     *
                                                       gint                      y,
                                                       gint                      z,
                                                       const GeglTileCopyParams *params);
+static gboolean   gegl_tile_handler_cache_uncached   (GeglTileHandlerCache     *cache,
+                                                      const GeglRectangle      *tiles,
+                                                      gint                      z,
+                                                      GeglRectangle            *uncached);
+
+
+static void       gegl_tile_handler_cache_thread_stats_free (gpointer     data);
 
+static void       gegl_tile_handler_cache_lru_insert        (GeglTileHandlerCache *cache,
+                                                             CacheItem            *item);
+static void       gegl_tile_handler_cache_lru_access        (GeglTileHandlerCache *cache,
+                                                             CacheItem            *item);
+static GList    * gegl_tile_handler_cache_lru_select        (GeglTileHandlerCache *cache,
+                                                             GList                *link);
+static void       gegl_tile_handler_cache_2q_insert         (GeglTileHandlerCache *cache,
+                                                             CacheItem            *item);
+static GList    * gegl_tile_handler_cache_cost_select       (GeglTileHandlerCache *cache,
+                                                             GList                *link);
 
-static GMutex             mutex                 = { 0, };
-static GQueue             cache_queue           = G_QUEUE_INIT;
+
+static GMutex             mutex                 = { 0, }; /* guards the trim state */
+static CacheShard         cache_shards[GEGL_CACHE_N_SHARDS];
+static guint              cache_hand            = 0;
 static gint               cache_wash_percentage = 20;
 static          guintptr  cache_total           = 0; /* approximate amount of bytes stored */
 static guintptr           cache_total_max       = 0; /* maximal value of cache_total */
 static volatile guintptr  cache_total_uncloned  = 0; /* approximate amount of uncloned bytes stored */
-static gint               cache_hits            = 0;
-static gint               cache_misses          = 0;
-static guintptr           cache_time            = 0;
+static GMutex             cache_stats_mutex     = { 0, };
+static GSList            *cache_thread_stats    = NULL;
+static gint               cache_hits[N_CACHE_POLICIES];   /* hits of exited threads */
+static gint               cache_misses[N_CACHE_POLICIES]; /* misses of exited threads */
+static GPrivate           cache_thread_stats_private =
+  G_PRIVATE_INIT (gegl_tile_handler_cache_thread_stats_free);
+/* the current epoch; caches record the epoch of their last access, and it
+ * only advances when a cache is picked for eviction, so that accesses only
+ * ever read it.
+ */
+static guintptr           cache_time            = 1;
+static guint              cache_trim_counter    = 0;
+
+static const CachePolicy  cache_policies[N_CACHE_POLICIES] =
+{
+  [CACHE_POLICY_LRU] =
+  {
+    .name   = "lru",
+    .insert = gegl_tile_handler_cache_lru_insert,
+    .access = gegl_tile_handler_cache_lru_access,
+    .select = gegl_tile_handler_cache_lru_select
+  },
+  [CACHE_POLICY_2Q] =
+  {
+    .name   = "2q",
+    .insert = gegl_tile_handler_cache_2q_insert,
+    .access = gegl_tile_handler_cache_lru_access,
+    .select = gegl_tile_handler_cache_lru_select
+  },
+  [CACHE_POLICY_COST] =
+  {
+    .name   = "cost",
+    .insert = gegl_tile_handler_cache_lru_insert,
+    .access = gegl_tile_handler_cache_lru_access,
+    .select = gegl_tile_handler_cache_cost_select
+  }
+};
+static gint               cache_policy          = CACHE_POLICY_LRU;
 
 
 G_DEFINE_TYPE (GeglTileHandlerCache, gegl_tile_handler_cache, GEGL_TYPE_TILE_HANDLER)
 
 
+static CacheThreadStats *
+gegl_tile_handler_cache_get_thread_stats (void)
+{
+  CacheThreadStats *stats = g_private_get (&cache_thread_stats_private);
+
+  if (G_UNLIKELY (! stats))
+    {
+      stats = g_slice_new0 (CacheThreadStats);
+
+      g_private_set (&cache_thread_stats_private, stats);
+
+      g_mutex_lock (&cache_stats_mutex);
+      cache_thread_stats = g_slist_prepend (cache_thread_stats, stats);
+      g_mutex_unlock (&cache_stats_mutex);
+    }
+
+  return stats;
+}
+
+static void
+gegl_tile_handler_cache_thread_stats_free (gpointer data)
+{
+  CacheThreadStats *stats = data;
+  gint              i;
+
+  g_mutex_lock (&cache_stats_mutex);
+
+  for (i = 0; i < N_CACHE_POLICIES; i++)
+    {
+      cache_hits[i]   += stats->hits[i];
+      cache_misses[i] += stats->misses[i];
+    }
+
+  cache_thread_stats = g_slist_remove (cache_thread_stats, stats);
+
+  g_mutex_unlock (&cache_stats_mutex);
+
+  g_slice_free (CacheThreadStats, stats);
+}
+
+static inline void
+gegl_tile_handler_cache_touch (GeglTileHandlerCache *cache)
+{
+  guintptr time = cache_time;
+
+  /* avoid dirtying the cache line when nothing changed */
+  if (cache->time != time)
+    cache->time = time;
+}
+
+static void
+gegl_tile_handler_cache_unlink_item (GeglTileHandlerCache *cache,
+                                     CacheItem            *item)
+{
+  if (cache->probation == &item->link)
+    cache->probation = item->link.next;
+
+  if (! item->hot)
+    cache->n_probation--;
+
+  g_queue_unlink (&cache->queue, &item->link);
+}
+
+static void
+gegl_tile_handler_cache_push_hot (GeglTileHandlerCache *cache,
+                                  CacheItem            *item)
+{
+  item->hot = TRUE;
+
+  g_queue_push_head_link (&cache->queue, &item->link);
+}
+
+static void
+gegl_tile_handler_cache_push_probation (GeglTileHandlerCache *cache,
+                                        CacheItem            *item)
+{
+  GList *next = cache->probation;
+
+  item->hot = FALSE;
+
+  if (next)
+    {
+      item->link.prev = next->prev;
+      item->link.next = next;
+
+      if (next->prev)
+        next->prev->next = &item->link;
+      else
+        cache->queue.head = &item->link;
+
+      next->prev = &item->link;
+
+      cache->queue.length++;
+    }
+  else
+    {
+      g_queue_push_tail_link (&cache->queue, &item->link);
+    }
+
+  cache->probation = &item->link;
+  cache->n_probation++;
+}
+
+/* whether the tile of item can be evicted right now */
+static gboolean
+gegl_tile_handler_cache_item_is_evictable (CacheItem *item)
+{
+  GeglTile *tile = item->tile;
+
+  /* if the tile's ref-count is greater than one, then someone is still
+   * using the tile, and we must keep it in the cache, so that we can
+   * return the same tile object upon request; otherwise, we would end
+   * up with two different tile objects referring to the same tile.
+   */
+  if (tile->ref_count > 1)
+    return FALSE;
+
+  /* if we need to maintain the tile's data-pointer identity we can't
+   * remove it from the cache, since the storage might copy the data
+   * and throw the tile away.
+   */
+  if (tile->keep_identity)
+    return FALSE;
+
+  /* a set of cloned tiles is only counted once toward the total cache
+   * size, so the entire set has to be removed from the cache in order
+   * to reclaim the memory of a single tile.  in other words, in a set
+   * of n cloned tiles, we can assume that each individual tile
+   * contributes only 1/n of its size to the total cache size.  on the
+   * other hand, storing a cloned tile is as expensive as storing an
+   * uncloned tile.  therefore, if the tile needs to be stored, we only
+   * remove it with a probability of 1/n.
+   */
+  if (gegl_tile_needs_store (tile) &&
+      cache_trim_counter++ % *gegl_tile_n_cached_clones (tile))
+    {
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* plain LRU:  items enter the queue at the head, and move back to the head
+ * whenever they're accessed.
+ */
+static void
+gegl_tile_handler_cache_lru_insert (GeglTileHandlerCache *cache,
+                                    CacheItem            *item)
+{
+  gegl_tile_handler_cache_push_hot (cache, item);
+}
+
+static void
+gegl_tile_handler_cache_lru_access (GeglTileHandlerCache *cache,
+                                    CacheItem            *item)
+{
+  gegl_tile_handler_cache_unlink_item (cache, item);
+  gegl_tile_handler_cache_push_hot (cache, item);
+}
+
+static GList *
+gegl_tile_handler_cache_lru_select (GeglTileHandlerCache *cache,
+                                    GList                *link)
+{
+  for (; link; link = g_list_previous (link))
+    {
+      if (gegl_tile_handler_cache_item_is_evictable (LINK_GET_ITEM (link)))
+        return link;
+    }
+
+  return NULL;
+}
+
+/* a simplified 2Q:  new items enter the probationary part of the queue, and
+ * are only promoted to the hot part once they're accessed again.  since the
+ * probationary part is at the tail of the queue, it's evicted first, so that
+ * a one-time sequential pass over a big buffer doesn't flush the tiles that
+ * are in actual use.  the hot part is demoted from its tail whenever the
+ * probationary part drops below a quarter of the queue, so that a stale
+ * working set eventually ages out.
+ */
+static void
+gegl_tile_handler_cache_2q_insert (GeglTileHandlerCache *cache,
+                                   CacheItem            *item)
+{
+  if (cache->n_probation < (gint) cache->queue.length / 4)
+    {
+      GList *last_hot = cache->probation ? cache->probation->prev :
+                                           g_queue_peek_tail_link (&cache->queue);
+
+      if (last_hot)
+        {
+          LINK_GET_ITEM (last_hot)->hot = FALSE;
+
+          cache->probation = last_hot;
+          cache->n_probation++;
+        }
+    }
+
+  gegl_tile_handler_cache_push_probation (cache, item);
+}
+
+/* the cost of evicting a tile, in units of tile reads.  a clean tile only
+ * has to be read back from the backend once it's needed again, while a dirty
+ * tile has to be written out first -- this matches the swap backend, which
+ * weighs queued, yet-to-be-compressed tiles at their full size.
+ */
+static gint
+gegl_tile_handler_cache_item_cost (CacheItem *item)
+{
+  return gegl_tile_needs_store (item->tile) ? 2 : 1;
+}
+
+/* cost-aware LRU:  evicts the cheapest of the GEGL_CACHE_COST_WINDOW least
+ * recently used evictable items, preferring the older one among equals.
+ */
+static GList *
+gegl_tile_handler_cache_cost_select (GeglTileHandlerCache *cache,
+                                     GList                *link)
+{
+  GList *cheapest      = NULL;
+  gint   cheapest_cost = G_MAXINT;
+  gint   n             = 0;
+
+  for (; link && n < GEGL_CACHE_COST_WINDOW; link = g_list_previous (link))
+    {
+      CacheItem *item = LINK_GET_ITEM (link);
+      gint       cost;
+
+      if (! gegl_tile_handler_cache_item_is_evictable (item))
+        continue;
+
+      cost = gegl_tile_handler_cache_item_cost (item);
+
+      if (cost < cheapest_cost)
+        {
+          cheapest      = link;
+          cheapest_cost = cost;
+
+          if (cost == 1)
+            break;
+        }
+
+      n++;
+    }
+
+  return cheapest;
+}
+
+
 static void
 gegl_tile_handler_cache_class_init (GeglTileHandlerCacheClass *class)
 {
@@ -148,6 +542,9 @@ gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
 
   g_hash_table_remove_all (cache->items);
 
+  cache->probation   = NULL;
+  cache->n_probation = 0;
+
   while ((link = g_queue_pop_head_link (&cache->queue)))
     {
       item = LINK_GET_ITEM (link);
@@ -194,13 +591,10 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
   if (tile)
     {
-      /* we don't bother making cache_{hits,misses} atomic, since they're only
-       * needed for GeglStats.
-       */
-      cache_hits++;
+      gegl_tile_handler_cache_get_thread_stats ()->hits[cache_policy]++;
       return tile;
     }
-  cache_misses++;
+  gegl_tile_handler_cache_get_thread_stats ()->misses[cache_policy]++;
 
   if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
@@ -282,6 +676,18 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
          */
         return GINT_TO_POINTER (gegl_tile_handler_cache_copy (cache,
                                                               x, y, z, data));
+      case GEGL_TILE_PREFETCH:
+        {
+          GeglRectangle uncached;
+
+          /* only ask the backend for the tiles we don't already have */
+          if (! gegl_tile_handler_cache_uncached (cache, data, z, &uncached))
+            return NULL;
+
+          return gegl_tile_handler_source_command (handler, command,
+                                                   uncached.x, uncached.y, z,
+                                                   &uncached);
+        }
       default:
         break;
     }
@@ -289,21 +695,14 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   return gegl_tile_handler_source_command (handler, command, x, y, z, data);
 }
 
-/* find the oldest (least-recently used) nonempty cache, after prev_cache (if
- * not NULL).  passing the previous result of this function as prev_cache
- * allows iterating over the caches in chronological order.
- *
- * if most caches haven't been accessed since the last call to this function,
- * it should be rather cheap (approaching O(1)).
- *
- * the global cache mutex must be held while calling this function, however,
- * individual caches may be accessed concurrently.  as a result, there is a
- * race between modifying the caches' last-access time during access, and
- * inspecting the time by this function.  this isn't critical, but it does mean
- * that the result might not always be accurate.
+/* returns the oldest (least-recently used) nonempty cache of shard, after
+ * prev_cache (if not NULL), and its last-access time in time_out, without
+ * modifying the shard.  the shard's mutex must be held.
  */
 static GeglTileHandlerCache *
-gegl_tile_handler_cache_find_oldest_cache (GeglTileHandlerCache *prev_cache)
+gegl_tile_handler_cache_scan_oldest_cache (CacheShard           *shard,
+                                           GeglTileHandlerCache *prev_cache,
+                                           guintptr             *time_out)
 {
   GList                *link;
   GeglTileHandlerCache *oldest_cache = NULL;
@@ -311,7 +710,7 @@ gegl_tile_handler_cache_find_oldest_cache (GeglTileHandlerCache *prev_cache)
 
   /* find the oldest cache, after prev_cache */
   for (link = prev_cache ? g_list_next (&prev_cache->link) :
-                           g_queue_peek_head_link (&cache_queue);
+                           g_queue_peek_head_link (&shard->queue);
        link;
        link = g_list_next (link))
     {
@@ -344,13 +743,44 @@ gegl_tile_handler_cache_find_oldest_cache (GeglTileHandlerCache *prev_cache)
         }
     }
 
+  *time_out = oldest_time;
+
+  return oldest_cache;
+}
+
+/* find the oldest (least-recently used) nonempty cache of shard, after
+ * prev_cache (if not NULL).  passing the previous result of this function as
+ * prev_cache allows iterating over the shard's caches in chronological order.
+ *
+ * if most caches haven't been accessed since the last call to this function,
+ * it should be rather cheap (approaching O(1)).
+ *
+ * the shard's mutex must be held while calling this function, however,
+ * individual caches may be accessed concurrently.  as a result, there is a
+ * race between modifying the caches' last-access time during access, and
+ * inspecting the time by this function.  this isn't critical, but it does mean
+ * that the result might not always be accurate.
+ */
+static GeglTileHandlerCache *
+gegl_tile_handler_cache_find_oldest_cache (CacheShard           *shard,
+                                           GeglTileHandlerCache *prev_cache)
+{
+  GeglTileHandlerCache *oldest_cache;
+  guintptr              oldest_time;
+
+  oldest_cache = gegl_tile_handler_cache_scan_oldest_cache (shard, prev_cache,
+                                                            &oldest_time);
+
   if (oldest_cache)
     {
-      /* stamp the cache */
+      /* stamp the cache, and start a new epoch, so that accessing the cache
+       * from now on makes its time differ from the stamp
+       */
       oldest_cache->stamp = oldest_time;
+      g_atomic_pointer_add (&cache_time, 1);
 
       /* ... and move it after prev_cache */
-      g_queue_unlink (&cache_queue, &oldest_cache->link);
+      g_queue_unlink (&shard->queue, &oldest_cache->link);
 
       if (prev_cache)
         {
@@ -362,22 +792,148 @@ gegl_tile_handler_cache_find_oldest_cache (GeglTileHandlerCache *prev_cache)
               oldest_cache->link.prev->next = &oldest_cache->link;
               oldest_cache->link.next->prev = &oldest_cache->link;
 
-              cache_queue.length++;
+              shard->queue.length++;
             }
           else
             {
-              g_queue_push_tail_link (&cache_queue, &oldest_cache->link);
+              g_queue_push_tail_link (&shard->queue, &oldest_cache->link);
             }
         }
       else
         {
-          g_queue_push_head_link (&cache_queue, &oldest_cache->link);
+          g_queue_push_head_link (&shard->queue, &oldest_cache->link);
         }
     }
 
   return oldest_cache;
 }
 
+static void
+gegl_tile_handler_cache_cursor_init (CacheCursor *cursor)
+{
+  cursor->start   = (guint) g_atomic_int_add (&cache_hand, 1) %
+                    GEGL_CACHE_N_SHARDS;
+  cursor->done    = 0;
+  cursor->scanned = 0;
+
+  memset (cursor->caches, 0, sizeof (cursor->caches));
+}
+
+/* returns the last cache the cursor visited in shard i, or NULL if it should
+ * start from the head of the shard.  the cursor holds no reference to the
+ * caches it visited, so once a cache has left the shard, which bumps its
+ * generation, the last visited cache may be gone, and the shard is walked
+ * again from its head.  this revisits the shard's caches, which is harmless
+ * when trimming or washing, and rare.  the shard's mutex must be held.
+ */
+static GeglTileHandlerCache *
+gegl_tile_handler_cache_cursor_get_prev (CacheCursor *cursor,
+                                         gint         i)
+{
+  CacheShard *shard = &cache_shards[i];
+
+  if (cursor->caches[i] && cursor->generations[i] != shard->generation)
+    cursor->caches[i] = NULL;
+
+  cursor->generations[i] = shard->generation;
+
+  return cursor->caches[i];
+}
+
+/* finds the time of the next cache of shard i, or marks the shard as
+ * exhausted if there's none.  the shard's mutex must be held.
+ */
+static void
+gegl_tile_handler_cache_cursor_scan (CacheCursor *cursor,
+                                     gint         i)
+{
+  CacheShard *shard = &cache_shards[i];
+
+  if (! gegl_tile_handler_cache_scan_oldest_cache (
+          shard,
+          gegl_tile_handler_cache_cursor_get_prev (cursor, i),
+          &cursor->times[i]))
+    {
+      cursor->done |= 1u << i;
+    }
+
+  cursor->scanned |= 1u << i;
+}
+
+/* returns the next cache of the cursor, with its storage mutex locked, or
+ * NULL once all shards have been visited.  the next cache is the oldest of
+ * the oldest remaining caches of each shard.  caches whose storage mutex
+ * can't be acquired are skipped:  when trimming a dirty tile,
+ * gegl_tile_unref() will try to store it, acquiring the cache's storage
+ * mutex in the process.  this can lead to a deadlock if another thread is
+ * already holding that mutex, and is waiting on a shard mutex, or on a
+ * tile-storage mutex held by the current thread.
+ */
+static GeglTileHandlerCache *
+gegl_tile_handler_cache_cursor_next (CacheCursor *cursor)
+{
+  while (cursor->done != (1u << GEGL_CACHE_N_SHARDS) - 1)
+    {
+      CacheShard           *shard;
+      GeglTileHandlerCache *cache;
+      gint                  oldest_shard = -1;
+      gint                  i;
+
+      /* find the shard whose next cache is the oldest */
+      for (i = 0; i < GEGL_CACHE_N_SHARDS; i++)
+        {
+          gint j = (cursor->start + i) % GEGL_CACHE_N_SHARDS;
+
+          if (! (cursor->scanned & (1u << j)))
+            {
+              shard = &cache_shards[j];
+
+              g_mutex_lock (&shard->mutex);
+              gegl_tile_handler_cache_cursor_scan (cursor, j);
+              g_mutex_unlock (&shard->mutex);
+            }
+
+          if (cursor->done & (1u << j))
+            continue;
+
+          if (oldest_shard < 0 || cursor->times[j] < cursor->times[oldest_shard])
+            oldest_shard = j;
+        }
+
+      if (oldest_shard < 0)
+        break;
+
+      shard = &cache_shards[oldest_shard];
+
+      g_mutex_lock (&shard->mutex);
+
+      cache = gegl_tile_handler_cache_find_oldest_cache (
+        shard, gegl_tile_handler_cache_cursor_get_prev (cursor, oldest_shard));
+
+      if (cache)
+        {
+          cursor->caches[oldest_shard] = cache;
+
+          if (! g_rec_mutex_trylock (&cache->tile_storage->mutex))
+            cache = NULL;
+
+          /* look for the shard's next cache while we're at it */
+          gegl_tile_handler_cache_cursor_scan (cursor, oldest_shard);
+        }
+      else
+        {
+          cursor->done |= 1u << oldest_shard;
+        }
+
+      g_mutex_unlock (&shard->mutex);
+
+      if (cache)
+        return cache;
+    }
+
+  return NULL;
+}
+
 /* write the least recently used dirty tile to disk if it
  * is in the wash_percentage (20%) least recently used tiles,
  * calling this function in an idle handler distributes the
@@ -386,31 +942,25 @@ gegl_tile_handler_cache_find_oldest_cache (GeglTileHandlerCache *prev_cache)
 gboolean
 gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
 {
-  GeglTile  *last_dirty = NULL;
-  guintptr   size       = 0;
-  guintptr   wash_size;
-
-  g_mutex_lock (&mutex);
+  GeglTile    *last_dirty = NULL;
+  guintptr     size       = 0;
+  guintptr     wash_size;
+  CacheCursor  cursor;
 
   wash_size = (gdouble) cache_total_uncloned *
               cache_wash_percentage / 100.0 + 0.5;
 
-  cache = NULL;
+  gegl_tile_handler_cache_cursor_init (&cursor);
 
   while (size < wash_size)
     {
       GList *link;
 
-      cache = gegl_tile_handler_cache_find_oldest_cache (cache);
+      cache = gegl_tile_handler_cache_cursor_next (&cursor);
 
       if (cache == NULL)
         break;
 
-      if (! g_rec_mutex_trylock (&cache->tile_storage->mutex))
-        {
-          continue;
-        }
-
       for (link = g_queue_peek_tail_link (&cache->queue);
            link && size < wash_size;
            link = g_list_previous (link))
@@ -434,8 +984,6 @@ gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
       g_rec_mutex_unlock (&cache->tile_storage->mutex);
     }
 
-  g_mutex_unlock (&mutex);
-
   if (last_dirty != NULL)
     {
       gegl_tile_store (last_dirty);
@@ -477,9 +1025,8 @@ gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
   result = cache_lookup (cache, x, y, z);
   if (result)
     {
-      g_queue_unlink (&cache->queue, &result->link);
-      g_queue_push_head_link (&cache->queue, &result->link);
-      cache->time = ++cache_time;
+      cache_policies[cache_policy].access (cache, result);
+      gegl_tile_handler_cache_touch (cache);
       if (result->tile == NULL)
       {
         g_printerr ("NULL tile in %s %p %i %i %i %p\n", __FUNCTION__, result, result->x, result->y, result->z,
@@ -492,6 +1039,51 @@ gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
   return NULL;
 }
 
+/* finds the bounding box of the tiles in @tiles that aren't in the cache.
+ * unlike gegl_tile_handler_cache_has_tile(), this doesn't count as an access
+ * to the cached tiles.
+ *
+ * returns FALSE if all the tiles are cached.
+ */
+static gboolean
+gegl_tile_handler_cache_uncached (GeglTileHandlerCache *cache,
+                                  const GeglRectangle  *tiles,
+                                  gint                  z,
+                                  GeglRectangle        *uncached)
+{
+  gint x1 = G_MAXINT, y1 = G_MAXINT;
+  gint x2 = G_MININT, y2 = G_MININT;
+  gint x, y;
+
+  if (g_queue_is_empty (&cache->queue))
+    {
+      *uncached = *tiles;
+
+      return ! gegl_rectangle_is_empty (tiles);
+    }
+
+  for (y = tiles->y; y < tiles->y + tiles->height; y++)
+    {
+      for (x = tiles->x; x < tiles->x + tiles->width; x++)
+        {
+          if (! cache_lookup (cache, x, y, z))
+            {
+              x1 = MIN (x1, x);
+              y1 = MIN (y1, y);
+              x2 = MAX (x2, x);
+              y2 = MAX (y2, y);
+            }
+        }
+    }
+
+  if (x1 > x2)
+    return FALSE;
+
+  gegl_rectangle_set (uncached, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+  return TRUE;
+}
+
 static gboolean
 gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
                                   gint                  x,
@@ -512,16 +1104,19 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
 static gboolean
 gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 {
-  GList          *link;
-  gint64          time;
-  static gint64   last_time;
-  static gdouble  ratio  = GEGL_CACHE_TRIM_RATIO_MIN;
-  guint64         target_size;
-  static guint    counter;
+  const CachePolicy *policy = &cache_policies[cache_policy];
+  GList             *link;
+  gint64             time;
+  static gint64      last_time;
+  static gdouble     ratio  = GEGL_CACHE_TRIM_RATIO_MIN;
+  guint64            target_size;
+  CacheCursor        cursor;
 
   cache = NULL;
   link  = NULL;
 
+  gegl_tile_handler_cache_cursor_init (&cursor);
+
   g_mutex_lock (&mutex);
 
   target_size = gegl_buffer_config ()->tile_cache_size;
@@ -557,7 +1152,7 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 
 #ifdef GEGL_DEBUG_CACHE_HITS
       GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:"G_GUINT64_FORMAT" > cache_size:"G_GUINT64_FORMAT, cache_total, gegl_buffer_config()->tile_cache_size);
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (&cache_queue));
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i]", gegl_tile_handler_cache_get_hits ()*100.0/(gegl_tile_handler_cache_get_hits ()+gegl_tile_handler_cache_get_misses ()), gegl_tile_handler_cache_get_hits (), gegl_tile_handler_cache_get_misses ());
 #endif
 
       if (! link)
@@ -565,24 +1160,7 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
           if (cache)
             g_rec_mutex_unlock (&cache->tile_storage->mutex);
 
-          g_mutex_lock (&mutex);
-
-          do
-            {
-              cache = gegl_tile_handler_cache_find_oldest_cache (cache);
-            }
-          while (cache &&
-                 /* XXX:  when trimming a dirty tile, gegl_tile_unref() will
-                  * try to store it, acquiring the cache's storage mutex in the
-                  * process.  this can lead to a deadlock if another thread is
-                  * already holding that mutex, and is waiting on the global
-                  * cache mutex, or on a tile-storage mutex held by the current
-                  * thread.  try locking the cache's storage mutex here, and
-                  * skip the cache if it fails.
-                  */
-                 ! g_rec_mutex_trylock (&cache->tile_storage->mutex));
-
-          g_mutex_unlock (&mutex);
+          cache = gegl_tile_handler_cache_cursor_next (&cursor);
 
           if (! cache)
             break;
@@ -590,43 +1168,7 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
           link = g_queue_peek_tail_link (&cache->queue);
         }
 
-      for (; link; link = g_list_previous (link))
-        {
-          last_writable = LINK_GET_ITEM (link);
-          tile          = last_writable->tile;
-
-          /* if the tile's ref-count is greater than one, then someone is still
-           * using the tile, and we must keep it in the cache, so that we can
-           * return the same tile object upon request; otherwise, we would end
-           * up with two different tile objects referring to the same tile.
-           */
-          if (tile->ref_count > 1)
-            continue;
-
-          /* if we need to maintain the tile's data-pointer identity we can't
-           * remove it from the cache, since the storage might copy the data
-           * and throw the tile away.
-           */
-          if (tile->keep_identity)
-            continue;
-
-          /* a set of cloned tiles is only counted once toward the total cache
-           * size, so the entire set has to be removed from the cache in order
-           * to reclaim the memory of a single tile.  in other words, in a set
-           * of n cloned tiles, we can assume that each individual tile
-           * contributes only 1/n of its size to the total cache size.  on the
-           * other hand, storing a cloned tile is as expensive as storing an
-           * uncloned tile.  therefore, if the tile needs to be stored, we only
-           * remove it with a probability of 1/n.
-           */
-          if (gegl_tile_needs_store (tile) &&
-              counter++ % *gegl_tile_n_cached_clones (tile))
-            {
-              continue;
-            }
-
-          break;
-        }
+      link = policy->select (cache, link);
 
       /* the cache is being disconnected */
       if (! cache->link.data)
@@ -635,8 +1177,11 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
       if (! link)
         continue;
 
+      last_writable = LINK_GET_ITEM (link);
+      tile          = last_writable->tile;
+
       prev_link = g_list_previous (link);
-      g_queue_unlink (&cache->queue, link);
+      gegl_tile_handler_cache_unlink_item (cache, last_writable);
       g_hash_table_remove (cache->items, last_writable);
       if (g_queue_is_empty (&cache->queue))
         cache->time = cache->stamp = 0;
@@ -683,7 +1228,7 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
         g_atomic_pointer_add (&cache_total, -item->tile->size);
       g_atomic_pointer_add (&cache_total_uncloned, -item->tile->size);
 
-      g_queue_unlink (&cache->queue, &item->link);
+      gegl_tile_handler_cache_unlink_item (cache, item);
       g_hash_table_remove (cache->items, item);
 
       if (g_queue_is_empty (&cache->queue))
@@ -813,7 +1358,7 @@ gegl_tile_handler_cache_remove_item (GeglTileHandlerCache *cache,
     g_atomic_pointer_add (&cache_total, -item->tile->size);
   g_atomic_pointer_add (&cache_total_uncloned, -item->tile->size);
 
-  g_queue_unlink (&cache->queue, &item->link);
+  gegl_tile_handler_cache_unlink_item (cache, item);
   g_hash_table_remove (cache->items, item);
 
   if (g_queue_is_empty (&cache->queue))
@@ -884,6 +1429,7 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
   item->x         = x;
   item->y         = y;
   item->z         = z;
+  item->hot       = FALSE;
 
   // XXX : remove entry if it already exists
   gegl_tile_handler_cache_remove (cache, x, y, z);
@@ -895,7 +1441,7 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
 
   /* XXX: this is a window when the tile is a zero tile during update */
 
-  cache->time = ++cache_time;
+  gegl_tile_handler_cache_touch (cache);
 
   if (g_atomic_int_add (gegl_tile_n_cached_clones (tile), 1) == 0)
     total = g_atomic_pointer_add (&cache_total, tile->size) + tile->size;
@@ -903,7 +1449,7 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
     total = (guintptr) g_atomic_pointer_get (&cache_total);
   g_atomic_pointer_add (&cache_total_uncloned, tile->size);
   g_hash_table_add (cache->items, item);
-  g_queue_push_head_link (&cache->queue, &item->link);
+  cache_policies[cache_policy].insert (cache, item);
 
   if (total > gegl_buffer_config ()->tile_cache_size)
     gegl_tile_handler_cache_trim (cache);
@@ -943,11 +1489,13 @@ gegl_tile_handler_cache_connect (GeglTileHandlerCache *cache)
   /* join the global cache queue */
   if (! cache->link.data)
     {
+      CacheShard *shard = CACHE_GET_SHARD (cache);
+
       cache->link.data = cache;
 
-      g_mutex_lock (&mutex);
-      g_queue_push_tail_link (&cache_queue, &cache->link);
-      g_mutex_unlock (&mutex);
+      g_mutex_lock (&shard->mutex);
+      g_queue_push_tail_link (&shard->queue, &cache->link);
+      g_mutex_unlock (&shard->mutex);
     }
 }
 
@@ -957,13 +1505,16 @@ gegl_tile_handler_cache_disconnect (GeglTileHandlerCache *cache)
   /* leave the global cache queue */
   if (cache->link.data)
     {
+      CacheShard *shard = CACHE_GET_SHARD (cache);
+
       cache->link.data = NULL;
 
       g_rec_mutex_lock (&cache->tile_storage->mutex);
 
-      g_mutex_lock (&mutex);
-      g_queue_unlink (&cache_queue, &cache->link);
-      g_mutex_unlock (&mutex);
+      g_mutex_lock (&shard->mutex);
+      g_queue_unlink (&shard->queue, &cache->link);
+      shard->generation++;
+      g_mutex_unlock (&shard->mutex);
 
       g_rec_mutex_unlock (&cache->tile_storage->mutex);
     }
@@ -987,24 +1538,110 @@ gegl_tile_handler_cache_get_total_uncompressed (void)
   return cache_total_uncloned;
 }
 
+/* sums the hit/miss counts of policy, or of all policies if policy is -1 */
+static void
+gegl_tile_handler_cache_sum_stats (gint  policy,
+                                   gint *hits,
+                                   gint *misses)
+{
+  GSList *iter;
+  gint    i;
+
+  *hits   = 0;
+  *misses = 0;
+
+  g_mutex_lock (&cache_stats_mutex);
+
+  for (i = 0; i < N_CACHE_POLICIES; i++)
+    {
+      if (policy >= 0 && i != policy)
+        continue;
+
+      *hits   += cache_hits[i];
+      *misses += cache_misses[i];
+
+      for (iter = cache_thread_stats; iter; iter = g_slist_next (iter))
+        {
+          CacheThreadStats *stats = iter->data;
+
+          *hits   += stats->hits[i];
+          *misses += stats->misses[i];
+        }
+    }
+
+  g_mutex_unlock (&cache_stats_mutex);
+}
+
 gint
 gegl_tile_handler_cache_get_hits (void)
 {
-  return cache_hits;
+  gint hits;
+  gint misses;
+
+  gegl_tile_handler_cache_sum_stats (-1, &hits, &misses);
+
+  return hits;
 }
 
 gint
 gegl_tile_handler_cache_get_misses (void)
 {
-  return cache_misses;
+  gint hits;
+  gint misses;
+
+  gegl_tile_handler_cache_sum_stats (-1, &hits, &misses);
+
+  return misses;
+}
+
+/* returns the fraction of tile lookups that hit the cache while policy was
+ * the active eviction policy, or 0.0 if there were none.
+ */
+gdouble
+gegl_tile_handler_cache_get_hit_rate (const gchar *policy)
+{
+  gint i;
+
+  for (i = 0; i < N_CACHE_POLICIES; i++)
+    {
+      if (! g_strcmp0 (policy, cache_policies[i].name))
+        {
+          gint hits;
+          gint misses;
+
+          gegl_tile_handler_cache_sum_stats (i, &hits, &misses);
+
+          if (hits + misses == 0)
+            return 0.0;
+
+          return (gdouble) hits / (hits + misses);
+        }
+    }
+
+  return 0.0;
 }
 
 void
 gegl_tile_handler_cache_reset_stats (void)
 {
+  GSList *iter;
+
   cache_total_max = cache_total;
-  cache_hits      = 0;
-  cache_misses    = 0;
+
+  g_mutex_lock (&cache_stats_mutex);
+
+  memset (cache_hits,   0, sizeof (cache_hits));
+  memset (cache_misses, 0, sizeof (cache_misses));
+
+  /* racy with respect to the owning threads, but these are only stats */
+  for (iter = cache_thread_stats; iter; iter = g_slist_next (iter))
+    {
+      CacheThreadStats *stats = iter->data;
+
+      memset (stats, 0, sizeof (CacheThreadStats));
+    }
+
+  g_mutex_unlock (&cache_stats_mutex);
 }
 
 
@@ -1060,29 +1697,68 @@ gegl_buffer_config_tile_cache_size_notify (GObject    *gobject,
     }
 }
 
+static void
+gegl_buffer_config_tile_cache_policy_notify (GObject    *gobject,
+                                             GParamSpec *pspec,
+                                             gpointer    user_data)
+{
+  const gchar *name = gegl_buffer_config ()->tile_cache_policy;
+  gint         i;
+
+  for (i = 0; i < N_CACHE_POLICIES; i++)
+    {
+      if (! g_strcmp0 (name, cache_policies[i].name))
+        {
+          g_atomic_int_set (&cache_policy, i);
+
+          return;
+        }
+    }
+
+  g_warning ("unknown tile-cache policy '%s', using '%s'",
+             name, cache_policies[CACHE_POLICY_LRU].name);
+
+  g_atomic_int_set (&cache_policy, CACHE_POLICY_LRU);
+}
+
 void
 gegl_tile_cache_init (void)
 {
   g_signal_connect (gegl_buffer_config (), "notify::tile-cache-size",
                     G_CALLBACK (gegl_buffer_config_tile_cache_size_notify), NULL);
+  g_signal_connect (gegl_buffer_config (), "notify::tile-cache-policy",
+                    G_CALLBACK (gegl_buffer_config_tile_cache_policy_notify), NULL);
+
+  gegl_buffer_config_tile_cache_policy_notify (G_OBJECT (gegl_buffer_config ()),
+                                               NULL, NULL);
 }
 
 void
 gegl_tile_cache_destroy (void)
 {
+  gint i;
+
   g_signal_handlers_disconnect_by_func (gegl_buffer_config(),
                                         gegl_buffer_config_tile_cache_size_notify,
                                         NULL);
-  g_warn_if_fail (g_queue_is_empty (&cache_queue));
-
+  g_signal_handlers_disconnect_by_func (gegl_buffer_config(),
+                                        gegl_buffer_config_tile_cache_policy_notify,
+                                        NULL);
 
-  if (g_queue_is_empty (&cache_queue))
-    {
-      g_queue_clear (&cache_queue);
-    }
-  else
+  for (i = 0; i < GEGL_CACHE_N_SHARDS; i++)
     {
-     /* we leak portions of the GQueue data structure when it is not empty,
-        permitting leaked tiles to still be unreffed correctly */
+      CacheShard *shard = &cache_shards[i];
+
+      g_warn_if_fail (g_queue_is_empty (&shard->queue));
+
+      if (g_queue_is_empty (&shard->queue))
+        {
+          g_queue_clear (&shard->queue);
+        }
+      else
+        {
+         /* we leak portions of the GQueue data structure when it is not empty,
+            permitting leaked tiles to still be unreffed correctly */
+        }
     }
 }
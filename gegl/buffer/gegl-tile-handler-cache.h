@@ -43,6 +43,8 @@ struct _GeglTileHandlerCache
   GList            link;
   GHashTable      *items;
   GQueue           queue;
+  GList           *probation;   /* first probationary item of queue */
+  gint             n_probation;
   guintptr         time;
   guintptr         stamp;
 };
@@ -80,6 +82,7 @@ gsize             gegl_tile_handler_cache_get_total_max          (void);
 gsize             gegl_tile_handler_cache_get_total_uncompressed (void);
 gint              gegl_tile_handler_cache_get_hits               (void);
 gint              gegl_tile_handler_cache_get_misses             (void);
+gdouble           gegl_tile_handler_cache_get_hit_rate           (const gchar *policy);
 
 void              gegl_tile_handler_cache_reset_stats            (void);
 
@@ -240,6 +240,25 @@ gegl_tile_source_copy (GeglTileSource *source,
     return FALSE;
 }
 
+/**
+ * gegl_tile_source_prefetch:
+ * @source: a GeglTileSource *
+ * @tiles: the range of tiles, in tile coordinates
+ * @z: tile zoom level
+ *
+ * Announces that the tiles in @tiles are about to be fetched, allowing the
+ * backend to start reading them in the background.  This is only a hint;
+ * sources are free to ignore it.
+ */
+static inline void
+gegl_tile_source_prefetch (GeglTileSource      *source,
+                           const GeglRectangle *tiles,
+                           gint                 z)
+{
+  gegl_tile_source_command (source, GEGL_TILE_PREFETCH,
+                            tiles->x, tiles->y, z, (gpointer) tiles);
+}
+
 /*    INTERNAL API
  * gegl_tile_source_refetch:
  * @source: a GeglTileSource *
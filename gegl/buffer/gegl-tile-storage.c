@@ -24,6 +24,8 @@
 #include "gegl-buffer.h"
 #include "gegl-buffer-types.h"
 #include "gegl-tile-storage.h"
+#include "gegl-tile-backend-file.h"
+#include "gegl-tile-backend-swap.h"
 #include "gegl-tile-handler-empty.h"
 #include "gegl-tile-handler-zoom.h"
 #include "gegl-tile-handler-private.h"
@@ -61,6 +63,9 @@ gegl_tile_storage_new (GeglTileBackend *backend,
   tile_storage->format      = gegl_tile_backend_get_format (backend);
   tile_storage->tile_size   = gegl_tile_backend_get_tile_size (backend);
 
+  tile_storage->can_prefetch = GEGL_IS_TILE_BACKEND_SWAP (backend) ||
+                               GEGL_IS_TILE_BACKEND_FILE (backend);
+
   gegl_tile_handler_set_source (handler, GEGL_TILE_SOURCE (backend));
 
   cache = gegl_tile_handler_cache_new ();
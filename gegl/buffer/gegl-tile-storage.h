@@ -54,6 +54,8 @@ struct _GeglTileStorage
 
   GeglTile      *hot_tile; /* cached tile for speeding up gegl_buffer_get_pixel
                               and gegl_buffer_set_pixel (1x1 sized gets/sets)*/
+
+  gboolean       can_prefetch; /* whether the backend reads tiles from a file */
 };
 
 struct _GeglTileStorageClass
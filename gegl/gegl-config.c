@@ -58,16 +58,23 @@ enum
   PROP_0,
   PROP_QUALITY,
   PROP_TILE_CACHE_SIZE,
+  PROP_TILE_CACHE_POLICY,
+  PROP_SHARED_CACHE_SIZE,
+  PROP_DISK_CACHE,
+  PROP_DISK_CACHE_SIZE,
   PROP_CHUNK_SIZE,
   PROP_SWAP,
   PROP_SWAP_COMPRESSION,
+  PROP_SWAP_IO_THREADS,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_THREADS,
   PROP_USE_OPENCL,
   PROP_QUEUE_SIZE,
   PROP_APPLICATION_LICENSE,
-  PROP_MIPMAP_RENDERING
+  PROP_MIPMAP_RENDERING,
+  PROP_TILED_SCHEDULING,
+  PROP_FUSE_POINT_OPS
 };
 
 gint _gegl_threads = 1;
@@ -86,6 +93,22 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_uint64 (value, config->tile_cache_size);
         break;
 
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_string (value, config->tile_cache_policy);
+        break;
+
+      case PROP_SHARED_CACHE_SIZE:
+        g_value_set_uint64 (value, config->shared_cache_size);
+        break;
+
+      case PROP_DISK_CACHE:
+        g_value_set_string (value, config->disk_cache);
+        break;
+
+      case PROP_DISK_CACHE_SIZE:
+        g_value_set_uint64 (value, config->disk_cache_size);
+        break;
+
       case PROP_CHUNK_SIZE:
         g_value_set_int (value, config->chunk_size);
         break;
@@ -110,6 +133,10 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_string (value, config->swap_compression);
         break;
 
+      case PROP_SWAP_IO_THREADS:
+        g_value_set_int (value, config->swap_io_threads);
+        break;
+
       case PROP_THREADS:
         g_value_set_int (value, _gegl_threads);
         break;
@@ -130,6 +157,14 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_boolean (value, config->mipmap_rendering);
         break;
 
+      case PROP_TILED_SCHEDULING:
+        g_value_set_boolean (value, config->tiled_scheduling);
+        break;
+
+      case PROP_FUSE_POINT_OPS:
+        g_value_set_boolean (value, config->fuse_point_ops);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -149,6 +184,20 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_TILE_CACHE_SIZE:
         config->tile_cache_size = g_value_get_uint64 (value);
         break;
+      case PROP_TILE_CACHE_POLICY:
+        g_free (config->tile_cache_policy);
+        config->tile_cache_policy = g_value_dup_string (value);
+        break;
+      case PROP_SHARED_CACHE_SIZE:
+        config->shared_cache_size = g_value_get_uint64 (value);
+        break;
+      case PROP_DISK_CACHE:
+        g_free (config->disk_cache);
+        config->disk_cache = g_value_dup_string (value);
+        break;
+      case PROP_DISK_CACHE_SIZE:
+        config->disk_cache_size = g_value_get_uint64 (value);
+        break;
       case PROP_CHUNK_SIZE:
         config->chunk_size = g_value_get_int (value);
         break;
@@ -169,6 +218,9 @@ gegl_config_set_property (GObject      *gobject,
         g_free (config->swap_compression);
         config->swap_compression = g_value_dup_string (value);
         break;
+      case PROP_SWAP_IO_THREADS:
+        config->swap_io_threads = g_value_get_int (value);
+        break;
       case PROP_THREADS:
         _gegl_threads = g_value_get_int (value);
         return;
@@ -178,6 +230,12 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_MIPMAP_RENDERING:
         config->mipmap_rendering = g_value_get_boolean (value);
         break;
+      case PROP_TILED_SCHEDULING:
+        config->tiled_scheduling = g_value_get_boolean (value);
+        break;
+      case PROP_FUSE_POINT_OPS:
+        config->fuse_point_ops = g_value_get_boolean (value);
+        break;
       case PROP_QUEUE_SIZE:
         config->queue_size = g_value_get_int (value);
         break;
@@ -198,6 +256,8 @@ gegl_config_finalize (GObject *gobject)
 
   g_free (config->swap);
   g_free (config->swap_compression);
+  g_free (config->disk_cache);
+  g_free (config->tile_cache_policy);
   g_free (config->application_license);
 
   G_OBJECT_CLASS (gegl_config_parent_class)->finalize (gobject);
@@ -368,6 +428,39 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_string ("tile-cache-policy",
+                                                        "Tile Cache policy",
+                                                        "eviction policy of the tile cache: lru, 2q or cost",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SHARED_CACHE_SIZE,
+                                   g_param_spec_uint64 ("shared-cache-size",
+                                                        "Shared cache size",
+                                                        "size in bytes of the node results kept for reuse by identical nodes of other graphs; 0 disables sharing",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DISK_CACHE,
+                                   g_param_spec_string ("disk-cache",
+                                                        "Disk cache",
+                                                        "directory where node results are kept for reuse by later processes; NULL disables the disk cache",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DISK_CACHE_SIZE,
+                                   g_param_spec_uint64 ("disk-cache-size",
+                                                        "Disk cache size",
+                                                        "size in bytes the disk cache is trimmed to",
+                                                        0, G_MAXUINT64, 1024 * 1024 * 1024,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS |
+                                                        G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_SWAP_COMPRESSION,
                                    g_param_spec_string ("swap-compression",
                                                         "Swap compression",
@@ -376,6 +469,14 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_IO_THREADS,
+                                   g_param_spec_int ("swap-io-threads",
+                                                     "Swap I/O threads",
+                                                     "Number of threads serving swap reads and writes",
+                                                     1, 16, 2,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_STATIC_STRINGS));
+
   _gegl_threads = g_get_num_processors ();
   _gegl_threads = MIN (_gegl_threads, GEGL_MAX_THREADS);
 
@@ -401,6 +502,24 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                          G_PARAM_STATIC_STRINGS |
                                                          G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_TILED_SCHEDULING,
+                                   g_param_spec_boolean ("tiled-scheduling",
+                                                         "Tiled scheduling",
+                                                         "Evaluate tileable parts of graphs tile by tile across threads, rather than one node at a time.",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS |
+                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_FUSE_POINT_OPS,
+                                   g_param_spec_boolean ("fuse-point-ops",
+                                                         "Fuse point ops",
+                                                         "Run chains of point operations back to back on each chunk, without intermediate buffers.",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS |
+                                                         G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
                                    g_param_spec_boolean ("use-opencl",
                                                          "Use OpenCL",
@@ -433,10 +552,12 @@ gegl_config_init (GeglConfig *self)
 {
   char *forward_props[]={"swap",
                          "swap-compression",
+                         "swap-io-threads",
                          "queue-size",
                          "tile-width",
                          "tile-height",
                          "tile-cache-size",
+                         "tile-cache-policy",
                          NULL};
   GeglBufferConfig *bconf = gegl_buffer_config ();
   for (int i = 0; forward_props[i]; i++)
@@ -37,7 +37,12 @@ struct _GeglConfig
 
   gchar   *swap;
   gchar   *swap_compression;
+  gint     swap_io_threads;
   guint64  tile_cache_size;
+  guint64  shared_cache_size;
+  gchar   *disk_cache;
+  guint64  disk_cache_size;
+  gchar   *tile_cache_policy;
   gint     chunk_size; /* The size of elements being processed at once */
   gdouble  quality;
   gint     tile_width;
@@ -46,6 +51,8 @@ struct _GeglConfig
   gint     queue_size;
   gboolean mipmap_rendering;
   gchar   *application_license;
+  gboolean tiled_scheduling;
+  gboolean fuse_point_ops;
 };
 
 struct _GeglConfigClass
@@ -84,6 +84,7 @@ guint gegl_debug_flags = 0;
 #include "gegl-config.h"
 #include "gegl-stats.h"
 #include "graph/gegl-node-private.h"
+#include "graph/gegl-disk-cache.h"
 #include "gegl-random-private.h"
 #include "gegl-parallel-private.h"
 #include "gegl-cpuaccel.h"
@@ -425,6 +426,28 @@ gegl_config_parse_env (GeglConfig *config)
         g_object_set (config, "mipmap-rendering", FALSE, NULL);
     }
 
+  if (g_getenv ("GEGL_TILED_SCHEDULING"))
+    {
+      const gchar *value = g_getenv ("GEGL_TILED_SCHEDULING");
+      if (!strcmp (value, "1")||
+          !strcmp (value, "true")||
+          !strcmp (value, "yes"))
+        g_object_set (config, "tiled-scheduling", TRUE, NULL);
+      else
+        g_object_set (config, "tiled-scheduling", FALSE, NULL);
+    }
+
+  if (g_getenv ("GEGL_FUSE_POINT_OPS"))
+    {
+      const gchar *value = g_getenv ("GEGL_FUSE_POINT_OPS");
+      if (!strcmp (value, "1")||
+          !strcmp (value, "true")||
+          !strcmp (value, "yes"))
+        g_object_set (config, "fuse-point-ops", TRUE, NULL);
+      else
+        g_object_set (config, "fuse-point-ops", FALSE, NULL);
+    }
+
 
   if (g_getenv ("GEGL_QUALITY"))
     {
@@ -448,6 +471,32 @@ gegl_config_parse_env (GeglConfig *config)
                     NULL);
     }
 
+  if (g_getenv ("GEGL_SHARED_CACHE_SIZE"))
+    {
+      g_object_set (config,
+                    "shared-cache-size",
+                    (guint64) atoll(g_getenv("GEGL_SHARED_CACHE_SIZE")) * 1024 * 1024,
+                    NULL);
+    }
+
+  if (g_getenv ("GEGL_DISK_CACHE"))
+    g_object_set (config, "disk-cache", g_getenv ("GEGL_DISK_CACHE"), NULL);
+
+  if (g_getenv ("GEGL_DISK_CACHE_SIZE"))
+    {
+      g_object_set (config,
+                    "disk-cache-size",
+                    (guint64) atoll(g_getenv("GEGL_DISK_CACHE_SIZE")) * 1024 * 1024,
+                    NULL);
+    }
+
+  if (g_getenv ("GEGL_CACHE_POLICY"))
+    {
+      g_object_set (config,
+                    "tile-cache-policy", g_getenv ("GEGL_CACHE_POLICY"),
+                    NULL);
+    }
+
   if (g_getenv ("GEGL_CHUNK_SIZE"))
     config->chunk_size = atoi(g_getenv("GEGL_CHUNK_SIZE"));
 
@@ -508,6 +557,15 @@ gegl_config_parse_env (GeglConfig *config)
                     "swap-compression", g_getenv ("GEGL_SWAP_COMPRESSION"),
                     NULL);
     }
+
+  if (g_getenv ("GEGL_SWAP_IO_THREADS"))
+    {
+      gint n_threads = atoi (g_getenv ("GEGL_SWAP_IO_THREADS"));
+
+      g_object_set (config,
+                    "swap-io-threads", CLAMP (n_threads, 1, 16),
+                    NULL);
+    }
 }
 
 GeglConfig *
@@ -548,6 +606,8 @@ gegl_exit (void)
 
   GEGL_INSTRUMENT_START()
 
+  gegl_cache_shared_cleanup ();
+  gegl_disk_cache_cleanup ();
   gegl_tile_backend_swap_cleanup ();
   gegl_tile_cache_destroy ();
   gegl_operation_gtype_cleanup ();
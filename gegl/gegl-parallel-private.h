@@ -37,6 +37,13 @@ gint      gegl_parallel_distribute_get_optimal_n_threads (gdouble n_elements,
 gint      gegl_parallel_get_n_assigned_worker_threads    (void);
 gint      gegl_parallel_get_n_active_worker_threads      (void);
 
+/* the time spent in distributed functions by each thread, in seconds.  the
+ * first element covers all calling threads, and the rest the worker threads.
+ */
+GArray  * gegl_parallel_get_thread_busy_time             (void);
+
+void      gegl_parallel_reset_stats                      (void);
+
 
 G_END_DECLS
 
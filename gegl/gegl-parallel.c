@@ -31,6 +31,9 @@
 
 #define GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS           GEGL_MAX_THREADS
 #define GEGL_PARALLEL_DISTRIBUTE_THREAD_TIME_N_SAMPLES 10
+#define GEGL_PARALLEL_DISTRIBUTE_AREA_MIN_CHUNKS       8 /* per thread */
+#define GEGL_PARALLEL_DISTRIBUTE_AREA_MIN_CHUNK_SIZE   16
+#define GEGL_PARALLEL_DISTRIBUTE_AREA_GUIDED_FACTOR    2
 
 
 typedef struct
@@ -38,43 +41,54 @@ typedef struct
   GeglParallelDistributeFunc func;
   gint                       n;
   gpointer                   user_data;
+
+  volatile gint              next_i;
+  volatile gint              n_remaining;
 } GeglParallelDistributeTask;
 
 typedef struct
 {
   GThread                    *thread;
-  GMutex                      mutex;
-  GCond                       cond;
 
   gboolean                    quit;
 
-  GeglParallelDistributeTask *volatile task;
-  volatile gint               i;
+  gint64                      busy_time;
 } GeglParallelDistributeThread;
 
 
 /*  local function prototypes  */
 
-static void          gegl_parallel_notify_threads                   (GeglConfig                   *config);
+static void                         gegl_parallel_notify_threads                (GeglConfig                   *config);
 
-static void          gegl_parallel_set_n_threads                    (gint                          n_threads,
-                                                                     gboolean                      finish_tasks);
+static void                         gegl_parallel_set_n_threads                 (gint                          n_threads,
+                                                                                 gboolean                      finish_tasks);
 
-static void          gegl_parallel_distribute_set_n_threads         (gint                          n_threads);
-static gpointer      gegl_parallel_distribute_thread_func           (GeglParallelDistributeThread *thread);
-static void          gegl_parallel_distribute_update_thread_time    (void);
+static void                         gegl_parallel_distribute_set_n_threads      (gint                          n_threads);
+static GeglParallelDistributeTask * gegl_parallel_distribute_claim              (gint                         *i);
+static gint64                       gegl_parallel_distribute_run                (GeglParallelDistributeTask   *task,
+                                                                                 gint                          i);
+static gpointer                     gegl_parallel_distribute_thread_func        (GeglParallelDistributeThread *thread);
+static void                         gegl_parallel_distribute_update_thread_time (void);
 
 
 /*  local variables  */
 
 static gint                         gegl_parallel_distribute_n_threads = 1;
 static GeglParallelDistributeThread gegl_parallel_distribute_threads[GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS - 1];
+static GMutex                       gegl_parallel_distribute_resize_mutex;
 
-static GMutex                       gegl_parallel_distribute_completion_mutex;
+/* the queue of tasks that may still have unclaimed indices, newest first,
+ * the assigned-threads counter, and the busy times, are protected by
+ * gegl_parallel_distribute_mutex.
+ */
+static GMutex                       gegl_parallel_distribute_mutex;
+static GCond                        gegl_parallel_distribute_cond;
 static GCond                        gegl_parallel_distribute_completion_cond;
-static volatile gint                gegl_parallel_distribute_completion_counter;
-static volatile gint                gegl_parallel_distribute_busy;
+static GQueue                       gegl_parallel_distribute_tasks = G_QUEUE_INIT;
 static gint                         gegl_parallel_distribute_n_assigned_threads;
+static volatile gint                gegl_parallel_distribute_n_active_threads;
+static gint64                       gegl_parallel_distribute_caller_busy_time;
+static GPrivate                     gegl_parallel_distribute_depth;
 
 static gdouble                      gegl_parallel_distribute_thread_time;
 
@@ -143,12 +157,21 @@ gegl_parallel_distribute_get_optimal_n_threads (gdouble n_elements,
   return n_threads;
 }
 
+/* every call to gegl_parallel_distribute() queues a task, whose indices are
+ * claimed, one at a time, by whichever worker threads are idle, as well as by
+ * the calling thread itself.  since the caller keeps claiming indices until
+ * none are left, a task always makes progress, even when all the workers are
+ * busy with other tasks, so that concurrent calls from different threads, and
+ * nested calls from within a distributed function, are processed in parallel
+ * as far as free threads allow, instead of serially.
+ */
 void
 gegl_parallel_distribute (gint                       max_n,
                           GeglParallelDistributeFunc func,
                           gpointer                   user_data)
 {
   GeglParallelDistributeTask task;
+  gint64                     busy_time = 0;
   gint                       i;
 
   g_return_if_fail (func != NULL);
@@ -161,56 +184,55 @@ gegl_parallel_distribute (gint                       max_n,
   else
     max_n = MIN (max_n, gegl_parallel_distribute_n_threads);
 
-  if (max_n == 1 ||
-      ! g_atomic_int_compare_and_exchange (&gegl_parallel_distribute_busy,
-                                           0, 1))
+  if (max_n == 1)
     {
       func (0, 1, user_data);
 
       return;
     }
 
-  task.n         = max_n;
-  task.func      = func;
-  task.user_data = user_data;
+  task.n           = max_n;
+  task.func        = func;
+  task.user_data   = user_data;
+  task.next_i      = 0;
+  task.n_remaining = max_n;
+
+  g_mutex_lock (&gegl_parallel_distribute_mutex);
 
-  gegl_parallel_distribute_n_assigned_threads = task.n - 1;
+  /* newer tasks are served first, so that tasks nested inside the indices
+   * of an older task, which is waiting for them, finish early.
+   */
+  g_queue_push_head (&gegl_parallel_distribute_tasks, &task);
 
-  g_atomic_int_set (&gegl_parallel_distribute_completion_counter, task.n - 1);
+  gegl_parallel_distribute_n_assigned_threads += task.n - 1;
 
   for (i = 0; i < task.n - 1; i++)
-    {
-      GeglParallelDistributeThread *thread =
-        &gegl_parallel_distribute_threads[i];
+    g_cond_signal (&gegl_parallel_distribute_cond);
 
-      g_mutex_lock (&thread->mutex);
+  g_mutex_unlock (&gegl_parallel_distribute_mutex);
 
-      thread->task = &task;
-      thread->i    = i;
+  while ((i = g_atomic_int_add (&task.next_i, 1)) < task.n)
+    busy_time += gegl_parallel_distribute_run (&task, i);
 
-      g_cond_signal (&thread->cond);
+  g_mutex_lock (&gegl_parallel_distribute_mutex);
 
-      g_mutex_unlock (&thread->mutex);
-    }
+  g_queue_remove (&gegl_parallel_distribute_tasks, &task);
 
-  func (i, task.n, user_data);
+  gegl_parallel_distribute_caller_busy_time += busy_time;
 
-  if (g_atomic_int_get (&gegl_parallel_distribute_completion_counter))
+  /* wait for the indices claimed by the workers.  we don't process other
+   * tasks while waiting, since the caller might be holding locks those tasks
+   * need.
+   */
+  while (g_atomic_int_get (&task.n_remaining))
     {
-      g_mutex_lock (&gegl_parallel_distribute_completion_mutex);
-
-      while (g_atomic_int_get (&gegl_parallel_distribute_completion_counter))
-        {
-          g_cond_wait (&gegl_parallel_distribute_completion_cond,
-                       &gegl_parallel_distribute_completion_mutex);
-        }
-
-      g_mutex_unlock (&gegl_parallel_distribute_completion_mutex);
+      g_cond_wait (&gegl_parallel_distribute_completion_cond,
+                   &gegl_parallel_distribute_mutex);
     }
 
-  gegl_parallel_distribute_n_assigned_threads = 0;
+  gegl_parallel_distribute_n_assigned_threads -= task.n - 1;
 
-  g_atomic_int_set (&gegl_parallel_distribute_busy, 0);
+  g_mutex_unlock (&gegl_parallel_distribute_mutex);
 }
 
 typedef struct
@@ -277,8 +299,56 @@ typedef struct
   GeglSplitStrategy               split_strategy;
   GeglParallelDistributeAreaFunc  func;
   gpointer                        user_data;
+
+  /* GEGL_SPLIT_STRATEGY_DYNAMIC */
+  gint                            n_threads;
+  gint                            chunk_x0;
+  gint                            chunk_y0;
+  gint                            chunk_width;
+  gint                            chunk_height;
+  gint                            n_chunks_x;
+  gint                            n_chunks;
+  volatile gint                   next_chunk;
 } GeglParallelDistributeAreaData;
 
+static gboolean
+gegl_parallel_distribute_area_claim (GeglParallelDistributeAreaData *data,
+                                     GeglRectangle                  *sub_area)
+{
+  gint chunk;
+  gint n;
+
+  /* claim a run of chunks along the current row, whose length is
+   * proportional to the remaining work, so that threads take big bites
+   * first, and small ones toward the end, when balancing matters.
+   */
+  do
+    {
+      chunk = g_atomic_int_get (&data->next_chunk);
+
+      if (chunk >= data->n_chunks)
+        return FALSE;
+
+      n = (data->n_chunks - chunk) /
+          (GEGL_PARALLEL_DISTRIBUTE_AREA_GUIDED_FACTOR * data->n_threads);
+      n = CLAMP (n, 1, data->n_chunks_x - chunk % data->n_chunks_x);
+    }
+  while (! g_atomic_int_compare_and_exchange (&data->next_chunk,
+                                              chunk, chunk + n));
+
+  gegl_rectangle_set (sub_area,
+                      data->chunk_x0 +
+                      chunk % data->n_chunks_x * data->chunk_width,
+                      data->chunk_y0 +
+                      chunk / data->n_chunks_x * data->chunk_height,
+                      n * data->chunk_width,
+                      data->chunk_height);
+
+  gegl_rectangle_intersect (sub_area, sub_area, data->area);
+
+  return TRUE;
+}
+
 static void
 gegl_parallel_distribute_area_func (gint                            i,
                                     gint                            n,
@@ -312,6 +382,12 @@ gegl_parallel_distribute_area_func (gint                            i,
 
       break;
 
+    case GEGL_SPLIT_STRATEGY_DYNAMIC:
+      while (gegl_parallel_distribute_area_claim (data, &sub_area))
+        data->func (&sub_area, data->user_data);
+
+      return;
+
     default:
       g_return_if_reached ();
     }
@@ -319,6 +395,59 @@ gegl_parallel_distribute_area_func (gint                            i,
   data->func (&sub_area, data->user_data);
 }
 
+/* divides the area into a grid of chunks, aligned to the tile grid, which is
+ * made finer than the tile size if there would otherwise be too few chunks
+ * to balance the load over n_threads threads.
+ */
+static void
+gegl_parallel_distribute_area_init_chunks (GeglParallelDistributeAreaData *data,
+                                           gint                            n_threads)
+{
+  const GeglRectangle *area = data->area;
+  gint                 n_chunks_y;
+
+  data->n_threads    = n_threads;
+  data->chunk_width  = gegl_config ()->tile_width;
+  data->chunk_height = gegl_config ()->tile_height;
+
+  while (TRUE)
+    {
+      data->chunk_x0 = floor ((gdouble) area->x / data->chunk_width) *
+                       data->chunk_width;
+      data->chunk_y0 = floor ((gdouble) area->y / data->chunk_height) *
+                       data->chunk_height;
+
+      data->n_chunks_x = (area->x + area->width - data->chunk_x0 +
+                          data->chunk_width - 1) / data->chunk_width;
+      n_chunks_y       = (area->y + area->height - data->chunk_y0 +
+                          data->chunk_height - 1) / data->chunk_height;
+
+      data->n_chunks = data->n_chunks_x * n_chunks_y;
+
+      if (data->n_chunks >= GEGL_PARALLEL_DISTRIBUTE_AREA_MIN_CHUNKS *
+                            n_threads)
+        {
+          break;
+        }
+
+      if (data->chunk_height >= data->chunk_width &&
+          data->chunk_height > GEGL_PARALLEL_DISTRIBUTE_AREA_MIN_CHUNK_SIZE)
+        {
+          data->chunk_height /= 2;
+        }
+      else if (data->chunk_width > GEGL_PARALLEL_DISTRIBUTE_AREA_MIN_CHUNK_SIZE)
+        {
+          data->chunk_width /= 2;
+        }
+      else
+        {
+          break;
+        }
+    }
+
+  data->next_chunk = 0;
+}
+
 void
 gegl_parallel_distribute_area (const GeglRectangle            *area,
                                gdouble                         thread_cost,
@@ -357,6 +486,9 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
       n_threads = MIN (n_threads, area->width);
       break;
 
+    case GEGL_SPLIT_STRATEGY_DYNAMIC:
+      break;
+
     default:
       g_return_if_reached ();
     }
@@ -373,6 +505,13 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
   data.func           = func;
   data.user_data      = user_data;
 
+  if (split_strategy == GEGL_SPLIT_STRATEGY_DYNAMIC)
+    {
+      gegl_parallel_distribute_area_init_chunks (&data, n_threads);
+
+      n_threads = MIN (n_threads, data.n_chunks);
+    }
+
   gegl_parallel_distribute (
     n_threads,
     (GeglParallelDistributeFunc) gegl_parallel_distribute_area_func,
@@ -386,13 +525,59 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
 gint
 gegl_parallel_get_n_assigned_worker_threads (void)
 {
-  return gegl_parallel_distribute_n_assigned_threads;
+  return MIN (gegl_parallel_distribute_n_assigned_threads,
+              gegl_parallel_distribute_n_threads - 1);
 }
 
 gint
 gegl_parallel_get_n_active_worker_threads (void)
 {
-  return gegl_parallel_distribute_completion_counter;
+  return g_atomic_int_get (&gegl_parallel_distribute_n_active_threads);
+}
+
+GArray *
+gegl_parallel_get_thread_busy_time (void)
+{
+  GArray *busy_time;
+  gint    i;
+
+  busy_time = g_array_sized_new (FALSE, FALSE, sizeof (gdouble),
+                                 gegl_parallel_distribute_n_threads);
+
+  g_mutex_lock (&gegl_parallel_distribute_mutex);
+
+  for (i = 0; i < gegl_parallel_distribute_n_threads; i++)
+    {
+      gdouble t;
+
+      if (i == 0)
+        t = gegl_parallel_distribute_caller_busy_time;
+      else
+        t = gegl_parallel_distribute_threads[i - 1].busy_time;
+
+      t /= G_TIME_SPAN_SECOND;
+
+      g_array_append_val (busy_time, t);
+    }
+
+  g_mutex_unlock (&gegl_parallel_distribute_mutex);
+
+  return busy_time;
+}
+
+void
+gegl_parallel_reset_stats (void)
+{
+  gint i;
+
+  g_mutex_lock (&gegl_parallel_distribute_mutex);
+
+  gegl_parallel_distribute_caller_busy_time = 0;
+
+  for (i = 0; i < GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS - 1; i++)
+    gegl_parallel_distribute_threads[i].busy_time = 0;
+
+  g_mutex_unlock (&gegl_parallel_distribute_mutex);
 }
 
 
@@ -424,8 +609,7 @@ gegl_parallel_distribute_set_n_threads (gint n_threads)
 {
   gint i;
 
-  while (! g_atomic_int_compare_and_exchange (&gegl_parallel_distribute_busy,
-                                              0, 1));
+  g_mutex_lock (&gegl_parallel_distribute_resize_mutex);
 
   n_threads = CLAMP (n_threads, 1, GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS);
 
@@ -436,8 +620,8 @@ gegl_parallel_distribute_set_n_threads (gint n_threads)
           GeglParallelDistributeThread *thread =
             &gegl_parallel_distribute_threads[i];
 
-          thread->quit = FALSE;
-          thread->task = NULL;
+          thread->quit      = FALSE;
+          thread->busy_time = 0;
 
           thread->thread = g_thread_new (
             "worker",
@@ -447,18 +631,17 @@ gegl_parallel_distribute_set_n_threads (gint n_threads)
     }
   else if (n_threads < gegl_parallel_distribute_n_threads) /* need less threads */
     {
-      for (i = n_threads - 1; i < gegl_parallel_distribute_n_threads - 1; i++)
-        {
-          GeglParallelDistributeThread *thread =
-            &gegl_parallel_distribute_threads[i];
+      /* tasks queued in the meantime don't depend on the quitting threads,
+       * since their callers process any indices left unclaimed.
+       */
+      g_mutex_lock (&gegl_parallel_distribute_mutex);
 
-          g_mutex_lock (&thread->mutex);
+      for (i = n_threads - 1; i < gegl_parallel_distribute_n_threads - 1; i++)
+        gegl_parallel_distribute_threads[i].quit = TRUE;
 
-          thread->quit = TRUE;
-          g_cond_signal (&thread->cond);
+      g_cond_broadcast (&gegl_parallel_distribute_cond);
 
-          g_mutex_unlock (&thread->mutex);
-        }
+      g_mutex_unlock (&gegl_parallel_distribute_mutex);
 
       for (i = n_threads - 1; i < gegl_parallel_distribute_n_threads - 1; i++)
         {
@@ -471,44 +654,105 @@ gegl_parallel_distribute_set_n_threads (gint n_threads)
 
   gegl_parallel_distribute_n_threads = n_threads;
 
-  g_atomic_int_set (&gegl_parallel_distribute_busy, 0);
-
   gegl_parallel_distribute_update_thread_time ();
+
+  g_mutex_unlock (&gegl_parallel_distribute_resize_mutex);
+}
+
+/* claims the next index of the newest task that has any left, dropping
+ * exhausted tasks from the queue.  called with gegl_parallel_distribute_mutex
+ * held.
+ */
+static GeglParallelDistributeTask *
+gegl_parallel_distribute_claim (gint *i)
+{
+  GeglParallelDistributeTask *task;
+
+  while ((task = g_queue_peek_head (&gegl_parallel_distribute_tasks)))
+    {
+      *i = g_atomic_int_add (&task->next_i, 1);
+
+      if (*i < task->n)
+        return task;
+
+      g_queue_pop_head (&gegl_parallel_distribute_tasks);
+    }
+
+  return NULL;
+}
+
+/* runs index i of task, and returns the time it took, or 0 if the call is
+ * nested inside another index, whose time already covers it.
+ */
+static gint64
+gegl_parallel_distribute_run (GeglParallelDistributeTask *task,
+                              gint                        i)
+{
+  gint   depth = GPOINTER_TO_INT (g_private_get (&gegl_parallel_distribute_depth));
+  gint64 t     = 0;
+
+  if (depth == 0)
+    t = g_get_monotonic_time ();
+
+  g_private_set (&gegl_parallel_distribute_depth, GINT_TO_POINTER (depth + 1));
+
+  task->func (i, task->n, task->user_data);
+
+  g_private_set (&gegl_parallel_distribute_depth, GINT_TO_POINTER (depth));
+
+  if (depth == 0)
+    t = g_get_monotonic_time () - t;
+
+  /* the task lives on its caller's stack, and may be gone as soon as the
+   * counter drops to zero, so it mustn't be touched afterwards.
+   */
+  if (g_atomic_int_dec_and_test (&task->n_remaining))
+    {
+      g_mutex_lock (&gegl_parallel_distribute_mutex);
+
+      g_cond_broadcast (&gegl_parallel_distribute_completion_cond);
+
+      g_mutex_unlock (&gegl_parallel_distribute_mutex);
+    }
+
+  return t;
 }
 
 static gpointer
 gegl_parallel_distribute_thread_func (GeglParallelDistributeThread *thread)
 {
-  g_mutex_lock (&thread->mutex);
+  g_mutex_lock (&gegl_parallel_distribute_mutex);
 
-  while (TRUE)
+  while (! thread->quit)
     {
-      if (thread->quit)
-        {
-          break;
-        }
-      else if (thread->task)
+      GeglParallelDistributeTask *task;
+      gint64                      busy_time;
+      gint                        i;
+
+      task = gegl_parallel_distribute_claim (&i);
+
+      if (task)
         {
-          thread->task->func (thread->i, thread->task->n,
-                              thread->task->user_data);
+          g_mutex_unlock (&gegl_parallel_distribute_mutex);
 
-          if (g_atomic_int_dec_and_test (
-                &gegl_parallel_distribute_completion_counter))
-            {
-              g_mutex_lock (&gegl_parallel_distribute_completion_mutex);
+          g_atomic_int_inc (&gegl_parallel_distribute_n_active_threads);
 
-              g_cond_signal (&gegl_parallel_distribute_completion_cond);
+          busy_time = gegl_parallel_distribute_run (task, i);
 
-              g_mutex_unlock (&gegl_parallel_distribute_completion_mutex);
-            }
+          g_atomic_int_add (&gegl_parallel_distribute_n_active_threads, -1);
 
-          thread->task = NULL;
-        }
+          g_mutex_lock (&gegl_parallel_distribute_mutex);
 
-      g_cond_wait (&thread->cond, &thread->mutex);
+          thread->busy_time += busy_time;
+        }
+      else
+        {
+          g_cond_wait (&gegl_parallel_distribute_cond,
+                       &gegl_parallel_distribute_mutex);
+        }
     }
 
-  g_mutex_unlock (&thread->mutex);
+  g_mutex_unlock (&gegl_parallel_distribute_mutex);
 
   return NULL;
 }
@@ -78,6 +78,11 @@ typedef void (* GeglParallelDistributeAreaFunc)  (const GeglRectangle *area,
  *
  * Distributes the execution of a function across multiple threads,
  * by calling it with a different index on each thread.
+ *
+ * The function may be called from multiple threads at once, and may itself
+ * call gegl_parallel_distribute(), as may other threads while it runs.
+ * Each index is processed exactly once, though not necessarily on a
+ * different thread.
  */
 void   gegl_parallel_distribute       (gint                             max_n,
                                        GeglParallelDistributeFunc       func,
@@ -112,6 +117,12 @@ void   gegl_parallel_distribute_range (gsize                            size,
  * Distributes the processing of a planar data-structure across
  * multiple threads, by calling the given function with different
  * sub-areas on different threads.
+ *
+ * With %GEGL_SPLIT_STRATEGY_DYNAMIC, the area is divided into many
+ * tile-aligned sub-areas, which are handed out to the threads as they
+ * become free, so that the function may be called several times on each
+ * thread.  This is preferable when the processing cost varies across the
+ * area.
  */
 void   gegl_parallel_distribute_area  (const GeglRectangle             *area,
                                        gdouble                          thread_cost,
@@ -0,0 +1,452 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-reduce.h"
+
+
+/* reading pixels is cheap compared to the cost of a thread, so only use a
+ * thread per this many pixels.
+ */
+#define GEGL_REDUCTION_PIXELS_PER_THREAD (128 * 128)
+
+
+struct _GeglReduction
+{
+  const Babl *format;
+  gint        n_components;
+  gboolean    is_double;
+
+  gint        n_bins;
+  gdouble     histogram_min;
+  gdouble     histogram_max;
+
+  gint64      n_pixels;
+  gdouble    *min;
+  gdouble    *max;
+  gdouble    *sum;
+  gint64     *histogram;
+};
+
+typedef struct
+{
+  GeglReduction *reduction;
+  GeglBuffer    *buffer;
+  gint           level;
+  GMutex         mutex;
+} ReduceData;
+
+
+static void
+gegl_reduction_clear (GeglReduction *reduction)
+{
+  gint c;
+
+  reduction->n_pixels = 0;
+
+  for (c = 0; c < reduction->n_components; c++)
+    {
+      reduction->min[c] =  G_MAXDOUBLE;
+      reduction->max[c] = -G_MAXDOUBLE;
+      reduction->sum[c] =  0.0;
+    }
+
+  if (reduction->histogram)
+    {
+      memset (reduction->histogram, 0,
+              sizeof (gint64) * reduction->n_components * reduction->n_bins);
+    }
+}
+
+static GeglReduction *
+gegl_reduction_alloc (const Babl *format,
+                      gint        n_bins,
+                      gdouble     histogram_min,
+                      gdouble     histogram_max)
+{
+  GeglReduction *reduction = g_slice_new0 (GeglReduction);
+  gint           n         = babl_format_get_n_components (format);
+
+  reduction->format        = format;
+  reduction->n_components  = n;
+  reduction->is_double     = babl_format_get_type (format, 0) ==
+                             babl_type ("double");
+  reduction->n_bins        = n_bins;
+  reduction->histogram_min = histogram_min;
+  reduction->histogram_max = histogram_max;
+
+  reduction->min = g_new (gdouble, n);
+  reduction->max = g_new (gdouble, n);
+  reduction->sum = g_new (gdouble, n);
+
+  if (n_bins > 0)
+    reduction->histogram = g_new (gint64, n * n_bins);
+
+  gegl_reduction_clear (reduction);
+
+  return reduction;
+}
+
+GeglReduction *
+gegl_reduction_new (const Babl *format,
+                    gint        n_bins,
+                    gdouble     histogram_min,
+                    gdouble     histogram_max)
+{
+  gint c;
+
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (n_bins >= 0, NULL);
+  g_return_val_if_fail (n_bins == 0 || histogram_max > histogram_min, NULL);
+
+  for (c = 0; c < babl_format_get_n_components (format); c++)
+    {
+      const Babl *type = babl_format_get_type (format, c);
+
+      g_return_val_if_fail (type == babl_type ("float") ||
+                            type == babl_type ("double"), NULL);
+      g_return_val_if_fail (type == babl_format_get_type (format, 0), NULL);
+    }
+
+  return gegl_reduction_alloc (format, n_bins, histogram_min, histogram_max);
+}
+
+GeglReduction *
+gegl_reduction_duplicate (const GeglReduction *reduction)
+{
+  GeglReduction *result;
+  gint           n;
+
+  g_return_val_if_fail (reduction != NULL, NULL);
+
+  n      = reduction->n_components;
+  result = gegl_reduction_alloc (reduction->format, reduction->n_bins,
+                                 reduction->histogram_min,
+                                 reduction->histogram_max);
+
+  result->n_pixels = reduction->n_pixels;
+
+  memcpy (result->min, reduction->min, sizeof (gdouble) * n);
+  memcpy (result->max, reduction->max, sizeof (gdouble) * n);
+  memcpy (result->sum, reduction->sum, sizeof (gdouble) * n);
+
+  if (reduction->histogram)
+    {
+      memcpy (result->histogram, reduction->histogram,
+              sizeof (gint64) * n * reduction->n_bins);
+    }
+
+  return result;
+}
+
+void
+gegl_reduction_free (GeglReduction *reduction)
+{
+  g_return_if_fail (reduction != NULL);
+
+  g_free (reduction->histogram);
+  g_free (reduction->sum);
+  g_free (reduction->max);
+  g_free (reduction->min);
+
+  g_slice_free (GeglReduction, reduction);
+}
+
+static void
+gegl_reduction_merge (GeglReduction       *reduction,
+                      const GeglReduction *partial)
+{
+  gint c;
+  gint i;
+
+  reduction->n_pixels += partial->n_pixels;
+
+  for (c = 0; c < reduction->n_components; c++)
+    {
+      reduction->min[c]  = MIN (reduction->min[c], partial->min[c]);
+      reduction->max[c]  = MAX (reduction->max[c], partial->max[c]);
+      reduction->sum[c] += partial->sum[c];
+    }
+
+  if (reduction->histogram)
+    {
+      for (i = 0; i < reduction->n_components * reduction->n_bins; i++)
+        reduction->histogram[i] += partial->histogram[i];
+    }
+}
+
+static inline void
+gegl_reduction_reduce_value (GeglReduction *reduction,
+                             gint           c,
+                             gdouble        value,
+                             gdouble        bin_scale)
+{
+  if (value < reduction->min[c])
+    reduction->min[c] = value;
+  if (value > reduction->max[c])
+    reduction->max[c] = value;
+
+  reduction->sum[c] += value;
+
+  if (reduction->histogram              &&
+      value >= reduction->histogram_min &&
+      value <= reduction->histogram_max)
+    {
+      gint bin = (value - reduction->histogram_min) * bin_scale;
+
+      bin = MIN (bin, reduction->n_bins - 1);
+
+      reduction->histogram[c * reduction->n_bins + bin]++;
+    }
+}
+
+static void
+gegl_reduction_reduce_area (const GeglRectangle *area,
+                            ReduceData          *data)
+{
+  GeglReduction      *reduction = data->reduction;
+  GeglReduction      *partial;
+  GeglBufferIterator *iter;
+  const gint          n         = reduction->n_components;
+  gdouble             bin_scale = 0.0;
+
+  partial = gegl_reduction_alloc (reduction->format, reduction->n_bins,
+                                  reduction->histogram_min,
+                                  reduction->histogram_max);
+
+  if (partial->histogram)
+    {
+      bin_scale = partial->n_bins /
+                  (partial->histogram_max - partial->histogram_min);
+    }
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, data->level,
+                                   reduction->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gint i;
+      gint c;
+
+      if (reduction->is_double)
+        {
+          const gdouble *src = iter->items[0].data;
+
+          for (i = 0; i < iter->length; i++)
+            {
+              for (c = 0; c < n; c++)
+                gegl_reduction_reduce_value (partial, c, src[c], bin_scale);
+
+              src += n;
+            }
+        }
+      else
+        {
+          const gfloat *src = iter->items[0].data;
+
+          for (i = 0; i < iter->length; i++)
+            {
+              for (c = 0; c < n; c++)
+                gegl_reduction_reduce_value (partial, c, src[c], bin_scale);
+
+              src += n;
+            }
+        }
+
+      partial->n_pixels += iter->length;
+    }
+
+  g_mutex_lock (&data->mutex);
+  gegl_reduction_merge (reduction, partial);
+  g_mutex_unlock (&data->mutex);
+
+  gegl_reduction_free (partial);
+}
+
+void
+gegl_reduction_add_buffer (GeglReduction       *reduction,
+                           GeglBuffer          *buffer,
+                           const GeglRectangle *rect,
+                           gint                 level)
+{
+  ReduceData    data;
+  GeglRectangle area;
+
+  g_return_if_fail (reduction != NULL);
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (level >= 0);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  area = *rect;
+
+  if (level)
+    {
+      area.x      = rect->x >> level;
+      area.y      = rect->y >> level;
+      area.width  = ((rect->x + rect->width)  >> level) - area.x;
+      area.height = ((rect->y + rect->height) >> level) - area.y;
+    }
+
+  data.reduction = reduction;
+  data.buffer    = buffer;
+  data.level     = level;
+  g_mutex_init (&data.mutex);
+
+  gegl_parallel_distribute_area (
+    &area,
+    GEGL_REDUCTION_PIXELS_PER_THREAD,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gegl_reduction_reduce_area,
+    &data);
+
+  g_mutex_clear (&data.mutex);
+}
+
+gint64
+gegl_reduction_get_n_pixels (const GeglReduction *reduction)
+{
+  g_return_val_if_fail (reduction != NULL, 0);
+
+  return reduction->n_pixels;
+}
+
+gdouble
+gegl_reduction_get_min (const GeglReduction *reduction,
+                        gint                 component)
+{
+  g_return_val_if_fail (reduction != NULL, 0.0);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, 0.0);
+
+  return reduction->min[component];
+}
+
+gdouble
+gegl_reduction_get_max (const GeglReduction *reduction,
+                        gint                 component)
+{
+  g_return_val_if_fail (reduction != NULL, 0.0);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, 0.0);
+
+  return reduction->max[component];
+}
+
+gdouble
+gegl_reduction_get_sum (const GeglReduction *reduction,
+                        gint                 component)
+{
+  g_return_val_if_fail (reduction != NULL, 0.0);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, 0.0);
+
+  return reduction->sum[component];
+}
+
+gdouble
+gegl_reduction_get_mean (const GeglReduction *reduction,
+                         gint                 component)
+{
+  g_return_val_if_fail (reduction != NULL, 0.0);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, 0.0);
+
+  if (reduction->n_pixels == 0)
+    return 0.0;
+
+  return reduction->sum[component] / reduction->n_pixels;
+}
+
+const gint64 *
+gegl_reduction_get_histogram (const GeglReduction *reduction,
+                              gint                 component,
+                              gint                *n_bins)
+{
+  g_return_val_if_fail (reduction != NULL, NULL);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, NULL);
+
+  if (n_bins)
+    *n_bins = reduction->n_bins;
+
+  if (! reduction->histogram)
+    return NULL;
+
+  return reduction->histogram + component * reduction->n_bins;
+}
+
+gdouble
+gegl_reduction_get_percentile (const GeglReduction *reduction,
+                               gint                 component,
+                               gdouble              percentile)
+{
+  const gint64 *histogram;
+  gdouble       bin_width;
+  gdouble       target;
+  gint64        total = 0;
+  gint64        sum   = 0;
+  gint          i;
+
+  g_return_val_if_fail (reduction != NULL, 0.0);
+  g_return_val_if_fail (reduction->histogram != NULL, 0.0);
+  g_return_val_if_fail (component >= 0 &&
+                        component < reduction->n_components, 0.0);
+
+  histogram = reduction->histogram + component * reduction->n_bins;
+  bin_width = (reduction->histogram_max - reduction->histogram_min) /
+              reduction->n_bins;
+
+  for (i = 0; i < reduction->n_bins; i++)
+    total += histogram[i];
+
+  if (total == 0)
+    return reduction->histogram_min;
+
+  target = CLAMP (percentile, 0.0, 1.0) * total;
+
+  for (i = 0; i < reduction->n_bins - 1; i++)
+    {
+      if (sum + histogram[i] >= target && histogram[i] > 0)
+        break;
+
+      sum += histogram[i];
+    }
+
+  return reduction->histogram_min +
+         (i + CLAMP ((target - sum) / MAX (histogram[i], 1), 0.0, 1.0)) *
+         bin_width;
+}
+
+GType
+gegl_reduction_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (our_type == 0)
+    our_type = g_boxed_type_register_static (g_intern_static_string ("GeglReduction"),
+                                             (GBoxedCopyFunc) gegl_reduction_duplicate,
+                                             (GBoxedFreeFunc) gegl_reduction_free);
+  return our_type;
+}
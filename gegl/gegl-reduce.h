@@ -0,0 +1,168 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_REDUCE_H__
+#define __GEGL_REDUCE_H__
+
+#include "gegl-types.h"
+
+G_BEGIN_DECLS
+
+/***
+ * Reductions:
+ *
+ * A GeglReduction gathers per-component statistics of the pixels of one or
+ * more buffers: the minimum, maximum and sum of every component, and
+ * optionally a histogram, from which percentiles can be estimated.  Buffers
+ * are scanned in parallel, with each thread reducing its own part of the
+ * buffer, and the partial results being merged at the end.
+ */
+
+/**
+ * gegl_reduction_new:
+ * @format: the format in which pixels are reduced; its components have to
+ *          be of type float or double
+ * @n_bins: the number of histogram bins, or 0 for no histogram
+ * @histogram_min: the lower bound of the histogram range
+ * @histogram_max: the upper bound of the histogram range
+ *
+ * Creates a new, empty reduction.  Component values outside of
+ * [@histogram_min, @histogram_max] are left out of the histogram, but are
+ * otherwise reduced as usual.
+ *
+ * Returns: a new #GeglReduction, to be freed with gegl_reduction_free().
+ */
+GeglReduction * gegl_reduction_new            (const Babl          *format,
+                                               gint                 n_bins,
+                                               gdouble              histogram_min,
+                                               gdouble              histogram_max);
+
+/**
+ * gegl_reduction_duplicate:
+ * @reduction: a #GeglReduction
+ *
+ * Returns: (transfer full): a copy of @reduction.
+ */
+GeglReduction * gegl_reduction_duplicate      (const GeglReduction *reduction);
+
+/**
+ * gegl_reduction_free:
+ * @reduction: a #GeglReduction
+ *
+ * Frees @reduction.
+ */
+void            gegl_reduction_free           (GeglReduction       *reduction);
+
+/**
+ * gegl_reduction_add_buffer:
+ * @reduction: a #GeglReduction
+ * @buffer: the buffer to reduce
+ * @rect: (nullable): the rectangle to reduce, or %NULL for the extent of
+ *        @buffer
+ * @level: the mipmap level to read from
+ *
+ * Adds the pixels of @rect in @buffer to @reduction.  @rect is given in
+ * level-0 coordinates; reading from a level greater than 0 reduces a
+ * downscaled version of @buffer, which makes for a cheap estimate of the
+ * statistics of the full-resolution buffer, e.g. for previews.
+ */
+void            gegl_reduction_add_buffer     (GeglReduction       *reduction,
+                                               GeglBuffer          *buffer,
+                                               const GeglRectangle *rect,
+                                               gint                 level);
+
+/**
+ * gegl_reduction_get_n_pixels:
+ * @reduction: a #GeglReduction
+ *
+ * Returns: the number of pixels added to @reduction.
+ */
+gint64          gegl_reduction_get_n_pixels   (const GeglReduction *reduction);
+
+/**
+ * gegl_reduction_get_min:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ *
+ * Returns: the minimal value of @component, or G_MAXDOUBLE if @reduction is
+ * empty.
+ */
+gdouble         gegl_reduction_get_min        (const GeglReduction *reduction,
+                                               gint                 component);
+
+/**
+ * gegl_reduction_get_max:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ *
+ * Returns: the maximal value of @component, or -G_MAXDOUBLE if @reduction
+ * is empty.
+ */
+gdouble         gegl_reduction_get_max        (const GeglReduction *reduction,
+                                               gint                 component);
+
+/**
+ * gegl_reduction_get_sum:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ *
+ * Returns: the sum of the values of @component.
+ */
+gdouble         gegl_reduction_get_sum        (const GeglReduction *reduction,
+                                               gint                 component);
+
+/**
+ * gegl_reduction_get_mean:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ *
+ * Returns: the mean value of @component, or 0.0 if @reduction is empty.
+ */
+gdouble         gegl_reduction_get_mean       (const GeglReduction *reduction,
+                                               gint                 component);
+
+/**
+ * gegl_reduction_get_histogram:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ * @n_bins: (out): return location for the number of bins
+ *
+ * Returns: (transfer none) (array length=n_bins) (nullable): the histogram
+ * of @component, or %NULL if @reduction has no histogram.
+ */
+const gint64  * gegl_reduction_get_histogram  (const GeglReduction *reduction,
+                                               gint                 component,
+                                               gint                *n_bins);
+
+/**
+ * gegl_reduction_get_percentile:
+ * @reduction: a #GeglReduction
+ * @component: the component index
+ * @percentile: the percentile, in the range [0.0, 1.0]
+ *
+ * Estimates a percentile of @component from its histogram, interpolating
+ * linearly within the bin it falls in.  @reduction has to have a histogram.
+ *
+ * Returns: the value below which the @percentile fraction of the values of
+ * @component in the histogram range lie.
+ */
+gdouble         gegl_reduction_get_percentile (const GeglReduction *reduction,
+                                               gint                 component,
+                                               gdouble              percentile);
+
+G_END_DECLS
+
+#endif /* __GEGL_REDUCE_H__ */
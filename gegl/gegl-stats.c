@@ -40,6 +40,9 @@ enum
   PROP_TILE_CACHE_TOTAL_UNCOMPRESSED,
   PROP_TILE_CACHE_HITS,
   PROP_TILE_CACHE_MISSES,
+  PROP_TILE_CACHE_LRU_HIT_RATE,
+  PROP_TILE_CACHE_2Q_HIT_RATE,
+  PROP_TILE_CACHE_COST_HIT_RATE,
   PROP_SWAP_TOTAL,
   PROP_SWAP_TOTAL_UNCOMPRESSED,
   PROP_SWAP_FILE_SIZE,
@@ -55,7 +58,8 @@ enum
   PROP_TILE_ALLOC_TOTAL,
   PROP_SCRATCH_TOTAL,
   PROP_ASSIGNED_THREADS,
-  PROP_ACTIVE_THREADS
+  PROP_ACTIVE_THREADS,
+  PROP_THREAD_BUSY_TIME
 };
 
 
@@ -115,6 +119,27 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                      0, G_MAXINT, 0,
                                                      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_LRU_HIT_RATE,
+                                   g_param_spec_double ("tile-cache-lru-hit-rate",
+                                                        "Tile Cache LRU hit rate",
+                                                        "Tile cache hit rate while using the 'lru' eviction policy",
+                                                        0.0, 1.0, 0.0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_2Q_HIT_RATE,
+                                   g_param_spec_double ("tile-cache-2q-hit-rate",
+                                                        "Tile Cache 2Q hit rate",
+                                                        "Tile cache hit rate while using the '2q' eviction policy",
+                                                        0.0, 1.0, 0.0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_COST_HIT_RATE,
+                                   g_param_spec_double ("tile-cache-cost-hit-rate",
+                                                        "Tile Cache cost-aware hit rate",
+                                                        "Tile cache hit rate while using the 'cost' eviction policy",
+                                                        0.0, 1.0, 0.0,
+                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_SWAP_TOTAL,
                                    g_param_spec_uint64 ("swap-total",
                                                         "Swap total size",
@@ -231,6 +256,13 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                      "Number of active worker threads",
                                                      0, G_MAXINT, 0,
                                                      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_THREAD_BUSY_TIME,
+                                   g_param_spec_boxed ("thread-busy-time",
+                                                       "Thread busy time",
+                                                       "Seconds spent processing by the calling threads, followed by each worker thread",
+                                                       G_TYPE_ARRAY,
+                                                       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -280,6 +312,18 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_int (value, gegl_tile_handler_cache_get_misses ());
         break;
 
+      case PROP_TILE_CACHE_LRU_HIT_RATE:
+        g_value_set_double (value, gegl_tile_handler_cache_get_hit_rate ("lru"));
+        break;
+
+      case PROP_TILE_CACHE_2Q_HIT_RATE:
+        g_value_set_double (value, gegl_tile_handler_cache_get_hit_rate ("2q"));
+        break;
+
+      case PROP_TILE_CACHE_COST_HIT_RATE:
+        g_value_set_double (value, gegl_tile_handler_cache_get_hit_rate ("cost"));
+        break;
+
       case PROP_SWAP_TOTAL:
         g_value_set_uint64 (value, gegl_tile_backend_swap_get_total ());
         break;
@@ -344,6 +388,10 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_int (value, gegl_parallel_get_n_active_worker_threads ());
         break;
 
+      case PROP_THREAD_BUSY_TIME:
+        g_value_take_boxed (value, gegl_parallel_get_thread_busy_time ());
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -356,4 +404,5 @@ gegl_stats_reset (GeglStats *stats)
   gegl_tile_handler_cache_reset_stats ();
   gegl_tile_backend_swap_reset_stats ();
   gegl_tile_handler_zoom_reset_stats ();
+  gegl_parallel_reset_stats ();
 }
@@ -45,7 +45,8 @@ typedef enum
 {
   GEGL_SPLIT_STRATEGY_AUTO,
   GEGL_SPLIT_STRATEGY_HORIZONTAL,
-  GEGL_SPLIT_STRATEGY_VERTICAL
+  GEGL_SPLIT_STRATEGY_VERTICAL,
+  GEGL_SPLIT_STRATEGY_DYNAMIC
 } GeglSplitStrategy;
 
 
@@ -93,6 +94,10 @@ typedef struct _GeglRandom  GeglRandom;
 GType gegl_random_get_type  (void) G_GNUC_CONST;
 #define GEGL_TYPE_RANDOM    (gegl_random_get_type())
 
+typedef struct _GeglReduction  GeglReduction;
+GType gegl_reduction_get_type  (void) G_GNUC_CONST;
+#define GEGL_TYPE_REDUCTION    (gegl_reduction_get_type())
+
 #include <gegl-buffer.h>
 
 G_END_DECLS
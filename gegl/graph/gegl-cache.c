@@ -26,7 +26,9 @@
 #include <babl/babl.h>
 
 #include "gegl-types-internal.h"
+#include "gegl-config.h"
 #include "gegl-cache.h"
+#include "gegl-disk-cache.h"
 #include "gegl-region.h"
 #include "gegl-buffer.h" /* for GeglRectangle XXX ... */
 
@@ -61,16 +63,26 @@ G_DEFINE_TYPE (GeglCache, gegl_cache, GEGL_TYPE_BUFFER)
 
 guint gegl_cache_signals[LAST_SIGNAL] = { 0 };
 
+static GHashTable *shared_caches = NULL; /* key -> GeglCache */
+static GMutex      shared_caches_mutex;
+
 static void
 gegl_cache_constructed (GObject *object)
 {
-  GeglCache *self = GEGL_CACHE (object);
+  GeglCache  *self   = GEGL_CACHE (object);
+  GeglBuffer *buffer = GEGL_BUFFER (object);
   gint i;
 
   G_OBJECT_CLASS (gegl_cache_parent_class)->constructed (object);
 
+  /* the valid regions are in level-0 coordinates, where the tiles of level
+   * i are 2^i times larger.
+   */
   for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
-    self->valid_region[i] = gegl_region_new ();
+    {
+      self->valid[i] = gegl_tile_bitmap_new (buffer->tile_width  << i,
+                                             buffer->tile_height << i);
+    }
 }
 
 /* expand invalidated regions to be align with coordinates divisible by 8 in both
@@ -171,7 +183,6 @@ gegl_cache_class_init (GeglCacheClass *klass)
 static void
 gegl_cache_init (GeglCache *self)
 {
-  g_mutex_init (&self->mutex);
 }
 
 static void
@@ -188,10 +199,10 @@ finalize (GObject *gobject)
   GeglCache *self = GEGL_CACHE (gobject);
   gint i;
 
-  g_mutex_clear (&self->mutex);
   for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
-    if (self->valid_region[i])
-      gegl_region_destroy (self->valid_region[i]);
+    if (self->valid[i])
+      gegl_tile_bitmap_free (self->valid[i]);
+  g_free (self->shared_key);
   G_OBJECT_CLASS (gegl_cache_parent_class)->finalize (gobject);
 }
 
@@ -266,28 +277,24 @@ gegl_cache_invalidate (GeglCache           *self,
     {
       GeglRectangle expanded = gegl_rectangle_expand (roi);
 
-      GeglRegion *temp_region;
-      temp_region = gegl_region_rectangle (&expanded);
-
-      g_mutex_lock (&self->mutex);
       for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
-        gegl_region_subtract (self->valid_region[i], temp_region);
-      g_mutex_unlock (&self->mutex);
-      gegl_region_destroy (temp_region);
+        gegl_tile_bitmap_remove (self->valid[i], &expanded);
+
+      if (self->disk_cache)
+        gegl_disk_cache_invalidate (self->disk_cache, &expanded);
+
       g_signal_emit (self, gegl_cache_signals[INVALIDATED], 0,
                      roi, NULL);
     }
   else
     {
       GeglRectangle rect = { 0, 0, 0, 0 }; /* should probably be the extent of the cache */
-      g_mutex_lock (&self->mutex);
       for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
-      {
-        if (self->valid_region[i])
-          gegl_region_destroy (self->valid_region[i]);
-        self->valid_region[i] = gegl_region_new ();
-      }
-      g_mutex_unlock (&self->mutex);
+        gegl_tile_bitmap_clear (self->valid[i]);
+
+      if (self->disk_cache)
+        gegl_disk_cache_invalidate (self->disk_cache, NULL);
+
       g_signal_emit (self, gegl_cache_signals[INVALIDATED], 0,
                      &rect, NULL);
     }
@@ -301,16 +308,186 @@ gegl_cache_computed (GeglCache           *self,
   g_return_if_fail (GEGL_IS_CACHE (self));
   g_return_if_fail (rect != NULL);
 
-  g_mutex_lock (&self->mutex);
-
   if (level < GEGL_CACHE_VALID_MIPMAPS)
-    gegl_region_union_with_rect (self->valid_region[level], rect);
+    gegl_tile_bitmap_add (self->valid[level], rect);
 
-  g_mutex_unlock (&self->mutex);
+  if (self->disk_cache)
+    gegl_disk_cache_store (self->disk_cache, self, rect, level);
 
   g_signal_emit (self, gegl_cache_signals[COMPUTED], 0, rect, NULL);
 }
 
+/* the approximate number of bytes of valid data held by the cache */
+static guint64
+gegl_cache_get_valid_size (GeglCache *self)
+{
+  gint    bpp  = babl_format_get_bytes_per_pixel (
+                   gegl_buffer_get_format (GEGL_BUFFER (self)));
+  guint64 size = 0;
+  gint    i;
+
+  for (i = 0; i < GEGL_CACHE_VALID_MIPMAPS; i++)
+    {
+      guint64 area = gegl_tile_bitmap_get_area (self->valid[i], NULL);
+
+      /* the valid regions are in level-0 coordinates */
+      size += (area >> (2 * i)) * bpp;
+    }
+
+  return size;
+}
+
+static gint
+gegl_cache_shared_compare_stamp (gconstpointer a,
+                                 gconstpointer b)
+{
+  const GeglCache *cache_a = a;
+  const GeglCache *cache_b = b;
+
+  return (cache_a->shared_stamp > cache_b->shared_stamp) -
+         (cache_a->shared_stamp < cache_b->shared_stamp);
+}
+
+/* evict the least recently released unused caches, until the rest fit the
+ * budget.  the budget can't exceed the tile-cache size, since the tiles of
+ * the retained caches would only end up in the swap.
+ */
+static void
+gegl_cache_shared_trim (void)
+{
+  guint64         budget;
+  guint64         total  = 0;
+  GList          *unused = NULL;
+  GList          *iter;
+  GHashTableIter  hash_iter;
+  gpointer        value;
+
+  budget = MIN (gegl_config ()->shared_cache_size,
+                gegl_config ()->tile_cache_size);
+
+  g_hash_table_iter_init (&hash_iter, shared_caches);
+
+  while (g_hash_table_iter_next (&hash_iter, NULL, &value))
+    {
+      GeglCache *cache = value;
+
+      if (cache->shared_users == 0)
+        {
+          unused  = g_list_prepend (unused, cache);
+          total  += gegl_cache_get_valid_size (cache);
+        }
+    }
+
+  unused = g_list_sort (unused, gegl_cache_shared_compare_stamp);
+
+  for (iter = unused; iter && total > budget; iter = g_list_next (iter))
+    {
+      GeglCache *cache = iter->data;
+
+      total -= MIN (total, gegl_cache_get_valid_size (cache));
+
+      g_hash_table_remove (shared_caches, cache->shared_key);
+    }
+
+  g_list_free (unused);
+}
+
+/* returns a new reference to the shared cache registered under @key, and
+ * counts the caller as one of its users, or NULL if there is none.
+ */
+GeglCache *
+gegl_cache_shared_lookup (const gchar *key)
+{
+  GeglCache *cache = NULL;
+
+  g_return_val_if_fail (key != NULL, NULL);
+
+  g_mutex_lock (&shared_caches_mutex);
+
+  if (shared_caches)
+    cache = g_hash_table_lookup (shared_caches, key);
+
+  if (cache)
+    {
+      cache->shared_users++;
+      g_object_ref (cache);
+    }
+
+  g_mutex_unlock (&shared_caches_mutex);
+
+  return cache;
+}
+
+/* registers @cache under @key, counting the caller as its first user.  fails
+ * if another cache was registered under the same key in the meantime, in
+ * which case @cache stays private to the caller.
+ */
+gboolean
+gegl_cache_shared_add (GeglCache   *cache,
+                       const gchar *key)
+{
+  gboolean added = FALSE;
+
+  g_return_val_if_fail (GEGL_IS_CACHE (cache), FALSE);
+  g_return_val_if_fail (cache->shared_key == NULL, FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  g_mutex_lock (&shared_caches_mutex);
+
+  if (! shared_caches)
+    {
+      shared_caches = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             NULL, g_object_unref);
+    }
+
+  if (! g_hash_table_contains (shared_caches, key))
+    {
+      cache->shared_key   = g_strdup (key);
+      cache->shared_users = 1;
+
+      g_hash_table_insert (shared_caches, cache->shared_key,
+                           g_object_ref (cache));
+
+      added = TRUE;
+    }
+
+  g_mutex_unlock (&shared_caches_mutex);
+
+  return added;
+}
+
+/* stops counting the caller as a user of the shared @cache.  the caller
+ * still has to drop its reference.
+ */
+void
+gegl_cache_shared_release (GeglCache *cache)
+{
+  g_return_if_fail (GEGL_IS_CACHE (cache));
+  g_return_if_fail (cache->shared_key != NULL);
+
+  g_mutex_lock (&shared_caches_mutex);
+
+  if (cache->shared_users > 0 && --cache->shared_users == 0)
+    {
+      cache->shared_stamp = g_get_monotonic_time ();
+
+      if (shared_caches)
+        gegl_cache_shared_trim ();
+    }
+
+  g_mutex_unlock (&shared_caches_mutex);
+}
+
+void
+gegl_cache_shared_cleanup (void)
+{
+  g_mutex_lock (&shared_caches_mutex);
+
+  g_clear_pointer (&shared_caches, g_hash_table_unref);
+
+  g_mutex_unlock (&shared_caches_mutex);
+}
+
 gboolean
 gegl_buffer_list_valid_rectangles (GeglBuffer     *buffer,
                                    GeglRectangle **rectangles,
@@ -321,7 +498,8 @@ gegl_buffer_list_valid_rectangles (GeglBuffer     *buffer,
                                    GeglRectangle **rectangles,
                                    gint           *n_rectangles)
 {
-  GeglCache *cache;
+  GeglCache  *cache;
+  GeglRegion *region;
   gint level = 0; /* should be an argument */
   g_return_val_if_fail (GEGL_IS_CACHE (buffer), FALSE);
   cache = GEGL_CACHE (buffer);
@@ -331,8 +509,9 @@ gegl_buffer_list_valid_rectangles (GeglBuffer     *buffer,
   if (level >= GEGL_CACHE_VALID_MIPMAPS)
     level = GEGL_CACHE_VALID_MIPMAPS-1;
 
-  gegl_region_get_rectangles (cache->valid_region[level],
-                              rectangles, n_rectangles);
+  region = gegl_tile_bitmap_get_region (cache->valid[level], NULL);
+  gegl_region_get_rectangles (region, rectangles, n_rectangles);
+  gegl_region_destroy (region);
 
   return TRUE;
 }
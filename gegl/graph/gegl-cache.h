@@ -23,6 +23,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-buffer.h"
 #include "gegl-buffer-private.h"
+#include "gegl-tile-bitmap.h"
 
 G_BEGIN_DECLS
 
@@ -34,15 +35,24 @@ G_BEGIN_DECLS
 #define GEGL_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_CACHE, GeglCacheClass))
 
 typedef struct _GeglCacheClass GeglCacheClass;
+typedef struct _GeglDiskCache  GeglDiskCache;
 
 #define GEGL_CACHE_VALID_MIPMAPS 8
 
 struct _GeglCache
 {
-  GeglBuffer    parent_instance;
+  GeglBuffer      parent_instance;
 
-  GeglRegion   *valid_region[GEGL_CACHE_VALID_MIPMAPS];
-  GMutex        mutex;
+  /* the valid pixels of each mipmap level */
+  GeglTileBitmap *valid[GEGL_CACHE_VALID_MIPMAPS];
+
+  /* content key of a cache shared between nodes, see gegl_cache_shared_*() */
+  gchar          *shared_key;
+  gint            shared_users;
+  gint64          shared_stamp;
+
+  /* the cache's entry in the disk cache, owned by the buffer's tile storage */
+  GeglDiskCache  *disk_cache;
 };
 
 struct _GeglCacheClass
@@ -57,6 +67,17 @@ void     gegl_cache_computed    (GeglCache           *self,
                                  const GeglRectangle *rect,
                                  gint                 level);
 
+/* shared caches are registered globally under a key identifying the content
+ * they hold, so that nodes computing the same thing, in the same or in
+ * different graphs, use the same cache.  caches which are no longer used by
+ * any node are kept around, up to the "shared-cache-size" budget.
+ */
+GeglCache * gegl_cache_shared_lookup  (const gchar         *key);
+gboolean    gegl_cache_shared_add     (GeglCache           *cache,
+                                       const gchar         *key);
+void        gegl_cache_shared_release (GeglCache           *cache);
+void        gegl_cache_shared_cleanup (void);
+
 G_END_DECLS
 
 #endif /* __GEGL_CACHE_H__ */
@@ -0,0 +1,1104 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include <babl/babl.h>
+
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-buffer.h"
+#include "gegl-buffer-private.h"
+#include "gegl-tile-handler-private.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-source.h"
+#include "gegl-compression.h"
+#include "gegl-disk-cache.h"
+
+/* bumped whenever the layout of the entries changes */
+#define GEGL_DISK_CACHE_VERSION 1
+
+/* entries marked as used during the last GRACE_PERIOD seconds are never
+ * evicted.  processes using an entry mark it as used at least four times as
+ * often, and notice when it's gone otherwise.
+ */
+#define GRACE_PERIOD (10 * 60)
+
+/* maximal tile-data compression ratio, above which we store the uncompressed
+ * tile, as in the swap.
+ */
+#define COMPRESSION_MAX_RATIO 0.95
+
+/* the cache is trimmed whenever the process wrote this fraction of the
+ * disk-cache size to it.
+ */
+#define TRIM_RATIO (1.0 / 16.0)
+
+#define TILE_SUFFIX    ".tile"
+#define STAMP_NAME     "stamp"
+#define EVICTED_PREFIX ".evicted-"
+
+typedef struct
+{
+  gchar   magic[4];        /* "GDCT"                                   */
+  guint32 size;            /* size of the tile data                    */
+  guint32 stored_size;     /* size of the data following the header    */
+  gchar   compression[20]; /* the compression algorithm, or "" if none */
+} GeglDiskCacheHeader;
+
+typedef struct
+{
+  gint     x;
+  gint     y;
+  gint     z;
+  gboolean in_buffer; /* whether the tile is also held by the buffer */
+} GeglDiskCacheTile;
+
+typedef struct
+{
+  gchar   *path;
+  gint64   stamp;
+  guint64  size;
+} GeglDiskCacheEntry;
+
+
+G_DEFINE_TYPE (GeglDiskCache, gegl_disk_cache, GEGL_TYPE_TILE_HANDLER)
+
+static GMutex   written_mutex;
+static guint64  written_size  = 0; /* since the last trim */
+static gboolean written_any   = FALSE;
+
+static GMutex   trim_mutex;
+
+
+static void gegl_disk_cache_trim (void);
+
+static void
+gegl_disk_cache_tile_free (GeglDiskCacheTile *tile)
+{
+  g_slice_free (GeglDiskCacheTile, tile);
+}
+
+static gchar *
+gegl_disk_cache_get_tile_name (gint x,
+                               gint y,
+                               gint z)
+{
+  return g_strdup_printf ("%d_%d_%d", z, x, y);
+}
+
+static gchar *
+gegl_disk_cache_get_tile_filename (GeglDiskCache *self,
+                                   const gchar   *name)
+{
+  return g_strconcat (self->path, G_DIR_SEPARATOR_S, name, TILE_SUFFIX, NULL);
+}
+
+/* the area covered by a tile, in level-0 coordinates, as in the valid
+ * regions of the cache.
+ */
+static gboolean
+gegl_disk_cache_get_tile_rect (GeglDiskCache *self,
+                               GeglRectangle *rect,
+                               gint           x,
+                               gint           y,
+                               gint           z)
+{
+  GeglTileStorage *storage = _gegl_tile_handler_get_tile_storage (
+                               GEGL_TILE_HANDLER (self));
+  GeglRectangle    tile_rect;
+
+  tile_rect.width  = storage->tile_width  * (1 << z);
+  tile_rect.height = storage->tile_height * (1 << z);
+  tile_rect.x      = x * tile_rect.width;
+  tile_rect.y      = y * tile_rect.height;
+
+  return gegl_rectangle_intersect (rect, &tile_rect, &self->extent);
+}
+
+/* marks the entry as used, unless it was marked recently, or @force is TRUE.
+ * returns FALSE if the entry is gone.  called with the mutex held.
+ */
+static gboolean
+gegl_disk_cache_touch (GeglDiskCache *self,
+                       gboolean       force)
+{
+  gint64    now = g_get_monotonic_time ();
+  gchar    *stamp;
+  gboolean  success;
+
+  if (! force && now - self->stamp < GRACE_PERIOD * G_USEC_PER_SEC / 4)
+    return TRUE;
+
+  self->stamp = now;
+
+  stamp   = g_build_filename (self->path, STAMP_NAME, NULL);
+  success = g_utime (stamp, NULL) == 0;
+  g_free (stamp);
+
+  return success;
+}
+
+/* whether @header, read from a tile file of @length bytes, describes a
+ * complete tile we can read.  @compression is set to the compression of
+ * the tile data, or NULL if it's uncompressed.
+ */
+static gboolean
+gegl_disk_cache_check_header (GeglDiskCache          *self,
+                              GeglDiskCacheHeader    *header,
+                              gsize                   length,
+                              const GeglCompression **compression)
+{
+  GeglTileStorage *storage = _gegl_tile_handler_get_tile_storage (
+                               GEGL_TILE_HANDLER (self));
+
+  *compression = NULL;
+
+  if (length < sizeof (*header))
+    return FALSE;
+
+  header->compression[sizeof (header->compression) - 1] = '\0';
+
+  if (header->compression[0])
+    *compression = gegl_compression (header->compression);
+
+  return ! memcmp (header->magic, "GDCT", sizeof (header->magic)) &&
+         header->size        == storage->tile_size                &&
+         header->stored_size == length - sizeof (*header)         &&
+         (*compression || (! header->compression[0] &&
+                           header->stored_size == header->size));
+}
+
+/* whether the tile file at @filename looks complete, without reading its
+ * data.
+ */
+static gboolean
+gegl_disk_cache_check_tile (GeglDiskCache *self,
+                            const gchar   *filename)
+{
+  const GeglCompression *compression;
+  GeglDiskCacheHeader    header;
+  GStatBuf               stat_buf;
+  FILE                  *file;
+  gboolean               success = FALSE;
+
+  file = g_fopen (filename, "rb");
+
+  if (! file)
+    return FALSE;
+
+  if (fread (&header, sizeof (header), 1, file) == 1 &&
+      ! g_stat (filename, &stat_buf))
+    {
+      success = gegl_disk_cache_check_header (self, &header,
+                                              stat_buf.st_size,
+                                              &compression);
+    }
+
+  fclose (file);
+
+  return success;
+}
+
+static gboolean
+gegl_disk_cache_create_entry (GeglDiskCache *self)
+{
+  gchar    *stamp;
+  gboolean  success;
+
+  if (g_mkdir_with_parents (self->path, 0700))
+    return FALSE;
+
+  stamp = g_build_filename (self->path, STAMP_NAME, NULL);
+
+  success = g_utime (stamp, NULL) == 0 ||
+            g_file_set_contents (stamp, "", 0, NULL);
+
+  g_free (stamp);
+
+  self->stamp = g_get_monotonic_time ();
+
+  return success;
+}
+
+/* marks the tiles of the entry as valid in @cache.  truncated or otherwise
+ * damaged tiles, as left by a full disk, are removed instead, and computed
+ * again.
+ */
+static void
+gegl_disk_cache_index (GeglDiskCache *self,
+                       GeglCache     *cache)
+{
+  GDir        *dir;
+  const gchar *name;
+
+  dir = g_dir_open (self->path, 0, NULL);
+
+  if (! dir)
+    return;
+
+  g_mutex_lock (&self->mutex);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      GeglDiskCacheTile *tile;
+      GeglRectangle      rect;
+      gchar             *tile_name;
+      gchar             *filename;
+      gint               x, y, z;
+
+      if (! g_str_has_suffix (name, TILE_SUFFIX) ||
+          sscanf (name, "%d_%d_%d", &z, &x, &y) != 3 ||
+          z < 0 || z >= GEGL_CACHE_VALID_MIPMAPS)
+        {
+          continue;
+        }
+
+      tile_name = gegl_disk_cache_get_tile_name (x, y, z);
+
+      /* skip anything which merely looks like a tile */
+      if (strlen (name) != strlen (tile_name) + strlen (TILE_SUFFIX) ||
+          strncmp (name, tile_name, strlen (tile_name)))
+        {
+          g_free (tile_name);
+
+          continue;
+        }
+
+      filename = g_build_filename (self->path, name, NULL);
+
+      if (! gegl_disk_cache_check_tile (self, filename))
+        {
+          g_unlink (filename);
+
+          g_free (filename);
+          g_free (tile_name);
+
+          continue;
+        }
+
+      g_free (filename);
+
+      tile    = g_slice_new0 (GeglDiskCacheTile);
+      tile->x = x;
+      tile->y = y;
+      tile->z = z;
+
+      g_hash_table_insert (self->tiles, tile_name, tile);
+
+      if (gegl_disk_cache_get_tile_rect (self, &rect, x, y, z))
+        gegl_tile_bitmap_add (cache->valid[z], &rect);
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  g_dir_close (dir);
+}
+
+static GeglTile *
+gegl_disk_cache_read_tile (GeglDiskCache *self,
+                           gint           x,
+                           gint           y,
+                           gint           z)
+{
+  GeglTileStorage       *storage     = _gegl_tile_handler_get_tile_storage (
+                                         GEGL_TILE_HANDLER (self));
+  const GeglCompression *compression = NULL;
+  GeglDiskCacheHeader    header;
+  GeglDiskCacheTile     *entry;
+  GeglTile              *tile        = NULL;
+  gchar                 *name;
+  gchar                 *filename;
+  gchar                 *contents;
+  gsize                  length;
+
+  name = gegl_disk_cache_get_tile_name (x, y, z);
+
+  g_mutex_lock (&self->mutex);
+
+  entry = g_hash_table_lookup (self->tiles, name);
+
+  if (entry)
+    gegl_disk_cache_touch (self, FALSE);
+
+  g_mutex_unlock (&self->mutex);
+
+  if (! entry)
+    {
+      g_free (name);
+
+      return NULL;
+    }
+
+  filename = gegl_disk_cache_get_tile_filename (self, name);
+
+  if (g_file_get_contents (filename, &contents, &length, NULL))
+    {
+      if (length >= sizeof (header))
+        memcpy (&header, contents, sizeof (header));
+
+      if (gegl_disk_cache_check_header (self, &header, length, &compression))
+        {
+          const gchar *data    = contents + sizeof (header);
+          gboolean     success = TRUE;
+
+          tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (self),
+                                                x, y, z);
+
+          gegl_tile_lock (tile);
+
+          if (compression)
+            {
+              success = gegl_compression_decompress (
+                compression, storage->format,
+                gegl_tile_get_data (tile), header.size / storage->px_size,
+                data, header.stored_size);
+            }
+          else
+            {
+              memcpy (gegl_tile_get_data (tile), data, header.size);
+            }
+
+          /* the upper levels of the pyramid have the same content, there's
+           * no need to void them.
+           */
+          gegl_tile_unlock_no_void (tile);
+
+          if (! success)
+            {
+              g_warning ("failed to decompress tile from the disk cache: %s",
+                         filename);
+
+              g_clear_pointer (&tile, gegl_tile_unref);
+            }
+        }
+
+      g_free (contents);
+    }
+
+  g_mutex_lock (&self->mutex);
+
+  entry = g_hash_table_lookup (self->tiles, name);
+
+  if (entry && tile)
+    {
+      entry->in_buffer = TRUE;
+    }
+  else if (entry)
+    {
+      GeglRectangle rect;
+
+      /* the tile is damaged, or gone; drop it, so that it's computed
+       * again.
+       */
+      g_unlink (filename);
+
+      if (gegl_disk_cache_get_tile_rect (self, &rect, x, y, z))
+        gegl_tile_bitmap_remove (self->cache->valid[z], &rect);
+
+      g_hash_table_remove (self->tiles, name);
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  g_free (filename);
+  g_free (name);
+
+  return tile;
+}
+
+static gboolean
+gegl_disk_cache_write_tile (GeglDiskCache *self,
+                            const gchar   *name,
+                            GeglTile      *tile)
+{
+  GeglTileStorage       *storage     = _gegl_tile_handler_get_tile_storage (
+                                         GEGL_TILE_HANDLER (self));
+  const GeglCompression *compression = NULL;
+  GeglDiskCacheHeader    header;
+  guchar                *contents;
+  gchar                 *filename;
+  gint                   compressed_size;
+  gboolean               success;
+
+  if (gegl_config ()->swap_compression)
+    compression = gegl_compression (gegl_config ()->swap_compression);
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, "GDCT", sizeof (header.magic));
+  header.size = storage->tile_size;
+
+  contents = g_malloc (sizeof (header) + storage->tile_size);
+
+  gegl_tile_read_lock (tile);
+
+  if (compression &&
+      gegl_compression_compress (compression, storage->format,
+                                 gegl_tile_get_data (tile),
+                                 storage->tile_size / storage->px_size,
+                                 contents + sizeof (header), &compressed_size,
+                                 storage->tile_size * COMPRESSION_MAX_RATIO))
+    {
+      header.stored_size = compressed_size;
+
+      g_strlcpy (header.compression, gegl_compression_get_name (compression),
+                 sizeof (header.compression));
+    }
+  else
+    {
+      header.stored_size = storage->tile_size;
+
+      memcpy (contents + sizeof (header), gegl_tile_get_data (tile),
+              storage->tile_size);
+    }
+
+  gegl_tile_read_unlock (tile);
+
+  memcpy (contents, &header, sizeof (header));
+
+  /* g_file_set_contents() writes to a temporary file, and renames it over
+   * the tile, so that other processes never see a partial tile.
+   */
+  filename = gegl_disk_cache_get_tile_filename (self, name);
+
+  success = g_file_set_contents (filename, (const gchar *) contents,
+                                 sizeof (header) + header.stored_size, NULL);
+
+  g_free (filename);
+  g_free (contents);
+
+  if (success)
+    {
+      gboolean trim = FALSE;
+
+      g_mutex_lock (&written_mutex);
+
+      written_size += sizeof (header) + header.stored_size;
+      written_any   = TRUE;
+
+      if (written_size >= gegl_config ()->disk_cache_size * TRIM_RATIO)
+        {
+          written_size = 0;
+          trim         = TRUE;
+        }
+
+      g_mutex_unlock (&written_mutex);
+
+      if (trim)
+        {
+          if (g_mutex_trylock (&trim_mutex))
+            {
+              gegl_disk_cache_trim ();
+
+              g_mutex_unlock (&trim_mutex);
+            }
+        }
+    }
+
+  return success;
+}
+
+static gpointer
+gegl_disk_cache_command (GeglTileSource  *source,
+                         GeglTileCommand  command,
+                         gint             x,
+                         gint             y,
+                         gint             z,
+                         gpointer         data)
+{
+  GeglTileHandler *handler = (GeglTileHandler *) source;
+  GeglDiskCache   *self    = (GeglDiskCache *) source;
+  gpointer         result;
+
+  result = gegl_tile_handler_source_command (handler, command, x, y, z, data);
+
+  switch (command)
+    {
+    case GEGL_TILE_GET:
+      if (! result)
+        result = gegl_disk_cache_read_tile (self, x, y, z);
+      break;
+
+    case GEGL_TILE_EXIST:
+      if (! result)
+        {
+          gchar *name = gegl_disk_cache_get_tile_name (x, y, z);
+
+          g_mutex_lock (&self->mutex);
+
+          if (g_hash_table_contains (self->tiles, name))
+            result = GINT_TO_POINTER (TRUE);
+
+          g_mutex_unlock (&self->mutex);
+
+          g_free (name);
+        }
+      break;
+
+    default:
+      break;
+    }
+
+  return result;
+}
+
+static void
+gegl_disk_cache_finalize (GObject *object)
+{
+  GeglDiskCache *self = GEGL_DISK_CACHE (object);
+
+  g_free (self->key);
+  g_free (self->path);
+  g_hash_table_unref (self->tiles);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gegl_disk_cache_parent_class)->finalize (object);
+}
+
+static void
+gegl_disk_cache_class_init (GeglDiskCacheClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gegl_disk_cache_finalize;
+}
+
+static void
+gegl_disk_cache_init (GeglDiskCache *self)
+{
+  ((GeglTileSource *) self)->command = gegl_disk_cache_command;
+
+  self->tiles = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free,
+                                       (GDestroyNotify) gegl_disk_cache_tile_free);
+
+  g_mutex_init (&self->mutex);
+}
+
+/* the name of the entry also covers anything the layout of the stored tiles
+ * depends on, besides the content of the cache.
+ */
+static gchar *
+gegl_disk_cache_get_entry_name (GeglCache   *cache,
+                                const gchar *key)
+{
+  GeglBuffer          *buffer = GEGL_BUFFER (cache);
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+  const Babl          *space  = babl_format_get_space (
+                                  gegl_buffer_get_format (buffer));
+  const Babl          *trc[3];
+  gdouble              chromaticities[8];
+  GString             *str;
+  gchar               *name;
+  gint                 i;
+
+  str = g_string_new (NULL);
+
+  g_string_append_printf (str, "gegl-disk-cache %d\n",
+                          GEGL_DISK_CACHE_VERSION);
+  g_string_append_printf (str, "gegl %d.%d.%d\n",
+                          GEGL_MAJOR_VERSION,
+                          GEGL_MINOR_VERSION,
+                          GEGL_MICRO_VERSION);
+  g_string_append_printf (str, "byte-order %d\n", G_BYTE_ORDER);
+  g_string_append_printf (str, "tile %dx%d\n",
+                          buffer->tile_width, buffer->tile_height);
+  g_string_append_printf (str, "extent %d,%d %dx%d\n",
+                          extent->x, extent->y,
+                          extent->width, extent->height);
+
+  /* the names of spaces loaded from icc profiles aren't unique */
+  babl_space_get (space,
+                  &chromaticities[0], &chromaticities[1],
+                  &chromaticities[2], &chromaticities[3],
+                  &chromaticities[4], &chromaticities[5],
+                  &chromaticities[6], &chromaticities[7],
+                  &trc[0], &trc[1], &trc[2]);
+
+  g_string_append_printf (str, "space %s", babl_get_name (space));
+
+  for (i = 0; i < 8; i++)
+    g_string_append_printf (str, " %a", chromaticities[i]);
+
+  for (i = 0; i < 3; i++)
+    g_string_append_printf (str, " %s", trc[i] ? babl_get_name (trc[i]) : "-");
+
+  g_string_append_printf (str, "\n%s", key);
+
+  name = g_compute_checksum_for_string (G_CHECKSUM_SHA256, str->str, str->len);
+
+  g_string_free (str, TRUE);
+
+  return name;
+}
+
+/* attaches @cache to the entry of the disk cache holding the content
+ * identified by @key, which must not depend on the process, creating it if
+ * necessary.  the tiles already stored in the entry are marked as valid in
+ * @cache.  returns NULL if the disk cache is disabled or can't be used.
+ */
+GeglDiskCache *
+gegl_disk_cache_attach (GeglCache   *cache,
+                        const gchar *key)
+{
+  GeglBuffer    *buffer = GEGL_BUFFER (cache);
+  const gchar   *root   = gegl_config ()->disk_cache;
+  GeglDiskCache *self;
+  gchar         *name;
+
+  g_return_val_if_fail (GEGL_IS_CACHE (cache), NULL);
+  g_return_val_if_fail (cache->disk_cache == NULL, NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  if (! root || ! *root)
+    return NULL;
+
+  /* the tile names assume a tile grid aligned to the origin */
+  if (buffer->shift_x || buffer->shift_y)
+    return NULL;
+
+  name = gegl_disk_cache_get_entry_name (cache, key);
+
+  self         = g_object_new (GEGL_TYPE_DISK_CACHE, NULL);
+  self->key    = g_strdup (key);
+  self->path   = g_build_filename (root, name, NULL);
+  self->extent = *gegl_buffer_get_extent (buffer);
+  self->cache  = cache;
+
+  g_free (name);
+
+  if (! gegl_disk_cache_create_entry (self))
+    {
+      g_object_unref (self);
+
+      return NULL;
+    }
+
+  gegl_buffer_add_handler (buffer, self);
+  g_object_unref (self);
+
+  gegl_disk_cache_index (self, cache);
+
+  cache->disk_cache = self;
+
+  return self;
+}
+
+/* marks the entry as used.  if it was evicted by another process meanwhile,
+ * the tiles we only had on disk are invalidated in @cache, and a new
+ * entry is started.
+ */
+void
+gegl_disk_cache_refresh (GeglDiskCache *self,
+                         GeglCache     *cache)
+{
+  g_return_if_fail (GEGL_IS_DISK_CACHE (self));
+  g_return_if_fail (GEGL_IS_CACHE (cache));
+
+  g_mutex_lock (&self->mutex);
+
+  if (! gegl_disk_cache_touch (self, FALSE))
+    {
+      GHashTableIter iter;
+      gpointer       value;
+
+      g_hash_table_iter_init (&iter, self->tiles);
+
+      while (g_hash_table_iter_next (&iter, NULL, &value))
+        {
+          GeglDiskCacheTile *tile = value;
+          GeglRectangle      rect;
+
+          if (! tile->in_buffer &&
+              gegl_disk_cache_get_tile_rect (self, &rect,
+                                             tile->x, tile->y, tile->z))
+            {
+              gegl_tile_bitmap_remove (cache->valid[tile->z], &rect);
+            }
+        }
+
+      g_hash_table_remove_all (self->tiles);
+
+      gegl_disk_cache_create_entry (self);
+    }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/* writes the tiles of @cache completed by computing @rect at @level to the
+ * entry.
+ */
+void
+gegl_disk_cache_store (GeglDiskCache       *self,
+                       GeglCache           *cache,
+                       const GeglRectangle *rect,
+                       gint                 level)
+{
+  GeglTileStorage *storage;
+  GeglRectangle    roi;
+  gint             tile_width;
+  gint             tile_height;
+  gint             x0, y0;
+  gint             x1, y1;
+  gint             x, y;
+
+  g_return_if_fail (GEGL_IS_DISK_CACHE (self));
+  g_return_if_fail (GEGL_IS_CACHE (cache));
+  g_return_if_fail (rect != NULL);
+
+  if (level < 0 || level >= GEGL_CACHE_VALID_MIPMAPS)
+    return;
+
+  if (! gegl_rectangle_intersect (&roi, rect, &self->extent))
+    return;
+
+  storage     = _gegl_tile_handler_get_tile_storage (GEGL_TILE_HANDLER (self));
+  tile_width  = storage->tile_width  * (1 << level);
+  tile_height = storage->tile_height * (1 << level);
+
+  x0 = gegl_tile_indice (roi.x, tile_width);
+  y0 = gegl_tile_indice (roi.y, tile_height);
+  x1 = gegl_tile_indice (roi.x + roi.width  - 1, tile_width);
+  y1 = gegl_tile_indice (roi.y + roi.height - 1, tile_height);
+
+  for (y = y0; y <= y1; y++)
+    for (x = x0; x <= x1; x++)
+      {
+        GeglRectangle  tile_rect;
+        GeglTile      *tile;
+        gchar         *name;
+        gboolean       stored;
+        gboolean       valid;
+
+        name = gegl_disk_cache_get_tile_name (x, y, level);
+
+        g_mutex_lock (&self->mutex);
+        stored = g_hash_table_contains (self->tiles, name);
+        g_mutex_unlock (&self->mutex);
+
+        /* only tiles which are entirely valid are stored */
+        if (stored ||
+            ! gegl_disk_cache_get_tile_rect (self, &tile_rect, x, y, level))
+          {
+            g_free (name);
+
+            continue;
+          }
+
+        valid = gegl_tile_bitmap_contains (cache->valid[level], &tile_rect);
+
+        tile = valid ? gegl_buffer_get_tile (GEGL_BUFFER (cache),
+                                             x, y, level) :
+                       NULL;
+
+        if (tile && gegl_disk_cache_write_tile (self, name, tile))
+          {
+            GeglDiskCacheTile *entry = g_slice_new (GeglDiskCacheTile);
+
+            entry->x         = x;
+            entry->y         = y;
+            entry->z         = level;
+            entry->in_buffer = TRUE;
+
+            g_mutex_lock (&self->mutex);
+            g_hash_table_replace (self->tiles, name, entry);
+            gegl_disk_cache_touch (self, FALSE);
+            g_mutex_unlock (&self->mutex);
+
+            name = NULL;
+          }
+
+        if (tile)
+          gegl_tile_unref (tile);
+
+        g_free (name);
+      }
+}
+
+/* removes the tiles intersecting @roi, in level-0 coordinates, from the
+ * entry, or all of them if @roi is NULL.
+ */
+void
+gegl_disk_cache_invalidate (GeglDiskCache       *self,
+                            const GeglRectangle *roi)
+{
+  GHashTableIter iter;
+  gpointer       key;
+  gpointer       value;
+
+  g_return_if_fail (GEGL_IS_DISK_CACHE (self));
+
+  g_mutex_lock (&self->mutex);
+
+  if (! roi)
+    {
+      GDir        *dir = g_dir_open (self->path, 0, NULL);
+      const gchar *name;
+
+      /* including the tiles stored by other processes since we attached */
+      while (dir && (name = g_dir_read_name (dir)))
+        {
+          if (g_str_has_suffix (name, TILE_SUFFIX))
+            {
+              gchar *filename = g_build_filename (self->path, name, NULL);
+
+              g_unlink (filename);
+              g_free (filename);
+            }
+        }
+
+      if (dir)
+        g_dir_close (dir);
+
+      g_hash_table_remove_all (self->tiles);
+    }
+  else
+    {
+      g_hash_table_iter_init (&iter, self->tiles);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          GeglDiskCacheTile *tile = value;
+          GeglRectangle      rect;
+
+          if (gegl_disk_cache_get_tile_rect (self, &rect,
+                                             tile->x, tile->y, tile->z) &&
+              gegl_rectangle_intersect (NULL, &rect, roi))
+            {
+              gchar *filename = gegl_disk_cache_get_tile_filename (self, key);
+
+              g_unlink (filename);
+              g_free (filename);
+
+              g_hash_table_iter_remove (&iter);
+            }
+        }
+    }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/* trimming */
+
+/* removes @path and the files in it */
+static void
+gegl_disk_cache_remove_dir (const gchar *path)
+{
+  GDir        *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  while (dir && (name = g_dir_read_name (dir)))
+    {
+      gchar *filename = g_build_filename (path, name, NULL);
+
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  if (dir)
+    g_dir_close (dir);
+
+  g_rmdir (path);
+}
+
+/* the last time the entry at @path was marked as used, in seconds */
+static gint64
+gegl_disk_cache_get_entry_stamp (const gchar *path)
+{
+  GStatBuf  stat_buf;
+  gchar    *stamp = g_build_filename (path, STAMP_NAME, NULL);
+  gint64    time  = 0;
+
+  if (! g_stat (stamp, &stat_buf) || ! g_stat (path, &stat_buf))
+    time = stat_buf.st_mtime;
+
+  g_free (stamp);
+
+  return time;
+}
+
+/* the size of the entry at @path.  leftover temporary files of processes
+ * which died while writing a tile are removed on the way.
+ */
+static guint64
+gegl_disk_cache_get_entry_size (const gchar *path,
+                                gint64       now)
+{
+  GDir        *dir  = g_dir_open (path, 0, NULL);
+  const gchar *name;
+  guint64      size = 0;
+
+  while (dir && (name = g_dir_read_name (dir)))
+    {
+      gchar    *filename = g_build_filename (path, name, NULL);
+      GStatBuf  stat_buf;
+
+      if (! g_stat (filename, &stat_buf))
+        {
+          if (g_str_has_suffix (name, TILE_SUFFIX) ||
+              ! strcmp (name, STAMP_NAME)          ||
+              now - stat_buf.st_mtime < GRACE_PERIOD)
+            {
+              size += stat_buf.st_size;
+            }
+          else
+            {
+              g_unlink (filename);
+            }
+        }
+
+      g_free (filename);
+    }
+
+  if (dir)
+    g_dir_close (dir);
+
+  return size;
+}
+
+static gint
+gegl_disk_cache_compare_entries (gconstpointer a,
+                                 gconstpointer b)
+{
+  const GeglDiskCacheEntry *entry_a = a;
+  const GeglDiskCacheEntry *entry_b = b;
+
+  return (entry_a->stamp > entry_b->stamp) -
+         (entry_a->stamp < entry_b->stamp);
+}
+
+/* evicts the least recently used entries, until the rest fit the
+ * "disk-cache-size" budget.  an entry is evicted by first renaming it, so
+ * that it disappears at once for the other processes.
+ */
+static void
+gegl_disk_cache_trim (void)
+{
+  const gchar *root   = gegl_config ()->disk_cache;
+  guint64      budget = gegl_config ()->disk_cache_size;
+  guint64      total  = 0;
+  gint64       now    = g_get_real_time () / G_USEC_PER_SEC;
+  GList       *entries = NULL;
+  GList       *iter;
+  GDir        *dir;
+  const gchar *name;
+
+  if (! root || ! *root)
+    return;
+
+  dir = g_dir_open (root, 0, NULL);
+
+  if (! dir)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *path = g_build_filename (root, name, NULL);
+
+      if (! g_file_test (path, G_FILE_TEST_IS_DIR))
+        {
+          g_free (path);
+        }
+      else if (g_str_has_prefix (name, EVICTED_PREFIX))
+        {
+          /* left behind by a process which died while evicting it */
+          if (now - gegl_disk_cache_get_entry_stamp (path) >= GRACE_PERIOD)
+            gegl_disk_cache_remove_dir (path);
+
+          g_free (path);
+        }
+      else
+        {
+          GeglDiskCacheEntry *entry = g_slice_new (GeglDiskCacheEntry);
+
+          entry->path  = path;
+          entry->stamp = gegl_disk_cache_get_entry_stamp (path);
+          entry->size  = gegl_disk_cache_get_entry_size (path, now);
+
+          total += entry->size;
+
+          entries = g_list_prepend (entries, entry);
+        }
+    }
+
+  g_dir_close (dir);
+
+  entries = g_list_sort (entries, gegl_disk_cache_compare_entries);
+
+  for (iter = entries; iter; iter = g_list_next (iter))
+    {
+      GeglDiskCacheEntry *entry = iter->data;
+
+      if (total > budget && now - entry->stamp >= GRACE_PERIOD)
+        {
+          gchar *basename = g_path_get_basename (entry->path);
+          gchar *evicted;
+
+          evicted = g_strdup_printf ("%s%s%s%s-%08x",
+                                     root, G_DIR_SEPARATOR_S,
+                                     EVICTED_PREFIX, basename,
+                                     g_random_int ());
+
+          if (! g_rename (entry->path, evicted))
+            {
+              /* put the entry back if it was used in the meantime */
+              if (gegl_disk_cache_get_entry_stamp (evicted) == entry->stamp ||
+                  g_rename (evicted, entry->path))
+                {
+                  gegl_disk_cache_remove_dir (evicted);
+
+                  total -= MIN (total, entry->size);
+                }
+            }
+
+          g_free (evicted);
+          g_free (basename);
+        }
+
+      g_free (entry->path);
+      g_slice_free (GeglDiskCacheEntry, entry);
+    }
+
+  g_list_free (entries);
+}
+
+void
+gegl_disk_cache_cleanup (void)
+{
+  g_mutex_lock (&written_mutex);
+
+  if (written_any)
+    {
+      g_mutex_unlock (&written_mutex);
+
+      g_mutex_lock (&trim_mutex);
+      gegl_disk_cache_trim ();
+      g_mutex_unlock (&trim_mutex);
+
+      g_mutex_lock (&written_mutex);
+
+      written_any  = FALSE;
+      written_size = 0;
+    }
+
+  g_mutex_unlock (&written_mutex);
+}
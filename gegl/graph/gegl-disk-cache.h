@@ -0,0 +1,81 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_DISK_CACHE_H__
+#define __GEGL_DISK_CACHE_H__
+
+#include "gegl-cache.h"
+#include "gegl-tile-handler.h"
+
+/***
+ * GeglDiskCache is a GeglTileHandler which keeps the tiles of a GeglCache in
+ * an entry of the on-disk cache, named after the content key of the cache,
+ * so that later processes computing the same content can reuse them.
+ *
+ * Completed tiles are written to the entry as they are computed, and the
+ * tiles of an existing entry are marked as valid when attaching to it, once
+ * their headers were checked, and only read when first requested.  Each tile is stored in its own file,
+ * compressed using the swap compression, and replaced atomically, so that
+ * several processes can share the same cache directory.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_DISK_CACHE            (gegl_disk_cache_get_type ())
+#define GEGL_DISK_CACHE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_DISK_CACHE, GeglDiskCache))
+#define GEGL_DISK_CACHE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_DISK_CACHE, GeglDiskCacheClass))
+#define GEGL_IS_DISK_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_DISK_CACHE))
+#define GEGL_IS_DISK_CACHE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_DISK_CACHE))
+#define GEGL_DISK_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_DISK_CACHE, GeglDiskCacheClass))
+
+typedef struct _GeglDiskCacheClass GeglDiskCacheClass;
+
+struct _GeglDiskCache
+{
+  GeglTileHandler  parent_instance;
+
+  gchar           *key;    /* the cache key of the content               */
+  gchar           *path;   /* the directory of the entry                 */
+  GHashTable      *tiles;  /* tile name -> GeglDiskCacheTile             */
+  GeglCache       *cache;  /* the cache the entry is attached to         */
+  GeglRectangle    extent; /* the extent of the cache, when attached     */
+  gint64           stamp;  /* the last time the entry was marked as used */
+  GMutex           mutex;
+};
+
+struct _GeglDiskCacheClass
+{
+  GeglTileHandlerClass parent_class;
+};
+
+GType           gegl_disk_cache_get_type   (void) G_GNUC_CONST;
+
+GeglDiskCache * gegl_disk_cache_attach     (GeglCache           *cache,
+                                            const gchar         *key);
+void            gegl_disk_cache_refresh    (GeglDiskCache       *self,
+                                            GeglCache           *cache);
+void            gegl_disk_cache_store      (GeglDiskCache       *self,
+                                            GeglCache           *cache,
+                                            const GeglRectangle *rect,
+                                            gint                 level);
+void            gegl_disk_cache_invalidate (GeglDiskCache       *self,
+                                            const GeglRectangle *roi);
+
+void            gegl_disk_cache_cleanup    (void);
+
+G_END_DECLS
+
+#endif /* __GEGL_DISK_CACHE_H__ */
@@ -133,6 +133,7 @@ void          gegl_node_insert_before       (GeglNode      *self,
 
 gboolean      gegl_node_use_cache           (GeglNode      *node);
 GeglCache   * gegl_node_get_cache           (GeglNode      *node);
+void          gegl_node_clear_cache         (GeglNode      *node);
 void          gegl_node_invalidated         (GeglNode      *node,
                                              const GeglRectangle *rect,
                                              gboolean             clean_cache);
@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <gobject/gvaluecollector.h>
 
 #include "gegl-types-internal.h"
@@ -39,6 +40,7 @@
 
 #include "graph/gegl-visitor.h"
 #include "graph/gegl-callback-visitor.h"
+#include "graph/gegl-disk-cache.h"
 #include "graph/gegl-node-output-visitable.h"
 
 #include "operation/gegl-operation.h"
@@ -79,6 +81,14 @@ struct _GeglNodePrivate
   gchar           *name;
   gchar           *debug_name;
   GeglEvalManager *eval_manager;
+
+  /* identifies the node's output by its content, for shared caches.  a
+   * persistent key doesn't depend on the process, as needed by the disk
+   * cache.
+   */
+  gchar           *content_key;
+  gboolean         content_key_valid;
+  gboolean         content_key_persistent;
 };
 
 
@@ -268,7 +278,7 @@ gegl_node_dispose (GObject *gobject)
     }
 
   gegl_node_remove_children (self);
-  g_clear_object (&self->cache);
+  gegl_node_clear_cache (self);
   g_clear_object (&self->priv->eval_manager);
 
   G_OBJECT_CLASS (gegl_node_parent_class)->dispose (gobject);
@@ -290,6 +300,7 @@ gegl_node_finalize (GObject *gobject)
   g_clear_object (&self->output_visitable);
   g_free (self->priv->name);
   g_free (self->priv->debug_name);
+  g_free (self->priv->content_key);
 
   g_mutex_clear (&self->mutex);
 
@@ -648,161 +659,503 @@ gegl_node_connect_to (GeglNode    *sink,
   return gegl_node_connect (sink, sink_pad_name, source, source_pad_name);
 }
 
-/* the implementation of gegl_node_invalidated() can use either GeglRegions
- * or GeglRectangles (bounding boxes) for calculating the invalidated areas
- * of the nodes in the graph.  The GeglRegion version is more granular,
- * invalidating exact areas, but has higher overhead, while the GeglRectangle
- * version in more coarse, potentially over-invalidating (but never under-
- * invalidating), but has lower overhead.
+/* shared caches
+ *
+ * when the "shared-cache-size" config property is non-zero, the caches of
+ * nodes are registered globally under a key derived from the content they
+ * hold: the operation type, its property values, the keys of the nodes
+ * connected to its inputs, and the output format.  nodes with equal keys
+ * compute the same thing, in whichever graph they are, and share a cache;
+ * the regions and levels computed so far are tracked by the cache itself.
  *
- * TODO: decide if the higher overhead of the GeglRegion version is worth it.
+ * object-valued properties, other than colors, are identified by object
+ * rather than by value; their content changes invalidate all the nodes using
+ * them.  nodes with properties that can't be keyed, such as boxed values or
+ * pointers other than babl formats, use a private cache, and so do the nodes
+ * depending on them.
  */
-/* #define GEGL_NODE_INVALIDATED_USE_REGIONS */
 
-#ifdef GEGL_NODE_INVALIDATED_USE_REGIONS
+static GMutex content_key_mutex;
 
-static gboolean
-gegl_node_invalidated_invalidate_node (GeglNode *node,
-                                       gpointer  data)
+/* a serial number identifying @object for the lifetime of the process,
+ * unlike its address, which may be reused.
+ */
+static gsize
+gegl_node_get_object_serial (GObject *object)
 {
-  GHashTable    *regions = data;
-  GeglRegion    *region  = g_hash_table_lookup (regions, node);
-  GeglRectangle *rects;
-  gint           n_rects;
-  GSList        *iter;
-  gint           i;
+  static GQuark  quark       = 0;
+  static gsize   last_serial = 0;
+  gsize          serial;
 
-  node->valid_have_rect = FALSE;
+  if (! quark)
+    quark = g_quark_from_static_string ("gegl-node-object-serial");
 
-  gegl_region_get_rectangles (region,
-                              &rects, &n_rects);
+  serial = GPOINTER_TO_SIZE (g_object_get_qdata (object, quark));
 
-  for (i = 0; i < n_rects; i++)
+  if (! serial)
     {
-      if (node->cache)
-        gegl_cache_invalidate (node->cache, &rects[i]);
+      serial = ++last_serial;
 
-      g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
-                     &rects[i], NULL);
+      g_object_set_qdata (object, quark, GSIZE_TO_POINTER (serial));
     }
 
-  for (iter = node->priv->sink_connections; iter; iter = g_slist_next (iter))
+  return serial;
+}
+
+static void
+gegl_node_append_file_key (GString     *str,
+                           const gchar *filename)
+{
+  GStatBuf stat_buf;
+
+  if (! g_stat (filename, &stat_buf))
     {
-      GeglConnection *connection  = iter->data;
-      GeglNode       *sink_node   = gegl_connection_get_sink_node (connection);
-      GeglPad        *sink_pad    = gegl_connection_get_sink_pad (connection);
-      GeglRegion     *sink_region = g_hash_table_lookup (regions, sink_node);
+      g_string_append_printf (str, " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT,
+                              (gint64) stat_buf.st_size,
+                              (gint64) stat_buf.st_mtime);
+    }
+}
 
-      if (! sink_region)
+static gboolean
+gegl_node_append_value_key (GString      *str,
+                            GParamSpec   *pspec,
+                            const GValue *value,
+                            gboolean     *persistent)
+{
+  if (G_VALUE_HOLDS_DOUBLE (value))
+    {
+      g_string_append_printf (str, "%a", g_value_get_double (value));
+    }
+  else if (G_VALUE_HOLDS_FLOAT (value))
+    {
+      g_string_append_printf (str, "%a", (gdouble) g_value_get_float (value));
+    }
+  else if (G_VALUE_HOLDS_OBJECT (value))
+    {
+      GObject *object = g_value_get_object (value);
+
+      if (! object)
         {
-          sink_region = gegl_region_new ();
+          g_string_append (str, "null");
+        }
+      else if (GEGL_IS_COLOR (object))
+        {
+          gdouble rgba[4];
 
-          g_hash_table_insert (regions, sink_node, sink_region);
+          gegl_color_get_pixel (GEGL_COLOR (object),
+                                babl_format ("RGBA double"), rgba);
+
+          g_string_append_printf (str, "%a,%a,%a,%a",
+                                  rgba[0], rgba[1], rgba[2], rgba[3]);
         }
+      else
+        {
+          g_string_append_printf (str, "object %" G_GSIZE_FORMAT,
+                                  gegl_node_get_object_serial (object));
 
-      if (sink_node->operation)
+          *persistent = FALSE;
+        }
+    }
+  else if (GEGL_IS_PARAM_SPEC_FORMAT (pspec))
+    {
+      /* babl formats live as long as the process */
+      const Babl *format = g_value_get_pointer (value);
+
+      g_string_append (str, format ? babl_get_name (format) : "null");
+    }
+  else if (G_VALUE_HOLDS_BOXED   (value) ||
+           G_VALUE_HOLDS_POINTER (value) ||
+           G_VALUE_HOLDS_PARAM   (value) ||
+           G_VALUE_HOLDS_VARIANT (value))
+    {
+      return FALSE;
+    }
+  else
+    {
+      gchar *contents = g_strdup_value_contents (value);
+
+      g_string_append (str, contents);
+
+      g_free (contents);
+
+      /* files are identified by their path, size and modification time */
+      if (GEGL_IS_PARAM_SPEC_FILE_PATH (pspec) && g_value_get_string (value))
         {
-          for (i = 0; i < n_rects; i++)
-            {
-              GeglRectangle invalidated_rect;
+          gegl_node_append_file_key (str, g_value_get_string (value));
+        }
+      else if (GEGL_IS_PARAM_SPEC_URI (pspec) && g_value_get_string (value) &&
+               *g_value_get_string (value))
+        {
+          gchar *filename;
 
-              invalidated_rect = gegl_operation_get_invalidated_by_change (
-                sink_node->operation,
-                gegl_pad_get_name (sink_pad), &rects[i]);
+          filename = g_filename_from_uri (g_value_get_string (value),
+                                          NULL, NULL);
 
-              gegl_region_union_with_rect (sink_region, &invalidated_rect);
-            }
+          /* other uris may refer to anything, from one process to another */
+          if (filename)
+            gegl_node_append_file_key (str, filename);
+          else
+            *persistent = FALSE;
+
+          g_free (filename);
         }
-      else
+    }
+
+  return TRUE;
+}
+
+static gint
+gegl_node_compare_pad_names (gconstpointer a,
+                             gconstpointer b)
+{
+  return strcmp (gegl_pad_get_name ((GeglPad *) a),
+                 gegl_pad_get_name ((GeglPad *) b));
+}
+
+/* returns the content key of @node, or NULL if it can't be keyed.  called
+ * with content_key_mutex held.
+ */
+static const gchar *
+gegl_node_get_content_key (GeglNode *node)
+{
+  GString     *str;
+  GParamSpec **pspecs;
+  guint        n_pspecs;
+  GSList      *pads;
+  GSList      *iter;
+  gboolean     keyable    = TRUE;
+  gboolean     persistent = TRUE;
+  guint        i;
+
+  if (node->priv->content_key_valid)
+    return node->priv->content_key;
+
+  g_clear_pointer (&node->priv->content_key, g_free);
+  node->priv->content_key_valid      = TRUE;
+  node->priv->content_key_persistent = FALSE;
+
+  if (! node->operation)
+    return NULL;
+
+  str = g_string_new (G_OBJECT_TYPE_NAME (node->operation));
+
+  g_string_append_printf (str, "\npassthrough %d", node->passthrough);
+
+  pspecs = g_object_class_list_properties (
+             G_OBJECT_GET_CLASS (node->operation), &n_pspecs);
+
+  for (i = 0; i < n_pspecs && keyable; i++)
+    {
+      GParamSpec *pspec = pspecs[i];
+      GValue      value = G_VALUE_INIT;
+
+      if (! (pspec->flags & G_PARAM_READABLE) ||
+          (pspec->flags & (GEGL_PARAM_PAD_INPUT | GEGL_PARAM_PAD_OUTPUT)))
+        continue;
+
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+      g_object_get_property (G_OBJECT (node->operation), pspec->name, &value);
+
+      g_string_append_printf (str, "\n%s ", pspec->name);
+      keyable = gegl_node_append_value_key (str, pspec, &value, &persistent);
+
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+
+  /* the inputs, in a stable order */
+  pads = g_slist_sort (g_slist_copy (node->input_pads),
+                       gegl_node_compare_pad_names);
+
+  for (iter = pads; iter && keyable; iter = g_slist_next (iter))
+    {
+      GeglPad *pad        = iter->data;
+      GeglPad *source_pad = gegl_pad_get_connected_to (pad);
+
+      g_string_append_printf (str, "\n%s <- ", gegl_pad_get_name (pad));
+
+      if (source_pad)
         {
-          gegl_region_union (sink_region, region);
+          const gchar *source_key;
+
+          source_key = gegl_node_get_content_key (
+                         gegl_pad_get_node (source_pad));
+
+          if (source_key)
+            {
+              g_string_append_printf (str, "%s %s", source_key,
+                                      gegl_pad_get_name (source_pad));
+
+              if (! gegl_pad_get_node (source_pad)->priv->content_key_persistent)
+                persistent = FALSE;
+            }
+          else
+            {
+              keyable = FALSE;
+            }
         }
     }
 
-  g_free (rects);
+  g_slist_free (pads);
 
-  return FALSE;
+  if (keyable)
+    {
+      node->priv->content_key =
+        g_compute_checksum_for_string (G_CHECKSUM_SHA256, str->str, str->len);
+      node->priv->content_key_persistent = persistent;
+    }
+
+  g_string_free (str, TRUE);
+
+  return node->priv->content_key;
 }
 
-void
-gegl_node_invalidated (GeglNode            *node,
-                       const GeglRectangle *rect,
-                       gboolean             clear_cache)
+/* returns the key of the shared cache holding the output of @node in
+ * @format, or NULL if the node can't use a shared cache.  if @persistent is
+ * not NULL, it's set to whether the key can be used by other processes.
+ *
+ * the key includes the node's extent, since a shared cache keeps the extent
+ * it was created with, and some content keys, like the ones of buffers,
+ * don't change with it.
+ */
+static gchar *
+gegl_node_get_cache_key (GeglNode   *node,
+                         const Babl *format,
+                         gboolean   *persistent)
 {
-  GHashTable  *regions;
-  GeglVisitor *visitor;
+  const gchar *content_key;
+  gchar       *key = NULL;
 
-  g_return_if_fail (GEGL_IS_NODE (node));
+  g_mutex_lock (&content_key_mutex);
 
-  if (!rect)
-    rect = &node->have_rect;
+  content_key = gegl_node_get_content_key (node);
 
-  if (node->cache && clear_cache)
-    gegl_buffer_clear (GEGL_BUFFER (node->cache), rect);
+  if (content_key)
+    key = g_strdup_printf ("%s %s %d,%d %dx%d",
+                           content_key, babl_get_name (format),
+                           node->have_rect.x, node->have_rect.y,
+                           node->have_rect.width, node->have_rect.height);
 
-  regions = g_hash_table_new_full (NULL, NULL, NULL,
-                                   (GDestroyNotify) gegl_region_destroy);
+  if (persistent)
+    *persistent = content_key && node->priv->content_key_persistent;
 
-  g_hash_table_insert (regions, node, gegl_region_rectangle (rect));
+  g_mutex_unlock (&content_key_mutex);
 
-  visitor = gegl_callback_visitor_new (gegl_node_invalidated_invalidate_node,
-                                       regions);
+  return key;
+}
+
+/* called for every invalidated node: invalidating a shared cache is only
+ * right if the node's content changed while its key didn't, as when the
+ * contents of a source buffer change.  if the key changed, as when a
+ * property changed, the node moves away from the shared cache instead,
+ * leaving it intact for the other nodes sharing it.  the same goes for the
+ * entry of a cache in the disk cache.
+ */
+static void
+gegl_node_update_shared_cache (GeglNode *node)
+{
+  const gchar *cache_key = NULL;
+
+  node->priv->content_key_valid = FALSE;
+
+  if (node->cache && node->cache->shared_key)
+    cache_key = node->cache->shared_key;
+  else if (node->cache && node->cache->disk_cache)
+    cache_key = node->cache->disk_cache->key;
+
+  if (cache_key)
+    {
+      gchar *key;
+
+      key = gegl_node_get_cache_key (
+              node, gegl_buffer_get_format (GEGL_BUFFER (node->cache)), NULL);
+
+      if (g_strcmp0 (key, cache_key))
+        gegl_node_clear_cache (node);
+
+      g_free (key);
+    }
+}
+
+static gboolean
+gegl_node_content_changed_node (GeglNode *node,
+                                gpointer  data)
+{
+  gegl_node_update_shared_cache (node);
+
+  return FALSE;
+}
+
+/* updates the shared caches of @node and of the nodes depending on it, after
+ * a change which affects their content keys without invalidating them.
+ */
+static void
+gegl_node_content_changed (GeglNode *node)
+{
+  GeglVisitor *visitor;
+
+  visitor = gegl_callback_visitor_new (gegl_node_content_changed_node, NULL);
 
   gegl_visitor_traverse_reverse_topological (visitor,
                                              gegl_node_get_output_visitable (node));
 
   g_object_unref (visitor);
-  g_hash_table_unref (regions);
 }
 
-#else /* ! GEGL_NODE_INVALIDATED_USE_REGIONS */
+/* gegl_node_invalidated() keeps the exact invalidated region of every node
+ * in the graph, so that separate changes, like the dabs of a brush stroke,
+ * don't invalidate the area between them.  the region of a node is reduced
+ * to at most GEGL_NODE_INVALIDATED_MAX_RECTS rectangles before being
+ * propagated, which bounds the cost of fragmented regions.
+ */
+#define GEGL_NODE_INVALIDATED_MAX_RECTS 16
+
+static guint64
+gegl_node_invalidated_rect_area (const GeglRectangle *rect)
+{
+  return (guint64) rect->width * rect->height;
+}
+
+/* merges the rectangles of @rects, in place, until there are no more than
+ * GEGL_NODE_INVALIDATED_MAX_RECTS of them, and returns their new number.
+ * the result covers the original rectangles, but may overlap.
+ */
+static gint
+gegl_node_invalidated_coalesce (GeglRectangle *rects,
+                                gint           n_rects)
+{
+  /* regions list their rectangles in bands, so neighbours in the list are
+   * neighbours in the image too; halve many rectangles by merging them in
+   * pairs, before the more precise, quadratic, merging below.
+   */
+  while (n_rects > 4 * GEGL_NODE_INVALIDATED_MAX_RECTS)
+    {
+      gint i;
+
+      for (i = 0; i < n_rects / 2; i++)
+        {
+          gegl_rectangle_bounding_box (&rects[i],
+                                       &rects[2 * i], &rects[2 * i + 1]);
+        }
+
+      if (n_rects % 2)
+        rects[i++] = rects[n_rects - 1];
+
+      n_rects = i;
+    }
+
+  /* merge the pair of rectangles whose bounding box adds the least area */
+  while (n_rects > GEGL_NODE_INVALIDATED_MAX_RECTS)
+    {
+      gint64 best_cost = G_MAXINT64;
+      gint   best_i    = 0;
+      gint   best_j    = 1;
+      gint   i, j;
+
+      for (i = 0; i < n_rects; i++)
+        {
+          for (j = i + 1; j < n_rects; j++)
+            {
+              GeglRectangle bounds;
+              gint64        cost;
+
+              gegl_rectangle_bounding_box (&bounds, &rects[i], &rects[j]);
+
+              cost = (gint64) gegl_node_invalidated_rect_area (&bounds)    -
+                     (gint64) gegl_node_invalidated_rect_area (&rects[i]) -
+                     (gint64) gegl_node_invalidated_rect_area (&rects[j]);
+
+              if (cost < best_cost)
+                {
+                  best_cost = cost;
+                  best_i    = i;
+                  best_j    = j;
+                }
+            }
+        }
+
+      gegl_rectangle_bounding_box (&rects[best_i],
+                                   &rects[best_i], &rects[best_j]);
+
+      rects[best_j] = rects[--n_rects];
+    }
+
+  return n_rects;
+}
 
 static gboolean
 gegl_node_invalidated_invalidate_node (GeglNode *node,
                                        gpointer  data)
 {
-  GHashTable          *rects = data;
-  const GeglRectangle *rect  = g_hash_table_lookup (rects, node);
-  GSList              *iter;
+  GHashTable    *regions = data;
+  GeglRegion    *region  = g_hash_table_lookup (regions, node);
+  GeglRectangle *rects;
+  gint           n_rects;
+  GSList        *iter;
+  gint           i;
 
   node->valid_have_rect = FALSE;
 
-  if (node->cache)
-    gegl_cache_invalidate (node->cache, rect);
+  gegl_node_update_shared_cache (node);
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
 
-  g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
-                 rect, NULL);
+  if (n_rects == 0)
+    {
+      /* the node is still notified, and its sinks may still depend on
+       * it as a whole, as before
+       */
+      rects   = g_renew (GeglRectangle, rects, 1);
+      n_rects = 1;
+
+      gegl_region_get_clipbox (region, &rects[0]);
+    }
+  else
+    {
+      n_rects = gegl_node_invalidated_coalesce (rects, n_rects);
+    }
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if (node->cache)
+        gegl_cache_invalidate (node->cache, &rects[i]);
+
+      g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
+                     &rects[i], NULL);
+    }
 
   for (iter = node->priv->sink_connections; iter; iter = g_slist_next (iter))
     {
-      GeglConnection *connection = iter->data;
-      GeglNode       *sink_node  = gegl_connection_get_sink_node (connection);
-      GeglPad        *sink_pad   = gegl_connection_get_sink_pad (connection);
-      GeglRectangle  *sink_rect  = g_hash_table_lookup (rects, sink_node);
+      GeglConnection *connection  = iter->data;
+      GeglNode       *sink_node   = gegl_connection_get_sink_node (connection);
+      GeglPad        *sink_pad    = gegl_connection_get_sink_pad (connection);
+      GeglRegion     *sink_region = g_hash_table_lookup (regions, sink_node);
 
-      if (! sink_rect)
+      if (! sink_region)
         {
-          sink_rect = gegl_rectangle_new (0, 0, 0, 0);
+          sink_region = gegl_region_new ();
 
-          g_hash_table_insert (rects, sink_node, sink_rect);
+          g_hash_table_insert (regions, sink_node, sink_region);
         }
 
-      if (sink_node->operation)
+      for (i = 0; i < n_rects; i++)
         {
-          GeglRectangle invalidated_rect;
+          GeglRectangle invalidated_rect = rects[i];
 
-          invalidated_rect = gegl_operation_get_invalidated_by_change (
-            sink_node->operation,
-            gegl_pad_get_name (sink_pad), rect);
+          if (sink_node->operation)
+            {
+              invalidated_rect = gegl_operation_get_invalidated_by_change (
+                sink_node->operation,
+                gegl_pad_get_name (sink_pad), &rects[i]);
+            }
 
-          gegl_rectangle_bounding_box (sink_rect, sink_rect, &invalidated_rect);
-        }
-      else
-        {
-          gegl_rectangle_bounding_box (sink_rect, sink_rect, rect);
+          gegl_region_union_with_rect (sink_region, &invalidated_rect);
         }
     }
 
+  g_free (rects);
+
   return FALSE;
 }
 
@@ -811,7 +1164,7 @@ gegl_node_invalidated (GeglNode            *node,
                        const GeglRectangle *rect,
                        gboolean             clear_cache)
 {
-  GHashTable  *rects;
+  GHashTable  *regions;
   GeglVisitor *visitor;
 
   g_return_if_fail (GEGL_IS_NODE (node));
@@ -822,26 +1175,21 @@ gegl_node_invalidated (GeglNode            *node,
   if (node->cache && clear_cache)
     gegl_buffer_clear (GEGL_BUFFER (node->cache), rect);
 
-  rects = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  regions = g_hash_table_new_full (NULL, NULL, NULL,
+                                   (GDestroyNotify) gegl_region_destroy);
 
-#if GLIB_CHECK_VERSION(2,68,0)
-  g_hash_table_insert (rects, node, g_memdup2 (rect, sizeof (GeglRectangle)));
-#else
-  g_hash_table_insert (rects, node, g_memdup (rect, sizeof (GeglRectangle)));
-#endif
+  g_hash_table_insert (regions, node, gegl_region_rectangle (rect));
 
   visitor = gegl_callback_visitor_new (gegl_node_invalidated_invalidate_node,
-                                       rects);
+                                       regions);
 
   gegl_visitor_traverse_reverse_topological (visitor,
                                              gegl_node_get_output_visitable (node));
 
   g_object_unref (visitor);
-  g_hash_table_unref (rects);
+  g_hash_table_unref (regions);
 }
 
-#endif /* ! GEGL_NODE_INVALIDATED_USE_REGIONS */
-
 static void
 gegl_node_source_invalidated (GeglNode            *source,
                               GeglPad             *destination_pad,
@@ -1036,6 +1384,10 @@ gegl_node_disconnect (GeglNode    *sink,
 
       gegl_connection_destroy (connection);
 
+      /* the sink was invalidated while still connected, so the content
+       * keys of its shared caches are only now out of date.
+       */
+      gegl_node_content_changed (real_sink);
 
       return TRUE;
     }
@@ -1448,6 +1800,15 @@ gegl_node_property_changed (GObject    *gobject,
         }
     }
 
+  else if (arg1 && arg1 != user_data &&
+           arg1->value_type == GEGL_TYPE_BUFFER)
+    {
+      /* buffer properties are not invalidated here, but they are part of
+       * the content key.
+       */
+      gegl_node_content_changed (self);
+    }
+
   if (arg1)
     g_object_notify_by_pspec (G_OBJECT (self), arg1);
 }
@@ -2126,10 +2487,15 @@ gegl_node_get_cache (GeglNode *node)
     }
 
   if (node->cache && gegl_buffer_get_format ((GeglBuffer *)(node->cache)) != format)
-    g_clear_object (&node->cache);
+    gegl_node_clear_cache (node);
 
   if (node->cache)
-    return node->cache;
+    {
+      if (node->cache->disk_cache)
+        gegl_disk_cache_refresh (node->cache->disk_cache, node->cache);
+
+      return node->cache;
+    }
 
   gegl_node_get_bounding_box (node);
 
@@ -2137,21 +2503,41 @@ gegl_node_get_cache (GeglNode *node)
 
   if (!node->cache)
     {
-      GeglCache *cache;
+      GeglCache *cache      = NULL;
+      gchar     *key        = NULL;
+      gboolean   persistent = FALSE;
+      gboolean   shared     = gegl_config ()->shared_cache_size > 0;
+
+      if (shared || gegl_config ()->disk_cache)
+        key = gegl_node_get_cache_key (node, format, &persistent);
 
-      cache = g_object_new (
-        GEGL_TYPE_CACHE,
-        "format",      format,
-        "initialized", gegl_operation_context_get_init_output (),
-        NULL);
+      if (key && shared)
+        cache = gegl_cache_shared_lookup (key);
 
-      gegl_object_set_has_forked (G_OBJECT (cache));
-      gegl_buffer_set_extent (GEGL_BUFFER (cache), &node->have_rect);
+      if (! cache)
+        {
+          cache = g_object_new (
+            GEGL_TYPE_CACHE,
+            "format",      format,
+            "initialized", gegl_operation_context_get_init_output (),
+            NULL);
+
+          gegl_object_set_has_forked (G_OBJECT (cache));
+          gegl_buffer_set_extent (GEGL_BUFFER (cache), &node->have_rect);
+
+          if (key && persistent && gegl_config ()->disk_cache)
+            gegl_disk_cache_attach (cache, key);
+
+          if (key && shared)
+            gegl_cache_shared_add (cache, key);
+        }
 
       g_signal_connect_swapped (G_OBJECT (cache), "computed",
                                 (GCallback) gegl_node_emit_computed,
                                 node);
       node->cache = cache;
+
+      g_free (key);
     }
 
   g_mutex_unlock (&node->mutex);
@@ -2159,6 +2545,24 @@ gegl_node_get_cache (GeglNode *node)
   return node->cache;
 }
 
+void
+gegl_node_clear_cache (GeglNode *node)
+{
+  g_return_if_fail (GEGL_IS_NODE (node));
+
+  if (! node->cache)
+    return;
+
+  g_signal_handlers_disconnect_by_func (node->cache,
+                                        gegl_node_emit_computed,
+                                        node);
+
+  if (node->cache->shared_key)
+    gegl_cache_shared_release (node->cache);
+
+  g_clear_object (&node->cache);
+}
+
 GeglVisitable *
 gegl_node_get_output_visitable (GeglNode *self)
 {
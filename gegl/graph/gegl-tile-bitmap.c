@@ -0,0 +1,919 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl-types-internal.h"
+#include "gegl-buffer.h"
+#include "gegl-region.h"
+#include "gegl-tile-bitmap.h"
+
+#define CHUNK_SHIFT 5
+#define CHUNK_SIZE  (1 << CHUNK_SHIFT) /* tiles along each side of a chunk */
+#define N_BUCKETS   64
+
+/* bits a to b - 1 of a chunk row */
+#define ROW_MASK(a, b) ((((b) < CHUNK_SIZE) ? (1u << (b)) : 0u) - (1u << (a)))
+
+typedef struct _GeglTileBitmapChunk GeglTileBitmapChunk;
+
+/* a square of CHUNK_SIZE x CHUNK_SIZE tiles, with a bit per whole tile, and
+ * a bit per tile which is only partially set, whose pixels are kept in a
+ * region of its own.
+ */
+struct _GeglTileBitmapChunk
+{
+  GeglTileBitmapChunk  *next;
+  gint                  x;
+  gint                  y;
+  guint                 rows[CHUNK_SIZE];
+  guint                 partial_rows[CHUNK_SIZE];
+  GeglRegion          **partial; /* protected by the mutex of the bitmap */
+};
+
+struct _GeglTileBitmap
+{
+  gint                 tile_width;
+  gint                 tile_height;
+
+  /* chunks are only ever added to the buckets, so that they can be looked up
+   * without locking, and are freed along with the bitmap.
+   */
+  GeglTileBitmapChunk *buckets[N_BUCKETS];
+  gint                 n_chunks;
+
+  GMutex               mutex;
+  gint                 n_partial;
+};
+
+/* a range of tiles, [x1, x2) x [y1, y2) */
+typedef struct
+{
+  gint x1;
+  gint y1;
+  gint x2;
+  gint y2;
+} GeglTileRange;
+
+typedef void (* GeglTileBitmapFunc) (GeglTileBitmap      *bitmap,
+                                     GeglTileBitmapChunk *chunk,
+                                     gint                 row,
+                                     guint                mask,
+                                     gpointer             data);
+
+static inline gint
+floor_div (gint64 a,
+           gint   b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static inline gint
+ceil_div (gint64 a,
+          gint   b)
+{
+  return a > 0 ? (a + b - 1) / b : -(-a / b);
+}
+
+static inline gboolean
+rect_is_empty (const GeglRectangle *rect)
+{
+  return rect->width <= 0 || rect->height <= 0;
+}
+
+static void
+get_tiles_rect (GeglTileBitmap *bitmap,
+                GeglRectangle  *rect,
+                gint            x,
+                gint            y,
+                gint            n_x,
+                gint            n_y)
+{
+  rect->x      = x   * bitmap->tile_width;
+  rect->y      = y   * bitmap->tile_height;
+  rect->width  = n_x * bitmap->tile_width;
+  rect->height = n_y * bitmap->tile_height;
+}
+
+static void
+get_chunk_tile_rect (GeglTileBitmap      *bitmap,
+                     GeglTileBitmapChunk *chunk,
+                     GeglRectangle       *rect,
+                     gint                 i,
+                     gint                 row)
+{
+  get_tiles_rect (bitmap, rect,
+                  chunk->x * CHUNK_SIZE + i, chunk->y * CHUNK_SIZE + row,
+                  1, 1);
+}
+
+/* the tiles overlapping @rect */
+static void
+get_overlapping_tiles (GeglTileBitmap      *bitmap,
+                       const GeglRectangle *rect,
+                       GeglTileRange       *range)
+{
+  range->x1 = floor_div (rect->x, bitmap->tile_width);
+  range->y1 = floor_div (rect->y, bitmap->tile_height);
+  range->x2 = ceil_div ((gint64) rect->x + rect->width,  bitmap->tile_width);
+  range->y2 = ceil_div ((gint64) rect->y + rect->height, bitmap->tile_height);
+}
+
+/* the tiles entirely covered by @rect, returns FALSE if there are none */
+static gboolean
+get_covered_tiles (GeglTileBitmap      *bitmap,
+                   const GeglRectangle *rect,
+                   GeglTileRange       *range)
+{
+  range->x1 = ceil_div (rect->x, bitmap->tile_width);
+  range->y1 = ceil_div (rect->y, bitmap->tile_height);
+  range->x2 = floor_div ((gint64) rect->x + rect->width,  bitmap->tile_width);
+  range->y2 = floor_div ((gint64) rect->y + rect->height, bitmap->tile_height);
+
+  return range->x1 < range->x2 && range->y1 < range->y2;
+}
+
+static void
+subtract_rect (GeglRegion          *region,
+               const GeglRectangle *rect)
+{
+  GeglRegion *temp = gegl_region_rectangle (rect);
+
+  gegl_region_subtract (region, temp);
+  gegl_region_destroy (temp);
+}
+
+static guint
+gegl_tile_bitmap_bucket (gint x,
+                         gint y)
+{
+  return ((guint) x * 73856093u ^ (guint) y * 19349663u) % N_BUCKETS;
+}
+
+static GeglTileBitmapChunk *
+gegl_tile_bitmap_lookup (GeglTileBitmap *bitmap,
+                         gint            x,
+                         gint            y,
+                         gboolean        create)
+{
+  GeglTileBitmapChunk **bucket = &bitmap->buckets[gegl_tile_bitmap_bucket (x, y)];
+  GeglTileBitmapChunk  *chunk  = NULL;
+  GeglTileBitmapChunk  *head;
+
+  do
+    {
+      GeglTileBitmapChunk *iter;
+
+      head = g_atomic_pointer_get (bucket);
+
+      for (iter = head; iter; iter = iter->next)
+        {
+          if (iter->x == x && iter->y == y)
+            {
+              /* somebody else added it in the meantime */
+              g_free (chunk);
+
+              return iter;
+            }
+        }
+
+      if (! create)
+        return NULL;
+
+      if (! chunk)
+        {
+          chunk    = g_new0 (GeglTileBitmapChunk, 1);
+          chunk->x = x;
+          chunk->y = y;
+        }
+
+      chunk->next = head;
+    }
+  while (! g_atomic_pointer_compare_and_exchange (bucket, head, chunk));
+
+  g_atomic_int_inc (&bitmap->n_chunks);
+
+  return chunk;
+}
+
+static void
+gegl_tile_bitmap_foreach_in_chunk (GeglTileBitmap      *bitmap,
+                                   GeglTileBitmapChunk *chunk,
+                                   const GeglTileRange *range,
+                                   GeglTileBitmapFunc   func,
+                                   gpointer             data)
+{
+  gint64 x0 = (gint64) chunk->x * CHUNK_SIZE;
+  gint64 y0 = (gint64) chunk->y * CHUNK_SIZE;
+  gint   a  = 0;
+  gint   b  = CHUNK_SIZE;
+  gint   r1 = 0;
+  gint   r2 = CHUNK_SIZE;
+  gint   row;
+
+  if (range)
+    {
+      a  = CLAMP (range->x1 - x0, 0, CHUNK_SIZE);
+      b  = CLAMP (range->x2 - x0, 0, CHUNK_SIZE);
+      r1 = CLAMP (range->y1 - y0, 0, CHUNK_SIZE);
+      r2 = CLAMP (range->y2 - y0, 0, CHUNK_SIZE);
+    }
+
+  if (a >= b)
+    return;
+
+  for (row = r1; row < r2; row++)
+    func (bitmap, chunk, row, ROW_MASK (a, b), data);
+}
+
+/* calls @func for each row of each chunk intersecting @range, or all the
+ * chunks if @range is NULL, creating the missing ones if @create is TRUE.
+ */
+static void
+gegl_tile_bitmap_foreach (GeglTileBitmap      *bitmap,
+                          const GeglTileRange *range,
+                          gboolean             create,
+                          GeglTileBitmapFunc   func,
+                          gpointer             data)
+{
+  gint x1 = 0, y1 = 0;
+  gint x2 = 0, y2 = 0;
+  gint x, y;
+
+  if (range)
+    {
+      if (range->x1 >= range->x2 || range->y1 >= range->y2)
+        return;
+
+      x1 = floor_div (range->x1, CHUNK_SIZE);
+      y1 = floor_div (range->y1, CHUNK_SIZE);
+      x2 = floor_div ((gint64) range->x2 - 1, CHUNK_SIZE) + 1;
+      y2 = floor_div ((gint64) range->y2 - 1, CHUNK_SIZE) + 1;
+    }
+
+  /* visit the existing chunks rather than the range, when there are fewer
+   * of them, as when invalidating an infinite plane.
+   */
+  if (! range ||
+      (! create &&
+       (guint64) (x2 - x1) * (guint64) (y2 - y1) >
+       (guint64) g_atomic_int_get (&bitmap->n_chunks)))
+    {
+      gint i;
+
+      for (i = 0; i < N_BUCKETS; i++)
+        {
+          GeglTileBitmapChunk *chunk;
+
+          for (chunk = g_atomic_pointer_get (&bitmap->buckets[i]);
+               chunk;
+               chunk = chunk->next)
+            {
+              if (! range ||
+                  (chunk->x >= x1 && chunk->x < x2 &&
+                   chunk->y >= y1 && chunk->y < y2))
+                {
+                  gegl_tile_bitmap_foreach_in_chunk (bitmap, chunk, range,
+                                                     func, data);
+                }
+            }
+        }
+
+      return;
+    }
+
+  for (y = y1; y < y2; y++)
+    for (x = x1; x < x2; x++)
+      {
+        GeglTileBitmapChunk *chunk;
+
+        chunk = gegl_tile_bitmap_lookup (bitmap, x, y, create);
+
+        if (chunk)
+          gegl_tile_bitmap_foreach_in_chunk (bitmap, chunk, range, func, data);
+      }
+}
+
+/* calls @func for the tiles of @overlap which are not in @covered */
+static void
+gegl_tile_bitmap_foreach_edge (GeglTileBitmap      *bitmap,
+                               const GeglTileRange *overlap,
+                               const GeglTileRange *covered,
+                               gboolean             create,
+                               GeglTileBitmapFunc   func,
+                               gpointer             data)
+{
+  GeglTileRange edges[4] =
+    {
+      {overlap->x1, overlap->y1, overlap->x2, covered->y1},
+      {overlap->x1, covered->y2, overlap->x2, overlap->y2},
+      {overlap->x1, covered->y1, covered->x1, covered->y2},
+      {covered->x2, covered->y1, overlap->x2, covered->y2}
+    };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (edges); i++)
+    gegl_tile_bitmap_foreach (bitmap, &edges[i], create, func, data);
+}
+
+/* the partial region of a tile, called with the mutex held */
+static GeglRegion **
+gegl_tile_bitmap_get_partial (GeglTileBitmapChunk *chunk,
+                              gint                 i,
+                              gint                 row)
+{
+  if (! chunk->partial)
+    chunk->partial = g_new0 (GeglRegion *, CHUNK_SIZE * CHUNK_SIZE);
+
+  return &chunk->partial[row * CHUNK_SIZE + i];
+}
+
+/* drops the partial regions of @bits, called with the mutex held */
+static void
+gegl_tile_bitmap_drop_partial (GeglTileBitmap      *bitmap,
+                               GeglTileBitmapChunk *chunk,
+                               gint                 row,
+                               guint                bits)
+{
+  bits &= (guint) g_atomic_int_get (&chunk->partial_rows[row]);
+
+  if (! bits)
+    return;
+
+  g_atomic_int_and (&chunk->partial_rows[row], ~bits);
+
+  while (bits)
+    {
+      gint i = g_bit_nth_lsf (bits, -1);
+
+      g_clear_pointer (gegl_tile_bitmap_get_partial (chunk, i, row),
+                       gegl_region_destroy);
+
+      g_atomic_int_add (&bitmap->n_partial, -1);
+
+      bits &= ~(1u << i);
+    }
+}
+
+/* sets whole tiles, without locking */
+static void
+gegl_tile_bitmap_set_bits (GeglTileBitmap      *bitmap,
+                           GeglTileBitmapChunk *chunk,
+                           gint                 row,
+                           guint                mask,
+                           gpointer             data)
+{
+  gboolean *has_partial = data;
+
+  g_atomic_int_or (&chunk->rows[row], mask);
+
+  /* checked after setting the bits, see gegl_tile_bitmap_add_partial() */
+  if ((guint) g_atomic_int_get (&chunk->partial_rows[row]) & mask)
+    *has_partial = TRUE;
+}
+
+/* drops the partial regions of whole tiles */
+static void
+gegl_tile_bitmap_drop_bits (GeglTileBitmap      *bitmap,
+                            GeglTileBitmapChunk *chunk,
+                            gint                 row,
+                            guint                mask,
+                            gpointer             data)
+{
+  gegl_tile_bitmap_drop_partial (bitmap, chunk, row,
+                                 mask & g_atomic_int_get (&chunk->rows[row]));
+}
+
+/* adds the part of a rectangle within tiles it doesn't cover entirely */
+static void
+gegl_tile_bitmap_add_partial (GeglTileBitmap      *bitmap,
+                              GeglTileBitmapChunk *chunk,
+                              gint                 row,
+                              guint                mask,
+                              gpointer             data)
+{
+  const GeglRectangle *rect = data;
+  guint                bits;
+
+  bits = mask & ~(guint) g_atomic_int_get (&chunk->rows[row]);
+
+  while (bits)
+    {
+      gint            i       = g_bit_nth_lsf (bits, -1);
+      GeglRegion    **partial = gegl_tile_bitmap_get_partial (chunk, i, row);
+      GeglRectangle   tile_rect;
+      GeglRectangle   part;
+
+      get_chunk_tile_rect (bitmap, chunk, &tile_rect, i, row);
+      gegl_rectangle_intersect (&part, &tile_rect, rect);
+
+      if (! *partial)
+        {
+          *partial = gegl_region_new ();
+
+          g_atomic_int_or (&chunk->partial_rows[row], 1u << i);
+          g_atomic_int_inc (&bitmap->n_partial);
+        }
+
+      gegl_region_union_with_rect (*partial, &part);
+
+      if (gegl_region_rect_in (*partial, &tile_rect) ==
+          GEGL_OVERLAP_RECTANGLE_IN)
+        {
+          g_atomic_int_or (&chunk->rows[row], 1u << i);
+        }
+
+      /* the tile might also have been set as a whole in the meantime, by
+       * gegl_tile_bitmap_set_bits(), which doesn't lock.
+       */
+      gegl_tile_bitmap_drop_partial (bitmap, chunk, row,
+                                     (1u << i) &
+                                     g_atomic_int_get (&chunk->rows[row]));
+
+      bits &= ~(1u << i);
+    }
+}
+
+/* clears whole tiles */
+static void
+gegl_tile_bitmap_clear_bits (GeglTileBitmap      *bitmap,
+                             GeglTileBitmapChunk *chunk,
+                             gint                 row,
+                             guint                mask,
+                             gpointer             data)
+{
+  g_atomic_int_and (&chunk->rows[row], ~mask);
+
+  gegl_tile_bitmap_drop_partial (bitmap, chunk, row, mask);
+}
+
+/* removes a rectangle from tiles it doesn't cover entirely */
+static void
+gegl_tile_bitmap_cut_bits (GeglTileBitmap      *bitmap,
+                           GeglTileBitmapChunk *chunk,
+                           gint                 row,
+                           guint                mask,
+                           gpointer             data)
+{
+  const GeglRectangle *rect = data;
+  guint                whole;
+  guint                bits;
+
+  whole = g_atomic_int_and (&chunk->rows[row], ~mask) & mask;
+  bits  = whole | (mask & g_atomic_int_get (&chunk->partial_rows[row]));
+
+  while (bits)
+    {
+      gint            i       = g_bit_nth_lsf (bits, -1);
+      GeglRegion    **partial = gegl_tile_bitmap_get_partial (chunk, i, row);
+      GeglRectangle   tile_rect;
+
+      get_chunk_tile_rect (bitmap, chunk, &tile_rect, i, row);
+
+      if (whole & (1u << i))
+        {
+          if (! *partial)
+            {
+              *partial = gegl_region_new ();
+
+              g_atomic_int_or (&chunk->partial_rows[row], 1u << i);
+              g_atomic_int_inc (&bitmap->n_partial);
+            }
+
+          gegl_region_union_with_rect (*partial, &tile_rect);
+        }
+
+      subtract_rect (*partial, rect);
+
+      if (gegl_region_empty (*partial))
+        gegl_tile_bitmap_drop_partial (bitmap, chunk, row, 1u << i);
+
+      bits &= ~(1u << i);
+    }
+}
+
+/* adds the contents of a row of a chunk to a region.  the partial tiles are
+ * only considered if the mutex is held.
+ */
+typedef struct
+{
+  GeglRegion *region;
+  gboolean    locked;
+} GetBitsData;
+
+static void
+gegl_tile_bitmap_get_bits (GeglTileBitmap      *bitmap,
+                           GeglTileBitmapChunk *chunk,
+                           gint                 row,
+                           guint                mask,
+                           gpointer             data)
+{
+  GetBitsData *get_bits = data;
+  guint        bits;
+  guint        partial_bits;
+
+  bits = (guint) g_atomic_int_get (&chunk->rows[row]) & mask;
+
+  while (bits)
+    {
+      GeglRectangle rect;
+      gint          a = g_bit_nth_lsf (bits, -1);
+      gint          b = g_bit_nth_lsf ((guint) ~bits, a);
+
+      if (b < 0)
+        b = CHUNK_SIZE;
+
+      get_tiles_rect (bitmap, &rect,
+                      chunk->x * CHUNK_SIZE + a, chunk->y * CHUNK_SIZE + row,
+                      b - a, 1);
+
+      gegl_region_union_with_rect (get_bits->region, &rect);
+
+      bits &= ~ROW_MASK (a, b);
+    }
+
+  if (! get_bits->locked)
+    return;
+
+  partial_bits = (guint) g_atomic_int_get (&chunk->partial_rows[row]) & mask;
+
+  while (partial_bits)
+    {
+      gint i = g_bit_nth_lsf (partial_bits, -1);
+
+      gegl_region_union (get_bits->region,
+                         *gegl_tile_bitmap_get_partial (chunk, i, row));
+
+      partial_bits &= ~(1u << i);
+    }
+}
+
+GeglTileBitmap *
+gegl_tile_bitmap_new (gint tile_width,
+                      gint tile_height)
+{
+  GeglTileBitmap *bitmap;
+
+  g_return_val_if_fail (tile_width > 0 && tile_height > 0, NULL);
+
+  bitmap = g_slice_new0 (GeglTileBitmap);
+
+  bitmap->tile_width  = tile_width;
+  bitmap->tile_height = tile_height;
+
+  g_mutex_init (&bitmap->mutex);
+
+  return bitmap;
+}
+
+void
+gegl_tile_bitmap_free (GeglTileBitmap *bitmap)
+{
+  gint i;
+
+  g_return_if_fail (bitmap != NULL);
+
+  for (i = 0; i < N_BUCKETS; i++)
+    {
+      while (bitmap->buckets[i])
+        {
+          GeglTileBitmapChunk *chunk = bitmap->buckets[i];
+          gint                 j;
+
+          bitmap->buckets[i] = chunk->next;
+
+          if (chunk->partial)
+            {
+              for (j = 0; j < CHUNK_SIZE * CHUNK_SIZE; j++)
+                {
+                  if (chunk->partial[j])
+                    gegl_region_destroy (chunk->partial[j]);
+                }
+
+              g_free (chunk->partial);
+            }
+
+          g_free (chunk);
+        }
+    }
+
+  g_mutex_clear (&bitmap->mutex);
+
+  g_slice_free (GeglTileBitmap, bitmap);
+}
+
+void
+gegl_tile_bitmap_add (GeglTileBitmap      *bitmap,
+                      const GeglRectangle *rect)
+{
+  GeglTileRange overlap;
+  GeglTileRange covered;
+  gboolean      has_covered;
+
+  g_return_if_fail (bitmap != NULL);
+  g_return_if_fail (rect != NULL);
+
+  if (rect_is_empty (rect))
+    return;
+
+  get_overlapping_tiles (bitmap, rect, &overlap);
+  has_covered = get_covered_tiles (bitmap, rect, &covered);
+
+  /* whole tiles are set without locking, unless they were partially set
+   * before.
+   */
+  if (has_covered)
+    {
+      gboolean has_partial = FALSE;
+
+      gegl_tile_bitmap_foreach (bitmap, &covered, TRUE,
+                                gegl_tile_bitmap_set_bits, &has_partial);
+
+      if (has_partial)
+        {
+          g_mutex_lock (&bitmap->mutex);
+          gegl_tile_bitmap_foreach (bitmap, &covered, FALSE,
+                                    gegl_tile_bitmap_drop_bits, NULL);
+          g_mutex_unlock (&bitmap->mutex);
+        }
+
+      if (overlap.x1 == covered.x1 && overlap.y1 == covered.y1 &&
+          overlap.x2 == covered.x2 && overlap.y2 == covered.y2)
+        {
+          return;
+        }
+    }
+
+  g_mutex_lock (&bitmap->mutex);
+
+  if (has_covered)
+    {
+      gegl_tile_bitmap_foreach_edge (bitmap, &overlap, &covered, TRUE,
+                                     gegl_tile_bitmap_add_partial,
+                                     (gpointer) rect);
+    }
+  else
+    {
+      gegl_tile_bitmap_foreach (bitmap, &overlap, TRUE,
+                                gegl_tile_bitmap_add_partial,
+                                (gpointer) rect);
+    }
+
+  g_mutex_unlock (&bitmap->mutex);
+}
+
+void
+gegl_tile_bitmap_remove (GeglTileBitmap      *bitmap,
+                         const GeglRectangle *rect)
+{
+  GeglTileRange overlap;
+  GeglTileRange covered;
+
+  g_return_if_fail (bitmap != NULL);
+  g_return_if_fail (rect != NULL);
+
+  if (rect_is_empty (rect))
+    return;
+
+  get_overlapping_tiles (bitmap, rect, &overlap);
+
+  g_mutex_lock (&bitmap->mutex);
+
+  if (get_covered_tiles (bitmap, rect, &covered))
+    {
+      gegl_tile_bitmap_foreach (bitmap, &covered, FALSE,
+                                gegl_tile_bitmap_clear_bits, NULL);
+
+      gegl_tile_bitmap_foreach_edge (bitmap, &overlap, &covered, FALSE,
+                                     gegl_tile_bitmap_cut_bits,
+                                     (gpointer) rect);
+    }
+  else
+    {
+      gegl_tile_bitmap_foreach (bitmap, &overlap, FALSE,
+                                gegl_tile_bitmap_cut_bits,
+                                (gpointer) rect);
+    }
+
+  g_mutex_unlock (&bitmap->mutex);
+}
+
+void
+gegl_tile_bitmap_clear (GeglTileBitmap *bitmap)
+{
+  g_return_if_fail (bitmap != NULL);
+
+  g_mutex_lock (&bitmap->mutex);
+
+  gegl_tile_bitmap_foreach (bitmap, NULL, FALSE,
+                            gegl_tile_bitmap_clear_bits, NULL);
+
+  g_mutex_unlock (&bitmap->mutex);
+}
+
+/* returns TRUE if all of @rect is in the bitmap.  only takes the lock when
+ * some of the tiles it touches are partially set.
+ */
+gboolean
+gegl_tile_bitmap_contains (GeglTileBitmap      *bitmap,
+                           const GeglRectangle *rect)
+{
+  GeglTileRange overlap;
+  gboolean      locked = FALSE;
+  gboolean      result = TRUE;
+  gint          x, y;
+
+  g_return_val_if_fail (bitmap != NULL, FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  if (rect_is_empty (rect))
+    return TRUE;
+
+  get_overlapping_tiles (bitmap, rect, &overlap);
+
+  for (y = overlap.y1; y < overlap.y2 && result; y++)
+    {
+      gint next;
+
+      for (x = overlap.x1; x < overlap.x2 && result; x = next)
+        {
+          GeglTileBitmapChunk *chunk;
+          gint                 chunk_x = floor_div (x, CHUNK_SIZE);
+          gint                 chunk_y = floor_div (y, CHUNK_SIZE);
+          gint                 row     = y - chunk_y * CHUNK_SIZE;
+          gint                 a       = x - chunk_x * CHUNK_SIZE;
+          gint                 b       = MIN ((gint64) overlap.x2 -
+                                              (gint64) chunk_x * CHUNK_SIZE,
+                                              CHUNK_SIZE);
+          guint                missing = ROW_MASK (a, b);
+
+          next = chunk_x * CHUNK_SIZE + b;
+
+          chunk = gegl_tile_bitmap_lookup (bitmap, chunk_x, chunk_y, FALSE);
+
+          if (! chunk)
+            {
+              result = FALSE;
+
+              break;
+            }
+
+          missing &= ~(guint) g_atomic_int_get (&chunk->rows[row]);
+
+          if (! missing)
+            continue;
+
+          /* the missing tiles can still be covered by their partial regions */
+          if (missing & ~(guint) g_atomic_int_get (&chunk->partial_rows[row]))
+            {
+              result = FALSE;
+
+              break;
+            }
+
+          if (! locked)
+            {
+              g_mutex_lock (&bitmap->mutex);
+              locked = TRUE;
+            }
+
+          while (missing && result)
+            {
+              GeglRegion    *partial;
+              GeglRectangle  tile_rect;
+              GeglRectangle  part;
+              gint           i = g_bit_nth_lsf (missing, -1);
+
+              partial = *gegl_tile_bitmap_get_partial (chunk, i, row);
+
+              get_chunk_tile_rect (bitmap, chunk, &tile_rect, i, row);
+              gegl_rectangle_intersect (&part, &tile_rect, rect);
+
+              if (! partial ||
+                  gegl_region_rect_in (partial, &part) !=
+                  GEGL_OVERLAP_RECTANGLE_IN)
+                {
+                  /* unless the tile was set as a whole in the meantime */
+                  result = ((guint) g_atomic_int_get (&chunk->rows[row]) >>
+                            i) & 1;
+                }
+
+              missing &= ~(1u << i);
+            }
+        }
+    }
+
+  if (locked)
+    g_mutex_unlock (&bitmap->mutex);
+
+  return result;
+}
+
+/* removes the contents of the bitmap from @region */
+void
+gegl_tile_bitmap_subtract (GeglTileBitmap *bitmap,
+                           GeglRegion     *region)
+{
+  GeglRectangle  clipbox;
+  GeglRegion    *valid;
+
+  g_return_if_fail (bitmap != NULL);
+  g_return_if_fail (region != NULL);
+
+  gegl_region_get_clipbox (region, &clipbox);
+
+  if (rect_is_empty (&clipbox))
+    return;
+
+  valid = gegl_tile_bitmap_get_region (bitmap, &clipbox);
+
+  gegl_region_subtract (region, valid);
+
+  gegl_region_destroy (valid);
+}
+
+/* returns a new region with the contents of the bitmap within @rect, or all
+ * of them if @rect is NULL.
+ */
+GeglRegion *
+gegl_tile_bitmap_get_region (GeglTileBitmap      *bitmap,
+                             const GeglRectangle *rect)
+{
+  GetBitsData   get_bits;
+  GeglTileRange range;
+
+  g_return_val_if_fail (bitmap != NULL, NULL);
+
+  get_bits.region = gegl_region_new ();
+  get_bits.locked = g_atomic_int_get (&bitmap->n_partial) > 0;
+
+  if (rect)
+    {
+      if (rect_is_empty (rect))
+        return get_bits.region;
+
+      get_overlapping_tiles (bitmap, rect, &range);
+    }
+
+  if (get_bits.locked)
+    g_mutex_lock (&bitmap->mutex);
+
+  gegl_tile_bitmap_foreach (bitmap, rect ? &range : NULL, FALSE,
+                            gegl_tile_bitmap_get_bits, &get_bits);
+
+  if (get_bits.locked)
+    g_mutex_unlock (&bitmap->mutex);
+
+  if (rect)
+    {
+      GeglRegion *temp = gegl_region_rectangle (rect);
+
+      gegl_region_intersect (get_bits.region, temp);
+      gegl_region_destroy (temp);
+    }
+
+  return get_bits.region;
+}
+
+/* returns the number of pixels of the bitmap within @rect, or in all of it
+ * if @rect is NULL.
+ */
+guint64
+gegl_tile_bitmap_get_area (GeglTileBitmap      *bitmap,
+                           const GeglRectangle *rect)
+{
+  GeglRegion    *region;
+  GeglRectangle *rects;
+  gint           n_rects;
+  guint64        area = 0;
+  gint           i;
+
+  g_return_val_if_fail (bitmap != NULL, 0);
+
+  region = gegl_tile_bitmap_get_region (bitmap, rect);
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    area += (guint64) rects[i].width * rects[i].height;
+
+  g_free (rects);
+  gegl_region_destroy (region);
+
+  return area;
+}
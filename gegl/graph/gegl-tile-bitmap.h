@@ -0,0 +1,60 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_BITMAP_H__
+#define __GEGL_TILE_BITMAP_H__
+
+#include "gegl-types-internal.h"
+#include "gegl-region.h"
+
+/***
+ * GeglTileBitmap is a set of pixels, kept as a sparse bitmap of the tiles of
+ * a fixed grid.  Tiles which are only partially in the set keep their pixels
+ * in a GeglRegion of their own.
+ *
+ * It is used for the valid regions of GeglCache: whole tiles are updated
+ * using atomic operations, and queries take time proportional to the number
+ * of tiles they touch, rather than to the complexity of the set, so that
+ * caches don't slow down after long interactive sessions.  Only the tiles
+ * which are partially set take the mutex.
+ */
+
+G_BEGIN_DECLS
+
+typedef struct _GeglTileBitmap GeglTileBitmap;
+
+GeglTileBitmap * gegl_tile_bitmap_new        (gint                 tile_width,
+                                              gint                 tile_height);
+void             gegl_tile_bitmap_free       (GeglTileBitmap      *bitmap);
+
+void             gegl_tile_bitmap_add        (GeglTileBitmap      *bitmap,
+                                              const GeglRectangle *rect);
+void             gegl_tile_bitmap_remove     (GeglTileBitmap      *bitmap,
+                                              const GeglRectangle *rect);
+void             gegl_tile_bitmap_clear      (GeglTileBitmap      *bitmap);
+
+gboolean         gegl_tile_bitmap_contains   (GeglTileBitmap      *bitmap,
+                                              const GeglRectangle *rect);
+void             gegl_tile_bitmap_subtract   (GeglTileBitmap      *bitmap,
+                                              GeglRegion          *region);
+GeglRegion     * gegl_tile_bitmap_get_region (GeglTileBitmap      *bitmap,
+                                              const GeglRectangle *rect);
+guint64          gegl_tile_bitmap_get_area   (GeglTileBitmap      *bitmap,
+                                              const GeglRectangle *rect);
+
+G_END_DECLS
+
+#endif /* __GEGL_TILE_BITMAP_H__ */
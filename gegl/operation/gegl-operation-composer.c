@@ -24,6 +24,7 @@
 #include "gegl.h"
 #include "gegl-operation-composer.h"
 #include "gegl-operation-context.h"
+#include "gegl-operation-private.h"
 #include "gegl-config.h"
 #include <glib/gi18n-lib.h>
 
@@ -186,7 +187,7 @@ gegl_operation_composer_process (GeglOperation        *operation,
         gegl_parallel_distribute_area (
           result,
           gegl_operation_get_pixels_per_thread (operation),
-          GEGL_SPLIT_STRATEGY_AUTO,
+          gegl_operation_get_split_strategy (operation),
           (GeglParallelDistributeAreaFunc) thread_process,
           &data);
 
@@ -24,6 +24,7 @@
 #include "gegl.h"
 #include "gegl-operation-filter.h"
 #include "gegl-operation-context.h"
+#include "gegl-operation-private.h"
 #include "gegl-config.h"
 
 static gboolean gegl_operation_filter_process
@@ -181,7 +182,9 @@ gegl_operation_filter_process (GeglOperation        *operation,
   if (gegl_operation_use_threading (operation, result))
   {
     ThreadData        data;
-    GeglSplitStrategy split_strategy = GEGL_SPLIT_STRATEGY_AUTO;
+    GeglSplitStrategy split_strategy;
+
+    split_strategy = gegl_operation_get_split_strategy (operation);
 
     if (klass->get_split_strategy)
     {
@@ -24,6 +24,7 @@
 #include "gegl.h"
 #include "gegl-operation-point-composer3.h"
 #include "gegl-operation-context.h"
+#include "gegl-operation-private.h"
 #include "gegl-types-internal.h"
 #include "gegl-config.h"
 #include "gegl-buffer-private.h"
@@ -248,7 +249,7 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
         gegl_parallel_distribute_area (
           result,
           gegl_operation_get_pixels_per_thread (operation),
-          GEGL_SPLIT_STRATEGY_AUTO,
+          gegl_operation_get_split_strategy (operation),
           (GeglParallelDistributeAreaFunc) thread_process,
           &data);
 
@@ -24,6 +24,7 @@
 #include "gegl.h"
 #include "gegl-debug.h"
 #include "gegl-operation-point-filter.h"
+#include "gegl-operation-private.h"
 #include "gegl-operation-context.h"
 #include "gegl-config.h"
 #include "gegl-types-internal.h"
@@ -88,10 +89,14 @@ gegl_operation_filter_process (GeglOperation        *operation,
   GeglRectangle scaled_result = *result;
   if (level)
   {
-    scaled_result.x >>= level;
-    scaled_result.y >>= level;
-    scaled_result.width >>= level;
-    scaled_result.height >>= level;
+    /* round the end outward, so that partially covered pixels of the
+     * level are rendered too, as in gegl_graph_process_fused() */
+    scaled_result.x = result->x >> level;
+    scaled_result.y = result->y >> level;
+    scaled_result.width  = ((result->x + result->width  +
+                             (1 << level) - 1) >> level) - scaled_result.x;
+    scaled_result.height = ((result->y + result->height +
+                             (1 << level) - 1) >> level) - scaled_result.y;
     result = &scaled_result;
   }
 
@@ -288,7 +293,7 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
         gegl_parallel_distribute_area (
           result,
           gegl_operation_get_pixels_per_thread (operation),
-          GEGL_SPLIT_STRATEGY_AUTO,
+          gegl_operation_get_split_strategy (operation),
           (GeglParallelDistributeAreaFunc) thread_process,
           &data);
 
@@ -314,3 +319,22 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
     }
   return TRUE;
 }
+
+gboolean
+gegl_operation_point_filter_is_fusable (GeglOperation *operation)
+{
+  GeglOperationClass *operation_class;
+
+  if (! GEGL_IS_OPERATION_POINT_FILTER (operation))
+    return FALSE;
+
+  operation_class = GEGL_OPERATION_GET_CLASS (operation);
+
+  /* subclasses overriding process() might do anything, like passing
+   * their input through, only the stock path can be fused.
+   */
+  return operation_class->process == gegl_operation_filter_process &&
+         GEGL_OPERATION_FILTER_GET_CLASS (operation)->process ==
+         gegl_operation_point_filter_process &&
+         GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation)->process != NULL;
+}
@@ -22,7 +22,21 @@
 G_BEGIN_DECLS
 
 
-gboolean   gegl_operation_use_cache (GeglOperation *operation);
+gboolean   gegl_operation_use_cache                 (GeglOperation *operation);
+
+/* the strategy for distributing the processing of an area across threads,
+ * according to the operation's dynamic_split hint.
+ */
+GeglSplitStrategy
+           gegl_operation_get_split_strategy        (GeglOperation *operation);
+
+/* TRUE if the operation is a point filter/composer which uses the stock
+ * base class process() path, so that its per-pixel process() callback can
+ * be chained with its neighbours' on the same data without an intermediate
+ * buffer.
+ */
+gboolean   gegl_operation_point_filter_is_fusable   (GeglOperation *operation);
+gboolean   gegl_operation_point_composer_is_fusable (GeglOperation *operation);
 
 
 G_END_DECLS
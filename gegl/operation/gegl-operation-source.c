@@ -24,6 +24,7 @@
 #include "gegl.h"
 #include "gegl-operation-source.h"
 #include "gegl-operation-context.h"
+#include "gegl-operation-private.h"
 #include "gegl-config.h"
 
 static gboolean gegl_operation_source_process
@@ -128,7 +129,7 @@ gegl_operation_source_process (GeglOperation        *operation,
     gegl_parallel_distribute_area (
       result,
       gegl_operation_get_pixels_per_thread (operation),
-      GEGL_SPLIT_STRATEGY_AUTO,
+      gegl_operation_get_split_strategy (operation),
       (GeglParallelDistributeAreaFunc) thread_process,
       &data);
 
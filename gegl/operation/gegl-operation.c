@@ -68,6 +68,11 @@ static void            gegl_operation_update_pixel_time (GeglOperation       *se
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeglOperation, gegl_operation, G_TYPE_OBJECT)
 
+/* an operation can be processed by several threads at once, each over a
+ * different tile, when the graph is evaluated tile by tile.
+ */
+static GMutex pixel_time_mutex;
+
 
 static void
 gegl_operation_class_init (GeglOperationClass *klass)
@@ -925,16 +930,32 @@ gdouble
 gegl_operation_get_pixels_per_thread (GeglOperation *operation)
 {
   GeglOperationPrivate *priv = gegl_operation_get_instance_private (operation);
+  gdouble               pixel_time;
+
+  g_mutex_lock (&pixel_time_mutex);
+  pixel_time = priv->pixel_time;
+  g_mutex_unlock (&pixel_time_mutex);
 
-  if (priv->pixel_time < 0.0 || ! gegl_operation_dynamic_thread_cost ())
+  if (pixel_time < 0.0 || ! gegl_operation_dynamic_thread_cost ())
     return GEGL_OPERATION_DEFAULT_PIXELS_PER_THREAD;
-  else if (priv->pixel_time == 0.0)
+  else if (pixel_time == 0.0)
     return GEGL_OPERATION_MAX_PIXELS_PER_THREAD;
 
-  return MIN (gegl_parallel_distribute_get_thread_time () / priv->pixel_time,
+  return MIN (gegl_parallel_distribute_get_thread_time () / pixel_time,
               GEGL_OPERATION_MAX_PIXELS_PER_THREAD);
 }
 
+GeglSplitStrategy
+gegl_operation_get_split_strategy (GeglOperation *operation)
+{
+  GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
+
+  if (klass->dynamic_split)
+    return GEGL_SPLIT_STRATEGY_DYNAMIC;
+
+  return GEGL_SPLIT_STRATEGY_AUTO;
+}
+
 static void
 gegl_operation_update_pixel_time (GeglOperation       *self,
                                   const GeglRectangle *roi,
@@ -942,6 +963,7 @@ gegl_operation_update_pixel_time (GeglOperation       *self,
 {
   GeglOperationPrivate *priv      = gegl_operation_get_instance_private (self);
   gdouble               n_pixels;
+  gdouble               pixel_time;
   gint                  n_threads = 1;
 
   n_pixels = (gdouble) roi->width * (gdouble) roi->height;
@@ -957,10 +979,13 @@ gegl_operation_update_pixel_time (GeglOperation       *self,
         gegl_operation_get_pixels_per_thread (self));
     }
 
-  priv->pixel_time = (t - (n_threads - 1)                              *
-                          gegl_parallel_distribute_get_thread_time ()) *
-                     n_threads / n_pixels;
-  priv->pixel_time = MAX (priv->pixel_time, 0.0);
+  pixel_time = (t - (n_threads - 1)                              *
+                    gegl_parallel_distribute_get_thread_time ()) *
+               n_threads / n_pixels;
+
+  g_mutex_lock (&pixel_time_mutex);
+  priv->pixel_time = MAX (pixel_time, 0.0);
+  g_mutex_unlock (&pixel_time_mutex);
 }
 
 static guchar *gegl_temp_alloc[GEGL_MAX_THREADS * 4]={NULL,};
@@ -90,7 +90,12 @@ struct _GeglOperationClass
                                   in the sub-classes of these.
                                 */
   guint           cache_policy:2; /* cache policy for this operation */
-  guint64         bit_pad:58;
+  guint           dynamic_split:1; /* the cost of processing varies across
+                                      the image, hand out small chunks of
+                                      it to the threads as they become
+                                      free, rather than equal strips.
+                                    */
+  guint64         bit_pad:57;
 
   /* attach this operation with a GeglNode, override this if you are creating a
    * GeglGraph, it is already defined for Filters/Sources/Composers.
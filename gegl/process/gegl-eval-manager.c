@@ -24,6 +24,7 @@
 
 #include "gegl.h"
 #include "gegl-types-internal.h"
+#include "gegl-config.h"
 #include "gegl-eval-manager.h"
 #include "gegl-instrument.h"
 
@@ -125,7 +126,10 @@ gegl_eval_manager_apply (GeglEvalManager     *self,
   GEGL_INSTRUMENT_END ("gegl", "prepare-request");
 
   GEGL_INSTRUMENT_START();
-  object = gegl_graph_process (self->traversal, level);
+  if (gegl_config ()->tiled_scheduling)
+    object = gegl_graph_process_tiled (self->traversal, level);
+  else
+    object = gegl_graph_process (self->traversal, level);
   GEGL_INSTRUMENT_END ("gegl", "process");
 
   return object;
@@ -19,10 +19,13 @@
 
 #include "config.h"
 
+#include <math.h>
+
 #include <glib-object.h>
 
 #include "gegl-types-internal.h"
 #include "gegl.h"
+#include "gegl-config.h"
 #include "gegl-debug.h"
 #include "gegl-instrument.h"
 
@@ -34,6 +37,7 @@
 #include "graph/gegl-callback-visitor.h"
 #include "graph/gegl-visitable.h"
 #include "graph/gegl-connection.h"
+#include "graph/gegl-disk-cache.h"
 
 #include "process/gegl-graph-traversal.h"
 #include "process/gegl-graph-traversal-private.h"
@@ -41,6 +45,9 @@
 #include "operation/gegl-operation.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
+#include "operation/gegl-operation-point-filter.h"
+#include "operation/gegl-operation-point-composer.h"
+#include "operation/gegl-operation-private.h"
 
 typedef struct
 {
@@ -48,12 +55,37 @@ typedef struct
   GeglOperationContext *context;
 } ContextConnection;
 
+typedef struct
+{
+  GeglOperation *operation;
+  gboolean       composer;
+  GeglBuffer    *aux;
+  gint           aux_slot;
+  const Babl    *input_format;
+  const Babl    *aux_format;
+  const Babl    *output_format;
+} FusedStage;
+
+typedef struct
+{
+  FusedStage *stages;
+  gint        n_stages;
+  GeglBuffer *input;
+  GeglBuffer *output;
+  gint        level;
+  gint        scratch_bpp;
+} FusedChain;
+
 static void   free_context_connection                  (gpointer concon);
-static GList *gegl_graph_get_connected_output_contexts (GeglGraphTraversal *path,
+static GList *gegl_graph_get_connected_output_contexts (GHashTable         *contexts,
                                                         GeglPad            *output_pad);
 static void   _gegl_graph_do_build                     (GeglGraphTraversal *path,
                                                         GeglNode           *node);
 static GeglBuffer *gegl_graph_get_shared_empty         (GeglGraphTraversal *path);
+static GeglBuffer *gegl_graph_process_range            (GeglGraphTraversal *path,
+                                                        GList              *first,
+                                                        GList              *end,
+                                                        gint                level);
 
 static gboolean
 _gegl_graph_do_build_add_node (GeglNode *node,
@@ -206,10 +238,15 @@ gegl_graph_prepare (GeglGraphTraversal *path)
             gegl_rectangle_align_to_buffer (&new_rect, &node->have_rect, cache,
                                             GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
 
-            if (gegl_rectangle_contains (&new_rect, &old_rect))
+            /* a shared cache's extent belongs to all the nodes using it,
+             * and the extent of a cache in the disk cache is part of its key
+             */
+            if (gegl_rectangle_contains (&new_rect, &old_rect) &&
+                ! node->cache->shared_key &&
+                ! node->cache->disk_cache)
               gegl_buffer_set_extent (cache, &node->have_rect);
             else
-              g_clear_object (&node->cache);
+              gegl_node_clear_cache (node);
           }
       }
 
@@ -313,9 +350,14 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
       if (node->cache)
         {
           gint i;
+
+          /* make sure the tiles we have on disk are still there */
+          if (node->cache->disk_cache)
+            gegl_disk_cache_refresh (node->cache->disk_cache, node->cache);
+
           for (i = level; i >=0 && !context->cached; i--)
           {
-            if (gegl_region_rect_in (node->cache->valid_region[level], request) == GEGL_OVERLAP_RECTANGLE_IN)
+            if (gegl_tile_bitmap_contains (node->cache->valid[level], request))
             {
               /* This node is cached and the cache fulfills our need rect */
               context->cached = TRUE;
@@ -323,7 +365,20 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
             }
           }
           if (context->cached)
-            continue;
+            {
+              GeglRectangle scaled;
+
+              /* the result is going to be read from the cache, at level */
+              scaled.x      = request->x >> level;
+              scaled.y      = request->y >> level;
+              scaled.width  = ((request->x + request->width  +
+                                (1 << level) - 1) >> level) - scaled.x;
+              scaled.height = ((request->y + request->height +
+                                (1 << level) - 1) >> level) - scaled.y;
+
+              gegl_buffer_prefetch (GEGL_BUFFER (node->cache), &scaled, level);
+              continue;
+            }
         }
 
       {
@@ -370,8 +425,8 @@ free_context_connection (gpointer concon)
 }
 
 GList *
-gegl_graph_get_connected_output_contexts (GeglGraphTraversal *path,
-                                          GeglPad            *output_pad)
+gegl_graph_get_connected_output_contexts (GHashTable *contexts,
+                                          GeglPad    *output_pad)
 {
   GList *result = NULL;
   GSList *targets = gegl_pad_get_connections (output_pad);
@@ -379,7 +434,7 @@ gegl_graph_get_connected_output_contexts (GeglGraphTraversal *path,
   for (targets_iter = targets; targets_iter; targets_iter = g_slist_next (targets_iter))
     {
       GeglNode *target_node = gegl_connection_get_sink_node (targets_iter->data);
-      GeglOperationContext *target_context = g_hash_table_lookup (path->contexts, target_node);
+      GeglOperationContext *target_context = g_hash_table_lookup (contexts, target_node);
       
       /* Only include this target if it's part of the current path */
       if (target_context)
@@ -409,6 +464,283 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 }
 
 
+static gboolean
+gegl_graph_node_is_fusable (GeglGraphTraversal *path,
+                            GeglNode           *node)
+{
+  GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+
+  if (! context || context->cached || node->passthrough)
+    return FALSE;
+
+  if (context->need_rect.width <= 0 || context->need_rect.height <= 0)
+    return FALSE;
+
+  if (gegl_operation_use_opencl (node->operation))
+    return FALSE;
+
+  return gegl_operation_point_filter_is_fusable (node->operation) ||
+         gegl_operation_point_composer_is_fusable (node->operation);
+}
+
+/* Returns the number of consecutive nodes, starting at @link, whose
+ * point-wise process() callbacks can be run back to back on the same
+ * chunk of pixels; 1 means no fusion is possible.
+ */
+static gint
+gegl_graph_get_fusable_length (GeglGraphTraversal *path,
+                               GList              *link,
+                               GList              *end)
+{
+  GeglNode *node   = GEGL_NODE (link->data);
+  gint      length = 1;
+
+  if (! gegl_config ()->fuse_point_ops ||
+      ! gegl_graph_node_is_fusable (path, node))
+    return 1;
+
+  for (; link->next && link->next != end; link = link->next)
+    {
+      GeglNode             *next         = GEGL_NODE (link->next->data);
+      GeglOperationContext *context      = g_hash_table_lookup (path->contexts, node);
+      GeglOperationContext *next_context = g_hash_table_lookup (path->contexts, next);
+      GeglPad              *output_pad   = gegl_node_get_pad (node, "output");
+      GSList               *connections;
+
+      if (! gegl_graph_node_is_fusable (path, next))
+        break;
+
+      /* the intermediate result is never materialized, so nothing but the
+       * next node may consume it, and it can't be cached.
+       */
+      if (gegl_node_use_cache (node))
+        break;
+
+      connections = output_pad ? gegl_pad_get_connections (output_pad) : NULL;
+
+      if (! connections || connections->next ||
+          gegl_connection_get_sink_pad (connections->data) !=
+          gegl_node_get_pad (next, "input"))
+        break;
+
+      if (! gegl_rectangle_equal (&context->need_rect, &next_context->need_rect))
+        break;
+
+      if (gegl_operation_get_format (node->operation, "output") !=
+          gegl_operation_get_format (next->operation, "input"))
+        break;
+
+      node = next;
+      length++;
+    }
+
+  return length;
+}
+
+static void
+gegl_graph_fused_process_area (const GeglRectangle *area,
+                               FusedChain          *chain)
+{
+  FusedStage         *last = &chain->stages[chain->n_stages - 1];
+  GeglBufferIterator *i;
+  gint                read;
+  gint                s;
+
+  i = gegl_buffer_iterator_new (chain->output, area, chain->level,
+                                last->output_format,
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                2 + chain->n_stages);
+
+  read = gegl_buffer_iterator_add (i, chain->input, area, chain->level,
+                                   chain->stages[0].input_format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  for (s = 0; s < chain->n_stages; s++)
+    {
+      FusedStage *stage = &chain->stages[s];
+
+      if (stage->aux)
+        stage->aux_slot = gegl_buffer_iterator_add (i, stage->aux, area,
+                                                    chain->level,
+                                                    stage->aux_format,
+                                                    GEGL_ACCESS_READ,
+                                                    GEGL_ABYSS_NONE);
+    }
+
+  while (gegl_buffer_iterator_next (i))
+    {
+      guchar *scratch = gegl_scratch_alloc (2 * (gsize) i->length *
+                                            chain->scratch_bpp);
+      gpointer in     = i->items[read].data;
+
+      for (s = 0; s < chain->n_stages; s++)
+        {
+          FusedStage *stage = &chain->stages[s];
+          gpointer    out;
+
+          /* intermediate results ping-pong between two halves of the
+           * scratch chunk, the last stage writes straight to the output.
+           */
+          if (stage == last)
+            out = i->items[0].data;
+          else
+            out = scratch + (s & 1) * (gsize) i->length * chain->scratch_bpp;
+
+          if (stage->composer)
+            {
+              GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (stage->operation)->process (
+                stage->operation,
+                in,
+                stage->aux ? i->items[stage->aux_slot].data : NULL,
+                out,
+                i->length, &i->items[0].roi, chain->level);
+            }
+          else
+            {
+              GEGL_OPERATION_POINT_FILTER_GET_CLASS (stage->operation)->process (
+                stage->operation,
+                in, out,
+                i->length, &i->items[0].roi, chain->level);
+            }
+
+          in = out;
+        }
+
+      gegl_scratch_free (scratch);
+    }
+}
+
+/* Processes the @length nodes starting at @link, as found by
+ * gegl_graph_get_fusable_length(), in a single pass over the output of
+ * the last one, which is returned.
+ */
+static GeglBuffer *
+gegl_graph_process_fused (GeglGraphTraversal *path,
+                          GList              *link,
+                          gint                length,
+                          gint                level)
+{
+  GeglOperationContext *context;
+  GeglOperation        *last_operation = NULL;
+  GeglRectangle         result;
+  FusedChain            chain;
+  gboolean              threaded;
+  gdouble               thread_cost = 0.0;
+  GeglSplitStrategy     split_strategy = GEGL_SPLIT_STRATEGY_AUTO;
+  gint                  s;
+
+  chain.stages      = g_new0 (FusedStage, length);
+  chain.n_stages    = length;
+  chain.level       = level;
+  chain.scratch_bpp = 1;
+
+  context     = g_hash_table_lookup (path->contexts, link->data);
+  chain.input = GEGL_BUFFER (gegl_operation_context_dup_object (context,
+                                                                "input"));
+  result      = context->need_rect;
+
+  /* the same area of the level as the point filters and composers render
+   * when processed one at a time
+   */
+  if (level)
+    {
+      result.x      = context->need_rect.x >> level;
+      result.y      = context->need_rect.y >> level;
+      result.width  = ((context->need_rect.x + context->need_rect.width  +
+                        (1 << level) - 1) >> level) - result.x;
+      result.height = ((context->need_rect.y + context->need_rect.height +
+                        (1 << level) - 1) >> level) - result.y;
+    }
+
+  threaded = gegl_config_threads () > 1;
+
+  for (s = 0; s < length; s++, link = link->next)
+    {
+      GeglNode   *node  = GEGL_NODE (link->data);
+      FusedStage *stage = &chain.stages[s];
+
+      context = g_hash_table_lookup (path->contexts, node);
+      context->level = level;
+
+      stage->operation     = node->operation;
+      stage->composer      = GEGL_IS_OPERATION_POINT_COMPOSER (node->operation);
+      stage->input_format  = gegl_operation_get_format (node->operation, "input");
+      stage->output_format = gegl_operation_get_format (node->operation, "output");
+
+      if (stage->composer)
+        {
+          stage->aux        = GEGL_BUFFER (gegl_operation_context_dup_object (
+                                             context, "aux"));
+          stage->aux_format = gegl_operation_get_format (node->operation, "aux");
+        }
+
+      if (s < length - 1)
+        {
+          chain.scratch_bpp = MAX (chain.scratch_bpp,
+                                   babl_format_get_bytes_per_pixel (
+                                     stage->output_format));
+        }
+
+      /* the chain is as expensive as all of its stages together */
+      threaded &= GEGL_OPERATION_GET_CLASS (node->operation)->threaded;
+      thread_cost += 1.0 / gegl_operation_get_pixels_per_thread (node->operation);
+
+      if (gegl_operation_get_split_strategy (node->operation) ==
+          GEGL_SPLIT_STRATEGY_DYNAMIC)
+        {
+          split_strategy = GEGL_SPLIT_STRATEGY_DYNAMIC;
+        }
+
+      last_operation = node->operation;
+    }
+
+  thread_cost = 1.0 / thread_cost;
+
+  chain.output = gegl_operation_context_get_output_maybe_in_place (
+                   last_operation, context, chain.input, &result);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Fused %d point operations ending in %s",
+             length, gegl_node_get_debug_name (last_operation->node));
+
+  if (result.width > 0 && result.height > 0)
+    {
+      if (threaded &&
+          (gdouble) result.width * (gdouble) result.height >= 2 * thread_cost)
+        {
+          if (gegl_cl_is_accelerated ())
+            {
+              gegl_buffer_flush_ext (chain.input, &result);
+
+              for (s = 0; s < length; s++)
+                {
+                  if (chain.stages[s].aux)
+                    gegl_buffer_flush_ext (chain.stages[s].aux, &result);
+                }
+            }
+
+          gegl_parallel_distribute_area (
+            &result,
+            thread_cost,
+            split_strategy,
+            (GeglParallelDistributeAreaFunc) gegl_graph_fused_process_area,
+            &chain);
+        }
+      else
+        {
+          gegl_graph_fused_process_area (&result, &chain);
+        }
+    }
+
+  for (s = 0; s < length; s++)
+    g_clear_object (&chain.stages[s].aux);
+
+  g_clear_object (&chain.input);
+  g_free (chain.stages);
+
+  return chain.output;
+}
+
 /**
  * gegl_graph_process:
  * @path: The traversal path
@@ -426,6 +758,19 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 GeglBuffer *
 gegl_graph_process (GeglGraphTraversal *path,
                     gint                level)
+{
+  return gegl_graph_process_range (path, g_queue_peek_head_link (&path->path),
+                                   NULL, level);
+}
+
+/* Processes the nodes of @path from @first up to, but not including, @end,
+ * returning the result of the last one.
+ */
+static GeglBuffer *
+gegl_graph_process_range (GeglGraphTraversal *path,
+                          GList              *first,
+                          GList              *end,
+                          gint                level)
 {
   GList *list_iter = NULL;
   GeglBuffer *result = NULL;
@@ -433,12 +778,13 @@ gegl_graph_process (GeglGraphTraversal *path,
   GeglOperationContext *last_context = NULL;
   GeglBuffer *operation_result = NULL;
 
-  for (list_iter = g_queue_peek_head_link (&path->path);
-       list_iter;
+  for (list_iter = first;
+       list_iter != end;
        list_iter = list_iter->next)
     {
       GeglNode *node = GEGL_NODE (list_iter->data);
       GeglOperation *operation = node->operation;
+      gint fused_length;
       g_return_val_if_fail (node, NULL);
       g_return_val_if_fail (operation, NULL);
       
@@ -480,11 +826,35 @@ gegl_graph_process (GeglGraphTraversal *path,
 
               context->level = level;
 
-              /* note: this hard-coding of "output" makes some more custom
-               * graph topologies harder than necessary.
-               */
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
-              operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+              fused_length = gegl_graph_get_fusable_length (path, list_iter, end);
+
+              if (fused_length > 1)
+                {
+                  operation_result = gegl_graph_process_fused (path, list_iter,
+                                                               fused_length,
+                                                               level);
+
+                  /* continue from the last node of the fused chain, the
+                   * intermediate nodes have nothing to deliver.
+                   */
+                  while (--fused_length)
+                    {
+                      gegl_operation_context_purge (context);
+
+                      list_iter = list_iter->next;
+                      node      = GEGL_NODE (list_iter->data);
+                      operation = node->operation;
+                      context   = g_hash_table_lookup (path->contexts, node);
+                    }
+                }
+              else
+                {
+                  /* note: this hard-coding of "output" makes some more custom
+                   * graph topologies harder than necessary.
+                   */
+                  gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
+                  operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+                }
 
               if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
                 gegl_cache_computed (operation->node->cache, &context->need_rect, level);
@@ -498,7 +868,7 @@ gegl_graph_process (GeglGraphTraversal *path,
       if (operation_result)
         {
           GeglPad *output_pad = gegl_node_get_pad (node, "output");
-          GList   *targets = gegl_graph_get_connected_output_contexts (path, output_pad);
+          GList   *targets = gegl_graph_get_connected_output_contexts (path->contexts, output_pad);
           GList   *targets_iter;
 
           GEGL_NOTE (GEGL_DEBUG_PROCESS,
@@ -532,3 +902,407 @@ gegl_graph_process (GeglGraphTraversal *path,
 
   return result;
 }
+
+typedef struct
+{
+  GeglGraphTraversal *path;
+  GList              *first;
+  GeglBuffer         *output;
+  GeglRectangle       area;
+  gint                tile_width;
+  gint                tile_height;
+  gint                tile_x0;
+  gint                tile_y0;
+  gint                n_tiles_x;
+  gint                n_tiles;
+  gint                next_tile;
+  GMutex              mutex;
+  GArray             *computed;
+} TiledProcess;
+
+typedef struct
+{
+  GeglNode      *node;
+  GeglRectangle  rect;
+} TiledComputed;
+
+/* A node can be evaluated tile by tile if it can run concurrently with
+ * itself, and only ever needs a bounded neighborhood of its inputs.  Only
+ * operations whose class is marked threaded qualify, as they already have
+ * their process() run on several areas at once by gegl_parallel_distribute().
+ */
+static gboolean
+gegl_graph_node_is_tileable (GeglGraphTraversal *path,
+                             GeglNode           *node,
+                             gint                tile_width,
+                             gint                tile_height)
+{
+  GeglOperation        *operation = node->operation;
+  GeglOperationContext *context   = g_hash_table_lookup (path->contexts, node);
+  const GeglRectangle  *need      = &context->need_rect;
+  GeglRectangle         tile;
+  GeglRectangle         cached_region;
+  GSList               *input_pads;
+
+  if (context->cached || need->width <= 0 || need->height <= 0)
+    return TRUE;
+
+  if (! GEGL_OPERATION_GET_CLASS (operation)->threaded ||
+      ! gegl_node_has_pad (node, "output")             ||
+      gegl_operation_use_opencl (operation))
+    return FALSE;
+
+  cached_region = gegl_operation_get_cached_region (operation, need);
+
+  if (! gegl_rectangle_equal (&cached_region, need))
+    return FALSE;
+
+  gegl_rectangle_set (&tile, need->x, need->y, tile_width, tile_height);
+
+  for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+    {
+      const gchar   *pad_name = gegl_pad_get_name (input_pads->data);
+      GeglRectangle  required;
+
+      required = gegl_operation_get_required_for_output (operation, pad_name,
+                                                         &tile);
+
+      /* recomputing a big neighborhood for every tile costs more than
+       * pipelining saves.
+       */
+      if (required.width  > 2 * tile_width ||
+          required.height > 2 * tile_height)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gegl_graph_process_tile (TiledProcess        *data,
+                         const GeglRectangle *tile)
+{
+  GeglGraphTraversal   *path         = data->path;
+  GHashTable           *contexts;
+  GeglOperationContext *last_context = NULL;
+  GeglBuffer           *result       = NULL;
+  GList                *last         = g_queue_peek_tail_link (&path->path);
+  GList                *list_iter;
+
+  contexts = g_hash_table_new_full (NULL,
+                                    NULL,
+                                    NULL,
+                                    (GDestroyNotify)gegl_operation_context_destroy);
+
+  for (list_iter = data->first; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+
+      g_hash_table_insert (contexts, node,
+                           gegl_operation_context_new (node->operation,
+                                                       contexts));
+    }
+
+  gegl_operation_context_set_need_rect (g_hash_table_lookup (contexts,
+                                                             last->data),
+                                        tile);
+
+  /* propagate the tile through the tiled part of the graph, like
+   * gegl_graph_prepare_request() does for the whole request.
+   */
+  for (list_iter = last; list_iter != data->first->prev; list_iter = list_iter->prev)
+    {
+      GeglNode             *node         = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context      = g_hash_table_lookup (contexts, node);
+      GeglOperationContext *main_context = g_hash_table_lookup (path->contexts, node);
+      GeglRectangle         request      = *gegl_operation_context_get_need_rect (context);
+      GSList               *input_pads;
+
+      if (request.width == 0 || request.height == 0 || main_context->cached)
+        {
+          context->cached = main_context->cached;
+          gegl_operation_context_set_result_rect (context, GEGL_RECTANGLE (0, 0, 0, 0));
+          continue;
+        }
+
+      gegl_operation_context_set_result_rect (context, &request);
+
+      for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+        {
+          GeglPad              *source_pad = gegl_pad_get_connected_to (input_pads->data);
+          GeglNode             *source_node;
+          GeglOperationContext *source_context;
+          GeglRectangle         rect, current_need, new_need;
+
+          if (! source_pad)
+            continue;
+
+          source_node    = gegl_pad_get_node (source_pad);
+          source_context = g_hash_table_lookup (contexts, source_node);
+
+          /* inputs from the untiled part of the graph are already complete */
+          if (! source_context)
+            continue;
+
+          rect = gegl_operation_get_required_for_output (node->operation,
+                                                         gegl_pad_get_name (input_pads->data),
+                                                         &request);
+          current_need = *gegl_operation_context_get_need_rect (source_context);
+
+          gegl_rectangle_bounding_box (&new_need, &rect, &current_need);
+          gegl_rectangle_intersect (&new_need, &source_node->have_rect, &new_need);
+
+          gegl_operation_context_set_need_rect (source_context, &new_need);
+        }
+    }
+
+  for (list_iter = data->first; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode             *node         = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context      = g_hash_table_lookup (contexts, node);
+      GeglOperationContext *main_context = g_hash_table_lookup (path->contexts, node);
+      GSList               *input_pads;
+
+      result = NULL;
+
+      if (last_context)
+        gegl_operation_context_purge (last_context);
+      last_context = context;
+
+      if (context->need_rect.width <= 0 || context->need_rect.height <= 0)
+        continue;
+
+      if (context->cached)
+        {
+          result = GEGL_BUFFER (node->cache);
+        }
+      else
+        {
+          for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+            {
+              const gchar *pad_name = gegl_pad_get_name (input_pads->data);
+              GObject     *object;
+
+              if (gegl_operation_context_get_object (context, pad_name))
+                continue;
+
+              object = gegl_operation_context_get_object (main_context, pad_name);
+
+              if (object)
+                gegl_operation_context_set_object (context, pad_name, object);
+            }
+
+          if (gegl_node_has_pad (node, "input") &&
+              !gegl_operation_context_get_object (context, "input"))
+            {
+              gegl_operation_context_set_object (context, "input", G_OBJECT (path->shared_empty));
+            }
+
+          context->level = 0;
+
+          gegl_operation_process (node->operation, context, "output", &context->need_rect, 0);
+          result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+
+          /* the cache is marked as computed, and its signal emitted, from
+           * the calling thread once all tiles are done.
+           */
+          if (result && result == (GeglBuffer *)node->cache)
+            {
+              TiledComputed computed = { node, context->need_rect };
+
+              g_mutex_lock (&data->mutex);
+              g_array_append_val (data->computed, computed);
+              g_mutex_unlock (&data->mutex);
+            }
+        }
+
+      if (result)
+        {
+          GList *targets = gegl_graph_get_connected_output_contexts (
+                             contexts, gegl_node_get_pad (node, "output"));
+          GList *targets_iter;
+
+          if (g_list_length (targets) > 1)
+            gegl_object_set_has_forked (G_OBJECT (result));
+
+          for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
+            {
+              ContextConnection *target_con = targets_iter->data;
+              gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (result));
+            }
+          g_list_free_full (targets, free_context_connection);
+        }
+    }
+
+  /* tiles are aligned to the output's tile grid, so this mostly shares,
+   * rather than copies, the tile data.
+   */
+  if (result && result != data->output)
+    gegl_buffer_copy (result, tile, GEGL_ABYSS_NONE, data->output, tile);
+
+  g_hash_table_unref (contexts);
+}
+
+static void
+gegl_graph_process_tiles (gint          i,
+                          gint          n,
+                          TiledProcess *data)
+{
+  gint t;
+
+  /* tiles are handed out one at a time, so that threads that got cheap
+   * tiles keep working while others are busy.
+   */
+  while ((t = g_atomic_int_add (&data->next_tile, 1)) < data->n_tiles)
+    {
+      GeglRectangle tile;
+
+      gegl_rectangle_set (&tile,
+                          (data->tile_x0 + t % data->n_tiles_x) * data->tile_width,
+                          (data->tile_y0 + t / data->n_tiles_x) * data->tile_height,
+                          data->tile_width,
+                          data->tile_height);
+      gegl_rectangle_intersect (&tile, &tile, &data->area);
+
+      gegl_graph_process_tile (data, &tile);
+    }
+}
+
+/**
+ * gegl_graph_process_tiled:
+ * @path: The traversal path
+ *
+ * Process the prepared request like gegl_graph_process(), but evaluate
+ * the trailing part of the graph made of tileable operations tile by tile,
+ * with each thread running a whole tile through all of these nodes, rather
+ * than running each node over the whole request in turn.  Nodes before the
+ * last non-tileable node are processed as usual, and the whole graph is if
+ * there is nothing to gain from tiling.
+ *
+ * Return value: (transfer full): The result of the graph, or NULL if
+ * there is no output pad.
+ */
+GeglBuffer *
+gegl_graph_process_tiled (GeglGraphTraversal *path,
+                          gint                level)
+{
+  GeglNode             *last_node = GEGL_NODE (g_queue_peek_tail (&path->path));
+  GeglOperationContext *last_context;
+  GeglBuffer           *prefix_result;
+  GeglBuffer           *result;
+  GList                *first     = NULL;
+  GList                *list_iter;
+  TiledProcess          data;
+  gint                  n_threads;
+  guint                 i;
+
+  /* mipmap levels are computed into the buffers' lower levels, which the
+   * per-tile results can't be merged into.
+   */
+  if (level != 0 || gegl_config_threads () == 1 ||
+      ! gegl_node_has_pad (last_node, "output"))
+    return gegl_graph_process (path, level);
+
+  last_context = g_hash_table_lookup (path->contexts, last_node);
+
+  data.path        = path;
+  data.area        = last_context->need_rect;
+  data.tile_width  = 2 * gegl_config ()->tile_width;
+  data.tile_height = 2 * gegl_config ()->tile_height;
+
+  for (list_iter = g_queue_peek_tail_link (&path->path);
+       list_iter;
+       list_iter = list_iter->prev)
+    {
+      if (! gegl_graph_node_is_tileable (path, GEGL_NODE (list_iter->data),
+                                         data.tile_width, data.tile_height))
+        break;
+
+      first = list_iter;
+    }
+
+  if (! first || last_context->cached ||
+      data.area.width <= 0 || data.area.height <= 0)
+    return gegl_graph_process (path, level);
+
+  data.tile_x0   = floor ((gdouble) data.area.x / data.tile_width);
+  data.tile_y0   = floor ((gdouble) data.area.y / data.tile_height);
+  data.n_tiles_x = ceil ((gdouble) (data.area.x + data.area.width) /
+                         data.tile_width) - data.tile_x0;
+  data.n_tiles   = data.n_tiles_x *
+                   (gint) (ceil ((gdouble) (data.area.y + data.area.height) /
+                                 data.tile_height) - data.tile_y0);
+  data.next_tile = 0;
+
+  if (data.n_tiles < 2)
+    return gegl_graph_process (path, level);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Processing %s and %d preceding nodes in %d tiles",
+             gegl_node_get_debug_name (last_node),
+             g_list_position (first, g_queue_peek_tail_link (&path->path)),
+             data.n_tiles);
+
+  /* the untiled part of the graph delivers complete buffers to the
+   * contexts of the tiled part.
+   */
+  prefix_result = gegl_graph_process_range (path,
+                                            g_queue_peek_head_link (&path->path),
+                                            first, level);
+  g_clear_object (&prefix_result);
+
+  data.first = first;
+
+  gegl_graph_get_shared_empty (path);
+
+  for (list_iter = first; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode             *node    = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+      GSList               *input_pads;
+
+      /* all tiles read these, none may process them in place */
+      for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+        {
+          GObject *object = gegl_operation_context_get_object (
+                              context, gegl_pad_get_name (input_pads->data));
+
+          if (object)
+            gegl_object_set_has_forked (object);
+        }
+
+      if (gegl_node_use_cache (node))
+        gegl_node_get_cache (node);
+    }
+
+  data.output = gegl_operation_context_get_target (last_context, "output");
+
+  n_threads = MIN (data.n_tiles, gegl_config_threads ());
+
+  g_mutex_init (&data.mutex);
+  data.computed = g_array_new (FALSE, FALSE, sizeof (TiledComputed));
+
+  gegl_parallel_distribute (n_threads,
+                            (GeglParallelDistributeFunc) gegl_graph_process_tiles,
+                            &data);
+
+  for (i = 0; i < data.computed->len; i++)
+    {
+      TiledComputed *computed = &g_array_index (data.computed, TiledComputed, i);
+
+      gegl_cache_computed (computed->node->cache, &computed->rect, 0);
+    }
+
+  g_array_free (data.computed, TRUE);
+  g_mutex_clear (&data.mutex);
+
+  result = g_object_ref (data.output);
+
+  for (list_iter = first; list_iter; list_iter = list_iter->next)
+    {
+      gegl_operation_context_purge (g_hash_table_lookup (path->contexts,
+                                                         list_iter->data));
+    }
+
+  return result;
+}
@@ -31,6 +31,8 @@ void                gegl_graph_prepare_request  (GeglGraphTraversal  *path,
                                                  gint                 level);
 GeglBuffer         *gegl_graph_process          (GeglGraphTraversal  *path,
                                                  gint                 level);
+GeglBuffer         *gegl_graph_process_tiled    (GeglGraphTraversal  *path,
+                                                 gint                 level);
 
 GeglRectangle       gegl_graph_get_bounding_box (GeglGraphTraversal  *path);
 
@@ -41,6 +41,11 @@
 
 #include "opencl/gegl-cl.h"
 
+/* past this many uncovered rectangles, a partially cached dirty rectangle
+ * is rendered as the bounding box of its uncovered parts instead.
+ */
+#define GEGL_PROCESSOR_MAX_PARTIAL_RECTS 16
+
 enum
 {
   PROP_0,
@@ -67,6 +72,10 @@ static void      gegl_processor_set_node     (GeglProcessor         *processor,
 static void      gegl_processor_constructed  (GObject               *object);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
 static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static void      gegl_processor_input_invalidated
+                                             (GeglNode              *node,
+                                              const GeglRectangle   *rect,
+                                              GeglProcessor         *processor);
 
 
 struct _GeglProcessor
@@ -243,6 +252,17 @@ gegl_processor_set_node (GeglProcessor *processor,
   g_return_if_fail (GEGL_IS_NODE (node));
   g_return_if_fail (node->is_graph || GEGL_IS_OPERATION (node->operation));
 
+  /* forget the previous node's input, and what we rendered of it */
+  if (processor->input)
+    {
+      g_signal_handlers_disconnect_by_func (processor->input,
+                                            gegl_processor_input_invalidated,
+                                            processor);
+      g_clear_object (&processor->input);
+    }
+
+  g_clear_pointer (&processor->valid_region, gegl_region_destroy);
+
   g_set_object (&processor->node, node);
   g_clear_object (&processor->real_node);
 
@@ -274,6 +294,13 @@ gegl_processor_set_node (GeglProcessor *processor,
       if (!gegl_operation_sink_needs_full (processor->real_node->operation))
         {
           processor->valid_region = gegl_region_new ();
+
+          /* the sink's output has no cache to be invalidated, so we forget
+           * what we rendered of the invalidated areas ourselves
+           */
+          g_signal_connect_object (processor->input, "invalidated",
+                                   G_CALLBACK (gegl_processor_input_invalidated),
+                                   processor, 0);
         }
       else
         {
@@ -298,6 +325,33 @@ gegl_processor_set_node (GeglProcessor *processor,
   g_object_notify (G_OBJECT (processor), "node");
 }
 
+/* removes the invalidated areas of the input, one rectangle of its
+ * invalidated region at a time, from what was rendered unbuffered
+ */
+static void
+gegl_processor_input_invalidated (GeglNode            *node,
+                                  const GeglRectangle *rect,
+                                  GeglProcessor       *processor)
+{
+  GeglRectangle  scaled;
+  GeglRegion    *region;
+  gint           level = processor->level;
+
+  if (! processor->valid_region || rect->width <= 0 || rect->height <= 0)
+    return;
+
+  scaled.x      = rect->x >> level;
+  scaled.y      = rect->y >> level;
+  scaled.width  = ((rect->x + rect->width  + (1 << level) - 1) >> level) -
+                  scaled.x;
+  scaled.height = ((rect->y + rect->height + (1 << level) - 1) >> level) -
+                  scaled.y;
+
+  region = gegl_region_rectangle (&scaled);
+  gegl_region_subtract (processor->valid_region, region);
+  gegl_region_destroy (region);
+}
+
 static void
 set_scaled_rectangle (GeglProcessor *processor)
 {
@@ -424,6 +478,78 @@ gegl_processor_get_band_size (gint size)
   return band_size;
 }
 
+/* Removes from @region, given in the coordinates of the processor's mipmap
+ * level, what is valid in @cache at that level or at any more detailed one
+ * down to @min_level, from which the level can be downscaled.  The valid
+ * regions of the cache are in level-0 coordinates at every level.
+ */
+static void
+gegl_processor_subtract_valid (GeglProcessor *processor,
+                               GeglCache     *cache,
+                               GeglRegion    *region,
+                               gint           min_level)
+{
+  gint           shift = processor->level;
+  GeglRegion    *unscaled;
+  GeglRegion    *remaining;
+  GeglRectangle *rects;
+  gint           n_rects;
+  gint           level;
+  gint           i;
+
+  if (shift == 0)
+    {
+      gegl_tile_bitmap_subtract (cache->valid[0], region);
+      return;
+    }
+
+  unscaled = gegl_region_new ();
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      GeglRectangle rect = {rects[i].x      << shift,
+                            rects[i].y      << shift,
+                            rects[i].width  << shift,
+                            rects[i].height << shift};
+
+      gegl_region_union_with_rect (unscaled, &rect);
+    }
+
+  g_free (rects);
+
+  for (level = processor->level;
+       level >= min_level && ! gegl_region_empty (unscaled);
+       level--)
+    {
+      gegl_tile_bitmap_subtract (cache->valid[level], unscaled);
+    }
+
+  /* scale what is still missing back down, rounding outwards */
+  remaining = gegl_region_new ();
+
+  gegl_region_get_rectangles (unscaled, &rects, &n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      gint          x1   = rects[i].x >> shift;
+      gint          y1   = rects[i].y >> shift;
+      gint          x2   = (rects[i].x + rects[i].width  + (1 << shift) - 1) >> shift;
+      gint          y2   = (rects[i].y + rects[i].height + (1 << shift) - 1) >> shift;
+      GeglRectangle rect = {x1, y1, x2 - x1, y2 - y1};
+
+      gegl_region_union_with_rect (remaining, &rect);
+    }
+
+  g_free (rects);
+
+  gegl_region_intersect (region, remaining);
+
+  gegl_region_destroy (remaining);
+  gegl_region_destroy (unscaled);
+}
+
 /* If the processor's dirty rectangle is too big then it will be cut, added
  * to the processor's list of dirty rectangles and TRUE will be returned.
  * If the rectangle is small enough it will be processed, using a buffer or
@@ -494,29 +620,42 @@ render_rectangle (GeglProcessor *processor)
 
       if (buffered)
         {
-          gboolean found_full = FALSE;
-          for (gint level = processor->level; level >= 0; level--)
-          {
-            if (gegl_region_rect_in (cache->valid_region[level], dr) == GEGL_OVERLAP_RECTANGLE_IN)
+          GeglRegion    *region   = gegl_region_rectangle (dr);
+          GeglRectangle  computed = {dr->x      << processor->level,
+                                     dr->y      << processor->level,
+                                     dr->width  << processor->level,
+                                     dr->height << processor->level};
+          GeglRectangle *rects;
+          gint           n_rects;
+          gint           i;
+
+          /* only render the parts of dr not found in the cache */
+          gegl_processor_subtract_valid (processor, cache, region, 0);
+
+          gegl_region_get_rectangles (region, &rects, &n_rects);
+
+          if (n_rects > GEGL_PROCESSOR_MAX_PARTIAL_RECTS)
             {
-              found_full = TRUE;
-              break;
+              gegl_region_get_clipbox (region, &rects[0]);
+              n_rects = 1;
             }
-            /* XXX: dr should be adjusted to be the bounding box of not-found
-             * in cache if there is partial hits
-             */
-          }
 
-          if (!found_full)
+          for (i = 0; i < n_rects; i++)
             {
               /* do the image calculations using the buffer */
               gegl_node_blit (processor->input, 1.0/(1<<processor->level),
-                              dr, format, NULL,
+                              &rects[i], format, NULL,
                               GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
-
-              /* tells the cache that the rectangle (dr) has been computed */
-              gegl_cache_computed (cache, dr, processor->level);
             }
+
+          /* tells the cache that the rectangle has been computed, including
+           * the parts downscaled from a more detailed level, in level-0
+           * coordinates
+           */
+          gegl_cache_computed (cache, &computed, processor->level);
+
+          g_free (rects);
+          gegl_region_destroy (region);
           g_slice_free (GeglRectangle, dr);
         }
       else
@@ -574,6 +713,64 @@ area_left (GeglRegion    *area,
   return sum;
 }
 
+/* returns the area of @rectangle which is already rendered, or all of the
+ * rendered area if @rectangle is NULL
+ */
+static gint
+gegl_processor_rendered_area (GeglProcessor *processor,
+                              GeglRectangle *rectangle)
+{
+  GeglCache *cache;
+
+  if (processor->valid_region)
+    {
+      if (rectangle)
+        return rect_area (rectangle) -
+               area_left (processor->valid_region, rectangle);
+      else
+        return region_area (processor->valid_region);
+    }
+
+  cache = gegl_node_get_cache (processor->input);
+
+  if (rectangle)
+    {
+      GeglRegion *region = gegl_region_rectangle (rectangle);
+      gint        area;
+
+      gegl_processor_subtract_valid (processor, cache, region,
+                                     processor->level);
+      area = rect_area (rectangle) - region_area (region);
+      gegl_region_destroy (region);
+
+      return area;
+    }
+
+  /* the valid regions are in level-0 coordinates */
+  return gegl_tile_bitmap_get_area (cache->valid[processor->level], NULL) >>
+         (2 * processor->level);
+}
+
+/* removes what is already rendered from @region */
+static void
+gegl_processor_subtract_rendered (GeglProcessor *processor,
+                                  GeglRegion    *region)
+{
+  GeglCache *cache;
+
+  if (processor->valid_region)
+    {
+      gegl_region_subtract (region, processor->valid_region);
+    }
+  else
+    {
+      cache = gegl_node_get_cache (processor->input);
+
+      gegl_processor_subtract_valid (processor, cache, region,
+                                     processor->level);
+    }
+}
+
 /* returns true if everything is rendered */
 static gboolean
 gegl_processor_is_rendered (GeglProcessor *processor)
@@ -587,24 +784,14 @@ gegl_processor_is_rendered (GeglProcessor *processor)
 static gdouble
 gegl_processor_progress (GeglProcessor *processor)
 {
-  GeglRegion *valid_region;
   gint        valid;
   gint        wanted;
   gdouble     ret;
 
   g_return_val_if_fail (processor->input != NULL, 1);
 
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
-
   wanted = rect_area (&(processor->rectangle));
-  valid  = wanted - area_left (valid_region, &(processor->rectangle));
+  valid  = gegl_processor_rendered_area (processor, &(processor->rectangle));
   if (wanted == 0)
     {
       if (gegl_processor_is_rendered (processor))
@@ -631,17 +818,8 @@ gegl_processor_render (GeglProcessor *processor,
                        GeglRectangle *rectangle,
                        gdouble       *progress)
 {
-  GeglRegion *valid_region;
-
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      g_return_val_if_fail (processor->input != NULL, FALSE);
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
+  g_return_val_if_fail (processor->valid_region || processor->input != NULL,
+                        FALSE);
 
   {
     gboolean more_work = render_rectangle (processor);
@@ -655,11 +833,11 @@ gegl_processor_render (GeglProcessor *processor,
             if (rectangle)
               {
                 wanted = rect_area (rectangle);
-                valid  = wanted - area_left (valid_region, rectangle);
+                valid  = gegl_processor_rendered_area (processor, rectangle);
               }
             else
               {
-                valid  = region_area (valid_region);
+                valid  = gegl_processor_rendered_area (processor, NULL);
                 wanted = region_area (processor->queued_region);
               }
             if (wanted == 0)
@@ -684,7 +862,7 @@ gegl_processor_render (GeglProcessor *processor,
       gint           n_rectangles;
       gint           i;
 
-      gegl_region_subtract (region, valid_region);
+      gegl_processor_subtract_rendered (processor, region);
       gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
       gegl_region_destroy (region);
 
@@ -704,8 +882,9 @@ gegl_processor_render (GeglProcessor *processor,
       if (n_rectangles != 0)
         {
           if (progress)
-            *progress = 1.0 - ((double) area_left (valid_region, rectangle) /
-                               rect_area (rectangle));
+            *progress = (double) gegl_processor_rendered_area (processor,
+                                                               rectangle) /
+                        rect_area (rectangle);
           return TRUE;
         }
 
@@ -425,6 +425,7 @@ gegl_op_class_init (GeglOpClass *klass)
   point_render_class->process = process;
   operation_class->get_bounding_box = get_bounding_box;
   operation_class->prepare = prepare;
+  operation_class->dynamic_split = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
     "name",               "gegl:fractal-explorer",
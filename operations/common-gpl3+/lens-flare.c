@@ -502,6 +502,7 @@ gegl_op_class_init (GeglOpClass *klass)
 
   operation_class->prepare = prepare;
   operation_class->opencl_support = FALSE;
+  operation_class->dynamic_split = TRUE;
 
   filter_class->process    = process;
 
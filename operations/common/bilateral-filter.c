@@ -23,6 +23,11 @@
 
 #ifdef GEGL_PROPERTIES
 
+enum_start (gegl_bilateral_filter_mode)
+  enum_value (GEGL_BILATERAL_FILTER_EXACT, "exact", N_("Exact"))
+  enum_value (GEGL_BILATERAL_FILTER_FAST,  "fast",  N_("Fast"))
+enum_end (GeglBilateralFilterMode)
+
 property_double (blur_radius, _("Blur radius"), 4.0)
   description(_("Radius of square pixel region, (width and height will be radius*2+1)."))
   value_range   (0.0, 1000.0)
@@ -33,6 +38,12 @@ property_double (edge_preservation, _("Edge preservation"), 8.0)
   description   (_("Amount of edge preservation"))
   value_range   (0.0, 100.0)
 
+property_enum (mode, _("Mode"),
+               GeglBilateralFilterMode, gegl_bilateral_filter_mode,
+               GEGL_BILATERAL_FILTER_EXACT)
+  description (_("Exact weighs every pixel of the neighborhood, fast uses "
+                 "a bilateral grid, whose cost does not depend on the radius"))
+
 #else
 
 #define GEGL_OP_AREA_FILTER
@@ -41,16 +52,35 @@ property_double (edge_preservation, _("Edge preservation"), 8.0)
 
 #include "gegl-op.h"
 
+/* the fast mode is only used when the grid cells are at least this large;
+ * for smaller kernels the grid is hardly coarser than the image, and the
+ * exact mode is cheap anyway.
+ */
+#define GRID_MIN_SIGMA 2.0
+
 static void
 bilateral_filter (GeglBuffer          *src,
                   const GeglRectangle *src_rect,
                   GeglBuffer          *dst,
                   const GeglRectangle *dst_rect,
                   gdouble              radius,
+                  gdouble              variance,
                   gdouble              preserve,
-                  const Babl          *format);
+                  const Babl          *format,
+                  gint                 level);
+
+static void
+bilateral_grid (GeglBuffer          *src,
+                const GeglRectangle *src_rect,
+                GeglBuffer          *dst,
+                const GeglRectangle *dst_rect,
+                gdouble              sigma_s,
+                gdouble              preserve,
+                const Babl          *format,
+                gint                 level);
 
 #include <stdio.h>
+#include <string.h>
 
 static void prepare (GeglOperation *operation)
 {
@@ -59,7 +89,18 @@ static void prepare (GeglOperation *operation)
   GeglOperationAreaFilter *area = GEGL_OPERATION_AREA_FILTER (operation);
   GeglProperties              *o = GEGL_PROPERTIES (operation);
 
-  area->left = area->right = area->top = area->bottom = ceil (o->blur_radius);
+  /* the spatial gaussian of the exact mode has a variance of blur_radius,
+   * the grid reaches about four standard deviations out; at lower levels
+   * the fast mode may fall back to the exact mode, which needs the whole
+   * radius.
+   */
+  if (o->mode == GEGL_BILATERAL_FILTER_FAST && o->blur_radius >= 1.0)
+    area->left = MAX (ceil (o->blur_radius),
+                      ceil (4.0 * sqrt (o->blur_radius)));
+  else
+    area->left = ceil (o->blur_radius);
+
+  area->right = area->top = area->bottom = area->left;
   gegl_operation_set_format (operation, "input", format);
   gegl_operation_set_format (operation, "output", format);
 }
@@ -166,11 +207,17 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
+  GeglOperationAreaFilter *area = GEGL_OPERATION_AREA_FILTER (operation);
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GeglRectangle compute;
+  GeglRectangle dst_rect;
   const Babl *format = gegl_operation_get_format (operation, "output");
+  gdouble radius;
+  gdouble variance;
+  gdouble sigma_s;
 
-  if (o->blur_radius >= 1.0 && gegl_operation_use_opencl (operation))
+  if (o->blur_radius >= 1.0 && o->mode == GEGL_BILATERAL_FILTER_EXACT &&
+      level == 0 && gegl_operation_use_opencl (operation))
     if (cl_process (operation, input, output, result))
       return TRUE;
 
@@ -180,10 +227,57 @@ process (GeglOperation       *operation,
     {
       gegl_buffer_copy (input, result, GEGL_ABYSS_NONE,
                         output, result);
+      return TRUE;
+    }
+
+  /* previews render at a reduced level, where both the rectangles and the
+   * kernel shrink along with the image.
+   */
+  dst_rect = *result;
+  radius   = o->blur_radius;
+  variance = o->blur_radius;
+
+  if (level)
+    {
+      dst_rect.x      = result->x >> level;
+      dst_rect.y      = result->y >> level;
+      dst_rect.width  = ((result->x + result->width) >> level) - dst_rect.x;
+      dst_rect.height = ((result->y + result->height) >> level) - dst_rect.y;
+
+      radius   /= 1 << level;
+      variance /= (1 << level) * (1 << level);
+    }
+
+  sigma_s = sqrt (variance);
+
+  if (o->mode == GEGL_BILATERAL_FILTER_FAST && sigma_s >= GRID_MIN_SIGMA)
+    {
+      gegl_rectangle_set (&compute,
+                          dst_rect.x - (area->left >> level),
+                          dst_rect.y - (area->top >> level),
+                          dst_rect.width +
+                          (area->left >> level) + (area->right >> level),
+                          dst_rect.height +
+                          (area->top >> level) + (area->bottom >> level));
+
+      bilateral_grid (input, &compute, output, &dst_rect,
+                      sigma_s, o->edge_preservation, format, level);
     }
   else
     {
-      bilateral_filter (input, &compute, output, result, o->blur_radius, o->edge_preservation, format);
+      if (level)
+        {
+          gint iradius = radius;
+
+          gegl_rectangle_set (&compute,
+                              dst_rect.x - iradius, dst_rect.y - iradius,
+                              dst_rect.width  + 2 * iradius,
+                              dst_rect.height + 2 * iradius);
+        }
+
+      bilateral_filter (input, &compute, output, &dst_rect,
+                        radius, variance, o->edge_preservation,
+                        format, level);
     }
 
   return  TRUE;
@@ -195,8 +289,10 @@ bilateral_filter (GeglBuffer          *src,
                   GeglBuffer          *dst,
                   const GeglRectangle *dst_rect,
                   gdouble              radius,
+                  gdouble              variance,
                   gdouble              preserve,
-                  const Babl          *format)
+                  const Babl          *format,
+                  gint                 level)
 {
   gfloat *gauss;
   gint x,y;
@@ -212,8 +308,8 @@ bilateral_filter (GeglBuffer          *src,
   src_buf = g_new0 (gfloat, src_rect->width * src_rect->height * 4);
   dst_buf = g_new0 (gfloat, dst_rect->width * dst_rect->height * 4);
 
-  gegl_buffer_get (src, src_rect, 1.0, format, src_buf, GEGL_AUTO_ROWSTRIDE,
-                   GEGL_ABYSS_NONE);
+  gegl_buffer_get (src, src_rect, 1.0 / (1 << level), format, src_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
   offset = 0;
 
@@ -221,7 +317,7 @@ bilateral_filter (GeglBuffer          *src,
   for (y=-iradius;y<=iradius;y++)
     for (x=-iradius;x<=iradius;x++)
       {
-        gauss[x+(int)radius + (y+(int)radius)*width] = exp(- 0.5*(POW2(x)+POW2(y))/radius   );
+        gauss[x+(int)radius + (y+(int)radius)*width] = exp(- 0.5*(POW2(x)+POW2(y))/variance );
       }
 
   for (y=0; y<dst_rect->height; y++)
@@ -268,13 +364,248 @@ bilateral_filter (GeglBuffer          *src,
           dst_buf[offset*4+u] = accumulated[u]/count;
         offset++;
       }
-  gegl_buffer_set (dst, dst_rect, 0, format, dst_buf,
+  gegl_buffer_set (dst, dst_rect, level, format, dst_buf,
                    GEGL_AUTO_ROWSTRIDE);
   g_free (src_buf);
   g_free (dst_buf);
 }
 
 
+/* the fast mode is the bilateral grid of Paris and Durand: the pixels are
+ * accumulated into a coarse (x, y, intensity) grid, the grid is blurred, and
+ * the output is interpolated back out of it.  the cells are aligned to the
+ * image coordinates, so that neighboring chunks use the same cells and render
+ * without seams.
+ */
+#define GRID_CHANNELS 5
+
+static void
+grid_blur (gfloat     *grid,
+           const gint *size,
+           gint        axis,
+           gfloat     *line)
+{
+  static const gfloat kernel[5] = {1.0f / 16.0f, 4.0f / 16.0f, 6.0f / 16.0f,
+                                   4.0f / 16.0f, 1.0f / 16.0f};
+  gint   strides[3];
+  gint   other[2];
+  gint   len = size[axis];
+  gint   i, j, k;
+
+  strides[0] = GRID_CHANNELS;
+  strides[1] = GRID_CHANNELS * size[0];
+  strides[2] = GRID_CHANNELS * size[0] * size[1];
+
+  other[0] = (axis + 1) % 3;
+  other[1] = (axis + 2) % 3;
+
+  for (j = 0; j < size[other[1]]; j++)
+    for (i = 0; i < size[other[0]]; i++)
+      {
+        gfloat *cells = grid + i * strides[other[0]] + j * strides[other[1]];
+
+        for (k = 0; k < len; k++)
+          memcpy (line + k * GRID_CHANNELS, cells + k * strides[axis],
+                  sizeof (gfloat) * GRID_CHANNELS);
+
+        for (k = 0; k < len; k++)
+          {
+            gfloat *cell = cells + k * strides[axis];
+            gint    t;
+            gint    c;
+
+            for (c = 0; c < GRID_CHANNELS; c++)
+              cell[c] = 0.0f;
+
+            for (t = MAX (k - 2, 0); t <= MIN (k + 2, len - 1); t++)
+              {
+                const gfloat *src = line + t * GRID_CHANNELS;
+                const gfloat  w   = kernel[t - k + 2];
+
+                for (c = 0; c < GRID_CHANNELS; c++)
+                  cell[c] += w * src[c];
+              }
+          }
+      }
+}
+
+static void
+bilateral_grid (GeglBuffer          *src,
+                const GeglRectangle *src_rect,
+                GeglBuffer          *dst,
+                const GeglRectangle *dst_rect,
+                gdouble              sigma_s,
+                gdouble              preserve,
+                const Babl          *format,
+                gint                 level)
+{
+  /* the exact mode weighs colors by exp (-|a - b|² * preserve); the range
+   * axis of the grid is the projection of the colors on the gray axis, so
+   * that it measures distances the same way along it.
+   */
+  const gfloat  to_intensity = 1.0f / sqrtf (3.0f);
+  gfloat       *src_buf;
+  gfloat       *dst_buf;
+  gfloat       *grid;
+  gfloat       *line;
+  gint         *cell_x;
+  gint         *cell_y;
+  gdouble       sigma_r;
+  gfloat        min_i = G_MAXFLOAT;
+  gfloat        max_i = -G_MAXFLOAT;
+  gint          x0, y0, z0;
+  gint          size[3];
+  gint          x, y;
+  gint          n;
+
+  src_buf = g_new (gfloat, src_rect->width * src_rect->height * 4);
+  dst_buf = g_new (gfloat, dst_rect->width * dst_rect->height * 4);
+
+  gegl_buffer_get (src, src_rect, 1.0 / (1 << level), format, src_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  n = src_rect->width * src_rect->height;
+
+  for (x = 0; x < n; x++)
+    {
+      const gfloat *p = src_buf + x * 4;
+      const gfloat  i = (p[0] + p[1] + p[2]) * to_intensity;
+
+      if (i < min_i)
+        min_i = i;
+      if (i > max_i)
+        max_i = i;
+    }
+
+  if (min_i > max_i)
+    min_i = max_i = 0.0f;
+
+  /* the cells only depend on the properties, and not on the range of the
+   * chunk, so that neighboring chunks are filtered alike; without edge
+   * preservation, all colors fall in the same cell.
+   */
+  if (preserve > 0.0)
+    sigma_r = 1.0 / sqrt (2.0 * preserve);
+  else
+    sigma_r = G_MAXFLOAT;
+
+  x0 = floor (src_rect->x / sigma_s);
+  y0 = floor (src_rect->y / sigma_s);
+  z0 = floor (min_i / sigma_r);
+
+  size[0] = (gint) floor ((src_rect->x + src_rect->width  - 1) / sigma_s) + 2 - x0;
+  size[1] = (gint) floor ((src_rect->y + src_rect->height - 1) / sigma_s) + 2 - y0;
+  size[2] = (gint) floor (max_i / sigma_r) + 2 - z0;
+
+  grid = g_new0 (gfloat, (gsize) size[0] * size[1] * size[2] * GRID_CHANNELS);
+  line = g_new (gfloat, MAX (MAX (size[0], size[1]), size[2]) * GRID_CHANNELS);
+
+  cell_x = g_new (gint, src_rect->width);
+  cell_y = g_new (gint, src_rect->height);
+
+  for (x = 0; x < src_rect->width; x++)
+    cell_x[x] = (gint) floor ((src_rect->x + x) / sigma_s + 0.5) - x0;
+  for (y = 0; y < src_rect->height; y++)
+    cell_y[y] = (gint) floor ((src_rect->y + y) / sigma_s + 0.5) - y0;
+
+  /* splat */
+  for (y = 0; y < src_rect->height; y++)
+    for (x = 0; x < src_rect->width; x++)
+      {
+        const gfloat *p = src_buf + (y * src_rect->width + x) * 4;
+        const gfloat  i = (p[0] + p[1] + p[2]) * to_intensity;
+        gint          z = (gint) floor (i / sigma_r + 0.5) - z0;
+        gfloat       *cell;
+
+        z = CLAMP (z, 0, size[2] - 1);
+
+        cell = grid + ((z * size[1] + cell_y[y]) * size[0] + cell_x[x]) *
+                      GRID_CHANNELS;
+
+        cell[0] += p[0];
+        cell[1] += p[1];
+        cell[2] += p[2];
+        cell[3] += p[3];
+        cell[4] += 1.0f;
+      }
+
+  /* blur, the binomial kernel has a standard deviation of one cell */
+  grid_blur (grid, size, 0, line);
+  grid_blur (grid, size, 1, line);
+  grid_blur (grid, size, 2, line);
+
+  /* slice */
+  for (y = 0; y < dst_rect->height; y++)
+    {
+      const gint   sy = y + dst_rect->y - src_rect->y;
+      const gfloat yf = (dst_rect->y + y) / sigma_s - y0;
+      const gint   y1 = MIN ((gint) yf, size[1] - 1);
+      const gint   y2 = MIN (y1 + 1, size[1] - 1);
+      const gfloat ya = yf - y1;
+
+      for (x = 0; x < dst_rect->width; x++)
+        {
+          const gint    sx = x + dst_rect->x - src_rect->x;
+          const gfloat *p  = src_buf + (sy * src_rect->width + sx) * 4;
+          gfloat       *q  = dst_buf + (y * dst_rect->width + x) * 4;
+          const gfloat  xf = (dst_rect->x + x) / sigma_s - x0;
+          const gint    x1 = MIN ((gint) xf, size[0] - 1);
+          const gint    x2 = MIN (x1 + 1, size[0] - 1);
+          const gfloat  xa = xf - x1;
+          gfloat        zf;
+          gint          z1, z2;
+          gfloat        za;
+          gfloat        v[GRID_CHANNELS];
+          gint          c;
+
+          zf = (p[0] + p[1] + p[2]) * to_intensity / sigma_r - z0;
+          zf = CLAMP (zf, 0.0f, size[2] - 1);
+          z1 = zf;
+          z2 = MIN (z1 + 1, size[2] - 1);
+          za = zf - z1;
+
+#define CELL(cx,cy,cz) (grid + (((cz) * size[1] + (cy)) * size[0] + (cx)) * \
+                               GRID_CHANNELS)
+          for (c = 0; c < GRID_CHANNELS; c++)
+            {
+              const gfloat a = CELL (x1, y1, z1)[c] * (1.0f - xa) +
+                               CELL (x2, y1, z1)[c] * xa;
+              const gfloat b = CELL (x1, y2, z1)[c] * (1.0f - xa) +
+                               CELL (x2, y2, z1)[c] * xa;
+              const gfloat d = CELL (x1, y1, z2)[c] * (1.0f - xa) +
+                               CELL (x2, y1, z2)[c] * xa;
+              const gfloat e = CELL (x1, y2, z2)[c] * (1.0f - xa) +
+                               CELL (x2, y2, z2)[c] * xa;
+
+              v[c] = (a * (1.0f - ya) + b * ya) * (1.0f - za) +
+                     (d * (1.0f - ya) + e * ya) * za;
+            }
+#undef CELL
+
+          if (v[4] > 0.0f)
+            {
+              for (c = 0; c < 4; c++)
+                q[c] = v[c] / v[4];
+            }
+          else
+            {
+              for (c = 0; c < 4; c++)
+                q[c] = p[c];
+            }
+        }
+    }
+
+  gegl_buffer_set (dst, dst_rect, level, format, dst_buf,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (cell_y);
+  g_free (cell_x);
+  g_free (line);
+  g_free (grid);
+  g_free (dst_buf);
+  g_free (src_buf);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
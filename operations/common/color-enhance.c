@@ -33,46 +33,94 @@
 
 #include "gegl-op.h"
 
+typedef struct
+{
+  GeglBuffer *input;
+  GeglBuffer *output;
+  const Babl *format;
+  gint        level;
+  gdouble     min;
+  gdouble     delta;
+} ThreadData;
+
 static void
 buffer_get_min_max (GeglOperation       *operation,
                     GeglBuffer          *buffer,
                     const GeglRectangle *result,
+                    gint                 level,
                     gdouble             *min,
                     gdouble             *max,
                     const Babl          *format)
 {
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
+  GeglReduction *reduction;
 
   gegl_operation_progress (operation, 0.0, "");
 
-  gi = gegl_buffer_iterator_new (buffer, result, 0, format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  reduction = gegl_reduction_new (format, 0, 0.0, 0.0);
 
-  *min = G_MAXDOUBLE;
-  *max = -G_MAXDOUBLE;
+  gegl_reduction_add_buffer (reduction, buffer, result, level);
 
-  while (gegl_buffer_iterator_next (gi))
-    {
-      gint o;
-      gfloat *buf = gi->items[0].data;
+  *min = gegl_reduction_get_min (reduction, 1);
+  *max = gegl_reduction_get_max (reduction, 1);
+
+  gegl_reduction_free (reduction);
+
+  gegl_operation_progress (operation, 0.5, "");
+}
+
+static void
+enhance_area (const GeglRectangle *area,
+              ThreadData          *data)
+{
+  const gdouble       min   = data->min;
+  const gdouble       delta = data->delta;
+  GeglBufferIterator *gi;
 
-      for (o = 0; o < gi->length; o++)
+  gi = gegl_buffer_iterator_new (data->input, area, data->level, data->format,
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (gi, data->output, area, data->level, data->format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  if (babl_format_has_alpha (data->format))
+    {
+      while (gegl_buffer_iterator_next (gi))
         {
-          *min = MIN (buf[1], *min);
-          *max = MAX (buf[1], *max);
-          buf += 3;
-        }
+          gfloat *in  = gi->items[0].data;
+          gfloat *out = gi->items[1].data;
 
-      done_pixels += gi->length;
+          gint i;
+          for (i = 0; i < gi->length; i++)
+            {
+              out[0] = in[0];
+              out[1] = (in[1] - min) / delta * 100.0;
+              out[2] = in[2];
+              out[3] = in[3];
 
-      gegl_operation_progress (operation,
-                               (gdouble) 0.5 * done_pixels /
-                               (gdouble) (result->width * result->height),
-                               "");
+              in  += 4;
+              out += 4;
+            }
+       }
     }
+  else
+    {
+       while (gegl_buffer_iterator_next (gi))
+        {
+          gfloat *in  = gi->items[0].data;
+          gfloat *out = gi->items[1].data;
 
-  gegl_operation_progress (operation, 0.5, "");
+          gint i;
+          for (i = 0; i < gi->length; i++)
+            {
+              out[0] = in[0];
+              out[1] = (in[1] - min) / delta * 100.0;
+              out[2] = in[2];
+
+              in  += 3;
+              out += 3;
+            }
+        }
+    }
 }
 
 static void prepare (GeglOperation *operation)
@@ -131,20 +179,17 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  const Babl *format = gegl_operation_get_format (operation, "output");
-  gboolean has_alpha = babl_format_has_alpha (format);
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
-  gdouble  min;
-  gdouble  max;
-  gdouble  delta;
-
-  buffer_get_min_max (operation, input, result, &min, &max,
+  const Babl    *format        = gegl_operation_get_format (operation, "output");
+  GeglRectangle  scaled_result = *result;
+  ThreadData     data;
+  gdouble        min;
+  gdouble        max;
+  gdouble        delta;
+
+  buffer_get_min_max (operation, input, result, level, &min, &max,
                       babl_format_with_space ("CIE LCH(ab) float",
                       babl_format_get_space (format)));
 
-  gegl_operation_progress (operation, 0.5, "");
-
   delta = max - min;
 
   if (! delta)
@@ -154,68 +199,29 @@ process (GeglOperation       *operation,
       return TRUE;
     }
 
-  gi = gegl_buffer_iterator_new (input, result, 0, format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
-
-  gegl_buffer_iterator_add (gi, output, result, 0, format,
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-
-  if (has_alpha)
+  if (level)
     {
-      while (gegl_buffer_iterator_next (gi))
-        {
-          gfloat *in  = gi->items[0].data;
-          gfloat *out = gi->items[1].data;
-
-          gint i;
-          for (i = 0; i < gi->length; i++)
-            {
-              out[0] = in[0];
-              out[1] = (in[1] - min) / delta * 100.0;
-              out[2] = in[2];
-              out[3] = in[3];
-
-              in  += 4;
-              out += 4;
-            }
-
-          done_pixels += gi->length;
-
-          gegl_operation_progress (operation,
-                                   0.5 +
-                                   (gdouble) 0.5 * done_pixels /
-                                   (gdouble) (result->width * result->height),
-                                   "");
-       }
+      scaled_result.x      = result->x >> level;
+      scaled_result.y      = result->y >> level;
+      scaled_result.width  = ((result->x + result->width)  >> level) -
+                             scaled_result.x;
+      scaled_result.height = ((result->y + result->height) >> level) -
+                             scaled_result.y;
     }
-  else
-    {
-       while (gegl_buffer_iterator_next (gi))
-        {
-          gfloat *in  = gi->items[0].data;
-          gfloat *out = gi->items[1].data;
 
-          gint i;
-          for (i = 0; i < gi->length; i++)
-            {
-              out[0] = in[0];
-              out[1] = (in[1] - min) / delta * 100.0;
-              out[2] = in[2];
-
-              in  += 3;
-              out += 3;
-            }
-
-          done_pixels += gi->length;
-
-          gegl_operation_progress (operation,
-                                   0.5 +
-                                   (gdouble) 0.5 * done_pixels /
-                                   (gdouble) (result->width * result->height),
-                                   "");
-        }
-    }
+  data.input  = input;
+  data.output = output;
+  data.format = format;
+  data.level  = level;
+  data.min    = min;
+  data.delta  = delta;
+
+  gegl_parallel_distribute_area (
+    &scaled_result,
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) enhance_area,
+    &data);
 
   gegl_operation_progress (operation, 1.0, "");
 
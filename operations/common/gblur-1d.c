@@ -88,6 +88,11 @@ typedef void (*IirYoungBlur1dFunc) (gfloat           *buf,
                                     const gint        components,
                                     GeglAbyssPolicy   policy);
 
+/* the number of rows, or columns, processed at once */
+#define IIR_BLOCK_SIZE       16
+/* the maximal size of the vertical pass' intermediate buffer */
+#define IIR_MAX_BLOCK_BUFFER (16 * 1024 * 1024)
+
 static const gfloat white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 static const gfloat black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
 static const gfloat none[4]  = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -601,6 +606,89 @@ iir_young_blur_1D_rgbA (gfloat           *buf,
     }
 }
 
+/* the vertical pass filters a block of adjacent columns at once, with the
+ * columns interleaved in the buffer, so that each step of the recursion is a
+ * loop over all the block's components, which the compiler can vectorize.
+ * the arithmetic is the same as that of the single-column filters above.
+ */
+static void
+iir_young_blur_1D_block (gfloat        * restrict buf,
+                         gdouble       * restrict tmp,
+                         const gdouble           *b,
+                         gdouble                (*m)[3],
+                         const gfloat            *iminus,
+                         const gfloat            *uplus,
+                         const gint               len,
+                         const gint               lanes)
+{
+  const gdouble b0 = b[0];
+  const gdouble b1 = b[1];
+  const gdouble b2 = b[2];
+  const gdouble b3 = b[3];
+  gint          i, k, l;
+
+  for (i = 0; i < 3; i++)
+    {
+      for (l = 0; l < lanes; l++)
+        tmp[i * lanes + l] = iminus[l];
+    }
+
+  for (i = 3; i < 3 + len; i++)
+    {
+      const gfloat  *src = buf + (i - 3) * lanes;
+      gdouble       *t0  = tmp + i * lanes;
+
+      for (l = 0; l < lanes; l++)
+        {
+          gdouble v = b0 * src[l];
+
+          v += b1 * t0[l - 1 * lanes];
+          v += b2 * t0[l - 2 * lanes];
+          v += b3 * t0[l - 3 * lanes];
+
+          t0[l] = v;
+        }
+    }
+
+  /* fix the right boundary */
+  for (l = 0; l < lanes; l++)
+    {
+      gdouble *t = tmp + (3 + len) * lanes + l;
+      gdouble  u[3];
+
+      for (k = 0; k < 3; k++)
+        u[k] = t[(-k - 1) * lanes] - uplus[l];
+
+      for (i = 0; i < 3; i++)
+        {
+          gdouble v = 0.0;
+
+          for (k = 0; k < 3; k++)
+            v += m[i][k] * u[k];
+
+          t[i * lanes] = v + uplus[l];
+        }
+    }
+
+  for (i = 3 + len - 1; 3 <= i; i--)
+    {
+      gfloat  *dst = buf + (i - 3) * lanes;
+      gdouble *t0  = tmp + i * lanes;
+
+      for (l = 0; l < lanes; l++)
+        {
+          gdouble v = t0[l] * b0;
+
+          v += b1 * t0[l + 1 * lanes];
+          v += b2 * t0[l + 2 * lanes];
+          v += b3 * t0[l + 3 * lanes];
+
+          t0[l]  = v;
+          dst[l] = v;
+        }
+    }
+}
+
 static void
 iir_young_hor_blur (IirYoungBlur1dFunc   real_blur_1D,
                     GeglBuffer          *src,
@@ -612,38 +700,49 @@ iir_young_hor_blur (IirYoungBlur1dFunc   real_blur_1D,
                     const Babl          *format,
                     gint                 level)
 {
-  GeglRectangle  cur_row = *rect;
-  const gint     nc = babl_format_get_n_components (format);
-  gfloat        *row = g_new (gfloat, (3 + rect->width + 3) * nc);
-  gdouble       *tmp = g_new (gdouble, (3 + rect->width + 3) * nc);
+  GeglRectangle  cur_rows  = *rect;
+  const gint     nc        = babl_format_get_n_components (format);
+  const gint     row_len   = (3 + rect->width + 3) * nc;
+  const gint     rowstride = row_len * sizeof (gfloat);
+  gint           n_rows    = MIN (IIR_BLOCK_SIZE, rect->height);
+  gfloat        *rows      = g_new (gfloat, n_rows * row_len);
+  gdouble       *tmp       = g_new (gdouble, row_len);
   gint           v;
 
-  cur_row.height = 1;
-
-  for (v = 0; v < rect->height; v++)
+  /* fetch and store blocks of rows, rather than single rows, to reduce the
+   * per-call overhead of accessing the buffer.
+   */
+  for (v = 0; v < rect->height; v += n_rows)
     {
-      const gfloat *iminus;
-      const gfloat *uplus;
+      gint r;
 
-      cur_row.y = rect->y + v;
+      n_rows          = MIN (IIR_BLOCK_SIZE, rect->height - v);
+      cur_rows.y      = rect->y + v;
+      cur_rows.height = n_rows;
 
-      gegl_buffer_get (src, &cur_row, 1.0/(1<<level), format, &row[3 * nc],
-                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gegl_buffer_get (src, &cur_rows, 1.0/(1<<level), format, &rows[3 * nc],
+                       rowstride, GEGL_ABYSS_NONE);
 
-      get_boundaries (policy, row, rect->width, nc, &iminus, &uplus);
-      real_blur_1D (row, tmp, b, m, iminus, uplus, rect->width, nc, policy);
+      for (r = 0; r < n_rows; r++)
+        {
+          gfloat       *row = rows + r * row_len;
+          const gfloat *iminus;
+          const gfloat *uplus;
 
-      gegl_buffer_set (dst, &cur_row, level, format, &row[3 * nc],
-                       GEGL_AUTO_ROWSTRIDE);
+          get_boundaries (policy, row, rect->width, nc, &iminus, &uplus);
+          real_blur_1D (row, tmp, b, m, iminus, uplus, rect->width, nc, policy);
+        }
+
+      gegl_buffer_set (dst, &cur_rows, level, format, &rows[3 * nc],
+                       rowstride);
     }
 
   g_free (tmp);
-  g_free (row);
+  g_free (rows);
 }
 
 static void
-iir_young_ver_blur (IirYoungBlur1dFunc   real_blur_1D,
-                    GeglBuffer          *src,
+iir_young_ver_blur (GeglBuffer          *src,
                     const GeglRectangle *rect,
                     GeglBuffer          *dst,
                     const gdouble       *b,
@@ -652,36 +751,77 @@ iir_young_ver_blur (IirYoungBlur1dFunc   real_blur_1D,
                     const Babl          *format,
                     gint                 level)
 {
-  GeglRectangle  cur_col = *rect;
-  const gint     nc = babl_format_get_n_components (format);
-  gfloat        *col = g_new (gfloat, (3 + rect->height + 3) * nc);
-  gdouble       *tmp = g_new (gdouble, (3 + rect->height + 3) * nc);
-  gint           i;
+  GeglRectangle  cur_cols = *rect;
+  const gint     nc       = babl_format_get_n_components (format);
+  gint           block_size;
+  gint           lanes;
+  gfloat        *cols;
+  gdouble       *tmp;
+  gfloat        *iminus;
+  gfloat        *uplus;
+  gint           x;
+
+  /* limit the size of the intermediate buffer for very tall images */
+  block_size = IIR_MAX_BLOCK_BUFFER /
+               ((3 + rect->height + 3) * nc * sizeof (gdouble));
+  block_size = CLAMP (block_size, 1, IIR_BLOCK_SIZE);
+
+  lanes  = block_size * nc;
+  cols   = g_new (gfloat, rect->height * lanes);
+  tmp    = g_new (gdouble, (3 + rect->height + 3) * lanes);
+  iminus = g_new (gfloat, lanes);
+  uplus  = g_new (gfloat, lanes);
+
+  if (policy != GEGL_ABYSS_CLAMP)
+    {
+      const gfloat *policy_iminus;
+      const gfloat *policy_uplus;
+      gint          l;
 
-  cur_col.width = 1;
+      get_boundaries (policy, NULL, rect->height, nc,
+                      &policy_iminus, &policy_uplus);
 
-  for (i = 0; i < rect->width; i++)
+      for (l = 0; l < lanes; l++)
+        {
+          iminus[l] = policy_iminus[l % nc];
+          uplus[l]  = policy_uplus[l % nc];
+        }
+    }
+
+  /* process blocks of columns aligned to multiples of the block size, so
+   * that they don't straddle tile boundaries.
+   */
+  for (x = rect->x; x < rect->x + rect->width; x += cur_cols.width)
     {
-      const gfloat *iminus;
-      const gfloat *uplus;
+      gint offset = ((x % block_size) + block_size) % block_size;
 
-      cur_col.x = rect->x + i;
+      cur_cols.x     = x;
+      cur_cols.width = MIN (block_size - offset, rect->x + rect->width - x);
+      lanes          = cur_cols.width * nc;
 
-      gegl_buffer_get (src, &cur_col, 1.0/(1<<level), format, &col[3 * nc],
+      gegl_buffer_get (src, &cur_cols, 1.0/(1<<level), format, cols,
                        GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      get_boundaries (policy, col, rect->height, nc, &iminus, &uplus);
-      real_blur_1D (col, tmp, b, m, iminus, uplus, rect->height, nc, policy);
+      if (policy == GEGL_ABYSS_CLAMP)
+        {
+          memcpy (iminus, cols, lanes * sizeof (gfloat));
+          memcpy (uplus, cols + (rect->height - 1) * lanes,
+                  lanes * sizeof (gfloat));
+        }
+
+      iir_young_blur_1D_block (cols, tmp, b, m, iminus, uplus,
+                               rect->height, lanes);
 
-      gegl_buffer_set (dst, &cur_col, level, format, &col[3 * nc],
+      gegl_buffer_set (dst, &cur_cols, level, format, cols,
                        GEGL_AUTO_ROWSTRIDE);
     }
 
+  g_free (uplus);
+  g_free (iminus);
   g_free (tmp);
-  g_free (col);
+  g_free (cols);
 }
 
-
 /**********************************************
  *
  * Finite Impulse Response (FIR)
@@ -1297,7 +1437,7 @@ gegl_gblur_1d_process (GeglOperation       *operation,
       if (o->orientation == GEGL_ORIENTATION_HORIZONTAL)
         iir_young_hor_blur (real_blur_1D, input, result, output, b, m, abyss_policy, format, level);
       else
-        iir_young_ver_blur (real_blur_1D, input, result, output, b, m, abyss_policy, format, level);
+        iir_young_ver_blur (input, result, output, b, m, abyss_policy, format, level);
     }
   else
     {
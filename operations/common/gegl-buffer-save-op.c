@@ -24,6 +24,19 @@
 property_file_path (path, _("File"), "/tmp/gegl-buffer.gegl")
   description (_("Target file path to write GeglBuffer to."))
 
+property_string (compression, _("Compression"), "")
+  description (_("Compression algorithm used for the tiles, as in the "
+                 "swap-compression setting; compressed files can't be read "
+                 "by older versions of GEGL.  An empty string writes "
+                 "uncompressed tiles, in the original file format unless "
+                 "mipmap levels are stored"))
+
+property_int (levels, _("Mipmap levels"), 0)
+  description (_("Number of reduced-resolution levels to store along "
+                 "with the image; files with reduced-resolution levels "
+                 "can't be read by older versions of GEGL"))
+  value_range (0, 8)
+
 #else
 
 #define GEGL_OP_SINK
@@ -41,7 +54,16 @@ gegl_buffer_save_op_process (GeglOperation       *operation,
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
 
-  gegl_buffer_save (input, o->path, result);
+  /* only the newer file format holds reduced-resolution levels */
+  if ((o->compression && *o->compression) || o->levels > 0)
+    {
+      gegl_buffer_save_compressed (input, o->path, result,
+                                   o->compression, o->levels);
+    }
+  else
+    {
+      gegl_buffer_save (input, o->path, result);
+    }
 
   return TRUE;
 }
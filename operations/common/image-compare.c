@@ -69,36 +69,30 @@ get_cached_region (GeglOperation       *operation,
   return *gegl_operation_source_get_bounding_box (operation, "input");
 }
 
-static gboolean
-process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *aux,
-         GeglBuffer          *output,
-         const GeglRectangle *result,
-         gint                 level)
+typedef struct
 {
-  GeglProperties         *props        = GEGL_PROPERTIES (operation);
-  gdouble             max_diff     = 0.0;
-  gdouble             diffsum      = 0.0;
-  gint                wrong_pixels = 0;
-  const Babl         *cielab       = babl_format ("CIE Lab alpha float");
-  const Babl         *srgb         = babl_format ("R'G'B' u8");
-  const Babl         *yadbl        = babl_format ("YA double");
-  GeglBuffer         *diff_buffer;
-  GeglBufferIterator *iter;
-
-  if (aux == NULL)
-    return TRUE;
+  GeglBuffer *input;
+  GeglBuffer *aux;
+  GeglBuffer *diff_buffer;
+  GeglBuffer *output;
+  gdouble     max_diff;
+} ThreadData;
 
-  diff_buffer = gegl_buffer_new (result, yadbl);
+static void
+compare_area (const GeglRectangle *area,
+              ThreadData          *data)
+{
+  const Babl         *cielab = babl_format ("CIE Lab alpha float");
+  const Babl         *yadbl  = babl_format ("YA double");
+  GeglBufferIterator *iter;
 
-  iter = gegl_buffer_iterator_new (diff_buffer, result, 0, yadbl,
+  iter = gegl_buffer_iterator_new (data->diff_buffer, area, 0, yadbl,
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 3);
 
-  gegl_buffer_iterator_add (iter, input, result, 0, cielab,
+  gegl_buffer_iterator_add (iter, data->input, area, 0, cielab,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, aux, result, 0, cielab,
+  gegl_buffer_iterator_add (iter, data->aux, area, 0, cielab,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -121,10 +115,6 @@ process (GeglOperation       *operation,
 
           if (diff >= ERROR_TOLERANCE)
             {
-              wrong_pixels++;
-              diffsum += diff;
-              if (diff > max_diff)
-                max_diff = diff;
               data_out[0] = diff;
               data_out[1] = data_in1[0];
             }
@@ -139,23 +129,33 @@ process (GeglOperation       *operation,
           data_in2 += 4;
         }
     }
+}
 
-  iter  = gegl_buffer_iterator_new (output, result, 0, srgb,
+static void
+visualize_area (const GeglRectangle *area,
+                ThreadData          *data)
+{
+  const Babl         *srgb     = babl_format ("R'G'B' u8");
+  const Babl         *yadbl    = babl_format ("YA double");
+  const gdouble       max_diff = data->max_diff;
+  GeglBufferIterator *iter;
+
+  iter  = gegl_buffer_iterator_new (data->output, area, 0, srgb,
                                     GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, diff_buffer, result, 0, yadbl,
+  gegl_buffer_iterator_add (iter, data->diff_buffer, area, 0, yadbl,
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
     {
       gint     i;
       guchar  *out  = iter->items[0].data;
-      gdouble *data = iter->items[1].data;
+      gdouble *diffs = iter->items[1].data;
 
       for (i = 0; i < iter->length; i++)
         {
-          gdouble diff = data[0];
-          gdouble a = data[1];
+          gdouble diff = diffs[0];
+          gdouble a = diffs[1];
 
           if (diff >= 0.01)
             {
@@ -171,11 +171,69 @@ process (GeglOperation       *operation,
             }
 
           out  += 3;
-          data += 2;
+          diffs += 2;
         }
     }
+}
+
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *aux,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  GeglProperties     *props        = GEGL_PROPERTIES (operation);
+  gdouble             max_diff     = 0.0;
+  gdouble             diffsum      = 0.0;
+  gint                wrong_pixels = 0;
+  const Babl         *yadbl        = babl_format ("YA double");
+  GeglReduction      *reduction;
+  ThreadData          data;
+
+  if (aux == NULL)
+    return TRUE;
+
+  data.input       = input;
+  data.aux         = aux;
+  data.output      = output;
+  data.diff_buffer = gegl_buffer_new (result, yadbl);
+
+  gegl_parallel_distribute_area (
+    result,
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) compare_area,
+    &data);
+
+  /* pixels below the tolerance have a zero difference, so a single histogram
+   * bin starting at the tolerance counts the wrong pixels.
+   */
+  reduction = gegl_reduction_new (yadbl, 1, ERROR_TOLERANCE, G_MAXDOUBLE);
+
+  gegl_reduction_add_buffer (reduction, data.diff_buffer, result, 0);
+
+  wrong_pixels = gegl_reduction_get_histogram (reduction, 0, NULL)[0];
+
+  if (gegl_reduction_get_n_pixels (reduction) > 0)
+    {
+      diffsum  = gegl_reduction_get_sum (reduction, 0);
+      max_diff = gegl_reduction_get_max (reduction, 0);
+    }
+
+  gegl_reduction_free (reduction);
+
+  data.max_diff = max_diff;
+
+  gegl_parallel_distribute_area (
+    result,
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) visualize_area,
+    &data);
 
-  g_object_unref (diff_buffer);
+  g_object_unref (data.diff_buffer);
 
   props->wrong_pixels   = wrong_pixels;
   props->max_diff       = max_diff;
@@ -72,6 +72,14 @@ property_boolean (high_precision, _("High precision"), FALSE)
 #define MAX_CHUNK_WIDTH  128
 #define MAX_CHUNK_HEIGHT 128
 
+/* square neighborhoods of at least this radius use column histograms, whose
+ * per-pixel cost doesn't depend on the radius.
+ */
+#define CONSTANT_TIME_MIN_RADIUS 16
+#define FINE_BITS                4
+#define N_FINE_BINS              (1 << FINE_BITS)
+#define N_COARSE_BINS            (DEFAULT_N_BINS >> FINE_BITS)
+
 #define SAFE_CLAMP(x, min, max) ((x) > (min) ? (x) < (max) ? (x) : (max) : (min))
 
 static gfloat        default_bin_values[DEFAULT_N_BINS];
@@ -93,6 +101,8 @@ typedef struct
 typedef struct
 {
   gint   *bins;
+  gint   *coarse_bins;
+  gint    coarse_shift;
   gfloat *bin_values;
   gint    last_median;
   gint    last_median_sum;
@@ -134,7 +144,53 @@ histogram_get_median (Histogram *hist,
   count = (gint) ceil (count * percentile);
   count = MAX (count, 1);
 
-  if (sum < count)
+  if (comp->coarse_bins)
+    {
+      /* with many bins, the median can be far away from the last one; skip
+       * over whole coarse bins when possible.
+       */
+      const gint shift = comp->coarse_shift;
+      const gint mask  = (1 << shift) - 1;
+
+      if (sum < count)
+        {
+          while ((i & mask) != mask)
+            {
+              if ((sum += comp->bins[++i]) >= count)
+                goto done;
+            }
+
+          while (sum + comp->coarse_bins[(i >> shift) + 1] < count)
+            {
+              sum += comp->coarse_bins[(i >> shift) + 1];
+              i   += 1 << shift;
+            }
+
+          while ((sum += comp->bins[++i]) < count);
+        }
+      else
+        {
+          do
+            {
+              if ((sum -= comp->bins[i--]) < count)
+                {
+                  sum += comp->bins[++i];
+                  goto done;
+                }
+            }
+          while ((i & mask) != mask);
+
+          while (sum - comp->coarse_bins[i >> shift] >= count)
+            {
+              sum -= comp->coarse_bins[i >> shift];
+              i   -= 1 << shift;
+            }
+
+          while ((sum -= comp->bins[i--]) >= count);
+          sum += comp->bins[++i];
+        }
+    }
+  else if (sum < count)
     {
       while ((sum += comp->bins[++i]) < count);
     }
@@ -144,6 +200,7 @@ histogram_get_median (Histogram *hist,
       sum += comp->bins[++i];
     }
 
+done:
   comp->last_median     = i;
   comp->last_median_sum = sum;
 
@@ -169,6 +226,8 @@ histogram_modify_val (Histogram    *hist,
       gint                bin  = src[c];
 
       comp->bins[bin] += alpha;
+      if (comp->coarse_bins)
+        comp->coarse_bins[bin >> comp->coarse_shift] += alpha;
 
       /* this is shorthand for:
        *
@@ -186,6 +245,8 @@ histogram_modify_val (Histogram    *hist,
       gint                bin  = src[n_color_components];
 
       comp->bins[bin] += diff;
+      if (comp->coarse_bins)
+        comp->coarse_bins[bin >> comp->coarse_shift] += diff;
 
       comp->last_median_sum += (bin <= comp->last_median) * diff;
     }
@@ -604,6 +665,18 @@ convert_values_to_bins (Histogram *hist,
 
           hist->components[c].bins       = g_new0 (gint, bin + 1);
           hist->components[c].bin_values = bin_values;
+
+          /* add a coarse level, of about sqrt (n_bins) bins of about
+           * sqrt (n_bins) values each, to speed up the percentile search.
+           */
+          if (bin + 1 > DEFAULT_N_BINS)
+            {
+              gint shift = (g_bit_storage (bin) + 1) / 2;
+
+              hist->components[c].coarse_bins  = g_new0 (gint,
+                                                         (bin >> shift) + 1);
+              hist->components[c].coarse_shift = shift;
+            }
         }
 
       g_free (scratch);
@@ -759,6 +832,249 @@ get_abyss_policy (GeglOperation *operation,
   g_return_val_if_reached (GEGL_ABYSS_NONE);
 }
 
+/* the constant-time path (Perreault and Hébert, "Median Filtering in
+ * Constant Time"): every column of the source keeps a histogram of the
+ * 2 * radius + 1 pixels it contributes to the current row of the kernel, so
+ * that moving down a row updates each column with two pixels, and moving
+ * right updates the kernel histogram with two columns.  the histograms are
+ * split into coarse and fine levels; the kernel only keeps the coarse level
+ * current, and brings the fine bins of a coarse bin up to date when the
+ * percentile search needs them.
+ */
+
+static inline void
+column_modify_val (gint         *fine,
+                   gint         *coarse,
+                   gint         *count,
+                   const gint32 *src,
+                   const gint   *alpha_values,
+                   gint          diff,
+                   gint          n_color_components,
+                   gboolean      has_alpha)
+{
+  gint alpha = diff;
+  gint c;
+
+  if (has_alpha)
+    alpha *= alpha_values[src[n_color_components]];
+
+  for (c = 0; c < n_color_components; c++)
+    {
+      fine[c * DEFAULT_N_BINS + src[c]]               += alpha;
+      coarse[c * N_COARSE_BINS + (src[c] >> FINE_BITS)] += alpha;
+    }
+
+  if (has_alpha)
+    {
+      fine[c * DEFAULT_N_BINS + src[c]]               += diff;
+      coarse[c * N_COARSE_BINS + (src[c] >> FINE_BITS)] += diff;
+    }
+
+  *count += alpha;
+}
+
+static inline gfloat
+kernel_get_percentile (const gint *column_fine,
+                       gint        n_components,
+                       gint        component,
+                       gint        size,
+                       gint        x,
+                       const gint *coarse,
+                       gint       *fine,
+                       gint       *fine_x,
+                       gint        count,
+                       gdouble     percentile)
+{
+  gint *bins;
+  gint  sum = 0;
+  gint  b   = 0;
+  gint  i;
+  gint  j;
+
+  if (count == 0)
+    return 0.0f;
+
+  count = (gint) ceil (count * percentile);
+  count = MAX (count, 1);
+
+  while (sum + coarse[b] < count)
+    sum += coarse[b++];
+
+  bins = fine + b * N_FINE_BINS;
+
+  /* bring the fine bins from the last position at which they were used up
+   * to date, or recompute them when that's cheaper.
+   */
+  if (fine_x[b] < 0 || 2 * (x - fine_x[b]) > size)
+    {
+      memset (bins, 0, N_FINE_BINS * sizeof (gint));
+
+      for (j = x; j < x + size; j++)
+        {
+          const gint *col = column_fine +
+                            (j * n_components + component) * DEFAULT_N_BINS +
+                            b * N_FINE_BINS;
+
+          for (i = 0; i < N_FINE_BINS; i++)
+            bins[i] += col[i];
+        }
+    }
+  else
+    {
+      for (j = fine_x[b]; j < x; j++)
+        {
+          const gint *col_out = column_fine +
+                                (j * n_components + component) *
+                                DEFAULT_N_BINS + b * N_FINE_BINS;
+          const gint *col_in  = col_out +
+                                size * n_components * DEFAULT_N_BINS;
+
+          for (i = 0; i < N_FINE_BINS; i++)
+            bins[i] += col_in[i] - col_out[i];
+        }
+    }
+
+  fine_x[b] = x;
+
+  i = 0;
+  while ((sum += bins[i]) < count)
+    i++;
+
+  return default_bin_values[b * N_FINE_BINS + i];
+}
+
+static void
+median_constant_time (Histogram    *hist,
+                      const gint32 *src,
+                      gint          src_width,
+                      gfloat       *dst,
+                      gint          dst_width,
+                      gint          dst_height,
+                      gint          radius,
+                      gdouble       percentile,
+                      gdouble       alpha_percentile)
+{
+  const gint      n_components       = hist->n_components;
+  const gint      n_color_components = hist->n_color_components;
+  const gboolean  has_alpha          = n_color_components < n_components;
+  const gint      size               = 2 * radius + 1;
+  const gint      src_stride         = src_width * n_components;
+  const gint      col_fine_size      = n_components * DEFAULT_N_BINS;
+  const gint      col_coarse_size    = n_components * N_COARSE_BINS;
+  gint           *column_fine;
+  gint           *column_coarse;
+  gint           *column_count;
+  gint            coarse[4 * N_COARSE_BINS];
+  gint            fine[4 * DEFAULT_N_BINS];
+  gint            fine_x[4 * N_COARSE_BINS];
+  gint            count;
+  gint            x;
+  gint            y;
+  gint            i;
+  gint            c;
+
+  column_fine   = g_new0 (gint, src_width * col_fine_size);
+  column_coarse = g_new0 (gint, src_width * col_coarse_size);
+  column_count  = g_new0 (gint, src_width);
+
+  for (y = 0; y < size - 1; y++)
+    {
+      for (x = 0; x < src_width; x++)
+        {
+          column_modify_val (column_fine   + x * col_fine_size,
+                             column_coarse + x * col_coarse_size,
+                             column_count  + x,
+                             src + y * src_stride + x * n_components,
+                             hist->alpha_values, +1,
+                             n_color_components, has_alpha);
+        }
+    }
+
+  for (y = 0; y < dst_height; y++)
+    {
+      if (y > 0)
+        {
+          const gint32 *row_out = src + (y - 1) * src_stride;
+
+          for (x = 0; x < src_width; x++)
+            {
+              column_modify_val (column_fine   + x * col_fine_size,
+                                 column_coarse + x * col_coarse_size,
+                                 column_count  + x,
+                                 row_out + x * n_components,
+                                 hist->alpha_values, -1,
+                                 n_color_components, has_alpha);
+            }
+        }
+
+      for (x = 0; x < src_width; x++)
+        {
+          const gint32 *row_in = src + (y + size - 1) * src_stride;
+
+          column_modify_val (column_fine   + x * col_fine_size,
+                             column_coarse + x * col_coarse_size,
+                             column_count  + x,
+                             row_in + x * n_components,
+                             hist->alpha_values, +1,
+                             n_color_components, has_alpha);
+        }
+
+      memset (coarse, 0, sizeof (coarse));
+      count = 0;
+
+      for (x = 0; x < size; x++)
+        {
+          for (i = 0; i < col_coarse_size; i++)
+            coarse[i] += column_coarse[x * col_coarse_size + i];
+
+          count += column_count[x];
+        }
+
+      for (i = 0; i < col_coarse_size; i++)
+        fine_x[i] = -1;
+
+      for (x = 0; x < dst_width; x++)
+        {
+          if (x > 0)
+            {
+              const gint *col_out = column_coarse + (x - 1)        * col_coarse_size;
+              const gint *col_in  = column_coarse + (x + size - 1) * col_coarse_size;
+
+              for (i = 0; i < col_coarse_size; i++)
+                coarse[i] += col_in[i] - col_out[i];
+
+              count += column_count[x + size - 1] - column_count[x - 1];
+            }
+
+          for (c = 0; c < n_color_components; c++)
+            {
+              dst[c] = kernel_get_percentile (column_fine, n_components, c,
+                                              size, x,
+                                              coarse + c * N_COARSE_BINS,
+                                              fine   + c * DEFAULT_N_BINS,
+                                              fine_x + c * N_COARSE_BINS,
+                                              count, percentile);
+            }
+
+          if (has_alpha)
+            {
+              dst[c] = kernel_get_percentile (column_fine, n_components, c,
+                                              size, x,
+                                              coarse + c * N_COARSE_BINS,
+                                              fine   + c * DEFAULT_N_BINS,
+                                              fine_x + c * N_COARSE_BINS,
+                                              size * size, alpha_percentile);
+            }
+
+          dst += n_components;
+        }
+    }
+
+  g_free (column_count);
+  g_free (column_coarse);
+  g_free (column_fine);
+}
+
 static gboolean
 process (GeglOperation       *operation,
          GeglBuffer          *input,
@@ -853,93 +1169,104 @@ process (GeglOperation       *operation,
                    GEGL_AUTO_ROWSTRIDE, get_abyss_policy (operation, "input"));
   convert_values_to_bins (hist, src_buf, n_src_pixels, data->quantize);
 
-  src = src_buf + radius * (src_rect.width + 1) * n_components;
-  dst = dst_buf;
+  if (data->quantize &&
+      o->neighborhood == GEGL_MEDIAN_BLUR_NEIGHBORHOOD_SQUARE &&
+      radius >= CONSTANT_TIME_MIN_RADIUS)
+    {
+      median_constant_time (hist, src_buf, src_rect.width,
+                            dst_buf, roi->width, roi->height,
+                            radius, percentile, alpha_percentile);
+    }
+  else
+    {
+      src = src_buf + radius * (src_rect.width + 1) * n_components;
+      dst = dst_buf;
 
-  /* compute the first window */
+      /* compute the first window */
 
-  for (i = -radius; i <= radius; i++)
-    {
-      histogram_modify_vals (hist, src, src_stride,
-                             i, -neighborhood_outline[abs (i)],
-                             i, +neighborhood_outline[abs (i)],
-                             +1);
+      for (i = -radius; i <= radius; i++)
+        {
+          histogram_modify_vals (hist, src, src_stride,
+                                 i, -neighborhood_outline[abs (i)],
+                                 i, +neighborhood_outline[abs (i)],
+                                 +1);
 
-      hist->size += 2 * neighborhood_outline[abs (i)] + 1;
-    }
+          hist->size += 2 * neighborhood_outline[abs (i)] + 1;
+        }
 
-  for (c = 0; c < n_color_components; c++)
-    dst[c] = histogram_get_median (hist, c, percentile);
-  if (has_alpha)
-    dst[c] = histogram_get_median (hist, c, alpha_percentile);
+      for (c = 0; c < n_color_components; c++)
+        dst[c] = histogram_get_median (hist, c, percentile);
+      if (has_alpha)
+        dst[c] = histogram_get_median (hist, c, alpha_percentile);
 
-  dst_x = 0;
-  dst_y = 0;
+      dst_x = 0;
+      dst_y = 0;
 
-  n_dst_pixels--;
-  dir = LEFT_TO_RIGHT;
+      n_dst_pixels--;
+      dir = LEFT_TO_RIGHT;
 
-  while (n_dst_pixels--)
-    {
-      /* move the src coords based on current direction and positions */
-      if (dir == LEFT_TO_RIGHT)
+      while (n_dst_pixels--)
         {
-          if (dst_x != roi->width - 1)
-            {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-            }
-          else
+          /* move the src coords based on current direction and positions */
+          if (dir == LEFT_TO_RIGHT)
             {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
-            }
-        }
-      else if (dir == TOP_TO_BOTTOM)
-        {
-          if (dst_x == 0)
-            {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-              dir = LEFT_TO_RIGHT;
-            }
-          else
-            {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
-              dir = RIGHT_TO_LEFT;
+              if (dst_x != roi->width - 1)
+                {
+                  dst_x++;
+                  src += n_components;
+                  dst += n_components;
+                }
+              else
+                {
+                  dst_y++;
+                  src += src_stride;
+                  dst += dst_stride;
+                  dir = TOP_TO_BOTTOM;
+                }
             }
-        }
-      else if (dir == RIGHT_TO_LEFT)
-        {
-          if (dst_x != 0)
+          else if (dir == TOP_TO_BOTTOM)
             {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
+              if (dst_x == 0)
+                {
+                  dst_x++;
+                  src += n_components;
+                  dst += n_components;
+                  dir = LEFT_TO_RIGHT;
+                }
+              else
+                {
+                  dst_x--;
+                  src -= n_components;
+                  dst -= n_components;
+                  dir = RIGHT_TO_LEFT;
+                }
             }
-          else
+          else if (dir == RIGHT_TO_LEFT)
             {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
+              if (dst_x != 0)
+                {
+                  dst_x--;
+                  src -= n_components;
+                  dst -= n_components;
+                }
+              else
+                {
+                  dst_y++;
+                  src += src_stride;
+                  dst += dst_stride;
+                  dir = TOP_TO_BOTTOM;
+                }
             }
-        }
 
-      histogram_update (hist, src, src_stride,
-                        o->neighborhood, radius, neighborhood_outline,
-                        dir);
+          histogram_update (hist, src, src_stride,
+                            o->neighborhood, radius, neighborhood_outline,
+                            dir);
 
-      for (c = 0; c < n_color_components; c++)
-        dst[c] = histogram_get_median (hist, c, percentile);
-      if (has_alpha)
-        dst[c] = histogram_get_median (hist, c, alpha_percentile);
+          for (c = 0; c < n_color_components; c++)
+            dst[c] = histogram_get_median (hist, c, percentile);
+          if (has_alpha)
+            dst[c] = histogram_get_median (hist, c, alpha_percentile);
+        }
     }
 
   gegl_buffer_set (output, roi, 0, format, dst_buf, GEGL_AUTO_ROWSTRIDE);
@@ -947,6 +1274,7 @@ process (GeglOperation       *operation,
   for (c = 0; c < n_components; c++)
     {
       g_free (hist->components[c].bins);
+      g_free (hist->components[c].coarse_bins);
 
       if (! data->quantize)
         g_free (hist->components[c].bin_values);
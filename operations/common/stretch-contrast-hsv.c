@@ -40,61 +40,73 @@ typedef struct {
   gfloat vdiff;
 } AutostretchData;
 
+typedef struct {
+  GeglBuffer      *input;
+  GeglBuffer      *output;
+  const Babl      *format;
+  gint             level;
+  AutostretchData  stretch;
+} ThreadData;
+
 static void
 buffer_get_auto_stretch_data (GeglOperation       *operation,
                               GeglBuffer          *buffer,
                               const GeglRectangle *result,
+                              gint                 level,
                               AutostretchData     *data,
-                              const Babl          *space)
+                              const Babl          *format)
 {
-  gfloat smin =  G_MAXFLOAT;
-  gfloat smax = -G_MAXFLOAT;
-  gfloat vmin =  G_MAXFLOAT;
-  gfloat vmax = -G_MAXFLOAT;
-
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
+  GeglReduction *reduction;
 
   gegl_operation_progress (operation, 0.0, "");
 
-  gi = gegl_buffer_iterator_new (buffer, result, 0, babl_format_with_space ("HSVA float", space),
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  reduction = gegl_reduction_new (format, 0, 0.0, 0.0);
 
-  while (gegl_buffer_iterator_next (gi))
+  gegl_reduction_add_buffer (reduction, buffer, result, level);
+
+  if (data)
     {
-      gfloat *buf = gi->items[0].data;
-      gint    i;
+      data->slo   = gegl_reduction_get_min (reduction, 1);
+      data->sdiff = gegl_reduction_get_max (reduction, 1) - data->slo;
+      data->vlo   = gegl_reduction_get_min (reduction, 2);
+      data->vdiff = gegl_reduction_get_max (reduction, 2) - data->vlo;
+    }
 
-      for (i = 0; i < gi->length; i++)
-        {
-          gfloat sval = buf[1];
-          gfloat vval = buf[2];
+  gegl_reduction_free (reduction);
 
-          smin = MIN (sval, smin);
-          smax = MAX (sval, smax);
-          vmin = MIN (vval, vmin);
-          vmax = MAX (vval, vmax);
+  gegl_operation_progress (operation, 0.5, "");
+}
 
-          buf += 4;
-        }
+static void
+autostretch_area (const GeglRectangle *area,
+                  ThreadData          *data)
+{
+  GeglBufferIterator    *gi;
+  const AutostretchData *stretch = &data->stretch;
 
-      done_pixels += gi->length;
+  gi = gegl_buffer_iterator_new (data->input, area, data->level, data->format,
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
 
-      gegl_operation_progress (operation,
-                               (gdouble) 0.5 * done_pixels /
-                               (gdouble) (result->width * result->height),
-                               "");
-    }
+  gegl_buffer_iterator_add (gi, data->output, area, data->level, data->format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  if (data)
+  while (gegl_buffer_iterator_next (gi))
     {
-      data->slo   = smin;
-      data->sdiff = smax - smin;
-      data->vlo   = vmin;
-      data->vdiff = vmax - vmin;
-    }
+      gfloat *in  = gi->items[0].data;
+      gfloat *out = gi->items[1].data;
+      gint    i;
 
-  gegl_operation_progress (operation, 0.5, "");
+      for (i = 0; i < gi->length; i++)
+        {
+          out[0] = in[0]; /* Keep hue */
+          out[1] = (in[1] - stretch->slo) / stretch->sdiff;
+          out[2] = (in[2] - stretch->vlo) / stretch->vdiff;
+          out[3] = in[3]; /* Keep alpha */
+
+          in  += 4;
+          out += 4;
+        }
+    }
 }
 
 static void
@@ -154,48 +166,36 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  const Babl *space = gegl_operation_get_format (operation, "output");
-  AutostretchData     data;
-  GeglBufferIterator *gi;
-  gint                done_pixels = 0;
-
-  buffer_get_auto_stretch_data (operation, input, result, &data, space);
-  clean_autostretch_data (&data);
+  const Babl    *format        = gegl_operation_get_format (operation, "output");
+  GeglRectangle  scaled_result = *result;
+  ThreadData     data;
 
-  gegl_operation_progress (operation, 0.5, "");
-
-  gi = gegl_buffer_iterator_new (input, result, 0, babl_format_with_space ("HSVA float", space),
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+  buffer_get_auto_stretch_data (operation, input, result, level,
+                                &data.stretch, format);
+  clean_autostretch_data (&data.stretch);
 
-  gegl_buffer_iterator_add (gi, output, result, 0, babl_format_with_space ("HSVA float", space),
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-  while (gegl_buffer_iterator_next (gi))
+  if (level)
     {
-      gfloat *in  = gi->items[0].data;
-      gfloat *out = gi->items[1].data;
-      gint    i;
-
-      for (i = 0; i < gi->length; i++)
-        {
-          out[0] = in[0]; /* Keep hue */
-          out[1] = (in[1] - data.slo) / data.sdiff;
-          out[2] = (in[2] - data.vlo) / data.vdiff;
-          out[3] = in[3]; /* Keep alpha */
-
-          in  += 4;
-          out += 4;
-        }
-
-      done_pixels += gi->length;
-
-      gegl_operation_progress (operation,
-                               0.5 +
-                               (gdouble) 0.5 * done_pixels /
-                               (gdouble) (result->width * result->height),
-                               "");
+      scaled_result.x      = result->x >> level;
+      scaled_result.y      = result->y >> level;
+      scaled_result.width  = ((result->x + result->width)  >> level) -
+                             scaled_result.x;
+      scaled_result.height = ((result->y + result->height) >> level) -
+                             scaled_result.y;
     }
 
+  data.input  = input;
+  data.output = output;
+  data.format = format;
+  data.level  = level;
+
+  gegl_parallel_distribute_area (
+    &scaled_result,
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) autostretch_area,
+    &data);
+
   gegl_operation_progress (operation, 1.0, "");
 
   return TRUE;
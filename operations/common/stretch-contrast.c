@@ -36,34 +36,67 @@ property_boolean (perceptual, _("Non-linear components"), FALSE)
 
 #include "gegl-op.h"
 
+typedef struct
+{
+  GeglBuffer *input;
+  GeglBuffer *output;
+  const Babl *format;
+  gint        level;
+  gfloat      min[3];
+  gfloat      diff[3];
+} StretchData;
+
 static void
 buffer_get_min_max (GeglBuffer *buffer,
                     const Babl *format,
+                    gint        level,
                     gfloat     *min,
                     gfloat     *max)
 {
-  GeglBufferIterator *gi;
-  gint c;
-  gi = gegl_buffer_iterator_new (buffer, NULL, 0, format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  GeglReduction *reduction;
+  gint           c;
+
+  reduction = gegl_reduction_new (format, 0, 0.0, 0.0);
+
+  gegl_reduction_add_buffer (reduction, buffer, NULL, level);
+
   for (c = 0; c < 3; c++)
     {
-      min[c] =  G_MAXFLOAT;
-      max[c] = -G_MAXFLOAT;
+      min[c] = MAX (gegl_reduction_get_min (reduction, c), -G_MAXFLOAT);
+      max[c] = MIN (gegl_reduction_get_max (reduction, c),  G_MAXFLOAT);
     }
 
+  gegl_reduction_free (reduction);
+}
+
+static void
+stretch_area (const GeglRectangle *area,
+              StretchData         *data)
+{
+  GeglBufferIterator *gi;
+  gint                c;
+
+  gi = gegl_buffer_iterator_new (data->input, area, data->level, data->format,
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+
+  gegl_buffer_iterator_add (gi, data->output, area, data->level, data->format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
   while (gegl_buffer_iterator_next (gi))
     {
-      gfloat *buf = gi->items[0].data;
+      gfloat *in  = gi->items[0].data;
+      gfloat *out = gi->items[1].data;
 
-      gint i;
-      for (i = 0; i < gi->length; i++)
+      gint o;
+      for (o = 0; o < gi->length; o++)
         {
           for (c = 0; c < 3; c++)
-            {
-              min[c] = MIN (buf [i * 4 + c], min[c]);
-              max[c] = MAX (buf [i * 4 + c], max[c]);
-            }
+            out[c] = (in[c] - data->min[c]) / data->diff[c];
+
+          out[3] = in[3];
+
+          in  += 4;
+          out += 4;
         }
     }
 }
@@ -468,59 +501,62 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  const Babl *out_format = gegl_operation_get_format (operation, "output");
-  gfloat  min[3], max[3], diff[3];
-  GeglBufferIterator *gi;
-  GeglProperties         *o;
-  gint                c;
-
-  if (gegl_cl_is_accelerated ())
+  const Babl     *out_format = gegl_operation_get_format (operation, "output");
+  gfloat          min[3], max[3];
+  GeglRectangle   scaled_result = *result;
+  StretchData     data;
+  GeglProperties *o;
+  gint            c;
+
+  if (gegl_cl_is_accelerated () && level == 0)
     if (cl_process (operation, input, output, result))
       return TRUE;
 
   o = GEGL_PROPERTIES (operation);
 
-  buffer_get_min_max (input, out_format, min, max);
+  /* at level > 0 the extremes are estimated from the input's mipmap, which
+   * is what a preview shows anyway.
+   */
+  buffer_get_min_max (input, out_format, level, min, max);
 
   if (o->keep_colors)
     reduce_min_max_global (min, max);
 
   for (c = 0; c < 3; c++)
     {
-      diff[c] = max[c] - min[c];
+      data.min[c]  = min[c];
+      data.diff[c] = max[c] - min[c];
 
       /* Avoid a divide by zero error if the image is a solid color */
-      if (diff[c] < 1e-3)
+      if (data.diff[c] < 1e-3)
         {
-          min[c]  = 0.0;
-          diff[c] = 1.0;
+          data.min[c]  = 0.0;
+          data.diff[c] = 1.0;
         }
     }
 
-  gi = gegl_buffer_iterator_new (input, result, 0, out_format,
-                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
-
-  gegl_buffer_iterator_add (gi, output, result, 0, out_format,
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-  while (gegl_buffer_iterator_next (gi))
+  if (level)
     {
-      gfloat *in  = gi->items[0].data;
-      gfloat *out = gi->items[1].data;
-
-      gint o;
-      for (o = 0; o < gi->length; o++)
-        {
-          for (c = 0; c < 3; c++)
-            out[c] = (in[c] - min[c]) / diff[c];
-
-          out[3] = in[3];
-
-          in  += 4;
-          out += 4;
-        }
+      scaled_result.x      = result->x >> level;
+      scaled_result.y      = result->y >> level;
+      scaled_result.width  = ((result->x + result->width)  >> level) -
+                             scaled_result.x;
+      scaled_result.height = ((result->y + result->height) >> level) -
+                             scaled_result.y;
     }
 
+  data.input  = input;
+  data.output = output;
+  data.format = out_format;
+  data.level  = level;
+
+  gegl_parallel_distribute_area (
+    &scaled_result,
+    gegl_operation_get_pixels_per_thread (operation),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) stretch_area,
+    &data);
+
   return TRUE;
 }
 
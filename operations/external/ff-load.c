@@ -61,10 +61,13 @@ property_audio_fragment (audio, _("audio"), 0)
 #include <errno.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
 
 #include <libavutil/channel_layout.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libswscale/swscale.h>
@@ -98,12 +101,41 @@ typedef struct
   AVCodecContext  *audio_ctx;
   const AVCodec   *video_codec;
   AVFrame         *lavc_frame;
-  AVFrame         *rgb_frame;
   glong            prevframe;      /* previously decoded frame number */
   gdouble          prevpts;        /* timestamp in seconds of last decoded frame */
 
+  struct SwsContext **sws_contexts; /* colour conversion context per band */
+  gint             n_sws_contexts;
+
+  int64_t         *keyframes;      /* sorted keyframe timestamps, in the video
+                                      stream's time base */
+  gint             n_keyframes;
 } Priv;
 
+/* the on-disk cache of the keyframe index of a file */
+#define INDEX_MAGIC   "GFFI"
+#define INDEX_VERSION 1
+
+typedef struct
+{
+  gchar   magic[4];
+  guint32 version;
+  gint64  file_size;     /* size and modification time of the indexed file */
+  gint64  file_mtime;
+  gint32  n_frames;
+  gint32  n_keyframes;   /* followed by n_keyframes timestamps */
+} IndexHeader;
+
+/* colour conversion is split into bands of rows, which are multiples of
+ * CONVERT_ALIGN, to stay aligned with subsampled chroma rows and with
+ * swscale's dither patterns, and which are converted with CONVERT_MARGIN
+ * rows of context above and below, so that the vertical chroma
+ * interpolation matches converting the whole frame at once.
+ */
+#define CONVERT_ALIGN      8
+#define CONVERT_MARGIN     8
+#define CONVERT_MIN_ROWS  64
+
 static void
 print_error (const char *filename, int err)
 {
@@ -151,15 +183,23 @@ ff_cleanup (GeglProperties *o)
         avformat_close_input(&p->video_fcontext);
       if (p->audio_fcontext)
         avformat_close_input(&p->audio_fcontext);
-      if (p->rgb_frame)
-        av_free (p->rgb_frame);
       if (p->lavc_frame)
         av_free (p->lavc_frame);
+      if (p->sws_contexts)
+        {
+          gint i;
+
+          for (i = 0; i < p->n_sws_contexts; i++)
+            sws_freeContext (p->sws_contexts[i]);
+          g_clear_pointer (&p->sws_contexts, g_free);
+          p->n_sws_contexts = 0;
+        }
+      g_clear_pointer (&p->keyframes, g_free);
+      p->n_keyframes = 0;
 
       p->video_fcontext = NULL;
       p->audio_fcontext = NULL;
       p->lavc_frame = NULL;
-      p->rgb_frame = NULL;
       p->loadedfilename = NULL;
     }
 }
@@ -319,6 +359,89 @@ decode_audio (GeglOperation *operation,
   return 0;
 }
 
+/* converts a timestamp of the video stream to a frame number */
+static glong
+frame_of_timestamp (GeglProperties *o,
+                    int64_t         ts)
+{
+  Priv *p = (Priv*)o->user_data;
+
+  return roundf ((ts - p->first_dts) * av_q2d (p->video_stream->time_base) *
+                 o->frame_rate);
+}
+
+/* returns the index of the last keyframe at or before frame, or -1 */
+static gint
+lookup_keyframe (GeglProperties *o,
+                 glong           frame)
+{
+  Priv *p  = (Priv*)o->user_data;
+  gint  lo = 0;
+  gint  hi = p->n_keyframes;
+
+  while (lo < hi)
+    {
+      gint mid = (lo + hi) / 2;
+
+      if (frame_of_timestamp (o, p->keyframes[mid]) <= frame)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo - 1;
+}
+
+/* decodes the next frame of the video stream into p->lavc_frame, draining
+ * the decoder at the end of the stream.
+ */
+static int
+decode_next_frame (GeglProperties *o)
+{
+  Priv *p = (Priv*)o->user_data;
+
+  while (TRUE)
+    {
+      AVPacket  pkt = {0,};
+      int       ret;
+
+      ret = avcodec_receive_frame (p->video_ctx, p->lavc_frame);
+      if (ret == 0)
+        return 0;
+      else if (ret != AVERROR(EAGAIN))
+        return -1;
+
+      /* the decoder needs more input */
+      do
+        {
+          av_packet_unref (&pkt);
+          if (av_read_frame (p->video_fcontext, &pkt) < 0)
+            {
+              av_packet_unref (&pkt);
+              /* end of stream, flush the frames still held by the decoder,
+               * or its threads
+               */
+              if (avcodec_send_packet (p->video_ctx, NULL) < 0)
+                return -1;
+              break;
+            }
+        }
+      while (pkt.stream_index != p->video_index);
+
+      if (pkt.data)
+        {
+          ret = avcodec_send_packet (p->video_ctx, &pkt);
+          av_packet_unref (&pkt);
+          if (ret < 0)
+            {
+              fprintf (stderr, "avcodec_send_packet failed for %s\n",
+                       o->path);
+              return -1;
+            }
+        }
+    }
+}
+
 static int
 decode_frame (GeglOperation *operation,
               glong          frame)
@@ -344,10 +467,30 @@ decode_frame (GeglOperation *operation,
   decodeframe = frame;
   if (p->video_stream)
   {
+  gint     keyframe  = lookup_keyframe (o, frame);
+  gboolean seek;
 
-  if (frame < 2 || frame > prevframe + 64 || frame < prevframe )
+  if (keyframe >= 0)
+    {
+      /* seek unless we can decode forward within the current group of
+       * pictures.
+       */
+      seek = prevframe < 0 || frame < prevframe ||
+             frame_of_timestamp (o, p->keyframes[keyframe]) > prevframe;
+    }
+  else
+    {
+      seek = frame < 2 || frame > prevframe + 64 || frame < prevframe;
+    }
+
+  if (seek)
   {
-    int64_t seek_target = av_rescale_q (((frame) * AV_TIME_BASE * 1.0) / o->frame_rate
+    int64_t seek_target;
+
+    if (keyframe >= 0)
+      seek_target = p->keyframes[keyframe];
+    else
+      seek_target = av_rescale_q (((frame) * AV_TIME_BASE * 1.0) / o->frame_rate
 , AV_TIME_BASE_Q, p->video_stream->time_base) / p->video_ctx->ticks_per_frame;
 
     if (av_seek_frame (p->video_fcontext, p->video_index, seek_target, (AVSEEK_FLAG_BACKWARD )) < 0)
@@ -356,86 +499,201 @@ decode_frame (GeglOperation *operation,
       avcodec_flush_buffers (p->video_ctx);
 
     prevframe = -1;
+    decodeframe = -1;
   }
 
   do
     {
-      int       got_picture = 0;
-      do
+      int64_t ts;
+
+      if (decode_next_frame (o) < 0)
+        return -1;
+
+      ts = p->lavc_frame->best_effort_timestamp;
+
+      /* use the frame's own timestamp, rather than the one of the last
+       * packet sent, which differs when the decoder delays frames.
+       */
+      if (ts != AV_NOPTS_VALUE)
+        p->prevpts = (ts - p->first_dts) * av_q2d (p->video_stream->time_base);
+      else
+        p->prevpts += 1.0 / o->frame_rate;
+      decodeframe = roundf (p->prevpts * o->frame_rate);
+    }
+    while (decodeframe < frame + p->codec_delay);
+  }
+
+  p->prevframe = frame;
+  return 0;
+}
+
+static gchar *
+index_cache_path (const gchar *path)
+{
+  gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+  gchar *name     = g_strconcat (checksum, ".index", NULL);
+  gchar *result   = g_build_filename (g_get_user_cache_dir (),
+                                      GEGL_LIBRARY,
+                                      "ff-load",
+                                      name,
+                                      NULL);
+
+  g_free (name);
+  g_free (checksum);
+
+  return result;
+}
+
+static gboolean
+load_index (GeglProperties *o,
+            const gchar    *cache_path,
+            GStatBuf       *stat_buf)
+{
+  Priv        *p    = (Priv*)o->user_data;
+  gchar       *data = NULL;
+  gsize        length;
+  IndexHeader  header;
+
+  if (! g_file_get_contents (cache_path, &data, &length, NULL))
+    return FALSE;
+
+  if (length < sizeof (IndexHeader))
+    {
+      g_free (data);
+      return FALSE;
+    }
+
+  memcpy (&header, data, sizeof (IndexHeader));
+
+  if (memcmp (header.magic, INDEX_MAGIC, 4)      ||
+      header.version    != INDEX_VERSION         ||
+      header.file_size  != stat_buf->st_size     ||
+      header.file_mtime != stat_buf->st_mtime    ||
+      header.n_keyframes < 0                     ||
+      length != sizeof (IndexHeader) +
+                header.n_keyframes * sizeof (int64_t))
+    {
+      g_free (data);
+      return FALSE;
+    }
+
+  p->n_keyframes = header.n_keyframes;
+  p->keyframes   = g_new (int64_t, header.n_keyframes);
+  memcpy (p->keyframes, data + sizeof (IndexHeader),
+          header.n_keyframes * sizeof (int64_t));
+
+  if (header.n_frames > 0)
+    o->frames = header.n_frames;
+
+  g_free (data);
+
+  return TRUE;
+}
+
+static gint
+compare_timestamps (gconstpointer a,
+                    gconstpointer b)
+{
+  int64_t ta = *(const int64_t *) a;
+  int64_t tb = *(const int64_t *) b;
+
+  return (ta > tb) - (ta < tb);
+}
+
+/* scans the packets of the video stream for keyframes, and counts the
+ * frames, then rewinds the stream.
+ */
+static void
+build_index (GeglProperties *o,
+             const gchar    *cache_path,
+             GStatBuf       *stat_buf)
+{
+  Priv        *p         = (Priv*)o->user_data;
+  GArray      *keyframes = g_array_new (FALSE, FALSE, sizeof (int64_t));
+  gint         n_frames  = 0;
+  AVPacket     pkt       = {0,};
+  IndexHeader  header    = {{0,}};
+  gchar       *dir;
+  gchar       *data;
+
+  while (av_read_frame (p->video_fcontext, &pkt) >= 0)
+    {
+      if (pkt.stream_index == p->video_index)
         {
-          int       ret;
-          AVPacket  pkt = {0,};
+          n_frames++;
 
-          do
-          {
-            av_packet_unref (&pkt);
-            if (av_read_frame (p->video_fcontext, &pkt) < 0)
+          if (pkt.flags & AV_PKT_FLAG_KEY)
             {
-              av_packet_unref (&pkt);
-              return -1;
-            }
-          }
-          while (pkt.stream_index != p->video_index);
+              int64_t ts = pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
 
-          ret = avcodec_send_packet (p->video_ctx, &pkt);
-          if (ret < 0)
-            {
-              fprintf (stderr, "avcodec_send_packet failed for %s\n",
-                       o->path);
-              return -1;
-            }
-          while (ret == 0)
-            {
-              if (!p->first_dts)
-                p->first_dts = pkt.dts;
-              ret = avcodec_receive_frame (p->video_ctx, p->lavc_frame);
-              if (ret == AVERROR(EAGAIN))
-                {
-                  // no more frames; should send the next packet now
-                  ret = 0;
-                  break;
-                }
-              else if (ret < 0)
-                {
-                  fprintf (stderr, "avcodec_receive_frame failed for %s\n",
-                                    o->path);
-                  break;
-                }
-              got_picture = 1;
-              if ((pkt.dts == pkt.pts) || (p->lavc_frame->key_frame!=0))
-                {
-                  // cur_dts and first_dts are moved to libavformat/internal.h
-                  /*
-                  p->lavc_frame->pts = (p->video_stream->cur_dts -
-                                        p->video_stream->first_dts);
-                  */
-                  p->lavc_frame->pts = pkt.dts - p->first_dts;
-                  p->prevpts =  av_rescale_q (p->lavc_frame->pts,
-                                              p->video_stream->time_base,
-                                              AV_TIME_BASE_Q) * 1.0 / AV_TIME_BASE;
-                  decodeframe = roundf( p->prevpts * o->frame_rate);
-                }
-              else
-                {
-                  p->prevpts += 1.0 / o->frame_rate;
-                  decodeframe = roundf ( p->prevpts * o->frame_rate);
-                }
-              if (decodeframe > frame + p->codec_delay)
-                break;
+              if (ts != AV_NOPTS_VALUE)
+                g_array_append_val (keyframes, ts);
             }
-#if 0
-          if (decoded_bytes != pkt.size)
-            fprintf (stderr, "bytes left!\n");
-#endif
-          av_packet_unref (&pkt);
         }
-      while (!got_picture);
+      av_packet_unref (&pkt);
     }
-    while (decodeframe <= frame + p->codec_delay);
-  }
 
-  p->prevframe = frame;
-  return 0;
+  g_array_sort (keyframes, compare_timestamps);
+
+  if (av_seek_frame (p->video_fcontext, p->video_index, p->first_dts,
+                     AVSEEK_FLAG_BACKWARD) < 0)
+    fprintf (stderr, "video seek error!\n");
+
+  p->n_keyframes = keyframes->len;
+  p->keyframes   = (int64_t *) g_array_free (keyframes, FALSE);
+
+  if (n_frames > 0)
+    o->frames = n_frames;
+
+  memcpy (header.magic, INDEX_MAGIC, 4);
+  header.version     = INDEX_VERSION;
+  header.file_size   = stat_buf->st_size;
+  header.file_mtime  = stat_buf->st_mtime;
+  header.n_frames    = n_frames;
+  header.n_keyframes = p->n_keyframes;
+
+  data = g_malloc (sizeof (IndexHeader) + p->n_keyframes * sizeof (int64_t));
+  memcpy (data, &header, sizeof (IndexHeader));
+  memcpy (data + sizeof (IndexHeader), p->keyframes,
+          p->n_keyframes * sizeof (int64_t));
+
+  dir = g_path_get_dirname (cache_path);
+  g_mkdir_with_parents (dir, 0700);
+  g_file_set_contents (cache_path, data,
+                       sizeof (IndexHeader) + p->n_keyframes * sizeof (int64_t),
+                       NULL);
+
+  g_free (dir);
+  g_free (data);
+}
+
+/* loads the keyframe index of the video stream from the cache, or builds
+ * it, when the file is seekable.
+ */
+static void
+init_index (GeglProperties *o,
+            const gchar    *path)
+{
+  Priv     *p = (Priv*)o->user_data;
+  GStatBuf  stat_buf;
+  gchar    *dereferenced_path;
+  gchar    *cache_path;
+
+  if (! p->video_fcontext->pb ||
+      ! (p->video_fcontext->pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+      g_stat (path, &stat_buf) != 0)
+    return;
+
+  dereferenced_path = realpath (path, NULL);
+  if (!dereferenced_path)
+    return;
+  cache_path = index_cache_path (dereferenced_path);
+  free (dereferenced_path);
+
+  if (! load_index (o, cache_path, &stat_buf))
+    build_index (o, cache_path, &stat_buf);
+
+  g_free (cache_path);
 }
 
 static void
@@ -455,7 +713,10 @@ prepare (GeglOperation *operation)
   if (o->path &&
       (!p->loadedfilename ||
       strcmp (p->loadedfilename, o->path) ||
-       p->prevframe > o->frame  /* a bit heavy handed, but improves consistency */
+       /* a bit heavy handed, but improves consistency, unnecessary when we
+        * can seek to keyframes
+        */
+       (p->prevframe > o->frame && ! p->n_keyframes)
       ))
     {
       gint i;
@@ -527,6 +788,16 @@ prepare (GeglOperation *operation)
                                                     AV_EF_BUFFER;
           p->video_ctx->workaround_bugs = FF_BUG_AUTODETECT;
 
+          /* decode using frame and slice threading, whichever the codec
+           * supports
+           */
+          {
+            gint threads;
+
+            g_object_get (gegl_config (), "threads", &threads, NULL);
+            p->video_ctx->thread_count = threads;
+            p->video_ctx->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+          }
 
           if (avcodec_open2 (p->video_ctx, p->video_codec, NULL) < 0)
           {
@@ -569,6 +840,8 @@ prepare (GeglOperation *operation)
         {
           p->width = p->video_stream->codecpar->width;
           p->height = p->video_stream->codecpar->height;
+          p->first_dts = p->video_stream->start_time != AV_NOPTS_VALUE ?
+                         p->video_stream->start_time : 0;
         }
       p->lavc_frame = av_frame_alloc ();
 
@@ -601,6 +874,7 @@ prepare (GeglOperation *operation)
              if (o->frames < 1)
                o->frames = 23;
            }
+          init_index (o, o->path);
 #if 0
            {
              int m ,h;
@@ -733,25 +1007,64 @@ static void get_sample_data (Priv *p, long sample_no, float *left, float *right)
   *right = 0;
 }
 
-static AVFrame *
-alloc_picture (int pix_fmt, int width, int height)
+typedef struct
 {
-  AVFrame  *picture;
-  uint8_t  *picture_buf;
-  int       size;
-
-  picture = av_frame_alloc ();
-  if (!picture)
-    return NULL;
-  size = av_image_get_buffer_size (pix_fmt, width + 1, height + 1, 16);
-  picture_buf = malloc (size);
-  if (!picture_buf)
+  Priv       *p;
+  GeglBuffer *output;
+} ConvertData;
+
+static void
+convert_band (gint     i,
+              gint     n,
+              gpointer user_data)
+{
+  ConvertData              *data   = user_data;
+  Priv                     *p      = data->p;
+  const AVPixFmtDescriptor *desc   = av_pix_fmt_desc_get (p->video_ctx->pix_fmt);
+  const uint8_t            *src[4] = {NULL,};
+  uint8_t                  *dst[4] = {NULL,};
+  int                       dst_stride[4] = {0,};
+  gint                      y0, y1;
+  gint                      top, bottom;
+  gint                      plane;
+  guchar                   *rgb;
+
+  y0 = p->height * i / n / CONVERT_ALIGN * CONVERT_ALIGN;
+  y1 = i == n - 1 ? p->height :
+                    p->height * (i + 1) / n / CONVERT_ALIGN * CONVERT_ALIGN;
+
+  if (y1 <= y0)
+    return;
+
+  top    = MAX (y0 - CONVERT_MARGIN, 0);
+  bottom = MIN (y1 + CONVERT_MARGIN, p->height);
+
+  for (plane = 0; plane < 4 && p->lavc_frame->data[plane]; plane++)
     {
-      av_free (picture);
-      return NULL;
+      gint shift = desc && (plane == 1 || plane == 2) ? desc->log2_chroma_h : 0;
+
+      src[plane] = p->lavc_frame->data[plane] +
+                   (top >> shift) * p->lavc_frame->linesize[plane];
     }
-  av_image_fill_arrays (picture->data, picture->linesize, picture_buf, pix_fmt, width, height, 1);
-  return picture;
+
+  dst_stride[0] = (p->width * 3 + 31) & ~31;
+  rgb = g_malloc (dst_stride[0] * (bottom - top));
+  dst[0] = rgb;
+
+  p->sws_contexts[i] = sws_getCachedContext (p->sws_contexts[i],
+                                             p->width, bottom - top,
+                                             p->video_ctx->pix_fmt,
+                                             p->width, bottom - top,
+                                             AV_PIX_FMT_RGB24,
+                                             SWS_BICUBIC, NULL, NULL, NULL);
+  sws_scale (p->sws_contexts[i], src, p->lavc_frame->linesize,
+             0, bottom - top, dst, dst_stride);
+
+  gegl_buffer_set (data->output, GEGL_RECTANGLE (0, y0, p->width, y1 - y0), 0,
+                   babl_format ("R'G'B' u8"),
+                   rgb + (y0 - top) * dst_stride[0], dst_stride[0]);
+
+  g_free (rgb);
 }
 
 static gboolean
@@ -813,18 +1126,29 @@ process (GeglOperation       *operation,
         }
         else
         {
-          struct SwsContext *img_convert_ctx;
-          GeglRectangle extent = {0,0,p->width,p->height};
+          const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get (p->video_ctx->pix_fmt);
+          ConvertData               data = {p, output};
+          gint                      n_bands;
+
+          /* convert bands of the frame in parallel, except for paletted
+           * frames, whose palette can't be split.
+           */
+          if (desc && ! (desc->flags & AV_PIX_FMT_FLAG_PAL))
+            n_bands = MAX (p->height / CONVERT_MIN_ROWS, 1);
+          else
+            n_bands = 1;
+
+          if (p->n_sws_contexts < n_bands)
+            {
+              p->sws_contexts = g_renew (struct SwsContext *, p->sws_contexts,
+                                         n_bands);
+              memset (p->sws_contexts + p->n_sws_contexts, 0,
+                      (n_bands - p->n_sws_contexts) *
+                      sizeof (struct SwsContext *));
+              p->n_sws_contexts = n_bands;
+            }
 
-          img_convert_ctx = sws_getContext(p->width, p->height, p->video_ctx->pix_fmt,
-                                           p->width, p->height, AV_PIX_FMT_RGB24,
-                                           SWS_BICUBIC, NULL, NULL, NULL);
-          if (!p->rgb_frame)
-            p->rgb_frame = alloc_picture (AV_PIX_FMT_RGB24, p->width, p->height);
-          sws_scale (img_convert_ctx, (void*)p->lavc_frame->data,
-                     p->lavc_frame->linesize, 0, p->height, p->rgb_frame->data, p->rgb_frame->linesize);
-          gegl_buffer_set (output, &extent, 0, babl_format("R'G'B' u8"), p->rgb_frame->data[0], GEGL_AUTO_ROWSTRIDE);
-          sws_freeContext (img_convert_ctx);
+          gegl_parallel_distribute (n_bands, convert_band, &data);
         }
       }
   }
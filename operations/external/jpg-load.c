@@ -37,6 +37,11 @@ property_uri (uri, _("URI"), "")
 #include <jpeglib.h>
 #include <gegl-gio-private.h>
 
+/* libjpeg can scale the image down by up to 1/8 while decoding, by
+ * dropping DCT coefficients, which corresponds to mipmap levels 1 to 3.
+ */
+#define JPG_MAX_LEVEL 3
+
 /* icc-loading code from:  http://www.littlecms.com/1/iccjpeg.c */
 
 static boolean
@@ -237,11 +242,16 @@ gegl_jpg_load_query_jpg (GInputStream *stream,
   return status;
 }
 
+/* decodes the whole image at the given mipmap level.  the image is written
+ * at MIN (level, JPG_MAX_LEVEL); coarser levels are derived from it by the
+ * buffer.
+ */
 static gint
 gegl_jpg_load_buffer_import_jpg (GeglBuffer   *gegl_buffer,
                                  GInputStream *stream,
                                  gint          dest_x,
-                                 gint          dest_y)
+                                 gint          dest_y,
+                                 gint          level)
 {
   gint row_stride;
   struct jpeg_decompress_struct  cinfo;
@@ -250,8 +260,12 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer   *gegl_buffer,
   JSAMPARRAY                     buffer;
   const Babl                    *format;
   GeglRectangle                  write_rect;
+  gint                           scale;
   GioSource gio_source = { stream, NULL, 1024 };
 
+  level = CLAMP (level, 0, JPG_MAX_LEVEL);
+  scale = 1 << level;
+
   cinfo.err = jpeg_std_error (&jerr);
   jpeg_create_decompress (&cinfo);
   setup_read_icc_profile (&cinfo);
@@ -266,6 +280,9 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer   *gegl_buffer,
    */
   cinfo.dct_method = JDCT_FLOAT;
 
+  cinfo.scale_num   = 1;
+  cinfo.scale_denom = scale;
+
   (void) jpeg_start_decompress (&cinfo);
 
   format = babl_from_jpeg_colorspace(cinfo.out_color_space,
@@ -301,7 +318,7 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer   *gegl_buffer,
     {
       jpeg_read_scanlines (&cinfo, buffer, 1);
 
-      gegl_buffer_set (gegl_buffer, &write_rect, 0,
+      gegl_buffer_set (gegl_buffer, &write_rect, level,
                        format, buffer[0],
                        GEGL_AUTO_ROWSTRIDE);
       write_rect.y += 1;
@@ -352,7 +369,7 @@ gegl_jpg_load_process (GeglOperation       *operation,
   GInputStream *stream = gegl_gio_open_input_stream(o->uri, o->path, &file, &err);
   if (!stream)
     return FALSE;
-  status = gegl_jpg_load_buffer_import_jpg(output, stream, 0, 0);
+  status = gegl_jpg_load_buffer_import_jpg(output, stream, 0, 0, level);
   g_input_stream_close(stream, NULL, NULL);
 
   if (err)
@@ -371,6 +388,10 @@ static GeglRectangle
 gegl_jpg_load_get_cached_region (GeglOperation       *operation,
                                  const GeglRectangle *roi)
 {
+  /* baseline jpegs can only be decoded from the top, so decoding parts of
+   * the image on their own would decode its upper rows over and over;
+   * decode it all at once instead.
+   */
   return gegl_jpg_load_get_bounding_box (operation);
 }
 
@@ -57,7 +57,12 @@ typedef enum {
   TIFF_LOADING_SEPARATED
 } LoadingMode;
 
-typedef struct
+/* maximal number of pyramid levels, including the full-resolution image */
+#define TIFF_MAX_LEVELS 16
+
+typedef struct _Priv Priv;
+
+struct _Priv
 {
   GFile *file;
   GInputStream *stream;
@@ -77,7 +82,28 @@ typedef struct
 
   gint width;
   gint height;
-} Priv;
+
+  /* whether the image is stored in tiles, which can be decoded
+   * individually, rather than in strips
+   */
+  gboolean tiled;
+
+  /* directories holding the image at each mipmap level, or 0 if the file
+   * has no matching reduced-resolution image.  level 0 is the image itself.
+   */
+  toff_t level_offsets[TIFF_MAX_LEVELS];
+  gint level_widths[TIFF_MAX_LEVELS];
+  gint level_heights[TIFF_MAX_LEVELS];
+
+  /* the directory a decoder's handle currently points to */
+  toff_t offset;
+
+  /* additional handles to the file, one per thread, used for decoding
+   * tiles in parallel.  a TIFF handle can't be shared across threads.
+   */
+  Priv **decoders;
+  gint n_decoders;
+};
 
 #ifdef HAVE_STRPTIME
 /* Parse the TIFF timestamp format - requires strptime() */
@@ -129,6 +155,25 @@ cleanup(GeglOperation *operation)
 
   if (p != NULL)
     {
+      gint i;
+
+      for (i = 0; i < p->n_decoders; i++)
+        {
+          Priv *decoder = p->decoders[i];
+
+          if (decoder == NULL)
+            continue;
+
+          if (decoder->tiff != NULL)
+            TIFFClose(decoder->tiff);
+          g_clear_object(&decoder->stream);
+          g_clear_object(&decoder->file);
+          g_free(decoder);
+        }
+
+      g_clear_pointer(&p->decoders, g_free);
+      p->n_decoders = 0;
+
       if (p->tiff != NULL)
         TIFFClose(p->tiff);
       else if (p->stream != NULL)
@@ -141,6 +186,7 @@ cleanup(GeglOperation *operation)
 
       p->width = p->height = 0;
       p->directory = 0;
+      p->tiled = FALSE;
     }
 }
 
@@ -613,6 +659,7 @@ query_tiff(GeglOperation *operation)
 
   p->height = (gint) height;
   p->width = (gint) width;
+  p->tiled = TIFFIsTiled(p->tiff);
 
   if (o->metadata != NULL)
     {
@@ -673,6 +720,139 @@ query_tiff(GeglOperation *operation)
   return 0;
 }
 
+/* checks whether the current directory holds a tiled, reduced-resolution
+ * version of the image, stored the same way as the image itself, and if so,
+ * returns its mipmap level, or 0 otherwise.
+ */
+static gint
+query_level(Priv      *p,
+            gushort    bits_per_sample,
+            gushort    samples_per_pixel,
+            gushort    sample_format,
+            gushort    planar_config,
+            gushort    photometric)
+{
+  guint width, height;
+  gushort value;
+  gint level;
+
+  if (!TIFFIsTiled(p->tiff) ||
+      !TIFFGetField(p->tiff, TIFFTAG_IMAGEWIDTH, &width) ||
+      !TIFFGetField(p->tiff, TIFFTAG_IMAGELENGTH, &height))
+    return 0;
+
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_BITSPERSAMPLE, &value);
+  if (value != bits_per_sample)
+    return 0;
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_SAMPLESPERPIXEL, &value);
+  if (value != samples_per_pixel)
+    return 0;
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_SAMPLEFORMAT, &value);
+  if (value != sample_format)
+    return 0;
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_PLANARCONFIG, &value);
+  if (value != planar_config)
+    return 0;
+  if (!TIFFGetField(p->tiff, TIFFTAG_PHOTOMETRIC, &value) ||
+      value != photometric)
+    return 0;
+
+  /* pyramid levels are either rounded up, or down */
+  for (level = 1; level < TIFF_MAX_LEVELS; level++)
+    {
+      gint scale = 1 << level;
+
+      if (((gint) width == p->width / scale ||
+           (gint) width == (p->width + scale - 1) / scale) &&
+          ((gint) height == p->height / scale ||
+           (gint) height == (p->height + scale - 1) / scale))
+        {
+          return level;
+        }
+    }
+
+  return 0;
+}
+
+/* finds the reduced-resolution images of the current directory, either
+ * stored in its SubIFDs, or in the directories directly following it, as
+ * written by most pyramid-TIFF writers.
+ */
+static void
+query_pyramid(Priv *p)
+{
+  gushort bits_per_sample, samples_per_pixel;
+  gushort sample_format, planar_config;
+  gushort photometric;
+  toff_t offset = TIFFCurrentDirOffset(p->tiff);
+  toff_t *candidates = NULL;
+  gint n_candidates = 0;
+  guint16 n_subifds = 0;
+  toff_t *subifds;
+  gint i;
+
+  memset(p->level_offsets, 0, sizeof(p->level_offsets));
+
+  p->level_offsets[0] = offset;
+  p->level_widths[0] = p->width;
+  p->level_heights[0] = p->height;
+  p->offset = offset;
+
+  if (!p->tiled || p->mode == TIFF_LOADING_RGBA)
+    return;
+
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_SAMPLEFORMAT, &sample_format);
+  TIFFGetFieldDefaulted(p->tiff, TIFFTAG_PLANARCONFIG, &planar_config);
+  if (!TIFFGetField(p->tiff, TIFFTAG_PHOTOMETRIC, &photometric))
+    return;
+
+  candidates = g_new(toff_t, TIFF_MAX_LEVELS);
+
+  if (TIFFGetField(p->tiff, TIFFTAG_SUBIFD, &n_subifds, &subifds))
+    {
+      for (i = 0; i < n_subifds && n_candidates < TIFF_MAX_LEVELS; i++)
+        candidates[n_candidates++] = subifds[i];
+    }
+
+  while (n_candidates < TIFF_MAX_LEVELS && TIFFReadDirectory(p->tiff))
+    {
+      guint32 subfile_type = 0;
+
+      TIFFGetField(p->tiff, TIFFTAG_SUBFILETYPE, &subfile_type);
+
+      /* the next page */
+      if (!(subfile_type & FILETYPE_REDUCEDIMAGE))
+        break;
+
+      candidates[n_candidates++] = TIFFCurrentDirOffset(p->tiff);
+    }
+
+  for (i = 0; i < n_candidates; i++)
+    {
+      gint level;
+
+      if (!TIFFSetSubDirectory(p->tiff, candidates[i]))
+        continue;
+
+      level = query_level(p, bits_per_sample, samples_per_pixel,
+                          sample_format, planar_config, photometric);
+
+      if (level > 0 && p->level_offsets[level] == 0)
+        {
+          p->level_offsets[level] = candidates[i];
+
+          TIFFGetField(p->tiff, TIFFTAG_IMAGEWIDTH, &p->level_widths[level]);
+          TIFFGetField(p->tiff, TIFFTAG_IMAGELENGTH, &p->level_heights[level]);
+        }
+    }
+
+  g_free(candidates);
+
+  TIFFSetSubDirectory(p->tiff, offset);
+}
+
 static gint
 load_RGBA(GeglOperation *operation,
           GeglBuffer    *output)
@@ -862,6 +1042,280 @@ load_separated(GeglOperation *operation,
   return 0;
 }
 
+typedef struct
+{
+  Priv *p;
+  GeglBuffer *output;
+  gint level;
+  toff_t offset;
+  GeglRectangle tiles;
+  guint32 tile_width;
+  guint32 tile_height;
+  gint n_threads;
+  gint failed;
+} TileJob;
+
+/* returns a TIFF handle for thread, pointing to directory at offset.  when
+ * the file can't be opened more than once, the operation's own handle is
+ * used, and there's only a single thread.
+ */
+static Priv *
+get_decoder(Priv   *p,
+            gint    thread,
+            gint    n_threads,
+            toff_t  offset)
+{
+  Priv *decoder;
+
+  if (n_threads == 1)
+    decoder = p;
+  else
+    {
+      decoder = p->decoders[thread];
+
+      if (decoder == NULL)
+        {
+          GError *error = NULL;
+
+          decoder = g_new0(Priv, 1);
+          decoder->file = g_object_ref(p->file);
+          decoder->stream = G_INPUT_STREAM(g_file_read(decoder->file,
+                                                       NULL, &error));
+          decoder->can_seek = TRUE;
+
+          if (decoder->stream == NULL)
+            {
+              if (error)
+                {
+                  g_warning("%s", error->message);
+                  g_error_free(error);
+                }
+              g_object_unref(decoder->file);
+              g_free(decoder);
+              return NULL;
+            }
+
+          decoder->tiff = TIFFClientOpen("GEGL-tiff-load", "r",
+                                         (thandle_t) decoder,
+                                         read_from_stream, write_to_stream,
+                                         seek_in_stream, close_stream,
+                                         get_file_size, NULL, NULL);
+          if (decoder->tiff == NULL)
+            {
+              g_clear_object(&decoder->stream);
+              g_object_unref(decoder->file);
+              g_free(decoder);
+              return NULL;
+            }
+
+          decoder->offset = TIFFCurrentDirOffset(decoder->tiff);
+
+          p->decoders[thread] = decoder;
+        }
+    }
+
+  if (decoder->offset != offset)
+    {
+      if (!TIFFSetSubDirectory(decoder->tiff, offset))
+        return NULL;
+
+      decoder->offset = offset;
+    }
+
+  return decoder;
+}
+
+static void
+load_tiles_thread(gint     thread,
+                  gint     n_threads,
+                  gpointer user_data)
+{
+  TileJob *job = user_data;
+  Priv *p = job->p;
+  Priv *decoder;
+  gint n_tiles = job->tiles.width * job->tiles.height;
+  gint bytes_per_pixel = babl_format_get_bytes_per_pixel(p->format);
+  gint nb_components = babl_format_get_n_components(p->format);
+  guchar *buffer;
+  guchar *pixels = NULL;
+  gint t;
+
+  decoder = get_decoder(p, thread, job->n_threads, job->offset);
+  if (decoder == NULL)
+    {
+      g_atomic_int_set(&job->failed, TRUE);
+      return;
+    }
+
+  buffer = g_try_malloc(TIFFTileSize(decoder->tiff));
+  if (p->mode == TIFF_LOADING_SEPARATED)
+    pixels = g_try_malloc((gsize) job->tile_width * job->tile_height *
+                          bytes_per_pixel);
+
+  if (buffer == NULL || (p->mode == TIFF_LOADING_SEPARATED && pixels == NULL))
+    {
+      g_atomic_int_set(&job->failed, TRUE);
+      g_free(buffer);
+      g_free(pixels);
+      return;
+    }
+
+  for (t = thread; t < n_tiles; t += n_threads)
+    {
+      gint x = (job->tiles.x + t % job->tiles.width) * job->tile_width;
+      gint y = (job->tiles.y + t / job->tiles.width) * job->tile_height;
+      GeglRectangle tile = { x, y, job->tile_width, job->tile_height };
+
+      if (p->mode == TIFF_LOADING_CONTIGUOUS)
+        {
+          if (TIFFReadTile(decoder->tiff, buffer, x, y, 0, 0) < 0)
+            {
+              g_atomic_int_set(&job->failed, TRUE);
+              continue;
+            }
+
+          gegl_buffer_set(job->output, &tile, job->level, p->format,
+                          buffer, GEGL_AUTO_ROWSTRIDE);
+        }
+      else
+        {
+          gint offset = 0;
+          gint i;
+
+          /* interleave the planes of the tile */
+          for (i = 0; i < nb_components; i++)
+            {
+              const Babl *component_type;
+              gint plane_bytes_per_pixel;
+              guchar *src = buffer;
+              guchar *dst = pixels + offset;
+              gint n;
+
+              component_type = babl_format_get_type(p->format, i);
+              plane_bytes_per_pixel =
+                babl_format_get_bytes_per_pixel(babl_format_n(component_type, 1));
+
+              if (TIFFReadTile(decoder->tiff, buffer, x, y, 0, i) < 0)
+                {
+                  g_atomic_int_set(&job->failed, TRUE);
+                  break;
+                }
+
+              for (n = job->tile_width * job->tile_height; n--;)
+                {
+                  memcpy(dst, src, plane_bytes_per_pixel);
+
+                  dst += bytes_per_pixel;
+                  src += plane_bytes_per_pixel;
+                }
+
+              offset += plane_bytes_per_pixel;
+            }
+
+          gegl_buffer_set(job->output, &tile, job->level, p->format,
+                          pixels, GEGL_AUTO_ROWSTRIDE);
+        }
+    }
+
+  g_free(buffer);
+  g_free(pixels);
+}
+
+/* decodes only the TIFF tiles intersecting result, reading them from the
+ * reduced-resolution image matching level, if there is one.
+ */
+static gint
+load_tiles(GeglOperation       *operation,
+           GeglBuffer          *output,
+           const GeglRectangle *result,
+           gint                 level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+  GeglRectangle roi = *result;
+  GeglRectangle bounds;
+  TileJob job;
+  gint threads = 1;
+
+  g_return_val_if_fail(p->tiff != NULL, -1);
+
+  if (level <= 0 || level >= TIFF_MAX_LEVELS || p->level_offsets[level] == 0)
+    level = 0;
+
+  if (level > 0)
+    {
+      gint scale = 1 << level;
+
+      roi.x = result->x >> level;
+      roi.y = result->y >> level;
+      roi.width = (result->x + result->width + scale - 1) / scale - roi.x;
+      roi.height = (result->y + result->height + scale - 1) / scale - roi.y;
+    }
+
+  gegl_rectangle_set(&bounds, 0, 0,
+                     p->level_widths[level], p->level_heights[level]);
+
+  if (!gegl_rectangle_intersect(&roi, &roi, &bounds))
+    return 0;
+
+  job.p = p;
+  job.output = output;
+  job.level = level;
+  job.offset = p->level_offsets[level];
+  job.failed = FALSE;
+
+  /* the tile size of the reduced-resolution images may differ */
+  if (p->offset != job.offset)
+    {
+      if (!TIFFSetSubDirectory(p->tiff, job.offset))
+        return -1;
+
+      p->offset = job.offset;
+    }
+
+  TIFFGetField(p->tiff, TIFFTAG_TILEWIDTH, &job.tile_width);
+  TIFFGetField(p->tiff, TIFFTAG_TILELENGTH, &job.tile_height);
+
+  job.tiles.x = roi.x / job.tile_width;
+  job.tiles.y = roi.y / job.tile_height;
+  job.tiles.width = (roi.x + roi.width - 1) / job.tile_width -
+                    job.tiles.x + 1;
+  job.tiles.height = (roi.y + roi.height - 1) / job.tile_height -
+                     job.tiles.y + 1;
+
+  /* decode tiles in parallel, when we can open the file more than once */
+  if (p->file != NULL && p->can_seek)
+    g_object_get(gegl_config(), "threads", &threads, NULL);
+
+  job.n_threads = MIN(threads, job.tiles.width * job.tiles.height);
+
+  if (job.n_threads > 1)
+    {
+      if (p->n_decoders < job.n_threads)
+        {
+          p->decoders = g_renew(Priv *, p->decoders, job.n_threads);
+          memset(p->decoders + p->n_decoders, 0,
+                 (job.n_threads - p->n_decoders) * sizeof(Priv *));
+          p->n_decoders = job.n_threads;
+        }
+
+      gegl_parallel_distribute(job.n_threads, load_tiles_thread, &job);
+    }
+  else
+    {
+      load_tiles_thread(0, 1, &job);
+    }
+
+  /* leave the main handle pointing at the image itself */
+  if (p->offset != p->level_offsets[0])
+    {
+      TIFFSetSubDirectory(p->tiff, p->level_offsets[0]);
+      p->offset = p->level_offsets[0];
+    }
+
+  return job.failed ? -1 : 0;
+}
+
 static void
 prepare(GeglOperation *operation)
 {
@@ -936,6 +1390,8 @@ prepare(GeglOperation *operation)
           return;
         }
 
+      query_pyramid(p);
+
         p->directory = o->directory;
     }
 
@@ -967,6 +1423,9 @@ process(GeglOperation *operation,
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (Priv*) o->user_data;
 
+  if (p->tiff != NULL && p->tiled && p->mode != TIFF_LOADING_RGBA)
+    return !load_tiles(operation, output, result, level);
+
   if (p->tiff != NULL)
     {
       switch (p->mode)
@@ -998,7 +1457,30 @@ static GeglRectangle
 get_cached_region(GeglOperation       *operation,
                   const GeglRectangle *roi)
 {
-  return get_bounding_box(operation);
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+  GeglRectangle bounds = get_bounding_box(operation);
+  GeglRectangle tile = { 0, 0, 0, 0 };
+  GeglRectangle result;
+  guint32 tile_width, tile_height;
+
+  /* strips, and images we can only read as a whole, are loaded at once */
+  if (p == NULL || p->tiff == NULL || !p->tiled ||
+      p->mode == TIFF_LOADING_RGBA || p->offset != p->level_offsets[0])
+    return bounds;
+
+  TIFFGetField(p->tiff, TIFFTAG_TILEWIDTH, &tile_width);
+  TIFFGetField(p->tiff, TIFFTAG_TILELENGTH, &tile_height);
+
+  tile.width = tile_width;
+  tile.height = tile_height;
+
+  /* round out to whole TIFF tiles, so that no tile is decoded twice */
+  gegl_rectangle_align(&result, roi, &tile,
+                       GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+  gegl_rectangle_intersect(&result, &result, &bounds);
+
+  return result;
 }
 
 static void
@@ -1234,17 +1234,33 @@ transform_affine (GeglOperation       *operation,
               u_float += x1 * inverse_jacobian.coeff [0][0];
               v_float += x1 * inverse_jacobian.coeff [1][0];
 
-              for (x = x1; x < x2; x++)
+              if (level == 0)
                 {
-                  sampler_get_fun (sampler,
-                                   u_float, v_float,
-                                   &inverse_jacobian,
-                                   dest_ptr,
-                                   abyss_policy);
-                  dest_ptr += (gint) components;
-
-                  u_float += inverse_jacobian.coeff [0][0];
-                  v_float += inverse_jacobian.coeff [1][0];
+                  /* sample the whole scanline in one go */
+                  gegl_sampler_get_span (sampler,
+                                         u_float, v_float,
+                                         inverse_jacobian.coeff [0][0],
+                                         inverse_jacobian.coeff [1][0],
+                                         &inverse_jacobian,
+                                         dest_ptr,
+                                         x2 - x1,
+                                         abyss_policy);
+                  dest_ptr += (gint) components * (x2 - x1);
+                }
+              else
+                {
+                  for (x = x1; x < x2; x++)
+                    {
+                      sampler_get_fun (sampler,
+                                       u_float, v_float,
+                                       &inverse_jacobian,
+                                       dest_ptr,
+                                       abyss_policy);
+                      dest_ptr += (gint) components;
+
+                      u_float += inverse_jacobian.coeff [0][0];
+                      v_float += inverse_jacobian.coeff [1][0];
+                    }
                 }
 
               memset (dest_ptr, 0, (gint) components * sizeof (gfloat) * (roi->width - x2));
@@ -1689,7 +1705,9 @@ gegl_transform_process (GeglOperation        *operation,
         gegl_parallel_distribute_area (
           result,
           gegl_operation_get_pixels_per_thread (operation),
-          GEGL_SPLIT_STRATEGY_AUTO,
+          /* the cost of the generic path varies with the local scale */
+          func == transform_generic ? GEGL_SPLIT_STRATEGY_DYNAMIC :
+                                      GEGL_SPLIT_STRATEGY_AUTO,
           (GeglParallelDistributeAreaFunc) thread_process,
           &data);
       }
@@ -60,13 +60,14 @@ load_png (const gchar *path,
   return data;
 }
 
-gint
-main (gint    argc,
-      gchar **argv)
+/* benchmarks all the algorithms on data in format, printing the compression
+ * and decompression speeds, as well as the compression ratio.
+ */
+static gboolean
+test_format (const gchar *path,
+             const Babl  *format)
 {
-  const Babl   *format;
   gint          bpp;
-  gchar        *path;
   gpointer      data;
   gint          n;
   gint          size;
@@ -75,22 +76,12 @@ main (gint    argc,
   guint8       *decompressed;
   const gchar **algorithms;
   gint          i;
-  gint          result = FAILURE;
-
-  gegl_init (&argc, &argv);
-
-  format = babl_format ("R'G'B'A u8");
-  bpp    = babl_format_get_bytes_per_pixel (format);
-
-  path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
-                           "tests", "compositions", "data", "car-stack.png",
-                           NULL);
+  gboolean      success = FALSE;
 
+  bpp  = babl_format_get_bytes_per_pixel (format);
   data = load_png (path, format, &n);
   size = n * bpp;
 
-  g_free (path);
-
   max_compressed_size = 2 * n * bpp;
   compressed          = g_malloc (max_compressed_size);
   decompressed        = g_malloc (size);
@@ -104,7 +95,8 @@ main (gint    argc,
       gint                   compressed_size;
       gint                   j;
 
-      id = g_strdup_printf ("%s compress", algorithms[i]);
+      id = g_strdup_printf ("%s compress (%s)",
+                            algorithms[i], babl_get_name (format));
       test_start ();
 
       for (j = 0; j < ITERATIONS && converged < BAIL_COUNT; j++)
@@ -116,6 +108,8 @@ main (gint    argc,
                                            compressed, &compressed_size,
                                            max_compressed_size))
             {
+              g_free (id);
+
               goto end;
             }
 
@@ -125,7 +119,8 @@ main (gint    argc,
       test_end (id, (gdouble) size * ITERATIONS);
       g_free (id);
 
-      id = g_strdup_printf ("%s decompress", algorithms[i]);
+      id = g_strdup_printf ("%s decompress (%s)",
+                            algorithms[i], babl_get_name (format));
       test_start ();
 
       for (j = 0; j < ITERATIONS && converged < BAIL_COUNT; j++)
@@ -136,6 +131,8 @@ main (gint    argc,
                                              decompressed, n,
                                              compressed, compressed_size))
             {
+              g_free (id);
+
               goto end;
             }
 
@@ -144,9 +141,13 @@ main (gint    argc,
 
       test_end (id, (gdouble) size * ITERATIONS);
       g_free (id);
+
+      g_print ("%s ratio (%s): %.3f\n",
+               algorithms[i], babl_get_name (format),
+               (gdouble) size / compressed_size);
     }
 
-  result = SUCCESS;
+  success = TRUE;
 
 end:
   g_free (algorithms);
@@ -156,6 +157,35 @@ end:
 
   g_free (data);
 
+  return success;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const gchar *formats[] = {"R'G'B'A u8",
+                            "R'G'B'A u16",
+                            "RGBA float",
+                            "Y' u8"};
+  gchar       *path;
+  gint         i;
+  gint         result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
+                           "tests", "compositions", "data", "car-stack.png",
+                           NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (formats) && result == SUCCESS; i++)
+    {
+      if (! test_format (path, babl_format (formats[i])))
+        result = FAILURE;
+    }
+
+  g_free (path);
+
   gegl_exit ();
 
   return result;
@@ -17,6 +17,9 @@
 #include "gegl.h"
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend-file.h"
+#include "gegl-buffer-index.h"
+#include "gegl-buffer-private.h"
+#include "gegl-tile-storage.h"
 
 #include <glib/gstdio.h>
 
@@ -409,6 +412,358 @@ test_buffer_change_extent (void)
   return result;
 }
 
+static gboolean
+buffer_matches (GeglBuffer          *buffer,
+                const guchar        *pixels,
+                const GeglRectangle *roi)
+{
+  guchar   *data   = g_malloc (roi->width * roi->height * 4);
+  gboolean  result;
+
+  gegl_buffer_get (buffer, roi, 1.0, babl_format ("R'G'B'A u8"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  result = ! memcmp (data, pixels, roi->width * roi->height * 4);
+
+  g_free (data);
+
+  return result;
+}
+
+static gboolean
+test_buffer_save_compressed (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_a_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglBuffer      *buf_b = NULL;
+  const Babl      *format = babl_format ("R'G'B'A u8");
+  GeglRectangle    roi = {0, 0, 300, 200};
+  guchar          *pixels;
+  gchar           *contents = NULL;
+  gsize            length;
+  GError          *error = NULL;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_a_path = g_build_filename (tmpdir, "buf_a.gegl", NULL);
+
+  pixels = g_malloc (roi.width * roi.height * 4);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      pixels[i * 4 + 0] = i % roi.width;
+      pixels[i * 4 + 1] = i / roi.width;
+      pixels[i * 4 + 2] = 0;
+      pixels[i * 4 + 3] = 255;
+    }
+
+  buf_a = gegl_buffer_new (&roi, format);
+  gegl_buffer_set (buf_a, &roi, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  gegl_buffer_save_compressed (buf_a, buf_a_path, NULL, "fast", 2);
+  g_object_unref (buf_a);
+
+  buf_a = gegl_buffer_load (buf_a_path);
+
+  if (!GEGL_IS_BUFFER (buf_a) || !buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Loaded buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_clear_object (&buf_a);
+
+  buf_a = gegl_buffer_open (buf_a_path);
+
+  if (!buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Opened buffer does not match\n");
+      result = FALSE;
+    }
+
+  /* rewrite part of the compressed tiles through the file backend */
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      if (i / roi.width < 100)
+        pixels[i * 4 + 2] = 128;
+    }
+
+  gegl_buffer_set (buf_a, GEGL_RECTANGLE (0, 0, roi.width, 100), 0, format,
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_flush (buf_a);
+  g_object_unref (buf_a);
+
+  buf_b = gegl_buffer_open (buf_a_path);
+
+  if (!buffer_matches (buf_b, pixels, &roi))
+    {
+      printf ("Reopened buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_b);
+
+  /* a file compressed with an algorithm we don't have fails to load */
+  if (g_file_get_contents (buf_a_path, &contents, &length, NULL) &&
+      length >= sizeof (GeglBufferHeader))
+    {
+      GeglBufferHeader *header = (GeglBufferHeader *) contents;
+
+      memset (header->compression, 0, sizeof (header->compression));
+      strcpy (header->compression, "unknown");
+
+      g_file_set_contents (buf_a_path, contents, length, NULL);
+
+      buf_a = gegl_buffer_load_with_error (buf_a_path, &error);
+
+      if (buf_a || ! error)
+        {
+          printf ("Buffer with an unknown compression was loaded\n");
+          result = FALSE;
+        }
+
+      g_clear_object (&buf_a);
+      g_clear_error (&error);
+    }
+  else
+    {
+      printf ("Failed to read back the saved buffer\n");
+      result = FALSE;
+    }
+
+  g_free (contents);
+
+  g_unlink (buf_a_path);
+  g_remove (tmpdir);
+
+  g_free (pixels);
+  g_free (tmpdir);
+  g_free (buf_a_path);
+
+  return result;
+}
+
+static gboolean
+test_buffer_open_mapped (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_a_path = NULL;
+  gchar           *buf_c_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglBuffer      *buf_b = NULL;
+  const Babl      *format = babl_format ("R'G'B'A u8");
+  GeglRectangle    roi = {0, 0, 300, 200};
+  guchar          *pixels;
+  guchar          *modified;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_a_path = g_build_filename (tmpdir, "buf_a.gegl", NULL);
+  buf_c_path = g_build_filename (tmpdir, "buf_c.gegl", NULL);
+
+  pixels   = g_malloc (roi.width * roi.height * 4);
+  modified = g_malloc (roi.width * roi.height * 4);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      pixels[i * 4 + 0] = i % roi.width;
+      pixels[i * 4 + 1] = i / roi.width;
+      pixels[i * 4 + 2] = 0;
+      pixels[i * 4 + 3] = 255;
+    }
+
+  buf_a = gegl_buffer_new (&roi, format);
+  gegl_buffer_set (buf_a, &roi, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_save (buf_a, buf_a_path, NULL);
+  gegl_buffer_save_compressed (buf_a, buf_c_path, NULL, "fast", 0);
+  g_object_unref (buf_a);
+
+  buf_a = gegl_buffer_open_mapped (buf_a_path);
+
+  if (!GEGL_IS_BUFFER (buf_a) || !buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Mapped buffer does not match\n");
+      result = FALSE;
+    }
+
+  /* share the mapped tiles with another buffer, and modify the mapped buffer */
+  buf_b = gegl_buffer_dup (buf_a);
+
+  memcpy (modified, pixels, roi.width * roi.height * 4);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      if (i / roi.width < 100)
+        modified[i * 4 + 2] = 128;
+    }
+
+  gegl_buffer_set (buf_a, GEGL_RECTANGLE (0, 0, roi.width, 100), 0, format,
+                   modified, GEGL_AUTO_ROWSTRIDE);
+
+  if (!buffer_matches (buf_a, modified, &roi))
+    {
+      printf ("Modified mapped buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_a);
+
+  /* the shared tiles outlive the mapped buffer */
+  if (!buffer_matches (buf_b, pixels, &roi))
+    {
+      printf ("Copy of mapped buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_b);
+
+  /* the file is left untouched */
+  buf_a = gegl_buffer_open_mapped (buf_a_path);
+
+  if (!buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Remapped buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_a);
+
+  buf_a = gegl_buffer_open_mapped (buf_c_path);
+
+  if (!GEGL_IS_BUFFER (buf_a) || !buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Mapped compressed buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_clear_object (&buf_a);
+
+  g_unlink (buf_a_path);
+  g_unlink (buf_c_path);
+  g_remove (tmpdir);
+
+  g_free (modified);
+  g_free (pixels);
+  g_free (tmpdir);
+  g_free (buf_a_path);
+  g_free (buf_c_path);
+
+  return result;
+}
+
+static gboolean
+test_buffer_prefetch (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_a_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglTileBackend *backend_a = NULL;
+  const Babl      *format = babl_format ("R'G'B'A u8");
+  GeglRectangle    roi = {0, 0, 300, 200};
+  GeglRectangle    tiles = {0, 0, 3, 4};
+  guchar          *pixels;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_a_path = g_build_filename (tmpdir, "buf_a.gegl", NULL);
+
+  pixels = g_malloc (roi.width * roi.height * 4);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      pixels[i * 4 + 0] = i % roi.width;
+      pixels[i * 4 + 1] = i / roi.width;
+      pixels[i * 4 + 2] = 0;
+      pixels[i * 4 + 3] = 255;
+    }
+
+  /* ram storage doesn't prefetch, and its backend ignores the command */
+  buf_a = gegl_buffer_new (&roi, format);
+  gegl_buffer_set (buf_a, &roi, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_object_get (buf_a,
+                "backend", &backend_a,
+                NULL);
+
+  if (buf_a->tile_storage->can_prefetch)
+    {
+      printf ("RAM storage prefetches\n");
+      result = FALSE;
+    }
+
+  if (gegl_tile_source_command (GEGL_TILE_SOURCE (backend_a),
+                                GEGL_TILE_PREFETCH, tiles.x, tiles.y, 0,
+                                &tiles))
+    {
+      printf ("RAM backend handled a prefetch\n");
+      result = FALSE;
+    }
+
+  g_clear_object (&backend_a);
+
+  gegl_buffer_prefetch (buf_a, &roi, 0);
+
+  if (!buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Prefetched RAM buffer does not match\n");
+      result = FALSE;
+    }
+
+  gegl_buffer_save (buf_a, buf_a_path, NULL);
+  g_object_unref (buf_a);
+
+  /* file storage prefetches, which changes nothing, even for tiles that are
+   * only modified in memory, outside the buffer, or at another level
+   */
+  buf_a = gegl_buffer_open (buf_a_path);
+
+  if (!buf_a->tile_storage->can_prefetch)
+    {
+      printf ("File storage doesn't prefetch\n");
+      result = FALSE;
+    }
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      if (i / roi.width < 100)
+        pixels[i * 4 + 2] = 128;
+    }
+
+  gegl_buffer_set (buf_a, GEGL_RECTANGLE (0, 0, roi.width, 100), 0, format,
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  gegl_buffer_prefetch (buf_a, &roi, 0);
+  gegl_buffer_prefetch (buf_a, GEGL_RECTANGLE (-100, -100, 600, 400), 0);
+  gegl_buffer_prefetch (buf_a, GEGL_RECTANGLE (0, 0, 150, 100), 1);
+
+  if (!buffer_matches (buf_a, pixels, &roi))
+    {
+      printf ("Prefetched file buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_a);
+
+  g_unlink (buf_a_path);
+  g_remove (tmpdir);
+
+  g_free (pixels);
+  g_free (tmpdir);
+  g_free (buf_a_path);
+
+  return result;
+}
+
 #define RUN_TEST(test_name) \
 { \
   if (test_name()) \
@@ -442,6 +797,9 @@ int main(int argc, char **argv)
   RUN_TEST (test_buffer_same_path)
   RUN_TEST (test_buffer_open)
   RUN_TEST (test_buffer_change_extent)
+  RUN_TEST (test_buffer_save_compressed)
+  RUN_TEST (test_buffer_open_mapped)
+  RUN_TEST (test_buffer_prefetch)
 
   gegl_exit();
 
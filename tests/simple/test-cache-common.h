@@ -0,0 +1,99 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* helpers shared by the tests of the shared cache and of the disk cache,
+ * which render a cached gegl:invert-linear of a plain color.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+
+#define SIZE 64
+
+static GeglNode *
+make_graph (const gchar  *color,
+            GeglNode    **invert)
+{
+  GeglNode  *graph = gegl_node_new ();
+  GeglNode  *source;
+  GeglNode  *crop;
+  GeglColor *value = gegl_color_new (color);
+
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:color",
+                                 "value",     value,
+                                 NULL);
+  crop    = gegl_node_new_child (graph,
+                                 "operation", "gegl:crop",
+                                 "width",     (gdouble) SIZE,
+                                 "height",    (gdouble) SIZE,
+                                 NULL);
+  *invert = gegl_node_new_child (graph,
+                                 "operation",    "gegl:invert-linear",
+                                 "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                                 NULL);
+
+  gegl_node_link_many (source, crop, *invert, NULL);
+
+  g_object_unref (value);
+
+  return graph;
+}
+
+/* whether the whole output of @invert is valid in its cache */
+static gboolean
+is_valid (GeglNode *invert)
+{
+  GeglCache *cache = gegl_node_get_cache (invert);
+
+  return gegl_tile_bitmap_contains (cache->valid[0],
+                                    GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+}
+
+/* whether the cache of @invert holds the inverse of @color, without
+ * computing anything.
+ */
+static gboolean
+is_inverted (GeglNode    *invert,
+             const gchar *color)
+{
+  GeglColor *value = gegl_color_new (color);
+  gfloat     expected[4];
+  gfloat     pixel[4];
+
+  gegl_color_get_pixel (value, babl_format ("RGBA float"), expected);
+  g_object_unref (value);
+
+  gegl_buffer_get (GEGL_BUFFER (gegl_node_get_cache (invert)),
+                   GEGL_RECTANGLE (SIZE / 2, SIZE / 2, 1, 1), 1.0,
+                   babl_format ("RGBA float"), pixel,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (fabsf (pixel[0] - (1.0f - expected[0])) > 1e-5f ||
+      fabsf (pixel[1] - (1.0f - expected[1])) > 1e-5f ||
+      fabsf (pixel[2] - (1.0f - expected[2])) > 1e-5f)
+    {
+      printf ("wrong cached result: %f, %f, %f\n",
+              pixel[0], pixel[1], pixel[2]);
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
@@ -0,0 +1,272 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* renders graphs with the disk cache enabled, each case in a cache
+ * directory of its own, and makes sure that:
+ *
+ *  - a fresh cache of an identical graph reads the results back from disk,
+ *    as a later process would;
+ *  - truncated tiles aren't taken as valid, and are computed again;
+ *  - old entries are evicted once the cache grows past its size.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#ifdef G_OS_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "test-cache-common.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define COLOR       "rgb(0.25, 0.5, 0.75)"
+#define OTHER_COLOR "rgb(0.75, 0.5, 0.25)"
+
+typedef enum
+{
+  WALK_TRUNCATE,
+  WALK_BACKDATE,
+  WALK_REMOVE
+} WalkMode;
+
+/* truncates the tiles in the entries of the cache directory, makes the
+ * entries look unused for an hour, or removes everything, depending on
+ * @mode.
+ */
+static void
+walk_cache (const gchar *path,
+            WalkMode     mode)
+{
+  GDir        *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  while (dir && (name = g_dir_read_name (dir)))
+    {
+      gchar *filename = g_build_filename (path, name, NULL);
+
+      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+        {
+          walk_cache (filename, mode);
+        }
+      else if (mode == WALK_REMOVE)
+        {
+          g_unlink (filename);
+        }
+      else if (mode == WALK_TRUNCATE && g_str_has_suffix (name, ".tile"))
+        {
+          gchar *contents;
+          gsize  length;
+
+          if (g_file_get_contents (filename, &contents, &length, NULL))
+            {
+              g_file_set_contents (filename, contents, length / 2, NULL);
+              g_free (contents);
+            }
+        }
+      else if (mode == WALK_BACKDATE && ! strcmp (name, "stamp"))
+        {
+          struct utimbuf times;
+
+          times.actime  = g_get_real_time () / G_USEC_PER_SEC - 60 * 60;
+          times.modtime = times.actime;
+
+          g_utime (filename, &times);
+        }
+
+      g_free (filename);
+    }
+
+  if (dir)
+    g_dir_close (dir);
+
+  if (mode == WALK_REMOVE)
+    g_rmdir (path);
+}
+
+/* renders the inverse of @color, and destroys the graph, leaving the
+ * result in the disk cache only.
+ */
+static void
+render (const gchar *color)
+{
+  GeglNode *graph;
+  GeglNode *invert;
+
+  graph = make_graph (color, &invert);
+
+  gegl_node_blit (invert, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  babl_format ("RGBA float"), NULL,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  g_object_unref (graph);
+}
+
+static gboolean
+test_reload (const gchar *path)
+{
+  GeglNode *graph;
+  GeglNode *invert;
+  gboolean  result = TRUE;
+
+  render (COLOR);
+
+  graph = make_graph (COLOR, &invert);
+
+  if (! is_valid (invert))
+    {
+      printf ("the tiles on disk weren't found by an identical node\n");
+      result = FALSE;
+    }
+  else if (! is_inverted (invert, COLOR))
+    {
+      result = FALSE;
+    }
+
+  g_object_unref (graph);
+
+  return result;
+}
+
+static gboolean
+test_truncated (const gchar *path)
+{
+  GeglNode *graph;
+  GeglNode *invert;
+  gboolean  result = TRUE;
+
+  render (COLOR);
+
+  walk_cache (path, WALK_TRUNCATE);
+
+  graph = make_graph (COLOR, &invert);
+
+  if (is_valid (invert))
+    {
+      printf ("truncated tiles were taken as valid\n");
+      result = FALSE;
+    }
+  else
+    {
+      gegl_node_blit (invert, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                      babl_format ("RGBA float"), NULL,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+      if (! is_inverted (invert, COLOR))
+        result = FALSE;
+    }
+
+  g_object_unref (graph);
+
+  return result;
+}
+
+static gboolean
+test_eviction (const gchar *path)
+{
+  GeglNode *graph;
+  GeglNode *invert;
+  gboolean  result = TRUE;
+
+  render (COLOR);
+
+  /* entries used recently are never evicted */
+  walk_cache (path, WALK_BACKDATE);
+
+  /* any write now trims the cache */
+  g_object_set (gegl_config (),
+                "disk-cache-size", (guint64) 1,
+                NULL);
+
+  render (OTHER_COLOR);
+
+  graph = make_graph (COLOR, &invert);
+
+  if (is_valid (invert))
+    {
+      printf ("an old entry wasn't evicted past the cache size\n");
+      result = FALSE;
+    }
+
+  g_object_unref (graph);
+
+  graph = make_graph (OTHER_COLOR, &invert);
+
+  if (! is_valid (invert))
+    {
+      printf ("an entry in use was evicted\n");
+      result = FALSE;
+    }
+
+  g_object_unref (graph);
+
+  return result;
+}
+
+static gboolean
+run_test (gboolean (* test) (const gchar *path))
+{
+  gchar    *path;
+  gboolean  result;
+
+  path = g_dir_make_tmp ("gegl-disk-cache-XXXXXX", NULL);
+
+  if (! path)
+    {
+      printf ("failed to create the cache directory\n");
+      return FALSE;
+    }
+
+  g_object_set (gegl_config (),
+                "disk-cache", path,
+                NULL);
+
+  result = test (path);
+
+  g_object_set (gegl_config (),
+                "disk-cache", NULL,
+                NULL);
+
+  walk_cache (path, WALK_REMOVE);
+  g_free (path);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! run_test (test_reload)    ||
+      ! run_test (test_truncated) ||
+      ! run_test (test_eviction))
+    {
+      result = FAILURE;
+    }
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,115 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* changes a small area of a source which reaches a cached node through two
+ * paths, at opposite ends of its output, and makes sure that only these two
+ * areas are invalidated, and not the area between them.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  1024
+#define HEIGHT 64
+
+int main (int argc, char *argv[])
+{
+  GeglBuffer *buffer;
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *translate;
+  GeglNode   *over;
+  GeglCache  *cache;
+  gfloat      pixel[4 * 8 * 8] = { 0.0f, };
+  gint        result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+
+  graph     = gegl_node_new ();
+  source    = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    buffer,
+                                   NULL);
+  translate = gegl_node_new_child (graph,
+                                   "operation", "gegl:translate",
+                                   "x",         (gdouble) WIDTH / 2,
+                                   NULL);
+  over      = gegl_node_new_child (graph,
+                                   "operation",    "gegl:over",
+                                   "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                                   NULL);
+
+  gegl_node_link_many (source, over, NULL);
+  gegl_node_link_many (source, translate, NULL);
+  gegl_node_connect (translate, "output", over, "aux");
+
+  gegl_node_blit (over, 1.0, GEGL_RECTANGLE (0, 0, WIDTH * 3 / 2, HEIGHT),
+                  babl_format ("RGBA float"), NULL,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  cache = gegl_node_get_cache (over);
+
+  if (! gegl_tile_bitmap_contains (cache->valid[0],
+                                   GEGL_RECTANGLE (0, 0,
+                                                   WIDTH * 3 / 2, HEIGHT)))
+    {
+      printf ("the output wasn't cached\n");
+      result = FAILURE;
+    }
+
+  /* reaches the output at 0,0 directly, and at WIDTH / 2,0 translated */
+  gegl_buffer_set (buffer, GEGL_RECTANGLE (0, 0, 8, 8), 0,
+                   babl_format ("RGBA float"), pixel, GEGL_AUTO_ROWSTRIDE);
+
+  if (result == SUCCESS &&
+      (gegl_tile_bitmap_contains (cache->valid[0],
+                                  GEGL_RECTANGLE (0, 0, 8, 8)) ||
+       gegl_tile_bitmap_contains (cache->valid[0],
+                                  GEGL_RECTANGLE (WIDTH / 2, 0, 8, 8))))
+    {
+      printf ("the changed areas weren't invalidated\n");
+      result = FAILURE;
+    }
+
+  if (result == SUCCESS &&
+      (! gegl_tile_bitmap_contains (cache->valid[0],
+                                    GEGL_RECTANGLE (WIDTH / 4, 0,
+                                                    WIDTH / 8, HEIGHT)) ||
+       ! gegl_tile_bitmap_contains (cache->valid[0],
+                                    GEGL_RECTANGLE (WIDTH, 0,
+                                                    WIDTH / 4, HEIGHT))))
+    {
+      printf ("more than the changed areas was invalidated\n");
+      result = FAILURE;
+    }
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,144 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* runs gegl:median-blur with square neighborhoods large enough to take the
+ * constant-time path, and compares the result against a brute-force
+ * percentile of each neighborhood.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  160
+#define HEIGHT 96
+
+static int
+compare_uchar (const void *a,
+               const void *b)
+{
+  return *(const guchar *) a - *(const guchar *) b;
+}
+
+static gboolean
+test_median_blur (guchar       *src,
+                  gint          radius,
+                  gdouble       percentile)
+{
+  GeglBuffer *buffer;
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *median;
+  const gint  size   = 2 * radius + 1;
+  guchar     *dst    = g_new (guchar, WIDTH * HEIGHT);
+  guchar     *window = g_new (guchar, size * size);
+  gint        count;
+  gint        x, y;
+  gboolean    result = TRUE;
+
+  buffer = gegl_buffer_linear_new_from_data (src, babl_format ("Y' u8"),
+                                             GEGL_RECTANGLE (0, 0,
+                                                             WIDTH, HEIGHT),
+                                             WIDTH, NULL, NULL);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  median = gegl_node_new_child (graph,
+                                "operation",  "gegl:median-blur",
+                                "radius",     radius,
+                                "percentile", percentile,
+                                NULL);
+  gegl_node_set_enum_as_string (median, "neighborhood", "square");
+
+  gegl_node_link (source, median);
+
+  gegl_node_blit (median, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                  babl_format ("Y' u8"), dst,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  count = MAX ((gint) ceil (size * size * (percentile / 100.0)), 1);
+
+  for (y = 0; y < HEIGHT && result; y++)
+    for (x = 0; x < WIDTH && result; x++)
+      {
+        gint i, j;
+        gint n = 0;
+
+        /* the default abyss policy clamps to the edges */
+        for (j = y - radius; j <= y + radius; j++)
+          for (i = x - radius; i <= x + radius; i++)
+            window[n++] = src[CLAMP (j, 0, HEIGHT - 1) * WIDTH +
+                              CLAMP (i, 0, WIDTH - 1)];
+
+        qsort (window, n, 1, compare_uchar);
+
+        if (dst[y * WIDTH + x] != window[count - 1])
+          {
+            printf ("radius %d, percentile %g: got %d instead of %d "
+                    "at %d,%d\n",
+                    radius, percentile,
+                    dst[y * WIDTH + x], window[count - 1], x, y);
+            result = FALSE;
+          }
+      }
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+  g_free (window);
+  g_free (dst);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  GRand  *rand;
+  guchar *src;
+  gint    result = SUCCESS;
+  gint    i;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (42);
+  src  = g_new (guchar, WIDTH * HEIGHT);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    src[i] = g_rand_int_range (rand, 0, 256);
+
+  if (! test_median_blur (src, 16, 50.0) ||
+      ! test_median_blur (src, 24, 25.0) ||
+      ! test_median_blur (src, 40, 90.0))
+    {
+      result = FAILURE;
+    }
+
+  g_free (src);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,210 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_THREADS 4
+#define N_CALLERS 3
+
+typedef struct
+{
+  gint counts[N_THREADS][N_THREADS];
+  gint n_inner[N_THREADS];
+} NestedData;
+
+typedef struct
+{
+  NestedData *data;
+  gint        outer;
+} InnerData;
+
+static void
+inner_func (gint       i,
+            gint       n,
+            InnerData *inner)
+{
+  g_atomic_int_inc (&inner->data->counts[inner->outer][i]);
+
+  inner->data->n_inner[inner->outer] = n;
+}
+
+static void
+outer_func (gint        i,
+            gint        n,
+            NestedData *data)
+{
+  InnerData inner = { data, i };
+
+  gegl_parallel_distribute (-1, (GeglParallelDistributeFunc) inner_func,
+                            &inner);
+}
+
+/* runs a distribute nested inside every index of another one, and checks
+ * that each inner index ran exactly once, and that the inner calls weren't
+ * serialized.
+ */
+static gint
+test_nested (void)
+{
+  NestedData data = {{{ 0 }}};
+  gint       i;
+  gint       j;
+
+  gegl_parallel_distribute (-1, (GeglParallelDistributeFunc) outer_func,
+                            &data);
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      if (data.n_inner[i] != N_THREADS)
+        {
+          printf ("nested: index %d distributed over %d threads\n",
+                  i, data.n_inner[i]);
+          return FAILURE;
+        }
+
+      for (j = 0; j < N_THREADS; j++)
+        {
+          if (data.counts[i][j] != 1)
+            {
+              printf ("nested: index %d/%d ran %d times\n",
+                      i, j, data.counts[i][j]);
+              return FAILURE;
+            }
+        }
+    }
+
+  return SUCCESS;
+}
+
+static gpointer
+caller_thread_func (gpointer data)
+{
+  gint i;
+
+  for (i = 0; i < 100; i++)
+    {
+      if (test_nested () != SUCCESS)
+        return GINT_TO_POINTER (FAILURE);
+    }
+
+  return GINT_TO_POINTER (SUCCESS);
+}
+
+/* runs nested distributes from several threads at once */
+static gint
+test_concurrent (void)
+{
+  GThread *threads[N_CALLERS];
+  gint     result = SUCCESS;
+  gint     i;
+
+  for (i = 0; i < N_CALLERS; i++)
+    threads[i] = g_thread_new ("caller", caller_thread_func, NULL);
+
+  for (i = 0; i < N_CALLERS; i++)
+    {
+      if (GPOINTER_TO_INT (g_thread_join (threads[i])) != SUCCESS)
+        result = FAILURE;
+    }
+
+  return result;
+}
+
+static void
+area_func (const GeglRectangle *area,
+           gint                *coverage)
+{
+  gint x;
+  gint y;
+
+  for (y = area->y; y < area->y + area->height; y++)
+    {
+      for (x = area->x; x < area->x + area->width; x++)
+        g_atomic_int_inc (&coverage[(y - 13) * 1000 + (x - 7)]);
+    }
+}
+
+/* checks that dynamic splitting covers an unaligned area exactly once, and
+ * that the threads' busy time is reported.
+ */
+static gint
+test_dynamic_area (void)
+{
+  gint   *coverage = g_new0 (gint, 1000 * 700);
+  GArray *busy_time;
+  gint    result   = SUCCESS;
+  gint    i;
+
+  gegl_reset_stats ();
+
+  gegl_parallel_distribute_area (GEGL_RECTANGLE (7, 13, 1000, 700), 1.0,
+                                 GEGL_SPLIT_STRATEGY_DYNAMIC,
+                                 (GeglParallelDistributeAreaFunc) area_func,
+                                 coverage);
+
+  for (i = 0; i < 1000 * 700; i++)
+    {
+      if (coverage[i] != 1)
+        {
+          printf ("dynamic: pixel %d,%d processed %d times\n",
+                  7 + i % 1000, 13 + i / 1000, coverage[i]);
+          result = FAILURE;
+          break;
+        }
+    }
+
+  g_object_get (gegl_stats (), "thread-busy-time", &busy_time, NULL);
+
+  if (busy_time->len != N_THREADS)
+    {
+      printf ("dynamic: busy time reported for %d threads\n", busy_time->len);
+      result = FAILURE;
+    }
+
+  g_array_unref (busy_time);
+  g_free (coverage);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "threads", N_THREADS,
+                NULL);
+
+  if (result == SUCCESS)
+    result = test_nested ();
+  if (result == SUCCESS)
+    result = test_concurrent ();
+  if (result == SUCCESS)
+    result = test_dynamic_area ();
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,405 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* renders chains of point operations with fuse-point-ops on and off, and
+ * makes sure that the chains are actually fused, and that fusing them
+ * doesn't change the result, both at level 0 and at level 1.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 300
+
+/* a point filter recording the order in which the chunks of every instance
+ * are processed: a fused chain processes each chunk through all of its
+ * operations before moving to the next one.
+ */
+
+typedef struct
+{
+  GeglOperationPointFilter  parent_instance;
+  gchar                     tag;
+} GeglTestOperationTrace;
+
+typedef struct
+{
+  GeglOperationPointFilterClass  parent_class;
+} GeglTestOperationTraceClass;
+
+GType   gegl_test_operation_trace_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (GeglTestOperationTrace, gegl_test_operation_trace,
+               GEGL_TYPE_OPERATION_POINT_FILTER);
+
+static GMutex   trace_mutex;
+static GString *trace;
+
+static gboolean
+gegl_test_operation_trace_process (GeglOperation       *operation,
+                                   void                *in_buf,
+                                   void                *out_buf,
+                                   glong                samples,
+                                   const GeglRectangle *roi,
+                                   gint                 level)
+{
+  const gfloat *in  = in_buf;
+  gfloat       *out = out_buf;
+  glong         i;
+
+  for (i = 0; i < samples * 4; i++)
+    out[i] = in[i] * 0.5f + 0.25f;
+
+  g_mutex_lock (&trace_mutex);
+  g_string_append_c (trace, ((GeglTestOperationTrace *) operation)->tag);
+  g_mutex_unlock (&trace_mutex);
+
+  return TRUE;
+}
+
+static void
+gegl_test_operation_trace_init (GeglTestOperationTrace *self)
+{
+}
+
+static void
+gegl_test_operation_trace_class_init (GeglTestOperationTraceClass *klass)
+{
+  GeglOperationPointFilterClass *point_filter_class =
+    GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  point_filter_class->process = gegl_test_operation_trace_process;
+
+  gegl_operation_class_set_keys (GEGL_OPERATION_CLASS (klass),
+                                 "name",        "gegl-test:trace",
+                                 "description", "",
+                                 NULL);
+}
+
+static GeglBuffer *
+make_source (gfloat seed)
+{
+  GeglBuffer *buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                                        babl_format ("RGBA float"));
+  gfloat     *pixels = g_new (gfloat, SIZE * SIZE * 4);
+  gint        i;
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    pixels[i] = fmodf (i * seed, 1.0f);
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  return buffer;
+}
+
+/* runs a single operation on its own, so that nothing can be fused */
+static GeglBuffer *
+apply_op (GeglBuffer  *input,
+          GeglBuffer  *aux,
+          const gchar *operation,
+          const gchar *first_property,
+          gdouble      value)
+{
+  GeglBuffer *output = NULL;
+  GeglNode   *graph  = gegl_node_new ();
+  GeglNode   *source = gegl_node_new_child (graph,
+                                            "operation", "gegl:buffer-source",
+                                            "buffer",    input,
+                                            NULL);
+  GeglNode   *op     = gegl_node_new_child (graph,
+                                            "operation", operation,
+                                            NULL);
+  GeglNode   *sink   = gegl_node_new_child (graph,
+                                            "operation", "gegl:buffer-sink",
+                                            "buffer",    &output,
+                                            NULL);
+
+  if (first_property)
+    gegl_node_set (op, first_property, value, NULL);
+
+  if (aux)
+    {
+      GeglNode *aux_source = gegl_node_new_child (graph,
+                                                  "operation", "gegl:buffer-source",
+                                                  "buffer",    aux,
+                                                  NULL);
+      gegl_node_connect (aux_source, "output", op, "aux");
+    }
+
+  gegl_node_link_many (source, op, sink, NULL);
+  gegl_node_process (sink);
+
+  g_object_unref (graph);
+
+  return output;
+}
+
+static gboolean
+pixels_equal (const gfloat *pa,
+              const gfloat *pb,
+              gint          n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (fabsf (pa[i] - pb[i]) > 1e-5f)
+        {
+          printf ("mismatch at component %d: %f != %f\n", i, pa[i], pb[i]);
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+buffers_equal (GeglBuffer *a,
+               GeglBuffer *b)
+{
+  gfloat   *pa = g_new (gfloat, SIZE * SIZE * 4);
+  gfloat   *pb = g_new (gfloat, SIZE * SIZE * 4);
+  gboolean  result;
+
+  gegl_buffer_get (a, GEGL_RECTANGLE (0, 0, SIZE, SIZE), 1.0,
+                   babl_format ("RGBA float"), pa,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (b, GEGL_RECTANGLE (0, 0, SIZE, SIZE), 1.0,
+                   babl_format ("RGBA float"), pb,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  result = pixels_equal (pa, pb, SIZE * SIZE * 4);
+
+  g_free (pa);
+  g_free (pb);
+
+  return result;
+}
+
+static int
+test_point_fusion (void)
+{
+  GeglBuffer *input    = make_source (0.37f);
+  GeglBuffer *aux      = make_source (0.73f);
+  GeglBuffer *fused    = NULL;
+  GeglBuffer *stepwise;
+  GeglBuffer *tmp;
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *aux_source;
+  GeglNode   *exposure;
+  GeglNode   *saturation;
+  GeglNode   *mix;
+  GeglNode   *invert;
+  GeglNode   *sink;
+  gint        result = SUCCESS;
+
+  graph      = gegl_node_new ();
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    input,
+                                    NULL);
+  aux_source = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    aux,
+                                    NULL);
+  exposure   = gegl_node_new_child (graph,
+                                    "operation", "gegl:exposure",
+                                    "exposure",  0.5,
+                                    NULL);
+  saturation = gegl_node_new_child (graph,
+                                    "operation", "gegl:saturation",
+                                    "scale",     1.5,
+                                    NULL);
+  mix        = gegl_node_new_child (graph,
+                                    "operation", "gegl:mix",
+                                    "ratio",     0.25,
+                                    NULL);
+  invert     = gegl_node_new_child (graph,
+                                    "operation", "gegl:invert-linear",
+                                    NULL);
+  sink       = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-sink",
+                                    "buffer",    &fused,
+                                    NULL);
+
+  gegl_node_link_many (source, exposure, saturation, mix, invert, sink, NULL);
+  gegl_node_connect (aux_source, "output", mix, "aux");
+  gegl_node_process (sink);
+
+  stepwise = apply_op (input, NULL, "gegl:exposure", "exposure", 0.5);
+  tmp = apply_op (stepwise, NULL, "gegl:saturation", "scale", 1.5);
+  g_object_unref (stepwise);
+  stepwise = apply_op (tmp, aux, "gegl:mix", "ratio", 0.25);
+  g_object_unref (tmp);
+  tmp = apply_op (stepwise, NULL, "gegl:invert-linear", NULL, 0.0);
+  g_object_unref (stepwise);
+  stepwise = tmp;
+
+  if (! fused || ! buffers_equal (fused, stepwise))
+    result = FAILURE;
+
+  g_clear_object (&fused);
+  g_object_unref (stepwise);
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (aux);
+
+  return result;
+}
+
+/* renders @roi of @node at @scale, with fusion turned on or off */
+static gfloat *
+render (GeglNode            *node,
+        const GeglRectangle *roi,
+        gdouble              scale,
+        gboolean             fuse)
+{
+  gfloat *pixels = g_new (gfloat, roi->width * roi->height * 4);
+
+  g_object_set (gegl_config (), "fuse-point-ops", fuse, NULL);
+
+  gegl_node_blit (node, scale, roi, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_set (gegl_config (), "fuse-point-ops", TRUE, NULL);
+
+  return pixels;
+}
+
+static int
+test_fused_vs_unfused (void)
+{
+  GeglBuffer    *input = make_source (0.37f);
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *trace1;
+  GeglNode      *trace2;
+  GeglNode      *invert;
+  GeglRectangle  roi    = { 0, 0, SIZE, SIZE };
+  GeglRectangle  roi1   = { 1, 1, SIZE / 2 - 3, SIZE / 2 - 3 };
+  gfloat        *fused;
+  gfloat        *unfused;
+  gint           result = SUCCESS;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  trace1 = gegl_node_new_child (graph,
+                                "operation", "gegl-test:trace",
+                                NULL);
+  trace2 = gegl_node_new_child (graph,
+                                "operation", "gegl-test:trace",
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+
+  ((GeglTestOperationTrace *) gegl_node_get_gegl_operation (trace1))->tag = 'a';
+  ((GeglTestOperationTrace *) gegl_node_get_gegl_operation (trace2))->tag = 'b';
+
+  gegl_node_link_many (source, trace1, trace2, invert, NULL);
+
+  /* level 0 */
+  g_string_truncate (trace, 0);
+  fused = render (invert, &roi, 1.0, TRUE);
+
+  if (! strstr (trace->str, "ab") || ! strstr (trace->str, "ba"))
+    {
+      printf ("the chain wasn't fused\n");
+      result = FAILURE;
+    }
+
+  g_string_truncate (trace, 0);
+  unfused = render (invert, &roi, 1.0, FALSE);
+
+  if (result == SUCCESS && strstr (trace->str, "ba"))
+    {
+      printf ("the chain was fused with fuse-point-ops off\n");
+      result = FAILURE;
+    }
+
+  if (result == SUCCESS &&
+      ! pixels_equal (fused, unfused, roi.width * roi.height * 4))
+    {
+      printf ("fusion changed the result at level 0\n");
+      result = FAILURE;
+    }
+
+  g_free (fused);
+  g_free (unfused);
+
+  /* level 1, with a request which isn't aligned to the level */
+  if (result == SUCCESS)
+    {
+      g_object_set (gegl_config (), "mipmap-rendering", TRUE, NULL);
+
+      fused   = render (invert, &roi1, 0.5, TRUE);
+      unfused = render (invert, &roi1, 0.5, FALSE);
+
+      g_object_set (gegl_config (), "mipmap-rendering", FALSE, NULL);
+
+      if (! pixels_equal (fused, unfused, roi1.width * roi1.height * 4))
+        {
+          printf ("fusion changed the result at level 1\n");
+          result = FAILURE;
+        }
+
+      g_free (fused);
+      g_free (unfused);
+    }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_type_class_peek (gegl_test_operation_trace_get_type ());
+
+  trace = g_string_new (NULL);
+
+  if (result == SUCCESS)
+    result = test_point_fusion ();
+
+  if (result == SUCCESS)
+    result = test_fused_vs_unfused ();
+
+  g_string_free (trace, TRUE);
+
+  gegl_exit ();
+
+  return result;
+}
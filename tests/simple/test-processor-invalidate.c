@@ -0,0 +1,244 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* renders a node with a processor at level 0 and at level 1, invalidates
+ * part of its input, and makes sure that rendering again only processes
+ * the invalidated area, at the processor's level.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+#include "graph/gegl-region.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 128
+
+/* the area invalidated in the input, in level-0 coordinates */
+#define INVALID_X 16
+#define INVALID_Y 16
+#define INVALID_W 16
+#define INVALID_H 16
+
+/* a point filter recording the area it processes, in the coordinates of
+ * the level it is processed at.
+ */
+
+typedef struct
+{
+  GeglOperationPointFilter  parent_instance;
+} GeglTestOperationCount;
+
+typedef struct
+{
+  GeglOperationPointFilterClass  parent_class;
+} GeglTestOperationCountClass;
+
+GType   gegl_test_operation_count_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (GeglTestOperationCount, gegl_test_operation_count,
+               GEGL_TYPE_OPERATION_POINT_FILTER);
+
+static GMutex      processed_mutex;
+static GeglRegion *processed;
+
+static gboolean
+gegl_test_operation_count_process (GeglOperation       *operation,
+                                   void                *in_buf,
+                                   void                *out_buf,
+                                   glong                samples,
+                                   const GeglRectangle *roi,
+                                   gint                 level)
+{
+  memcpy (out_buf, in_buf, samples * 4 * sizeof (gfloat));
+
+  g_mutex_lock (&processed_mutex);
+  gegl_region_union_with_rect (processed, roi);
+  g_mutex_unlock (&processed_mutex);
+
+  return TRUE;
+}
+
+static void
+gegl_test_operation_count_init (GeglTestOperationCount *self)
+{
+}
+
+static void
+gegl_test_operation_count_class_init (GeglTestOperationCountClass *klass)
+{
+  GeglOperationPointFilterClass *point_filter_class =
+    GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  point_filter_class->process = gegl_test_operation_count_process;
+
+  gegl_operation_class_set_keys (GEGL_OPERATION_CLASS (klass),
+                                 "name",        "gegl-test:count",
+                                 "description", "",
+                                 NULL);
+}
+
+static gint
+region_area (GeglRegion *region)
+{
+  GeglRectangle *rects;
+  gint           n_rects;
+  gint           area = 0;
+  gint           i;
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    area += rects[i].width * rects[i].height;
+
+  g_free (rects);
+
+  return area;
+}
+
+/* renders everything the processor has left to do, and returns the region
+ * processed by gegl-test:count.
+ */
+static GeglRegion *
+render (GeglProcessor *processor)
+{
+  GeglRegion *result;
+
+  processed = gegl_region_new ();
+
+  gegl_processor_set_rectangle (processor,
+                                GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+
+  while (gegl_processor_work (processor, NULL));
+
+  result    = processed;
+  processed = NULL;
+
+  return result;
+}
+
+static gboolean
+test_processor_invalidate (gint level)
+{
+  GeglBuffer    *buffer;
+  GeglColor     *color;
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *count;
+  GeglProcessor *processor;
+  GeglRegion    *region;
+  GeglRectangle  full    = {0, 0, SIZE >> level, SIZE >> level};
+  GeglRectangle  invalid = {INVALID_X >> level, INVALID_Y >> level,
+                            INVALID_W >> level, INVALID_H >> level};
+  gboolean       result  = TRUE;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  color  = gegl_color_new ("rgb(0.25, 0.5, 0.75)");
+  gegl_buffer_set_color (buffer, NULL, color);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  count  = gegl_node_new_child (graph,
+                                "operation", "gegl-test:count",
+                                NULL);
+
+  gegl_node_link (source, count);
+
+  processor = gegl_node_new_processor (count,
+                                       GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+  gegl_processor_set_level (processor, level);
+
+  region = render (processor);
+
+  if (gegl_region_rect_in (region, &full) != GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      printf ("level %d: the first render didn't cover everything\n", level);
+      result = FALSE;
+    }
+
+  gegl_region_destroy (region);
+
+  region = render (processor);
+
+  if (! gegl_region_empty (region))
+    {
+      printf ("level %d: a valid cache was rendered again\n", level);
+      result = FALSE;
+    }
+
+  gegl_region_destroy (region);
+
+  gegl_buffer_set_color (buffer,
+                         GEGL_RECTANGLE (INVALID_X, INVALID_Y,
+                                         INVALID_W, INVALID_H),
+                         color);
+
+  region = render (processor);
+
+  if (gegl_region_rect_in (region, &invalid) != GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      printf ("level %d: the invalidated area wasn't rendered again\n",
+              level);
+      result = FALSE;
+    }
+  else if (region_area (region) > full.width * full.height / 4)
+    {
+      printf ("level %d: rendered %d pixels again, for %d invalidated\n",
+              level, region_area (region), invalid.width * invalid.height);
+      result = FALSE;
+    }
+
+  gegl_region_destroy (region);
+
+  g_object_unref (processor);
+  g_object_unref (graph);
+  g_object_unref (color);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_type_class_peek (gegl_test_operation_count_get_type ());
+
+  /* the processor only renders at its level with mipmap rendering */
+  g_object_set (gegl_config (), "mipmap-rendering", TRUE, NULL);
+
+  if (! test_processor_invalidate (0) ||
+      ! test_processor_invalidate (1))
+    {
+      result = FAILURE;
+    }
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,164 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  517
+#define HEIGHT 389
+#define N_BINS 64
+
+/* reduces a buffer with gegl_reduction_add_buffer(), which splits the work
+ * across threads, and compares the result against a serial scan of the same
+ * pixels.
+ */
+static int
+test_reduce (const GeglRectangle *rect)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglBuffer    *buffer;
+  GeglReduction *reduction;
+  gfloat        *pixels;
+  gdouble        min[4], max[4], sum[4];
+  gint64         histogram[4][N_BINS] = {{0,}};
+  gint64         n_pixels             = 0;
+  gint           result               = SUCCESS;
+  gint           x, y, c;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+  pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (x = 0; x < WIDTH * HEIGHT * 4; x++)
+    pixels[x] = fmodf (x * 0.37f, 1.2f) - 0.1f;
+
+  gegl_buffer_set (buffer, NULL, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  for (c = 0; c < 4; c++)
+    {
+      min[c] =  G_MAXDOUBLE;
+      max[c] = -G_MAXDOUBLE;
+      sum[c] =  0.0;
+    }
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    {
+      for (x = rect->x; x < rect->x + rect->width; x++)
+        {
+          const gfloat *pixel = pixels + (y * WIDTH + x) * 4;
+
+          for (c = 0; c < 4; c++)
+            {
+              gdouble v = pixel[c];
+
+              min[c]  = MIN (min[c], v);
+              max[c]  = MAX (max[c], v);
+              sum[c] += v;
+
+              if (v >= 0.0 && v <= 1.0)
+                histogram[c][MIN ((gint) (v * N_BINS), N_BINS - 1)]++;
+            }
+
+          n_pixels++;
+        }
+    }
+
+  reduction = gegl_reduction_new (format, N_BINS, 0.0, 1.0);
+
+  gegl_reduction_add_buffer (reduction, buffer, rect, 0);
+
+  if (gegl_reduction_get_n_pixels (reduction) != n_pixels)
+    {
+      printf ("pixel count mismatch: %" G_GINT64_FORMAT " != %" G_GINT64_FORMAT "\n",
+              gegl_reduction_get_n_pixels (reduction), n_pixels);
+      result = FAILURE;
+    }
+
+  for (c = 0; c < 4 && result == SUCCESS; c++)
+    {
+      const gint64 *bins;
+      gint          n_bins;
+      gint          i;
+
+      if (gegl_reduction_get_min (reduction, c) != min[c] ||
+          gegl_reduction_get_max (reduction, c) != max[c])
+        {
+          printf ("component %d: min/max mismatch: %f, %f != %f, %f\n", c,
+                  gegl_reduction_get_min (reduction, c),
+                  gegl_reduction_get_max (reduction, c),
+                  min[c], max[c]);
+          result = FAILURE;
+        }
+
+      if (fabs (gegl_reduction_get_sum (reduction, c) - sum[c]) >
+          1e-9 * n_pixels)
+        {
+          printf ("component %d: sum mismatch: %f != %f\n", c,
+                  gegl_reduction_get_sum (reduction, c), sum[c]);
+          result = FAILURE;
+        }
+
+      bins = gegl_reduction_get_histogram (reduction, c, &n_bins);
+
+      for (i = 0; i < N_BINS && result == SUCCESS; i++)
+        {
+          if (n_bins != N_BINS || bins[i] != histogram[c][i])
+            {
+              printf ("component %d: histogram mismatch at bin %d\n", c, i);
+              result = FAILURE;
+            }
+        }
+    }
+
+  if (result == SUCCESS)
+    {
+      gdouble median = gegl_reduction_get_percentile (reduction, 0, 0.5);
+
+      if (median < 0.4 || median > 0.6)
+        {
+          printf ("median out of range: %f\n", median);
+          result = FAILURE;
+        }
+    }
+
+  gegl_reduction_free (reduction);
+  g_free (pixels);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (result == SUCCESS)
+    result = test_reduce (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT));
+  if (result == SUCCESS)
+    result = test_reduce (GEGL_RECTANGLE (13, 7, 301, 211));
+
+  gegl_exit ();
+
+  return result;
+}
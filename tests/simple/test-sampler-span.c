@@ -0,0 +1,145 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 100
+#define N    333
+
+/* samples a line crossing the buffer, and its abyss, both with
+ * gegl_sampler_get_span() and gegl_sampler_get(), and compares the results.
+ */
+static int
+test_sampler_span (GeglSamplerType  type,
+                   const gchar     *format_name,
+                   GeglAbyssPolicy  abyss)
+{
+  const Babl        *format  = babl_format (format_name);
+  gint               n_comps = babl_format_get_n_components (format);
+  GeglBuffer        *buffer;
+  GeglSampler       *sampler;
+  GeglBufferMatrix2  scale   = {{{ 0.7, 0.1 }, { 0.2, 0.7 }}};
+  gfloat            *pixels;
+  gfloat            *span;
+  gfloat            *points;
+  gdouble           *coords;
+  gdouble            x       = -20.3;
+  gdouble            y       = 10.7;
+  gint               result  = SUCCESS;
+  gint               i;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    pixels[i] = fmodf (i * 0.37f, 1.0f);
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  sampler = gegl_buffer_sampler_new (buffer, format, type);
+
+  span   = g_new (gfloat, N * n_comps);
+  points = g_new (gfloat, N * n_comps);
+  coords = g_new (gdouble, N * 2);
+
+  gegl_sampler_get_span (sampler, x, y, 0.43, 0.11, &scale,
+                         span, N, abyss);
+
+  for (i = 0; i < N; i++)
+    {
+      coords[2 * i + 0] = x;
+      coords[2 * i + 1] = y;
+
+      gegl_sampler_get (sampler, x, y, &scale,
+                        points + i * n_comps, abyss);
+
+      x += 0.43;
+      y += 0.11;
+    }
+
+  for (i = 0; i < N * n_comps && result == SUCCESS; i++)
+    {
+      if (fabsf (span[i] - points[i]) > 1e-5f)
+        {
+          printf ("%s, %d: span mismatch at %d: %f != %f\n",
+                  format_name, type, i / n_comps, span[i], points[i]);
+          result = FAILURE;
+        }
+    }
+
+  gegl_sampler_get_points (sampler, coords, &scale, span, N, abyss);
+
+  for (i = 0; i < N * n_comps && result == SUCCESS; i++)
+    {
+      if (fabsf (span[i] - points[i]) > 1e-5f)
+        {
+          printf ("%s, %d: points mismatch at %d: %f != %f\n",
+                  format_name, type, i / n_comps, span[i], points[i]);
+          result = FAILURE;
+        }
+    }
+
+  g_free (coords);
+  g_free (points);
+  g_free (span);
+  g_free (pixels);
+  g_object_unref (sampler);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  const GeglSamplerType types[]   = {GEGL_SAMPLER_NEAREST,
+                                     GEGL_SAMPLER_LINEAR,
+                                     GEGL_SAMPLER_CUBIC,
+                                     GEGL_SAMPLER_NOHALO};
+  const GeglAbyssPolicy abysses[] = {GEGL_ABYSS_NONE,
+                                     GEGL_ABYSS_CLAMP,
+                                     GEGL_ABYSS_LOOP,
+                                     GEGL_ABYSS_WHITE};
+  gint                  result    = SUCCESS;
+  gint                  i;
+  gint                  j;
+
+  gegl_init (&argc, &argv);
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (abysses); j++)
+        {
+          if (result == SUCCESS)
+            result = test_sampler_span (types[i], "RGBA float", abysses[j]);
+          if (result == SUCCESS)
+            result = test_sampler_span (types[i], "YA float", abysses[j]);
+        }
+    }
+
+  gegl_exit ();
+
+  return result;
+}
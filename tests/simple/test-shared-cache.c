@@ -0,0 +1,187 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* builds the same graph twice, and makes sure that the cached node of the
+ * second graph reuses the results of the first one, and that changing the
+ * first graph afterwards leaves them intact.  then makes sure that resizing
+ * a source buffer, whose key doesn't change with its extent, doesn't bring
+ * back a cache of the old size.
+ */
+
+#include "config.h"
+
+#include "test-cache-common.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define COLOR "rgb(0.25, 0.5, 0.75)"
+
+static GeglNode *
+make_buffer_graph (GeglBuffer  *buffer,
+                   GeglNode   **invert)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *source;
+
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:buffer-source",
+                                 "buffer",    buffer,
+                                 NULL);
+  *invert = gegl_node_new_child (graph,
+                                 "operation",    "gegl:invert-linear",
+                                 "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                                 NULL);
+
+  gegl_node_link (source, *invert);
+
+  return graph;
+}
+
+static gboolean
+test_resized_source (void)
+{
+  GeglBuffer *buffer;
+  GeglNode   *graph1;
+  GeglNode   *graph2;
+  GeglNode   *invert1;
+  GeglNode   *invert2;
+  GeglColor  *value;
+  gfloat      pixel[4];
+  gboolean    result = TRUE;
+
+  value  = gegl_color_new (COLOR);
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set_color (buffer, NULL, value);
+
+  graph1 = make_buffer_graph (buffer, &invert1);
+  graph2 = make_buffer_graph (buffer, &invert2);
+
+  gegl_node_blit (invert1, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  babl_format ("RGBA float"), NULL,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  if (gegl_node_get_cache (invert1) != gegl_node_get_cache (invert2))
+    {
+      printf ("identical buffer sources don't share their cache\n");
+      result = FALSE;
+    }
+
+  if (result)
+    {
+      const GeglRectangle *extent;
+
+      /* writing to the new area invalidates the sources */
+      gegl_buffer_set_extent (buffer, GEGL_RECTANGLE (0, 0, 2 * SIZE, SIZE));
+      gegl_buffer_set_color (buffer, GEGL_RECTANGLE (SIZE, 0, SIZE, SIZE),
+                             value);
+
+      gegl_node_blit (invert1, 1.0,
+                      GEGL_RECTANGLE (SIZE + SIZE / 2, SIZE / 2, 1, 1),
+                      babl_format ("RGBA float"), pixel,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+      extent = gegl_buffer_get_extent (
+                 GEGL_BUFFER (gegl_node_get_cache (invert1)));
+
+      if (! gegl_rectangle_equal (extent,
+                                  GEGL_RECTANGLE (0, 0, 2 * SIZE, SIZE)))
+        {
+          printf ("the cache of a resized source is %dx%d\n",
+                  extent->width, extent->height);
+          result = FALSE;
+        }
+      else if (fabsf (pixel[3] - 1.0f) > 1e-5f)
+        {
+          printf ("the resized area of the source wasn't rendered\n");
+          result = FALSE;
+        }
+    }
+
+  g_object_unref (graph2);
+  g_object_unref (graph1);
+  g_object_unref (buffer);
+  g_object_unref (value);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  GeglNode  *graph1;
+  GeglNode  *graph2;
+  GeglNode  *invert1;
+  GeglNode  *invert2;
+  GeglColor *value;
+  gint       result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "shared-cache-size", (guint64) 64 * 1024 * 1024,
+                NULL);
+
+  graph1 = make_graph (COLOR, &invert1);
+
+  gegl_node_blit (invert1, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  babl_format ("RGBA float"), NULL,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  graph2 = make_graph (COLOR, &invert2);
+
+  if (gegl_node_get_cache (invert1) != gegl_node_get_cache (invert2) ||
+      ! is_valid (invert2))
+    {
+      printf ("identical nodes don't share their cache\n");
+      result = FAILURE;
+    }
+
+  if (result == SUCCESS)
+    {
+      GeglNode *color = gegl_node_get_producer (
+                          gegl_node_get_producer (invert1, "input", NULL),
+                          "input", NULL);
+
+      value = gegl_color_new ("rgb(1.0, 0.0, 0.0)");
+      gegl_node_set (color, "value", value, NULL);
+      g_object_unref (value);
+
+      if (gegl_node_get_cache (invert1) == gegl_node_get_cache (invert2))
+        {
+          printf ("changed node still uses the shared cache\n");
+          result = FAILURE;
+        }
+      else if (! is_valid (invert2))
+        {
+          printf ("changing a node invalidated the shared cache\n");
+          result = FAILURE;
+        }
+    }
+
+  if (result == SUCCESS && ! is_inverted (invert2, COLOR))
+    result = FAILURE;
+
+  g_object_unref (graph2);
+  g_object_unref (graph1);
+
+  if (result == SUCCESS && ! test_resized_source ())
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
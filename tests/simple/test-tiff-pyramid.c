@@ -0,0 +1,225 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* loads a tiled, multi-page TIFF, whose first page is followed by a
+ * reduced-resolution image of it, and makes sure that partial regions, the
+ * reduced-resolution image, and the second page are loaded the same as a
+ * full decode of the file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  40
+#define HEIGHT 36
+
+/* the first page, its reduced-resolution image, and the second page */
+#define FIRST_PAGE  1
+#define SECOND_PAGE 3
+
+static gchar *path;
+
+/* the pixels of the first page, the second page has them inverted */
+static void
+expected_pixel (gint    page,
+                gint    x,
+                gint    y,
+                guint8 *pixel)
+{
+  pixel[0] = (x * 6) & 255;
+  pixel[1] = (y * 7) & 255;
+  pixel[2] = ((x + y) * 3) & 255;
+
+  if (page == SECOND_PAGE)
+    {
+      pixel[0] = 255 - pixel[0];
+      pixel[1] = 255 - pixel[1];
+      pixel[2] = 255 - pixel[2];
+    }
+}
+
+/* loads @rect of a page at @scale, with a node of its own, so that nothing
+ * is shared with earlier loads.
+ */
+static guint8 *
+load (gint                 page,
+      gdouble              scale,
+      const GeglRectangle *rect)
+{
+  GeglNode *graph;
+  GeglNode *loader;
+  guint8   *data = g_new (guint8, rect->width * rect->height * 3);
+
+  graph  = gegl_node_new ();
+  loader = gegl_node_new_child (graph,
+                                "operation", "gegl:tiff-load",
+                                "path",      path,
+                                "directory", page,
+                                NULL);
+
+  gegl_node_blit (loader, scale, rect, babl_format ("R'G'B' u8"), data,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+
+  return data;
+}
+
+static gboolean
+test_full (gint     page,
+           guint8 **full)
+{
+  guint8 expected[3];
+  gint   x, y, c;
+
+  *full = load (page, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT));
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        expected_pixel (page, x, y, expected);
+
+        for (c = 0; c < 3; c++)
+          {
+            if ((*full)[(y * WIDTH + x) * 3 + c] != expected[c])
+              {
+                printf ("page %d: got %d instead of %d at %d,%d\n",
+                        page, (*full)[(y * WIDTH + x) * 3 + c],
+                        expected[c], x, y);
+                return FALSE;
+              }
+          }
+      }
+
+  return TRUE;
+}
+
+/* loads a region straddling several tiles, and the edge tiles */
+static gboolean
+test_partial (gint          page,
+              const guint8 *full)
+{
+  const GeglRectangle rect = {10, 7, 27, 29};
+  guint8             *data;
+  gboolean            result = TRUE;
+  gint                x, y;
+
+  data = load (page, 1.0, &rect);
+
+  for (y = 0; y < rect.height && result; y++)
+    for (x = 0; x < rect.width * 3; x++)
+      {
+        if (data[y * rect.width * 3 + x] !=
+            full[((rect.y + y) * WIDTH + rect.x) * 3 + x])
+          {
+            printf ("page %d: partial load differs at %d,%d\n",
+                    page, rect.x + x / 3, rect.y + y);
+            result = FALSE;
+            break;
+          }
+      }
+
+  g_free (data);
+
+  return result;
+}
+
+/* loads the page at half its size, which reads the reduced-resolution
+ * image, and compares it with a 2x2 box filter of the full decode.
+ */
+static gboolean
+test_level (gint          page,
+            const guint8 *full)
+{
+  guint8   *data;
+  gboolean  result = TRUE;
+  gint      x, y, c;
+
+  data = load (page, 0.5, GEGL_RECTANGLE (0, 0, WIDTH / 2, HEIGHT / 2));
+
+  for (y = 0; y < HEIGHT / 2 && result; y++)
+    for (x = 0; x < WIDTH / 2 && result; x++)
+      for (c = 0; c < 3; c++)
+        {
+          gint sum = full[((2 * y)     * WIDTH + 2 * x)     * 3 + c] +
+                     full[((2 * y)     * WIDTH + 2 * x + 1) * 3 + c] +
+                     full[((2 * y + 1) * WIDTH + 2 * x)     * 3 + c] +
+                     full[((2 * y + 1) * WIDTH + 2 * x + 1) * 3 + c];
+          gint got = data[(y * (WIDTH / 2) + x) * 3 + c];
+
+          if (abs (got - (sum + 2) / 4) > 2)
+            {
+              printf ("page %d: got %d instead of %d at %d,%d at level 1\n",
+                      page, got, (sum + 2) / 4, x, y);
+              result = FALSE;
+              break;
+            }
+        }
+
+  g_free (data);
+
+  return result;
+}
+
+static gboolean
+test_page (gint     page,
+           gboolean reduced)
+{
+  guint8   *full;
+  gboolean  result;
+
+  result = test_full (page, &full)       &&
+           test_partial (page, full)     &&
+           (! reduced || test_level (page, full));
+
+  g_free (full);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* level 1 is only rendered as such with mipmap rendering */
+  g_object_set (gegl_config (), "mipmap-rendering", TRUE, NULL);
+
+  path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
+                           "tests", "compositions", "data",
+                           "gegl-8bit-3ch-tiled-pyramid.tif",
+                           NULL);
+
+  if (! test_page (FIRST_PAGE, TRUE) ||
+      ! test_page (SECOND_PAGE, FALSE))
+    {
+      result = FAILURE;
+    }
+
+  g_free (path);
+
+  gegl_exit ();
+
+  return result;
+}
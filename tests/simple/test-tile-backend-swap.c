@@ -0,0 +1,177 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* writes buffers much bigger than the tile cache from several threads at
+ * once, with a swap directory and several swap writer threads, and reads
+ * them back, so that their tiles are written to the swap in batches, and
+ * read back from it, both compressed and uncompressed.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_THREADS 4
+#define N_PASSES  2
+#define SIZE      512
+
+static void
+fill_pixels (guint32 *pixels,
+             guint32  seed)
+{
+  gint i;
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    pixels[i] = (i + seed) * 2654435761u;
+}
+
+/* writes a buffer band by band, and reads it back band by band, several
+ * times over, checking every pixel.
+ */
+static gpointer
+swap_thread (gpointer data)
+{
+  guint       id       = GPOINTER_TO_UINT (data);
+  guint32    *expected = g_new (guint32, SIZE * SIZE);
+  guint32    *row      = g_new (guint32, SIZE * 64);
+  GeglBuffer *buffer;
+  gboolean    result   = TRUE;
+  gint        pass;
+  gint        y;
+
+  fill_pixels (expected, id * 1000003u);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("R'G'B'A u8"));
+
+  for (y = 0; y < SIZE; y += 64)
+    {
+      gegl_buffer_set (buffer, GEGL_RECTANGLE (0, y, SIZE, 64), 0,
+                       babl_format ("R'G'B'A u8"), expected + y * SIZE,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  for (pass = 0; pass < N_PASSES && result; pass++)
+    {
+      for (y = 0; y < SIZE && result; y += 64)
+        {
+          gint i;
+
+          gegl_buffer_get (buffer, GEGL_RECTANGLE (0, y, SIZE, 64), 1.0,
+                           babl_format ("R'G'B'A u8"), row,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (i = 0; i < SIZE * 64; i++)
+            {
+              if (row[i] != expected[y * SIZE + i])
+                {
+                  printf ("thread %u, pass %d: mismatch at %d,%d\n",
+                          id, pass, i % SIZE, y + i / SIZE);
+                  result = FALSE;
+                  break;
+                }
+            }
+        }
+    }
+
+  g_object_unref (buffer);
+  g_free (row);
+  g_free (expected);
+
+  return GINT_TO_POINTER (result);
+}
+
+static int
+test_swap (const gchar *compression)
+{
+  GThread *threads[N_THREADS];
+  guint64  swap_total;
+  gint     result = SUCCESS;
+  gint     i;
+
+  g_object_set (gegl_config (),
+                "swap-compression", compression,
+                NULL);
+
+  gegl_reset_stats ();
+
+  for (i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_new (NULL, swap_thread, GUINT_TO_POINTER (i));
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      if (! GPOINTER_TO_INT (g_thread_join (threads[i])))
+        result = FAILURE;
+    }
+
+  g_object_get (gegl_stats (),
+                "swap-read-total", &swap_total,
+                NULL);
+
+  if (result == SUCCESS && swap_total == 0)
+    {
+      printf ("%s: nothing was read back from the swap\n", compression);
+      result = FAILURE;
+    }
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gchar *path;
+  gint   result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  path = g_dir_make_tmp ("gegl-swap-XXXXXX", NULL);
+
+  if (! path)
+    {
+      printf ("failed to create the swap directory\n");
+      gegl_exit ();
+
+      return FAILURE;
+    }
+
+  /* the writer threads are started along with the first swap buffer; each
+   * thread's buffer is four times the size of the tile cache.
+   */
+  g_object_set (gegl_config (),
+                "swap",            path,
+                "swap-io-threads", 3,
+                "tile-cache-size", (guint64) 256 * 1024,
+                NULL);
+
+  if (result == SUCCESS)
+    result = test_swap ("none");
+  if (result == SUCCESS)
+    result = test_swap ("fast");
+
+  gegl_exit ();
+
+  g_rmdir (path);
+  g_free (path);
+
+  return result;
+}
@@ -0,0 +1,217 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* applies random sequences of aligned and unaligned additions and removals
+ * to a GeglTileBitmap and to a GeglRegion, and makes sure that they agree.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+#include "graph/gegl-region.h"
+#include "graph/gegl-tile-bitmap.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define TILE_WIDTH  16
+#define TILE_HEIGHT 8
+
+#define N_SEQUENCES  50
+#define N_OPERATIONS 200
+#define N_QUERIES    4
+
+static void
+random_rect (GRand         *rand,
+             GeglRectangle *rect)
+{
+  if (g_rand_boolean (rand))
+    {
+      rect->x      = g_rand_int_range (rand, -20, 20) * TILE_WIDTH;
+      rect->y      = g_rand_int_range (rand, -20, 20) * TILE_HEIGHT;
+      rect->width  = g_rand_int_range (rand, 0, 10)   * TILE_WIDTH;
+      rect->height = g_rand_int_range (rand, 0, 10)   * TILE_HEIGHT;
+    }
+  else
+    {
+      rect->x      = g_rand_int_range (rand, -400, 400);
+      rect->y      = g_rand_int_range (rand, -200, 200);
+      rect->width  = g_rand_int_range (rand, 0, 150);
+      rect->height = g_rand_int_range (rand, 0, 80);
+    }
+}
+
+static guint64
+region_area (GeglRegion *region)
+{
+  GeglRectangle *rects;
+  gint           n_rects;
+  guint64        area = 0;
+  gint           i;
+
+  gegl_region_get_rectangles (region, &rects, &n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    area += (guint64) rects[i].width * rects[i].height;
+
+  g_free (rects);
+
+  return area;
+}
+
+static gboolean
+same_region (GeglRegion *region1,
+             GeglRegion *region2)
+{
+  GeglRegion *diff = gegl_region_copy (region1);
+  gboolean    same;
+
+  gegl_region_xor (diff, region2);
+  same = gegl_region_empty (diff);
+  gegl_region_destroy (diff);
+
+  return same;
+}
+
+static gboolean
+check (GeglTileBitmap *bitmap,
+       GeglRegion     *expected,
+       GRand          *rand)
+{
+  GeglRegion *region;
+  gboolean    success = TRUE;
+  gint        i;
+
+  region = gegl_tile_bitmap_get_region (bitmap, NULL);
+
+  if (! same_region (region, expected))
+    {
+      printf ("the bitmap doesn't hold the expected region\n");
+      success = FALSE;
+    }
+
+  gegl_region_destroy (region);
+
+  if (gegl_tile_bitmap_get_area (bitmap, NULL) != region_area (expected))
+    {
+      printf ("the bitmap doesn't have the expected area\n");
+      success = FALSE;
+    }
+
+  for (i = 0; i < N_QUERIES && success; i++)
+    {
+      GeglRectangle  rect;
+      GeglRegion    *left;
+      GeglRegion    *expected_left;
+
+      random_rect (rand, &rect);
+
+      if (gegl_tile_bitmap_contains (bitmap, &rect) !=
+          (gegl_region_rect_in (expected, &rect) == GEGL_OVERLAP_RECTANGLE_IN ||
+           rect.width == 0 || rect.height == 0))
+        {
+          printf ("wrong answer for %d,%d %dx%d\n",
+                  rect.x, rect.y, rect.width, rect.height);
+          success = FALSE;
+        }
+
+      left          = gegl_region_rectangle (&rect);
+      expected_left = gegl_region_rectangle (&rect);
+
+      gegl_tile_bitmap_subtract (bitmap, left);
+      gegl_region_subtract (expected_left, expected);
+
+      if (! same_region (left, expected_left))
+        {
+          printf ("wrong subtraction from %d,%d %dx%d\n",
+                  rect.x, rect.y, rect.width, rect.height);
+          success = FALSE;
+        }
+
+      gegl_region_destroy (expected_left);
+      gegl_region_destroy (left);
+    }
+
+  return success;
+}
+
+int main (int argc, char *argv[])
+{
+  GRand *rand;
+  gint   result = SUCCESS;
+  gint   i, j;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (0);
+
+  for (i = 0; i < N_SEQUENCES && result == SUCCESS; i++)
+    {
+      GeglTileBitmap *bitmap   = gegl_tile_bitmap_new (TILE_WIDTH, TILE_HEIGHT);
+      GeglRegion     *expected = gegl_region_new ();
+
+      for (j = 0; j < N_OPERATIONS && result == SUCCESS; j++)
+        {
+          GeglRectangle rect;
+          GeglRegion   *temp;
+          gint          operation;
+
+          random_rect (rand, &rect);
+
+          operation = g_rand_int_range (rand, 0, 20);
+
+          if (operation < 12)
+            {
+              gegl_tile_bitmap_add (bitmap, &rect);
+              gegl_region_union_with_rect (expected, &rect);
+            }
+          else if (operation < 19)
+            {
+              gegl_tile_bitmap_remove (bitmap, &rect);
+
+              temp = gegl_region_rectangle (&rect);
+              gegl_region_subtract (expected, temp);
+              gegl_region_destroy (temp);
+            }
+          else
+            {
+              /* invalidating the infinite plane */
+              gegl_rectangle_set (&rect,
+                                  G_MININT / 2, G_MININT / 2,
+                                  G_MAXINT, G_MAXINT);
+
+              gegl_tile_bitmap_remove (bitmap, &rect);
+
+              gegl_region_destroy (expected);
+              expected = gegl_region_new ();
+            }
+
+          if (! check (bitmap, expected, rand))
+            result = FAILURE;
+        }
+
+      gegl_tile_bitmap_free (bitmap);
+      gegl_region_destroy (expected);
+    }
+
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
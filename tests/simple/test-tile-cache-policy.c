@@ -0,0 +1,356 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE 512
+
+/* the default tile size; the scanned buffer is 16 x 8 tiles, or 4mb, while
+ * the tile cache holds 8 tiles
+ */
+#define TILE_WIDTH  128
+#define TILE_HEIGHT 64
+#define SCAN_WIDTH  (16 * TILE_WIDTH)
+#define SCAN_HEIGHT (8 * TILE_HEIGHT)
+
+/* writes a buffer that is several times bigger than the tile cache, and reads
+ * it back, so that tiles get evicted, and fetched again, under policy.
+ */
+static int
+test_policy (const gchar *policy)
+{
+  GeglBuffer *buffer;
+  guint32    *pixels;
+  gchar      *property;
+  gdouble     hit_rate;
+  gint        result = SUCCESS;
+  gint        pass;
+  gint        i;
+
+  g_object_set (gegl_config (),
+                "tile-cache-policy", policy,
+                "tile-cache-size",   (guint64) 256 * 1024,
+                NULL);
+
+  gegl_reset_stats ();
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("R'G'B'A u8"));
+  pixels = g_new (guint32, SIZE * SIZE);
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    pixels[i] = i * 2654435761u;
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  for (pass = 0; pass < 2 && result == SUCCESS; pass++)
+    {
+      gint y;
+
+      /* read the first rows over and over, interleaved with a sequential
+       * scan over the rest of the buffer.
+       */
+      for (y = 0; y < SIZE && result == SUCCESS; y++)
+        {
+          guint32 row[SIZE];
+          gint    x;
+
+          gegl_buffer_get (buffer, GEGL_RECTANGLE (0, y % 64, SIZE, 1), 1.0,
+                           babl_format ("R'G'B'A u8"), row,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          gegl_buffer_get (buffer, GEGL_RECTANGLE (0, y, SIZE, 1), 1.0,
+                           babl_format ("R'G'B'A u8"), row,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (x = 0; x < SIZE; x++)
+            {
+              if (row[x] != pixels[y * SIZE + x])
+                {
+                  printf ("%s: mismatch at %d,%d\n", policy, x, y);
+                  result = FAILURE;
+                  break;
+                }
+            }
+        }
+    }
+
+  property = g_strdup_printf ("tile-cache-%s-hit-rate", policy);
+  g_object_get (gegl_stats (), property, &hit_rate, NULL);
+  g_free (property);
+
+  if (hit_rate <= 0.0 || hit_rate > 1.0)
+    {
+      printf ("%s: bad hit rate %g\n", policy, hit_rate);
+      result = FAILURE;
+    }
+
+  g_free (pixels);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+/* keeps reading a working set of two tiles, after every tile row of a
+ * sequential scan over a buffer that is much bigger than the tile cache, and
+ * returns the hit rate of the working set reads alone.
+ */
+static gdouble
+working_set_hit_rate (const gchar *policy)
+{
+  GeglBuffer *buffer;
+  guchar     *pixels;
+  gchar      *property;
+  gdouble     sum = 0.0;
+  gint        n   = 0;
+  gint        pass;
+  gint        i;
+
+  g_object_set (gegl_config (),
+                "tile-cache-policy", policy,
+                "tile-cache-size",   (guint64) 256 * 1024,
+                NULL);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SCAN_WIDTH, SCAN_HEIGHT),
+                            babl_format ("R'G'B'A u8"));
+  pixels = g_new (guchar, SCAN_WIDTH * TILE_HEIGHT * 4);
+
+  for (i = 0; i < SCAN_WIDTH * TILE_HEIGHT * 4; i++)
+    pixels[i] = i * 2654435761u >> 24;
+
+  for (i = 0; i < SCAN_HEIGHT; i += TILE_HEIGHT)
+    {
+      gegl_buffer_set (buffer, GEGL_RECTANGLE (0, i, SCAN_WIDTH, TILE_HEIGHT),
+                       0, babl_format ("R'G'B'A u8"), pixels,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  property = g_strdup_printf ("tile-cache-%s-hit-rate", policy);
+
+  /* make the working set hot, reading it more than once */
+  for (i = 0; i < 2; i++)
+    {
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (0, 0, 2 * TILE_WIDTH, TILE_HEIGHT),
+                       1.0, babl_format ("R'G'B'A u8"), pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      gint y;
+
+      for (y = TILE_HEIGHT; y < SCAN_HEIGHT; y += TILE_HEIGHT)
+        {
+          gdouble hit_rate;
+
+          gegl_buffer_get (buffer, GEGL_RECTANGLE (0, y, SCAN_WIDTH, TILE_HEIGHT),
+                           1.0, babl_format ("R'G'B'A u8"), pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          gegl_reset_stats ();
+
+          gegl_buffer_get (buffer,
+                           GEGL_RECTANGLE (0, 0, 2 * TILE_WIDTH, TILE_HEIGHT),
+                           1.0, babl_format ("R'G'B'A u8"), pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          g_object_get (gegl_stats (), property, &hit_rate, NULL);
+
+          sum += hit_rate;
+          n++;
+        }
+    }
+
+  g_free (property);
+  g_free (pixels);
+  g_object_unref (buffer);
+
+  return sum / n;
+}
+
+/* a sequential scan must not flush the working set out of the 2q cache, the
+ * way it does out of the lru cache.
+ */
+static int
+test_scan_resistance (void)
+{
+  gdouble lru_hit_rate = working_set_hit_rate ("lru");
+  gdouble q2_hit_rate  = working_set_hit_rate ("2q");
+
+  if (q2_hit_rate <= lru_hit_rate)
+    {
+      printf ("2q working set hit rate %g is no better than lru's %g\n",
+              q2_hit_rate, lru_hit_rate);
+      return FAILURE;
+    }
+
+  return SUCCESS;
+}
+
+#define N_THREADS    4
+#define N_ITERATIONS 16
+#define BUFFER_SIZE  256
+
+static void
+fill_pixels (guint32 *pixels,
+             guint32  seed)
+{
+  gint i;
+
+  for (i = 0; i < BUFFER_SIZE * BUFFER_SIZE; i++)
+    pixels[i] = (i + seed) * 2654435761u;
+}
+
+static GeglBuffer *
+new_filled_buffer (guint32 *pixels,
+                   guint32  seed)
+{
+  GeglBuffer *buffer;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, BUFFER_SIZE, BUFFER_SIZE),
+                            babl_format ("R'G'B'A u8"));
+
+  fill_pixels (pixels, seed);
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("R'G'B'A u8"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  return buffer;
+}
+
+static gboolean
+buffer_has_pixels (GeglBuffer    *buffer,
+                   const guint32 *pixels)
+{
+  guint32 *data = g_new (guint32, BUFFER_SIZE * BUFFER_SIZE);
+  gint     i;
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("R'G'B'A u8"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < BUFFER_SIZE * BUFFER_SIZE; i++)
+    {
+      if (data[i] != pixels[i])
+        break;
+    }
+
+  g_free (data);
+
+  return i == BUFFER_SIZE * BUFFER_SIZE;
+}
+
+/* keeps creating, checking and destroying buffers, while checking a buffer
+ * that lives throughout, whose tiles are evicted by the other threads.
+ */
+static gpointer
+concurrent_buffers_thread (gpointer data)
+{
+  guint       id       = GPOINTER_TO_UINT (data);
+  guint32     seed     = id * 1000003u;
+  guint32    *pixels   = g_new (guint32, BUFFER_SIZE * BUFFER_SIZE);
+  guint32    *expected = g_new (guint32, BUFFER_SIZE * BUFFER_SIZE);
+  GeglBuffer *buffer;
+  gboolean    result   = TRUE;
+  gint        i;
+
+  buffer = new_filled_buffer (expected, seed);
+
+  for (i = 0; i < N_ITERATIONS && result; i++)
+    {
+      GeglBuffer *temp = new_filled_buffer (pixels, seed + 1 + i);
+
+      if (! buffer_has_pixels (temp, pixels))
+        {
+          printf ("thread %u: a new buffer has the wrong pixels\n", id);
+          result = FALSE;
+        }
+
+      g_object_unref (temp);
+
+      if (! buffer_has_pixels (buffer, expected))
+        {
+          printf ("thread %u: an evicted buffer has the wrong pixels\n", id);
+          result = FALSE;
+        }
+    }
+
+  g_object_unref (buffer);
+  g_free (expected);
+  g_free (pixels);
+
+  return GINT_TO_POINTER (result);
+}
+
+/* trims the tile cache from several threads, while the caches being
+ * trimmed come and go.
+ */
+static int
+test_concurrent_buffers (const gchar *policy)
+{
+  GThread *threads[N_THREADS];
+  gint     result = SUCCESS;
+  gint     i;
+
+  g_object_set (gegl_config (),
+                "tile-cache-policy", policy,
+                "tile-cache-size",   (guint64) 256 * 1024,
+                NULL);
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      threads[i] = g_thread_new (NULL, concurrent_buffers_thread,
+                                 GUINT_TO_POINTER (i));
+    }
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      if (! GPOINTER_TO_INT (g_thread_join (threads[i])))
+        result = FAILURE;
+    }
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (result == SUCCESS)
+    result = test_policy ("lru");
+  if (result == SUCCESS)
+    result = test_policy ("2q");
+  if (result == SUCCESS)
+    result = test_policy ("cost");
+  if (result == SUCCESS)
+    result = test_scan_resistance ();
+  if (result == SUCCESS)
+    result = test_concurrent_buffers ("lru");
+  if (result == SUCCESS)
+    result = test_concurrent_buffers ("cost");
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,191 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* renders a gaussian blur composited over another image with
+ * tiled-scheduling on and off, and makes sure that the results are the
+ * same, and that a cached node is fully valid after a tiled render.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH  600
+#define HEIGHT 300
+
+static GeglBuffer *
+make_buffer (GRand *rand)
+{
+  GeglBuffer *buffer;
+  gfloat     *data = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gint        i;
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    data[i] = g_rand_double (rand);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+
+  return buffer;
+}
+
+/* renders the graph, and returns the result.  if @over has a cache,
+ * @valid is set to whether all of the result is valid in it.
+ */
+static gfloat *
+render (GeglNode  *over,
+        gboolean   tiled,
+        gboolean  *valid)
+{
+  gfloat *data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  g_object_set (gegl_config (), "tiled-scheduling", tiled, NULL);
+
+  gegl_node_blit (over, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                  babl_format ("RGBA float"), data,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_set (gegl_config (), "tiled-scheduling", FALSE, NULL);
+
+  if (valid && over->cache)
+    {
+      *valid = gegl_tile_bitmap_contains (over->cache->valid[0],
+                                          GEGL_RECTANGLE (0, 0,
+                                                          WIDTH, HEIGHT));
+    }
+
+  return data;
+}
+
+static gboolean
+test_tiled_scheduling (GeglBuffer  *input,
+                       GeglBuffer  *aux,
+                       const gchar *filter,
+                       gboolean     cached)
+{
+  GeglNode *graph;
+  GeglNode *source;
+  GeglNode *aux_source;
+  GeglNode *blur;
+  GeglNode *over;
+  gfloat   *expected;
+  gfloat   *output;
+  gboolean  valid  = TRUE;
+  gboolean  result = TRUE;
+  gint      i;
+
+  graph      = gegl_node_new ();
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    input,
+                                    NULL);
+  aux_source = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    aux,
+                                    NULL);
+  blur       = gegl_node_new_child (graph,
+                                    "operation", "gegl:gaussian-blur",
+                                    "std-dev-x", 3.0,
+                                    "std-dev-y", 3.0,
+                                    NULL);
+  over       = gegl_node_new_child (graph,
+                                    "operation", "gegl:over",
+                                    NULL);
+  gegl_node_set_enum_as_string (blur, "filter", filter);
+
+  gegl_node_link_many (source, blur, over, NULL);
+  gegl_node_connect (aux_source, "output", over, "aux");
+
+  expected = render (over, FALSE, NULL);
+
+  if (cached)
+    gegl_node_set (over, "cache-policy", GEGL_CACHE_POLICY_ALWAYS, NULL);
+
+  output = render (over, TRUE, &valid);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    {
+      if (fabsf (output[i] - expected[i]) > 1e-6f)
+        {
+          printf ("%s filter%s: got %f instead of %f at %d,%d\n",
+                  filter, cached ? ", cached" : "",
+                  output[i], expected[i],
+                  (i / 4) % WIDTH, (i / 4) / WIDTH);
+          result = FALSE;
+          break;
+        }
+    }
+
+  if (! valid)
+    {
+      printf ("%s filter: the cache isn't valid after a tiled render\n",
+              filter);
+      result = FALSE;
+    }
+
+  g_free (output);
+  g_free (expected);
+  g_object_unref (graph);
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  GRand      *rand;
+  GeglBuffer *input;
+  GeglBuffer *aux;
+  gint        result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* the graph is processed as usual with a single thread */
+  g_object_set (gegl_config (), "threads", 4, NULL);
+
+  rand  = g_rand_new_with_seed (42);
+  input = make_buffer (rand);
+  aux   = make_buffer (rand);
+
+  /* the fir blur is evaluated tile by tile along with gegl:over, the
+   * iir blur has to be computed in full before gegl:over is tiled.
+   */
+  if (! test_tiled_scheduling (input, aux, "fir", FALSE) ||
+      ! test_tiled_scheduling (input, aux, "fir", TRUE)  ||
+      ! test_tiled_scheduling (input, aux, "iir", FALSE) ||
+      ! test_tiled_scheduling (input, aux, "iir", TRUE))
+    {
+      result = FAILURE;
+    }
+
+  g_object_unref (aux);
+  g_object_unref (input);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}